@@ -21,26 +21,26 @@
 // Positive ele_norm variable means moving the elevator in the direction that causes a pitch up
 // Positive elevator PWM also means moving the elevator in the direction that causes a pitch up
 
-Autopilot* Autopilot::_instance = nullptr;
-
 Autopilot::Autopilot(HAL* hal)
-	: _ahrs(hal, &_data_bus),
-	  _position_estimator(hal, &_data_bus),
-	  _att_control(hal, &_data_bus),
-	  _position_control(hal, &_data_bus),
-	  _telem(hal, &_data_bus),
-	  _storage(hal, &_data_bus),
-	  _mixer(hal, &_data_bus),
-	  _rc_handler(hal, &_data_bus),
-	  _commander(hal, &_data_bus),
-	  _navigator(hal, &_data_bus),
-	  _sensors(hal, &_data_bus),
-	  _usb_comm(hal, &_data_bus)
+	: _ahrs(hal, &_data_bus, &_params),
+	  _position_estimator(hal, &_data_bus, &_params),
+	  _att_control(hal, &_data_bus, &_params),
+	  _position_control(hal, &_data_bus, &_params, &_mission),
+	  _telem(hal, &_data_bus, &_params, &_mission),
+	  _storage(hal, &_data_bus, &_params),
+	  _mission_storage(hal, &_data_bus, &_params, &_mission),
+	  _mixer(hal, &_data_bus, &_params),
+	  _rc_handler(hal, &_data_bus, &_params),
+	  _commander(hal, &_data_bus, &_params, &_mission),
+	  _navigator(hal, &_data_bus, &_params, &_mission),
+	  _sensors(hal, &_data_bus, &_params),
+	  _sensor_log(hal, &_data_bus, &_params),
+	  _usb_comm(hal, &_data_bus, &_params)
 {
 	_hal = hal;
-	_instance = this;
 
-	param_init();
+	param_init(&_params);
+	mission_init(&_mission);
 }
 
 void Autopilot::setup()
@@ -48,21 +48,48 @@ void Autopilot::setup()
 	printf("Autopilot: Setup\n");
 
 	_hal->init();
-	_hal->set_main_task(&Autopilot::static_main_task);
+	_hal->set_fast_task(&Autopilot::static_fast_task, this, IMU_SYNC);
+	_hal->set_main_task(&Autopilot::static_main_task, this);
 }
 
+// In lockstep HITL every simulator step runs the whole loop once, on the
+// simulated time it carries, and nothing runs between steps
 void Autopilot::main_task()
 {
-	_sensors.update();
+	while (_usb_comm.read_step())
+	{
+		fast_task();
+		update_main_modules();
+		_usb_comm.transmit_step();
+	}
+
+	if (!_usb_comm.lockstep_active())
+	{
+		update_main_modules();
+	}
+}
+
+void Autopilot::update_main_modules()
+{
+	_sensor_log.begin_tick();
 	_rc_handler.update();
-	_ahrs.update();
 	_position_estimator.update();
 	_commander.update();
 	_navigator.update();
 	_position_control.update();
-	_att_control.update();
-	_mixer.update();
 	_storage.update();
+	_sensor_log.flush();
 	_telem.update();
+	_mission_storage.update();
 	_usb_comm.update();
 }
+
+// Sensor to actuator chain, kept short so it can run on every IMU sample
+void Autopilot::fast_task()
+{
+	_sensors.update();
+	_sensor_log.update();
+	_ahrs.update();
+	_att_control.update();
+	_mixer.update();
+}
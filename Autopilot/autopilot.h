@@ -7,12 +7,14 @@
 #include "modules/position_estimator/position_estimator.h"
 #include "modules/ahrs/ahrs.h"
 #include "modules/commander/commander.h"
+#include "modules/mission_storage/mission_storage.h"
 #include "modules/mixer/mixer.h"
 #include "modules/navigator/navigator.h"
 #include "modules/rc_handler/rc_handler.h"
 #include "modules/storage/storage.h"
 #include "modules/telemetry/telem.h"
 #include "modules/sensors/sensors.h"
+#include "modules/sensor_log/sensor_log.h"
 #include "modules/usb_comm/usb_comm.h"
 #include <stdint.h>
 #include <stdio.h>
@@ -25,27 +27,37 @@ public:
 
     void setup();
 
+    // Parameters of this instance, to load them without the ground station
+    param_context_t* get_params() { return &_params; }
+
 private:
     HAL* _hal;
     DataBus _data_bus;
+    param_context_t _params;
+    mission_context_t _mission;
     AHRS _ahrs;
     PositionEstimator _position_estimator;
     AttitudeControl _att_control;
     PositionControl _position_control;
     Telem _telem;
     Storage _storage;
+    MissionStorage _mission_storage;
     Mixer _mixer;
     RCHandler _rc_handler;
     Commander _commander;
     Navigator _navigator;
     Sensors _sensors;
+    SensorLog _sensor_log;
     USBComm _usb_comm;
 
     // Scheduler
-    void main_task();
-    static void static_main_task() { _instance->main_task(); }
+    static constexpr bool IMU_SYNC = true;
 
-    static Autopilot* _instance;
+    void main_task();
+    void fast_task();
+    void update_main_modules();
+    static void static_main_task(void* context) { static_cast<Autopilot*>(context)->main_task(); }
+    static void static_fast_task(void* context) { static_cast<Autopilot*>(context)->fast_task(); }
 };
 
 #endif
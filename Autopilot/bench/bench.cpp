@@ -0,0 +1,64 @@
+#ifdef AUTOPILOT_BENCH
+
+#include "bench/bench.h"
+#include <stdio.h>
+
+Bench::Bench(Bench_platform* platform, Bench_format format, uint32_t scale, const char* filter)
+{
+	_platform = platform;
+	_format = format;
+	_scale = scale > 0 ? scale : 1;
+	_filter = filter;
+}
+
+void Bench::begin()
+{
+	char line[128];
+	const char* unit = _platform->get_tick_unit();
+
+	if (_format == BENCH_FORMAT_JSON)
+	{
+		snprintf(line, sizeof(line), "{\"unit\":\"%s\",\"results\":[\n", unit);
+	}
+	else
+	{
+		snprintf(line, sizeof(line), "name,iterations,%s_per_op,allocs_per_op\n", unit);
+	}
+
+	_platform->print(line);
+	_count = 0;
+}
+
+void Bench::end()
+{
+	if (_format == BENCH_FORMAT_JSON)
+	{
+		_platform->print("\n]}\n");
+	}
+}
+
+// Printed as doubles so newlib-nano on target does not need 64 bit integer
+// formatting, float printf is enabled there already
+void Bench::report(const char* name, uint32_t iterations, uint64_t ticks, uint32_t allocs)
+{
+	char line[192];
+	const double per_op = (double)ticks / iterations;
+	const double allocs_per_op = (double)allocs / iterations;
+
+	if (_format == BENCH_FORMAT_JSON)
+	{
+		snprintf(line, sizeof(line),
+				 "%s{\"name\":\"%s\",\"iterations\":%lu,\"per_op\":%.2f,\"allocs_per_op\":%.2f}",
+				 _count > 0 ? ",\n" : "", name, (unsigned long)iterations, per_op, allocs_per_op);
+	}
+	else
+	{
+		snprintf(line, sizeof(line), "%s,%lu,%.2f,%.2f\n",
+				 name, (unsigned long)iterations, per_op, allocs_per_op);
+	}
+
+	_platform->print(line);
+	_count++;
+}
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef BENCH_BENCH_H_
+#define BENCH_BENCH_H_
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Microbenchmarks of the flight libraries, shared by the host build and an
+ * on-target build. Only compiled with AUTOPILOT_BENCH defined, the flight
+ * firmware does not contain any of it.
+ *
+ * Allocations are counted by wrapping malloc, calloc and realloc at link
+ * time (-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc) and routing
+ * operator new through malloc, see bench_alloc.cpp.
+ */
+
+// Clock and output of the platform running the benchmarks
+class Bench_platform
+{
+public:
+	virtual ~Bench_platform() = default;
+
+	virtual uint64_t get_ticks() = 0;
+	virtual const char* get_tick_unit() = 0; // "ns" on the host, "cycles" on target
+	virtual void print(const char* str) = 0;
+};
+
+enum Bench_format
+{
+	BENCH_FORMAT_CSV,
+	BENCH_FORMAT_JSON
+};
+
+uint32_t bench_get_alloc_count();
+
+// Keeps the compiler from optimizing away a result that is never used
+template <typename T>
+inline void bench_keep(const T& value)
+{
+	__asm__ volatile("" : : "r"(&value) : "memory");
+}
+
+/**
+ * @brief Times one operation at a time and prints a row per benchmark
+ *
+ * Every benchmark runs a short warm up, then the loop is timed a few times
+ * and the fastest run is reported, which filters out preemption by the OS
+ * or interrupts. The operation is passed the loop index so inputs can vary
+ * between calls. Results are ticks and heap allocations per operation.
+ */
+class Bench
+{
+public:
+	Bench(Bench_platform* platform, Bench_format format, uint32_t scale = 1, const char* filter = nullptr);
+
+	void begin();
+	void end();
+
+	template <typename Op>
+	void run(const char* name, uint32_t iterations, Op op)
+	{
+		if (_filter && !strstr(name, _filter))
+		{
+			return;
+		}
+
+		iterations *= _scale;
+
+		for (uint32_t i = 0; i < iterations / 16 + 1; i++)
+		{
+			op(i);
+		}
+
+		uint64_t best_ticks = UINT64_MAX;
+		uint32_t allocs = 0;
+
+		for (uint8_t repeat = 0; repeat < REPEATS; repeat++)
+		{
+			const uint32_t start_allocs = bench_get_alloc_count();
+			const uint64_t start = _platform->get_ticks();
+
+			for (uint32_t i = 0; i < iterations; i++)
+			{
+				op(i);
+			}
+
+			const uint64_t ticks = _platform->get_ticks() - start;
+			allocs = bench_get_alloc_count() - start_allocs;
+
+			if (ticks < best_ticks)
+			{
+				best_ticks = ticks;
+			}
+		}
+
+		report(name, iterations, best_ticks, allocs);
+	}
+
+private:
+	static constexpr uint8_t REPEATS = 3;
+
+	Bench_platform* _platform;
+	Bench_format _format;
+	uint32_t _scale;
+	const char* _filter;
+	uint32_t _count = 0;
+
+	void report(const char* name, uint32_t iterations, uint64_t ticks, uint32_t allocs);
+};
+
+// lib_bench.cpp, one or more benchmarks for every library in Autopilot/lib
+void bench_run_libs(Bench* bench);
+
+#endif /* BENCH_BENCH_H_ */
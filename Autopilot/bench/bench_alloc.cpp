@@ -0,0 +1,81 @@
+#ifdef AUTOPILOT_BENCH
+
+#include "bench/bench.h"
+#include <new>
+#include <stdlib.h>
+
+// Counts every heap allocation made while benchmarking. The linker sends
+// calls to malloc, calloc and realloc here when wrapped. operator new goes
+// through malloc as well, since the one in a shared libstdc++ calls a
+// malloc the wrap does not reach.
+
+static volatile uint32_t alloc_count = 0;
+
+extern "C"
+{
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t num, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+	alloc_count = alloc_count + 1;
+	return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t num, size_t size)
+{
+	alloc_count = alloc_count + 1;
+	return __real_calloc(num, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+	alloc_count = alloc_count + 1;
+	return __real_realloc(ptr, size);
+}
+}
+
+uint32_t bench_get_alloc_count()
+{
+	return alloc_count;
+}
+
+void* operator new(size_t size)
+{
+	void* ptr = malloc(size);
+
+	if (!ptr)
+	{
+		abort();
+	}
+
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifdef AUTOPILOT_BENCH
+
+#include "bench/geo_double.h"
+#include <math.h>
+
+static constexpr double EARTH_RADIUS = 6378137.0;
+
+void geo_double_lat_lon_to_meters(double lat_ref, double lon_ref, double lat, double lon, double *north, double *east)
+{
+	const double d_lat = (lat - lat_ref) * M_PI / 180.0;
+	const double d_lon = (lon - lon_ref) * M_PI / 180.0;
+	const double mean_lat = (lat + lat_ref) / 2.0 * M_PI / 180.0;
+
+	*north = d_lat * EARTH_RADIUS;
+	*east = d_lon * EARTH_RADIUS * cos(mean_lat);
+}
+
+void geo_double_meters_to_lat_lon(double north, double east, double lat_ref, double lon_ref, double *lat, double *lon)
+{
+	const double lat_ref_rad = lat_ref * M_PI / 180.0;
+
+	*lat = lat_ref + (north / EARTH_RADIUS) * (180.0 / M_PI);
+	*lon = lon_ref + (east / (EARTH_RADIUS * cos(lat_ref_rad))) * (180.0 / M_PI);
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef BENCH_GEO_DOUBLE_H_
+#define BENCH_GEO_DOUBLE_H_
+
+/*
+ * The double precision geodesy lib/geo replaced, on degrees, kept as the
+ * reference for the float path. Benchmarked against it in lib_bench.cpp and
+ * checked against it by Host/Tests/geo_test.cpp. Not part of the firmware.
+ */
+
+void geo_double_lat_lon_to_meters(double lat_ref, double lon_ref, double lat, double lon, double *north, double *east);
+void geo_double_meters_to_lat_lon(double north, double east, double lat_ref, double lon_ref, double *lat, double *lon);
+
+#endif /* BENCH_GEO_DOUBLE_H_ */
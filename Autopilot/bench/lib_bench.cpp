@@ -0,0 +1,509 @@
+#ifdef AUTOPILOT_BENCH
+
+#include "bench/bench.h"
+#include "bench/geo_double.h"
+#include "lib/data_bus/data_bus.h"
+#include "lib/fastmath/fastmath.h"
+#include "lib/filters/biquad.h"
+#include "lib/filters/gyro_fft.h"
+#include "lib/geo/geo.h"
+#include "lib/geo/map_projection.h"
+#include "lib/kalman/kalman.h"
+#include "lib/l1_control/l1_control.h"
+#include "lib/madgwick/madgwick.h"
+#include "lib/mission/mission.h"
+#include "lib/moving_average/moving_avg.h"
+#include "lib/parameters/params.h"
+#include "lib/pi_control/pi_control.h"
+#include "lib/pi_control/pid_control.h"
+#include "lib/pwm/pwm_scaling.h"
+#include "lib/tecs/tecs.h"
+#include "lib/utils/utils.h"
+
+// Inputs are varied with the loop index so results are not constant folded
+// and branches see realistic patterns. Iteration counts are sized so every
+// benchmark takes a few milliseconds on target.
+
+static float wobble(uint32_t i)
+{
+	return (float)(i & 15) * 0.01f - 0.08f;
+}
+
+// Same shapes as the position estimator, 6 states and 3 inputs
+static void bench_kalman(Bench* bench)
+{
+	const float dt = 0.002f;
+	const float half_dt2 = 0.5f * dt * dt;
+
+	Eigen::MatrixXf A = Eigen::MatrixXf::Identity(6, 6);
+	A(0, 3) = dt;
+	A(1, 4) = dt;
+	A(2, 5) = dt;
+
+	Eigen::MatrixXf B = Eigen::MatrixXf::Zero(6, 3);
+	B(0, 0) = half_dt2;
+	B(1, 1) = half_dt2;
+	B(2, 2) = half_dt2;
+	B(3, 0) = dt;
+	B(4, 1) = dt;
+	B(5, 2) = dt;
+
+	const Eigen::MatrixXf Q = Eigen::MatrixXf::Identity(6, 6);
+	Eigen::MatrixXf u(3, 1);
+	u << 0.1f, -0.2f, 0.05f;
+
+	Kalman predict_filter(6, 3);
+	bench->run("kalman_predict", 2000, [&](uint32_t i)
+	{
+		u(0, 0) = wobble(i);
+		predict_filter.predict(u, A, B, Q);
+	});
+
+	Eigen::MatrixXf H = Eigen::MatrixXf::Zero(2, 6);
+	H(0, 0) = 1;
+	H(1, 1) = 1;
+	const Eigen::MatrixXf R = Eigen::MatrixXf::Identity(2, 2) * 4.0f;
+	Eigen::MatrixXf y(2, 1);
+
+	Kalman update_filter(6, 3);
+	update_filter.predict(u, A, B, Q);
+	bench->run("kalman_update", 2000, [&](uint32_t i)
+	{
+		y << wobble(i), -wobble(i);
+		update_filter.update(R, H, y);
+	});
+}
+
+static void bench_madgwick(Bench* bench)
+{
+	Madgwick filter;
+	filter.set_beta(0.1f);
+	filter.set_dt(0.002f);
+
+	bench->run("madgwick_update", 20000, [&](uint32_t i)
+	{
+		filter.update(wobble(i), 0.02f, -0.01f, 0.01f, wobble(i), -1.0f, -20.0f, 0.5f, -45.0f);
+	});
+
+	bench->run("madgwick_update_imu", 20000, [&](uint32_t i)
+	{
+		filter.updateIMU(wobble(i), 0.02f, -0.01f, 0.01f, wobble(i), -1.0f);
+	});
+
+	bench->run("madgwick_update_gyro", 20000, [&](uint32_t i)
+	{
+		filter.updateGyro(wobble(i), 0.02f, -0.01f);
+	});
+
+	// Per batch of 8 samples, as the AHRS drains the IMU FIFO
+	MadgwickSample samples[8];
+	for (uint8_t j = 0; j < 8; j++)
+	{
+		samples[j] = {wobble(j), 0.02f, -0.01f, 0.01f, wobble(j), -1.0f, -20.0f, 0.5f, -45.0f, 0.00025f};
+	}
+
+	bench->run("madgwick_update_batch8", 4000, [&](uint32_t i)
+	{
+		samples[i & 7].gx = wobble(i);
+		filter.updateBatch(samples, 8);
+	});
+
+	bench->run("madgwick_get_euler", 20000, [&](uint32_t i)
+	{
+		filter.updateGyro(wobble(i), 0, 0);
+		const float yaw = filter.getRoll() + filter.getPitch() + filter.getYaw();
+		bench_keep(yaw);
+	});
+}
+
+static void bench_tecs(Bench* bench)
+{
+	TECS tecs;
+	tecs.set_param({12.0f, 25.0f, 1.0f, -20.0f, 20.0f, 0.1f, 0.01f, 0.0f, 1.0f, 0.5f, 0.1f, 0.01f});
+
+	bench->run("tecs_update", 20000, [&](uint32_t i)
+	{
+		tecs.update(100.0f + wobble(i), 18.0f - wobble(i), 110.0f, 18.0f, 0.01f);
+		const float pitch = tecs.get_pitch_setpoint();
+		bench_keep(pitch);
+	});
+}
+
+static void bench_l1_control(Bench* bench)
+{
+	L1Control l1;
+	l1.set_l1_period(20.0f);
+	l1.set_l1_damping(0.75f);
+	l1.set_roll_limit(35.0f);
+
+	bench->run("l1_navigate_waypoints", 20000, [&](uint32_t i)
+	{
+		l1.navigate_waypoints(10.0f + wobble(i), -5.0f, 15.0f, 3.0f, 15.3f,
+							  400.0f, 0.0f, 1.0f, 0.0f, 0.0f);
+		const float roll = l1.get_roll_setpoint();
+		bench_keep(roll);
+	});
+
+	bench->run("l1_navigate_loiter", 20000, [&](uint32_t i)
+	{
+		l1.navigate_loiter(120.0f + wobble(i), 30.0f, 2.0f, 15.0f, 15.1f,
+						   0.0f, 0.0f, 100.0f, 1);
+		const float roll = l1.get_roll_setpoint();
+		bench_keep(roll);
+	});
+}
+
+static void bench_pi_control(Bench* bench)
+{
+	PI_control pi;
+	bench->run("pi_control_get_output", 50000, [&](uint32_t i)
+	{
+		const float out = pi.get_output(wobble(i), 0.1f, 0.5f, 0.1f, 0.2f, -1.0f, 1.0f, 0.0f, 0.002f);
+		bench_keep(out);
+	});
+
+	PID_control pid;
+	bench->run("pid_control_get_output", 50000, [&](uint32_t i)
+	{
+		const float out = pid.get_output(wobble(i), 0.1f, 0.5f, 0.1f, 0.01f, 0.2f, 0.2f,
+										 -1.0f, 1.0f, 0.0f, 20.0f, 30.0f, 0.002f);
+		bench_keep(out);
+	});
+}
+
+static void bench_aplink(Bench* bench)
+{
+	uint8_t payload[32];
+	for (uint8_t j = 0; j < sizeof(payload); j++)
+	{
+		payload[j] = j * 7;
+	}
+
+	uint8_t packet[MAX_PACKET_LEN];
+
+	bench->run("aplink_crc16_32b", 20000, [&](uint32_t i)
+	{
+		payload[0] = (uint8_t)i;
+		const uint16_t crc = aplink_crc16(payload, sizeof(payload));
+		bench_keep(crc);
+	});
+
+	bench->run("aplink_pack_32b", 20000, [&](uint32_t i)
+	{
+		payload[0] = (uint8_t)i;
+		const uint16_t len = aplink_pack(packet, payload, sizeof(payload), 1);
+		bench_keep(len);
+	});
+
+	// Per byte of a valid packet, so the CRC check on the last byte is spread out
+	const uint16_t packet_len = aplink_pack(packet, payload, sizeof(payload), 1);
+	aplink_msg_t msg = {};
+	bench->run("aplink_parse_byte", 200000, [&](uint32_t i)
+	{
+		const bool done = aplink_parse_byte(&msg, packet[i % packet_len]);
+		bench_keep(done);
+	});
+}
+
+static void bench_geo(Bench* bench)
+{
+	const int32_t lat_ref = 437794390;
+	const int32_t lon_ref = -794030930;
+
+	bench->run("geo_lat_lon_to_meters", 50000, [&](uint32_t i)
+	{
+		float north, east;
+		lat_lon_to_meters(lat_ref, lon_ref, lat_ref + (int32_t)(i & 1023) * 100, lon_ref - 5000, &north, &east);
+		bench_keep(north);
+		bench_keep(east);
+	});
+
+	bench->run("geo_meters_to_lat_lon", 50000, [&](uint32_t i)
+	{
+		int32_t lat, lon;
+		meters_to_lat_lon(100.0f + wobble(i), -50.0f, lat_ref, lon_ref, &lat, &lon);
+		bench_keep(lat);
+		bench_keep(lon);
+	});
+
+	// The double path lib/geo replaced, soft float on the board
+	const double lat_ref_deg = lat_ref * 1E-7;
+	const double lon_ref_deg = lon_ref * 1E-7;
+
+	bench->run("geo_double_lat_lon_to_meters", 50000, [&](uint32_t i)
+	{
+		double north, east;
+		geo_double_lat_lon_to_meters(lat_ref_deg, lon_ref_deg, lat_ref_deg + (i & 1023) * 1E-5, lon_ref_deg - 5E-4, &north, &east);
+		bench_keep(north);
+		bench_keep(east);
+	});
+
+	bench->run("geo_double_meters_to_lat_lon", 50000, [&](uint32_t i)
+	{
+		double lat, lon;
+		geo_double_meters_to_lat_lon(100.0 + wobble(i), -50.0, lat_ref_deg, lon_ref_deg, &lat, &lon);
+		bench_keep(lat);
+		bench_keep(lon);
+	});
+
+	MapProjection projection;
+	projection.init(lat_ref, lon_ref);
+	bench->run("map_projection_project", 50000, [&](uint32_t i)
+	{
+		float north, east;
+		projection.project(lat_ref + (int32_t)(i & 1023) * 100, lon_ref - 5000, &north, &east);
+		bench_keep(north);
+		bench_keep(east);
+	});
+}
+
+static void bench_moving_average(Bench* bench)
+{
+	float buffer[10];
+	MovingAverage average(10, buffer);
+
+	bench->run("moving_average_add", 100000, [&](uint32_t i)
+	{
+		average.add(wobble(i));
+		const float value = average.getAverage();
+		bench_keep(value);
+	});
+}
+
+static void bench_params(Bench* bench)
+{
+	static param_context_t params;
+	param_init(&params);
+	param_set_float(&params, param_find(&params, "ATT_PR_KP"), 0.5f);
+
+	// First and last entries bound the linear search
+	bench->run("param_find_first", 20000, [&](uint32_t)
+	{
+		const param_t param = param_find(&params, "TKO_ALT");
+		bench_keep(param);
+	});
+
+	bench->run("param_find_last", 2000, [&](uint32_t)
+	{
+		const param_t param = param_find(&params, params.table[PARAM_COUNT - 1].name);
+		bench_keep(param);
+	});
+
+	const param_t handle = param_find(&params, "ATT_PR_KP");
+	bench->run("param_get", 100000, [&](uint32_t)
+	{
+		float value;
+		param_get(&params, handle, &value);
+		bench_keep(value);
+	});
+}
+
+static void bench_data_bus(Bench* bench)
+{
+	static DataBus data_bus;
+	Publisher<IMU_data> imu_pub(data_bus.imu_node);
+	Subscriber<IMU_data> imu_sub(data_bus.imu_node);
+	IMU_data imu;
+
+	bench->run("node_publish", 100000, [&](uint32_t i)
+	{
+		imu.gx = wobble(i);
+		imu.timestamp = i + 1;
+		imu_pub.publish(imu);
+	});
+
+	bench->run("node_check_get", 100000, [&](uint32_t)
+	{
+		imu.timestamp++;
+		imu_pub.publish(imu);
+
+		if (imu_sub.check_new())
+		{
+			const IMU_data data = imu_sub.get();
+			bench_keep(data);
+		}
+	});
+}
+
+static void bench_filters(Bench* bench)
+{
+	Biquad3 lowpass;
+	lowpass.set_coeffs(biquad_lowpass(4000.0f, 80.0f));
+	float x[3] = {};
+
+	bench->run("biquad3_apply", 100000, [&](uint32_t i)
+	{
+		x[0] = wobble(i);
+		lowpass.apply(x);
+	});
+
+	// Averaged over the FFT and peak search steps
+	static Gyro_fft fft;
+	fft.set_range(30.0f, 400.0f);
+	bench->run("gyro_fft_update", 20000, [&](uint32_t i)
+	{
+		const float gyr[3] = {wobble(i), -wobble(i * 3), wobble(i * 5)};
+		const bool updated = fft.update(gyr, 1000.0f);
+		bench_keep(updated);
+	});
+}
+
+static void bench_pwm(Bench* bench)
+{
+	Pwm_scaling scaling;
+	scaling.set(-1.0f, 1.0f, 1000.0f, 2000.0f, false);
+
+	bench->run("pwm_scaling_apply", 100000, [&](uint32_t i)
+	{
+		const uint16_t pwm = scaling.apply(wobble(i) * 10.0f);
+		bench_keep(pwm);
+	});
+}
+
+static void bench_mission(Bench* bench)
+{
+	mission_data_t header = {};
+	header.magic = MISSION_FILE_MAGIC;
+	header.format_version = MISSION_FORMAT_VERSION;
+
+	bench->run("mission_check_header", 20000, [&](uint32_t i)
+	{
+		header.num_items = (uint16_t)i;
+		const bool valid = mission_check_header(&header);
+		bench_keep(valid);
+	});
+}
+
+// Each fastmath kernel next to the libm call it replaces, on inputs from
+// the domains in fastmath.h. Accuracy is checked by Host/Tests/fastmath_test.cpp.
+static void bench_math(Bench* bench)
+{
+	bench->run("fast_sinf", 100000, [&](uint32_t i)
+	{
+		const float y = fast_sinf(wobble(i) * 100.0f);
+		bench_keep(y);
+	});
+
+	bench->run("libm_sinf", 100000, [&](uint32_t i)
+	{
+		const float y = sinf(wobble(i) * 100.0f);
+		bench_keep(y);
+	});
+
+	bench->run("fast_cosf", 100000, [&](uint32_t i)
+	{
+		const float y = fast_cosf(wobble(i) * 100.0f);
+		bench_keep(y);
+	});
+
+	bench->run("libm_cosf", 100000, [&](uint32_t i)
+	{
+		const float y = cosf(wobble(i) * 100.0f);
+		bench_keep(y);
+	});
+
+	bench->run("fast_atan2f", 100000, [&](uint32_t i)
+	{
+		const float y = fast_atan2f(wobble(i), 0.3f);
+		bench_keep(y);
+	});
+
+	bench->run("libm_atan2f", 100000, [&](uint32_t i)
+	{
+		const float y = atan2f(wobble(i), 0.3f);
+		bench_keep(y);
+	});
+
+	bench->run("fast_asinf", 100000, [&](uint32_t i)
+	{
+		const float y = fast_asinf(wobble(i) * 10.0f);
+		bench_keep(y);
+	});
+
+	bench->run("libm_asinf", 100000, [&](uint32_t i)
+	{
+		const float y = asinf(wobble(i) * 10.0f);
+		bench_keep(y);
+	});
+
+	bench->run("fast_sqrtf", 100000, [&](uint32_t i)
+	{
+		const float y = fast_sqrtf(1.0f + wobble(i));
+		bench_keep(y);
+	});
+
+	bench->run("libm_sqrtf", 100000, [&](uint32_t i)
+	{
+		const float y = sqrtf(1.0f + wobble(i));
+		bench_keep(y);
+	});
+
+	bench->run("fast_expf", 100000, [&](uint32_t i)
+	{
+		const float y = fast_expf(wobble(i) * 100.0f);
+		bench_keep(y);
+	});
+
+	bench->run("libm_expf", 100000, [&](uint32_t i)
+	{
+		const float y = expf(wobble(i) * 100.0f);
+		bench_keep(y);
+	});
+
+	bench->run("fast_logf", 100000, [&](uint32_t i)
+	{
+		const float y = fast_logf(1.0f + wobble(i) * 10.0f);
+		bench_keep(y);
+	});
+
+	bench->run("libm_logf", 100000, [&](uint32_t i)
+	{
+		const float y = logf(1.0f + wobble(i) * 10.0f);
+		bench_keep(y);
+	});
+
+	// Barometric altitude, barometer.c used the double pow before fast_powf
+	bench->run("fast_powf", 100000, [&](uint32_t i)
+	{
+		const float y = fast_powf(0.9f + wobble(i), 1.0f / 5.255f);
+		bench_keep(y);
+	});
+
+	bench->run("libm_powf", 100000, [&](uint32_t i)
+	{
+		const float y = powf(0.9f + wobble(i), 1.0f / 5.255f);
+		bench_keep(y);
+	});
+
+	bench->run("libm_pow_double", 100000, [&](uint32_t i)
+	{
+		const float y = pow(0.9 + wobble(i), 1.0 / 5.255);
+		bench_keep(y);
+	});
+
+	bench->run("utils_wrap_pi", 100000, [&](uint32_t i)
+	{
+		const float y = wrap_pi(wobble(i) * 1000.0f);
+		bench_keep(y);
+	});
+}
+
+void bench_run_libs(Bench* bench)
+{
+	bench_kalman(bench);
+	bench_madgwick(bench);
+	bench_tecs(bench);
+	bench_l1_control(bench);
+	bench_pi_control(bench);
+	bench_aplink(bench);
+	bench_geo(bench);
+	bench_moving_average(bench);
+	bench_params(bench);
+	bench_data_bus(bench);
+	bench_filters(bench);
+	bench_pwm(bench);
+	bench_mission(bench);
+	bench_math(bench);
+}
+
+#endif
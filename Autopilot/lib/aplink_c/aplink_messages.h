@@ -777,5 +777,553 @@ inline bool aplink_flight_log_unpack(aplink_msg_t* msg, aplink_flight_log_t* out
     return false;
 }
 
+#define HITL_STEP_MSG_ID 18
+
+#pragma pack(push, 1)
+typedef struct aplink_hitl_step
+{
+
+
+    uint32_t sequence;
+
+
+
+    uint64_t time_us;
+
+
+
+    float imu_ax;
+
+
+
+    float imu_ay;
+
+
+
+    float imu_az;
+
+
+
+    float imu_gx;
+
+
+
+    float imu_gy;
+
+
+
+    float imu_gz;
+
+
+
+    float mag_x;
+
+
+
+    float mag_y;
+
+
+
+    float mag_z;
+
+
+
+    float baro_asl;
+
+
+
+    int32_t gps_lat;
+
+
+
+    int32_t gps_lon;
+
+
+
+    int16_t of_x;
+
+
+
+    int16_t of_y;
+
+
+} aplink_hitl_step_t;
+#pragma pack(pop)
+
+inline uint16_t aplink_hitl_step_pack(aplink_hitl_step_t data, uint8_t packet[]) {
+    uint8_t buffer[sizeof(data)];
+    memcpy(buffer, &data, sizeof(data));
+    return aplink_pack(packet, buffer, sizeof(buffer), HITL_STEP_MSG_ID);
+}
+                    
+inline bool aplink_hitl_step_unpack(aplink_msg_t* msg, aplink_hitl_step_t* output) {
+    if (msg->payload_len == sizeof(aplink_hitl_step_t)) {
+        memcpy(output, msg->payload, sizeof(aplink_hitl_step_t));
+        return true;
+    }
+    return false;
+}
+
+#define HITL_STEP_OUTPUT_MSG_ID 19
+
+#pragma pack(push, 1)
+typedef struct aplink_hitl_step_output
+{
+
+
+    uint32_t sequence;
+
+
+
+    uint64_t time_us;
+
+
+
+    uint16_t rud_pwm;
+
+
+
+    uint16_t ele_pwm;
+
+
+
+    uint16_t thr_pwm;
+
+
+} aplink_hitl_step_output_t;
+#pragma pack(pop)
+
+inline uint16_t aplink_hitl_step_output_pack(aplink_hitl_step_output_t data, uint8_t packet[]) {
+    uint8_t buffer[sizeof(data)];
+    memcpy(buffer, &data, sizeof(data));
+    return aplink_pack(packet, buffer, sizeof(buffer), HITL_STEP_OUTPUT_MSG_ID);
+}
+                    
+inline bool aplink_hitl_step_output_unpack(aplink_msg_t* msg, aplink_hitl_step_output_t* output) {
+    if (msg->payload_len == sizeof(aplink_hitl_step_output_t)) {
+        memcpy(output, msg->payload, sizeof(aplink_hitl_step_output_t));
+        return true;
+    }
+    return false;
+}
+
+#define LOG_IMU_MSG_ID 20
+
+#pragma pack(push, 1)
+typedef struct aplink_log_imu
+{
+
+
+    uint64_t time_us;
+
+
+
+    float gx;
+
+
+
+    float gy;
+
+
+
+    float gz;
+
+
+
+    float ax;
+
+
+
+    float ay;
+
+
+
+    float az;
+
+
+} aplink_log_imu_t;
+#pragma pack(pop)
+
+inline uint16_t aplink_log_imu_pack(aplink_log_imu_t data, uint8_t packet[]) {
+    uint8_t buffer[sizeof(data)];
+    memcpy(buffer, &data, sizeof(data));
+    return aplink_pack(packet, buffer, sizeof(buffer), LOG_IMU_MSG_ID);
+}
+                    
+inline bool aplink_log_imu_unpack(aplink_msg_t* msg, aplink_log_imu_t* output) {
+    if (msg->payload_len == sizeof(aplink_log_imu_t)) {
+        memcpy(output, msg->payload, sizeof(aplink_log_imu_t));
+        return true;
+    }
+    return false;
+}
+
+#define LOG_MAG_MSG_ID 21
+
+#pragma pack(push, 1)
+typedef struct aplink_log_mag
+{
+
+
+    uint64_t time_us;
+
+
+
+    float x;
+
+
+
+    float y;
+
+
+
+    float z;
+
+
+} aplink_log_mag_t;
+#pragma pack(pop)
+
+inline uint16_t aplink_log_mag_pack(aplink_log_mag_t data, uint8_t packet[]) {
+    uint8_t buffer[sizeof(data)];
+    memcpy(buffer, &data, sizeof(data));
+    return aplink_pack(packet, buffer, sizeof(buffer), LOG_MAG_MSG_ID);
+}
+                    
+inline bool aplink_log_mag_unpack(aplink_msg_t* msg, aplink_log_mag_t* output) {
+    if (msg->payload_len == sizeof(aplink_log_mag_t)) {
+        memcpy(output, msg->payload, sizeof(aplink_log_mag_t));
+        return true;
+    }
+    return false;
+}
+
+#define LOG_BARO_MSG_ID 22
+
+#pragma pack(push, 1)
+typedef struct aplink_log_baro
+{
+
+
+    uint64_t time_us;
+
+
+
+    float alt;
+
+
+
+    float pressure;
+
+
+
+    float temperature;
+
+
+} aplink_log_baro_t;
+#pragma pack(pop)
+
+inline uint16_t aplink_log_baro_pack(aplink_log_baro_t data, uint8_t packet[]) {
+    uint8_t buffer[sizeof(data)];
+    memcpy(buffer, &data, sizeof(data));
+    return aplink_pack(packet, buffer, sizeof(buffer), LOG_BARO_MSG_ID);
+}
+                    
+inline bool aplink_log_baro_unpack(aplink_msg_t* msg, aplink_log_baro_t* output) {
+    if (msg->payload_len == sizeof(aplink_log_baro_t)) {
+        memcpy(output, msg->payload, sizeof(aplink_log_baro_t));
+        return true;
+    }
+    return false;
+}
+
+#define LOG_GNSS_MSG_ID 23
+
+#pragma pack(push, 1)
+typedef struct aplink_log_gnss
+{
+
+
+    uint64_t time_us;
+
+
+
+    int32_t lat;
+
+
+
+    int32_t lon;
+
+
+
+    float asl;
+
+
+
+    float vel_n;
+
+
+
+    float vel_e;
+
+
+
+    float vel_d;
+
+
+
+    float h_acc;
+
+
+
+    float v_acc;
+
+
+
+    float s_acc;
+
+
+
+    uint8_t sats;
+
+
+
+    uint8_t fix;
+
+
+
+    uint16_t year;
+
+
+
+    uint8_t month;
+
+
+
+    uint8_t day;
+
+
+
+    uint8_t hours;
+
+
+
+    uint8_t minutes;
+
+
+
+    uint8_t seconds;
+
+
+} aplink_log_gnss_t;
+#pragma pack(pop)
+
+inline uint16_t aplink_log_gnss_pack(aplink_log_gnss_t data, uint8_t packet[]) {
+    uint8_t buffer[sizeof(data)];
+    memcpy(buffer, &data, sizeof(data));
+    return aplink_pack(packet, buffer, sizeof(buffer), LOG_GNSS_MSG_ID);
+}
+                    
+inline bool aplink_log_gnss_unpack(aplink_msg_t* msg, aplink_log_gnss_t* output) {
+    if (msg->payload_len == sizeof(aplink_log_gnss_t)) {
+        memcpy(output, msg->payload, sizeof(aplink_log_gnss_t));
+        return true;
+    }
+    return false;
+}
+
+#define LOG_OF_MSG_ID 24
+
+#pragma pack(push, 1)
+typedef struct aplink_log_of
+{
+
+
+    uint64_t time_us;
+
+
+
+    int16_t x;
+
+
+
+    int16_t y;
+
+
+} aplink_log_of_t;
+#pragma pack(pop)
+
+inline uint16_t aplink_log_of_pack(aplink_log_of_t data, uint8_t packet[]) {
+    uint8_t buffer[sizeof(data)];
+    memcpy(buffer, &data, sizeof(data));
+    return aplink_pack(packet, buffer, sizeof(buffer), LOG_OF_MSG_ID);
+}
+                    
+inline bool aplink_log_of_unpack(aplink_msg_t* msg, aplink_log_of_t* output) {
+    if (msg->payload_len == sizeof(aplink_log_of_t)) {
+        memcpy(output, msg->payload, sizeof(aplink_log_of_t));
+        return true;
+    }
+    return false;
+}
+
+#define LOG_TICK_MSG_ID 25
+
+#pragma pack(push, 1)
+typedef struct aplink_log_tick
+{
+
+
+    uint64_t time_us;
+
+
+
+    uint8_t system_mode;
+
+
+
+    uint8_t flight_mode;
+
+
+
+    uint8_t auto_mode;
+
+
+
+    uint8_t manual_mode;
+
+
+
+    uint32_t dropped_bytes;
+
+
+} aplink_log_tick_t;
+#pragma pack(pop)
+
+inline uint16_t aplink_log_tick_pack(aplink_log_tick_t data, uint8_t packet[]) {
+    uint8_t buffer[sizeof(data)];
+    memcpy(buffer, &data, sizeof(data));
+    return aplink_pack(packet, buffer, sizeof(buffer), LOG_TICK_MSG_ID);
+}
+                    
+inline bool aplink_log_tick_unpack(aplink_msg_t* msg, aplink_log_tick_t* output) {
+    if (msg->payload_len == sizeof(aplink_log_tick_t)) {
+        memcpy(output, msg->payload, sizeof(aplink_log_tick_t));
+        return true;
+    }
+    return false;
+}
+
+#define WAYPOINTS_COUNT_V2_MSG_ID 26
+
+#pragma pack(push, 1)
+typedef struct aplink_waypoints_count_v2
+{
+
+
+    uint16_t num_waypoints;
+
+
+
+    uint8_t type;
+
+
+
+    float radius;
+
+
+
+    uint8_t direction;
+
+
+
+    float final_leg;
+
+
+
+    float glideslope;
+
+
+
+    float runway_heading;
+
+
+} aplink_waypoints_count_v2_t;
+#pragma pack(pop)
+
+inline uint16_t aplink_waypoints_count_v2_pack(aplink_waypoints_count_v2_t data, uint8_t packet[]) {
+    uint8_t buffer[sizeof(data)];
+    memcpy(buffer, &data, sizeof(data));
+    return aplink_pack(packet, buffer, sizeof(buffer), WAYPOINTS_COUNT_V2_MSG_ID);
+}
+                    
+inline bool aplink_waypoints_count_v2_unpack(aplink_msg_t* msg, aplink_waypoints_count_v2_t* output) {
+    if (msg->payload_len == sizeof(aplink_waypoints_count_v2_t)) {
+        memcpy(output, msg->payload, sizeof(aplink_waypoints_count_v2_t));
+        return true;
+    }
+    return false;
+}
+
+#define REQUEST_WAYPOINT_V2_MSG_ID 27
+
+#pragma pack(push, 1)
+typedef struct aplink_request_waypoint_v2
+{
+
+
+    uint16_t index;
+
+
+} aplink_request_waypoint_v2_t;
+#pragma pack(pop)
+
+inline uint16_t aplink_request_waypoint_v2_pack(aplink_request_waypoint_v2_t data, uint8_t packet[]) {
+    uint8_t buffer[sizeof(data)];
+    memcpy(buffer, &data, sizeof(data));
+    return aplink_pack(packet, buffer, sizeof(buffer), REQUEST_WAYPOINT_V2_MSG_ID);
+}
+                    
+inline bool aplink_request_waypoint_v2_unpack(aplink_msg_t* msg, aplink_request_waypoint_v2_t* output) {
+    if (msg->payload_len == sizeof(aplink_request_waypoint_v2_t)) {
+        memcpy(output, msg->payload, sizeof(aplink_request_waypoint_v2_t));
+        return true;
+    }
+    return false;
+}
+
+#define MISSION_ITEM_V2_MSG_ID 28
+
+#pragma pack(push, 1)
+typedef struct aplink_mission_item_v2
+{
+
+
+    int32_t lat;
+
+
+
+    int32_t lon;
+
+
+
+    int16_t alt;
+
+
+} aplink_mission_item_v2_t;
+#pragma pack(pop)
+
+inline uint16_t aplink_mission_item_v2_pack(aplink_mission_item_v2_t data, uint8_t packet[]) {
+    uint8_t buffer[sizeof(data)];
+    memcpy(buffer, &data, sizeof(data));
+    return aplink_pack(packet, buffer, sizeof(buffer), MISSION_ITEM_V2_MSG_ID);
+}
+                    
+inline bool aplink_mission_item_v2_unpack(aplink_msg_t* msg, aplink_mission_item_v2_t* output) {
+    if (msg->payload_len == sizeof(aplink_mission_item_v2_t)) {
+        memcpy(output, msg->payload, sizeof(aplink_mission_item_v2_t));
+        return true;
+    }
+    return false;
+}
 
 #endif /* APLINK_MESSAGES_H_ */
@@ -26,11 +26,13 @@ struct DataBus
    	Node<Ctrl_cmd_data> ctrl_cmd_node;
    	Node<RC_data> rc_node;
    	Node<waypoint_s> waypoint_node;
+   	Node<landing_s> landing_node;
    	Node<hitl_sensors_s> hitl_sensors_node;
    	Node<HITL_output_data> hitl_output_node;
    	Node<position_control_s> position_control_node;
    	Node<uncalibrated_imu_s> uncalibrated_imu_node;
    	Node<uncalibrated_mag_s> uncalibrated_mag_node;
+   	Node<gyro_fft_s> gyro_fft_node;
 };
 
 #endif /* LIB_DATA_BUS_DATA_BUS_H_ */
@@ -59,22 +59,30 @@ struct Mag_data
 struct Baro_data
 {
 	float alt = 0;
+	float pressure = 0; // Pa
+	float temperature = 0; // C
 	uint64_t timestamp = 0;
 };
 
 struct GNSS_data
 {
-	double lat = 0;
-	double lon = 0;
+	int32_t lat = 0; // Latitude (deg * 1E7)
+	int32_t lon = 0; // Longitude (deg * 1E7)
 	float asl = 0;
+	float vel_n = 0; // North velocity (m/s)
+	float vel_e = 0; // East velocity (m/s)
+	float vel_d = 0; // Down velocity (m/s)
+	float h_acc = 0; // Horizontal position accuracy (m)
+	float v_acc = 0; // Vertical position accuracy (m)
+	float s_acc = 0; // Speed accuracy (m/s), 0 if velocity is not available
 	uint8_t sats = 0;
 	bool fix = false;
-	int year;
-	int month;
-	int day;
-	int hours;
-	int minutes;
-	int seconds;
+	int year = 0; // UTC
+	int month = 0;
+	int day = 0;
+	int hours = 0;
+	int minutes = 0;
+	int seconds = 0;
 	uint64_t timestamp = 0;
 };
 
@@ -84,6 +92,16 @@ struct AHRS_data
 	float roll = 0;
 	float pitch = 0;
 	float yaw = 0;
+	float q[4] = {1, 0, 0, 0}; // Body to NED quaternion (w, x, y, z), declination applied
+	float dcm[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}; // Body to NED rotation matrix, row major
+	uint64_t timestamp = 0;
+};
+
+struct gyro_fft_s
+{
+	float peak_freq[2] = {}; // Vibration peaks, 0 if none (Hz)
+	float peak_snr[2] = {}; // Peak power over the noise floor
+	uint32_t cycles_max = 0; // Worst case analysis step (CPU cycles)
 	uint64_t timestamp = 0;
 };
 
@@ -114,8 +132,8 @@ struct local_position_s
 	// Position of reference point (local NED frame origin) in global (GPS / WGS84) frame
 	bool ref_xy_set = false; // true if position (x, y) has a valid global reference (ref_lat, ref_lon)
 	bool ref_z_set = false; // true if z has a valid global reference (ref_alt)
-	double ref_lat;
-	double ref_lon;
+	int32_t ref_lat; // Reference latitude (deg * 1E7)
+	int32_t ref_lon; // Reference longitude (deg * 1E7)
 	float ref_alt; // Reference altitude ASL
 
 	bool converged = false;
@@ -183,8 +201,34 @@ struct waypoint_s
 	float previous_east = 0;
 	float current_north = 0;
 	float current_east = 0;
-	uint8_t current_index = 0;
-	uint8_t num_waypoints = 0;
+	float unit_north = 1; // Unit vector from previous to current waypoint
+	float unit_east = 0;
+	float length = 0; // Distance from previous to current waypoint (meters)
+	float bearing = 0; // Bearing from previous to current waypoint (radians)
+	float current_alt = 0; // Altitude of the current waypoint above home (meters)
+	uint16_t current_index = 0;
+	uint16_t num_waypoints = 0;
+	uint64_t timestamp = 0;
+};
+
+// Landing pattern in local NED, computed once per mission by the navigator
+struct landing_s
+{
+	float touchdown_north = 0;
+	float touchdown_east = 0;
+	float glideslope_start_north = 0;
+	float glideslope_start_east = 0;
+	float approach_unit_north = 1; // Unit vector from glideslope start to touchdown
+	float approach_unit_east = 0;
+	float approach_bearing = 0; // Bearing from glideslope start to touchdown (radians)
+	float runway_heading = 0; // Degrees
+	float loiter_north = 0;
+	float loiter_east = 0;
+	float loiter_radius = 0;
+	float loiter_alt = 0; // Height above touchdown at the glideslope start
+	float tan_glideslope = 0;
+	float sin_glideslope = 0;
+	int8_t loiter_direction = 1; // 1 is right, -1 is left
 	uint64_t timestamp = 0;
 };
 
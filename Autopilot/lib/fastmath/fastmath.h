@@ -0,0 +1,196 @@
+#ifndef LIB_FASTMATH_FASTMATH_H_
+#define LIB_FASTMATH_FASTMATH_H_
+
+/*
+ * Single precision math kernels for the control loop.
+ *
+ * The Cortex-M4F FPU only has add, multiply, divide and sqrt, so every libm
+ * call is a branchy library routine (and anything touching double is soft
+ * float). These are short polynomial approximations that stay entirely in
+ * FPU registers. Errors are the worst case measured against double libm
+ * over the stated domain:
+ *
+ *   fast_sinf, fast_cosf   |x| <= 2 pi              abs err 2.8e-7
+ *                          |x| <= 100 rad           abs err 8.6e-6 (float range reduction)
+ *   fast_atan2f            all finite y, x          abs err 5.3e-7 rad
+ *   fast_asinf             [-1, 1]                  abs err 3.0e-7 rad
+ *   fast_sqrtf             x >= 0                   correctly rounded (vsqrt)
+ *   fast_expf              [-10, 10]                rel err 6.8e-7
+ *                          [-80, 80]                rel err 3.9e-6
+ *   fast_logf              [1e-3, 10]               abs err 6.0e-7
+ *                          positive normals         rel err 3.1e-7
+ *   fast_powf              x in [0.3, 1.2], y = 0.19  rel err 1.8e-7 (barometric altitude)
+ *
+ * Host/Tests/fastmath_test.cpp checks these bounds.
+ *
+ * No errno, no NaN/inf handling beyond what falls out of the arithmetic.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FASTMATH_PI      3.14159265358979f
+#define FASTMATH_PI_2    1.57079632679490f
+#define FASTMATH_2PI     6.28318530717959f
+#define FASTMATH_1_2PI   0.159154943091895f
+#define FASTMATH_LN2     0.693147180559945f
+#define FASTMATH_LOG2E   1.44269504088896f
+
+// Round to nearest integer without going through libm
+static inline float fast_roundf(float x)
+{
+	return (float)(int32_t)(x + (x >= 0.0f ? 0.5f : -0.5f));
+}
+
+static inline float fast_sqrtf(float x)
+{
+#if defined(__ARM_FP) && (__ARM_FP & 4)
+	float result;
+	__asm__ ("vsqrt.f32 %0, %1" : "=t"(result) : "t"(x));
+	return result;
+#else
+	return sqrtf(x);
+#endif
+}
+
+static inline float fast_sinf(float x)
+{
+	// Reduce to [-pi, pi] then fold to [-pi/2, pi/2] with sin(pi - x) = sin(x)
+	x -= FASTMATH_2PI * fast_roundf(x * FASTMATH_1_2PI);
+
+	if (x > FASTMATH_PI_2)
+	{
+		x = FASTMATH_PI - x;
+	}
+	else if (x < -FASTMATH_PI_2)
+	{
+		x = -FASTMATH_PI - x;
+	}
+
+	// Odd minimax polynomial on [0, pi/2]
+	const float x2 = x * x;
+	return x * (0.99999997659f + x2 * (-0.16666647636f + x2 * (0.0083328998367f +
+		   x2 * (-0.00019800898436f + x2 * 2.5904896588e-6f))));
+}
+
+static inline float fast_cosf(float x)
+{
+	return fast_sinf(x + FASTMATH_PI_2);
+}
+
+static inline float fast_atan2f(float y, float x)
+{
+	const float abs_x = fabsf(x);
+	const float abs_y = fabsf(y);
+	const float max = abs_x > abs_y ? abs_x : abs_y;
+	const float min = abs_x > abs_y ? abs_y : abs_x;
+
+	if (max == 0.0f)
+	{
+		return 0.0f;
+	}
+
+	// Odd minimax polynomial for atan on [0, 1]
+	const float a = min / max;
+	const float a2 = a * a;
+	float result = a * (0.99999611167f + a2 * (-0.33317368207f + a2 * (0.19807816048f +
+				   a2 * (-0.13233342211f + a2 * (0.079623656750f + a2 * (-0.033604197801f +
+				   a2 * 0.0068117838611f))))));
+
+	// Undo the octant reduction
+	if (abs_y > abs_x)
+	{
+		result = FASTMATH_PI_2 - result;
+	}
+
+	if (x < 0.0f)
+	{
+		result = FASTMATH_PI - result;
+	}
+
+	return y < 0.0f ? -result : result;
+}
+
+static inline float fast_asinf(float x)
+{
+	const float abs_x = fminf(fabsf(x), 1.0f);
+
+	// Abramowitz and Stegun 4.4.46
+	const float p = 1.5707963050f + abs_x * (-0.2145988016f + abs_x * (0.0889789874f +
+					abs_x * (-0.0501743046f + abs_x * (0.0308918810f + abs_x * (-0.0170881256f +
+					abs_x * (0.0066700901f + abs_x * -0.0012624911f))))));
+	const float result = FASTMATH_PI_2 - fast_sqrtf(1.0f - abs_x) * p;
+
+	return x < 0.0f ? -result : result;
+}
+
+static inline float fast_exp2f(float x)
+{
+	x = fminf(fmaxf(x, -126.0f), 126.0f);
+
+	// Split into integer and fractional parts, fraction in [-0.5, 0.5]
+	const float n = fast_roundf(x);
+	const float f = x - n;
+
+	// Minimax polynomial for 2^f, relative error weighted
+	const float p = 1.0000000717f + f * (0.69314696706f + f * (0.24022119725f +
+					f * (0.055507132891f + f * (0.0096755412948f + f * 0.0013276466934f))));
+
+	// Build 2^n directly in the exponent field
+	const uint32_t bits = (uint32_t)((int32_t)n + 127) << 23;
+	float scale;
+	memcpy(&scale, &bits, sizeof(scale));
+
+	return p * scale;
+}
+
+static inline float fast_log2f(float x)
+{
+	// Split into exponent and mantissa, mantissa in [sqrt(1/2), sqrt(2))
+	uint32_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127;
+	bits = (bits & 0x007FFFFF) | 0x3F800000;
+	float m;
+	memcpy(&m, &bits, sizeof(m));
+
+	if (m > 1.41421356f)
+	{
+		m *= 0.5f;
+		exponent++;
+	}
+
+	// ln(m) = 2 atanh(t), t = (m - 1) / (m + 1), |t| < 0.172
+	const float t = (m - 1.0f) / (m + 1.0f);
+	const float t2 = t * t;
+	const float ln_m = 2.0f * t * (1.0f + t2 * (0.333333333f + t2 * (0.2f + t2 * 0.142857143f)));
+
+	return (float)exponent + ln_m * FASTMATH_LOG2E;
+}
+
+static inline float fast_expf(float x)
+{
+	return fast_exp2f(x * FASTMATH_LOG2E);
+}
+
+static inline float fast_logf(float x)
+{
+	return fast_log2f(x) * FASTMATH_LN2;
+}
+
+// x must be positive
+static inline float fast_powf(float x, float y)
+{
+	return fast_exp2f(y * fast_log2f(x));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIB_FASTMATH_FASTMATH_H_ */
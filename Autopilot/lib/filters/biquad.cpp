@@ -0,0 +1,85 @@
+#include "lib/filters/biquad.h"
+#include <math.h>
+
+// Coefficients from the RBJ audio EQ cookbook
+
+Biquad_coeffs biquad_lowpass(float sample_rate, float cutoff)
+{
+	Biquad_coeffs c;
+
+	if (cutoff <= 0 || cutoff >= 0.5f * sample_rate)
+	{
+		return c;
+	}
+
+	const float w0 = 6.28318531f * cutoff / sample_rate;
+	const float alpha = sinf(w0) * 0.70710678f; // sin(w0) / (2 Q), Q = 1 / sqrt(2)
+	const float cos_w0 = cosf(w0);
+	const float a0_inv = 1.0f / (1.0f + alpha);
+
+	c.b0 = 0.5f * (1.0f - cos_w0) * a0_inv;
+	c.b1 = (1.0f - cos_w0) * a0_inv;
+	c.b2 = c.b0;
+	c.a1 = -2.0f * cos_w0 * a0_inv;
+	c.a2 = (1.0f - alpha) * a0_inv;
+
+	return c;
+}
+
+Biquad_coeffs biquad_notch(float sample_rate, float center, float bandwidth)
+{
+	Biquad_coeffs c;
+
+	if (center <= 0 || bandwidth <= 0 || center >= 0.5f * sample_rate || bandwidth >= 0.5f * sample_rate)
+	{
+		return c;
+	}
+
+	// The cookbook sets the bandwidth on the analog prototype, which the
+	// bilinear transform narrows towards Nyquist. tan() of half the digital
+	// width makes it exact.
+	const float w0 = 6.28318531f * center / sample_rate;
+	const float alpha = tanf(3.14159265f * bandwidth / sample_rate);
+	const float cos_w0 = cosf(w0);
+	const float a0_inv = 1.0f / (1.0f + alpha);
+
+	c.b0 = a0_inv;
+	c.b1 = -2.0f * cos_w0 * a0_inv;
+	c.b2 = a0_inv;
+	c.a1 = c.b1;
+	c.a2 = (1.0f - alpha) * a0_inv;
+
+	return c;
+}
+
+// The states are kept, so coefficients can change while running
+void Biquad3::set_coeffs(const Biquad_coeffs& coeffs)
+{
+	_c = coeffs;
+}
+
+void Biquad3::reset(const float x[3])
+{
+	const float dc_gain = (_c.b0 + _c.b1 + _c.b2) / (1.0f + _c.a1 + _c.a2);
+
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		const float y = x[i] * dc_gain;
+		_z1[i] = y - _c.b0 * x[i];
+		_z2[i] = _c.b2 * x[i] - _c.a2 * y;
+	}
+}
+
+void Biquad3::apply(float x[3])
+{
+	const Biquad_coeffs c = _c;
+
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		const float in = x[i];
+		const float out = c.b0 * in + _z1[i];
+		_z1[i] = c.b1 * in - c.a1 * out + _z2[i];
+		_z2[i] = c.b2 * in - c.a2 * out;
+		x[i] = out;
+	}
+}
@@ -0,0 +1,50 @@
+#ifndef LIB_FILTERS_BIQUAD_H_
+#define LIB_FILTERS_BIQUAD_H_
+
+#include <stdint.h>
+
+// Normalized so a0 = 1
+struct Biquad_coeffs
+{
+	float b0 = 1;
+	float b1 = 0;
+	float b2 = 0;
+	float a1 = 0;
+	float a2 = 0;
+};
+
+// Second order Butterworth. A cutoff of 0 or at or above Nyquist passes
+// the signal through.
+Biquad_coeffs biquad_lowpass(float sample_rate, float cutoff);
+
+// Bandwidth is the -3 dB width in Hz. A center of 0 or at or above Nyquist,
+// or a bandwidth at or above Nyquist, passes the signal through.
+Biquad_coeffs biquad_notch(float sample_rate, float center, float bandwidth);
+
+/**
+ * @brief Biquad applied to the three axes of a sensor together
+ *
+ * Direct form II transposed, which needs two states per axis and keeps
+ * good precision in single precision float. The states are stored per
+ * delay across the axes, so each step of apply() is the same multiply
+ * accumulate on three neighbouring values. The loop has no branches and
+ * unrolls into straight FPU code.
+ */
+class Biquad3
+{
+public:
+	void set_coeffs(const Biquad_coeffs& coeffs);
+
+	// Start at steady state for a constant input x instead of from zero
+	void reset(const float x[3]);
+
+	// Filters x in place
+	void apply(float x[3]);
+
+private:
+	Biquad_coeffs _c;
+	float _z1[3] = {};
+	float _z2[3] = {};
+};
+
+#endif /* LIB_FILTERS_BIQUAD_H_ */
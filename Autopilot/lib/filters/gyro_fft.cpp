@@ -0,0 +1,252 @@
+#include "lib/filters/gyro_fft.h"
+#include <algorithm>
+#include <math.h>
+
+Gyro_fft::Gyro_fft()
+{
+	for (uint16_t n = 0; n < N; n++)
+	{
+		_window[n] = 0.5f - 0.5f * cosf(6.28318531f * n / N);
+	}
+
+	// Twiddles for the real N point transform, every other one serves the
+	// M point complex FFT
+	for (uint16_t k = 0; k < M; k++)
+	{
+		_cos[k] = cosf(6.28318531f * k / N);
+		_sin[k] = sinf(6.28318531f * k / N);
+	}
+
+	uint8_t bits = 0;
+	while ((1 << bits) < M)
+	{
+		bits++;
+	}
+
+	for (uint16_t i = 0; i < M; i++)
+	{
+		uint8_t reversed = 0;
+
+		for (uint8_t b = 0; b < bits; b++)
+		{
+			reversed |= ((i >> b) & 1) << (bits - 1 - b);
+		}
+
+		_bit_reverse[i] = reversed;
+	}
+}
+
+void Gyro_fft::set_range(float min_freq, float max_freq)
+{
+	_min_freq = min_freq;
+	_max_freq = max_freq;
+}
+
+bool Gyro_fft::update(const float gyr[3], float sample_rate)
+{
+	for (uint8_t axis = 0; axis < 3; axis++)
+	{
+		_samples[axis][_head] = gyr[axis];
+	}
+
+	_head = (_head + 1) % N;
+
+	if (_count < N)
+	{
+		_count++;
+	}
+
+	if (_step < 0)
+	{
+		// Start a new analysis once the window is full and has moved a hop
+		if (_count == N && _head % HOP == 0)
+		{
+			_step = 0;
+		}
+
+		return false;
+	}
+
+	if (_step < 3)
+	{
+		analyze_axis(_step);
+		_step++;
+
+		return false;
+	}
+
+	find_peaks(sample_rate);
+	_step = -1;
+
+	return true;
+}
+
+// Adds the power spectrum of one axis to _power, bins 0 to M - 1
+void Gyro_fft::analyze_axis(uint8_t axis)
+{
+	const float* samples = _samples[axis];
+
+	// Even samples go in the real part, odd ones in the imaginary part,
+	// oldest first
+	for (uint16_t n = 0; n < M; n++)
+	{
+		const uint16_t i = (_head + 2 * n) % N;
+		const uint16_t j = (i + 1) % N;
+		const uint8_t r = _bit_reverse[n];
+
+		_re[r] = samples[i] * _window[2 * n];
+		_im[r] = samples[j] * _window[2 * n + 1];
+	}
+
+	fft();
+
+	if (axis == 0)
+	{
+		for (uint16_t k = 0; k < M; k++)
+		{
+			_power[k] = 0;
+		}
+	}
+
+	// Split the packed transform back into the spectrum of the real signal
+	for (uint16_t k = 1; k < M; k++)
+	{
+		const float zr = _re[k];
+		const float zi = _im[k];
+		const float cr = _re[M - k];
+		const float ci = _im[M - k];
+
+		const float er = 0.5f * (zr + cr);
+		const float ei = 0.5f * (zi - ci);
+		const float odd_r = 0.5f * (zi + ci);
+		const float odd_i = -0.5f * (zr - cr);
+
+		const float xr = er + _cos[k] * odd_r + _sin[k] * odd_i;
+		const float xi = ei + _cos[k] * odd_i - _sin[k] * odd_r;
+
+		_power[k] += xr * xr + xi * xi;
+	}
+}
+
+// Radix 2 decimation in time on input already in bit reversed order
+void Gyro_fft::fft()
+{
+	for (uint16_t size = 2; size <= M; size *= 2)
+	{
+		const uint16_t half = size / 2;
+		const uint16_t stride = 2 * (M / size);
+
+		for (uint16_t start = 0; start < M; start += size)
+		{
+			for (uint16_t k = 0; k < half; k++)
+			{
+				const float wr = _cos[k * stride];
+				const float wi = -_sin[k * stride];
+
+				const uint16_t a = start + k;
+				const uint16_t b = a + half;
+
+				const float tr = wr * _re[b] - wi * _im[b];
+				const float ti = wr * _im[b] + wi * _re[b];
+
+				_re[b] = _re[a] - tr;
+				_im[b] = _im[a] - ti;
+				_re[a] += tr;
+				_im[a] += ti;
+			}
+		}
+	}
+}
+
+void Gyro_fft::find_peaks(float sample_rate)
+{
+	const float bin_width = sample_rate / N;
+
+	int first = (int)(_min_freq / bin_width);
+	int last = (int)(_max_freq / bin_width) + 1;
+
+	if (first < 1) first = 1;
+	if (last > M - 1) last = M - 1;
+
+	if (last <= first)
+	{
+		return;
+	}
+
+	// The median is the noise floor, a mean would be pulled up by the peaks
+	// themselves and hide the weaker ones. _re is free to sort in by now.
+	for (int k = first; k < last; k++)
+	{
+		_re[k - first] = _power[k];
+	}
+
+	std::nth_element(_re, _re + (last - first) / 2, _re + (last - first));
+	const float floor = _re[(last - first) / 2];
+
+	float found_freq[MAX_PEAKS] = {};
+	float found_power[MAX_PEAKS] = {};
+
+	// Strongest local maxima, kept sorted by power
+	for (int k = first; k < last; k++)
+	{
+		const float p = _power[k];
+
+		if (p <= _power[k - 1] || p < _power[k + 1] || p < MIN_SNR * floor)
+		{
+			continue;
+		}
+
+		for (uint8_t i = 0; i < MAX_PEAKS; i++)
+		{
+			if (p <= found_power[i])
+			{
+				continue;
+			}
+
+			for (uint8_t j = MAX_PEAKS - 1; j > i; j--)
+			{
+				found_power[j] = found_power[j - 1];
+				found_freq[j] = found_freq[j - 1];
+			}
+
+			const float l = _power[k - 1];
+			const float r = _power[k + 1];
+			const float denominator = l - 2 * p + r;
+			const float offset = denominator != 0 ? 0.5f * (l - r) / denominator : 0;
+
+			// The end bins reach past the range, the notches must not
+			found_power[i] = p;
+			found_freq[i] = std::min(std::max((k + offset) * bin_width, _min_freq), _max_freq);
+			break;
+		}
+	}
+
+	// Sort by frequency so each notch keeps following the same peak, empty
+	// slots stay at the end
+	for (uint8_t i = 1; i < MAX_PEAKS; i++)
+	{
+		for (uint8_t j = i; j > 0 && found_freq[j] > 0 && found_freq[j] < found_freq[j - 1]; j--)
+		{
+			const float f = found_freq[j];
+			const float p = found_power[j];
+			found_freq[j] = found_freq[j - 1];
+			found_power[j] = found_power[j - 1];
+			found_freq[j - 1] = f;
+			found_power[j - 1] = p;
+		}
+	}
+
+	for (uint8_t i = 0; i < MAX_PEAKS; i++)
+	{
+		if (found_freq[i] <= 0)
+		{
+			peak_freq[i] = 0;
+			peak_snr[i] = 0;
+		}
+		else
+		{
+			peak_freq[i] = peak_freq[i] > 0 ? peak_freq[i] + SMOOTHING * (found_freq[i] - peak_freq[i]) : found_freq[i];
+			peak_snr[i] = floor > 0 ? found_power[i] / floor : 0;
+		}
+	}
+}
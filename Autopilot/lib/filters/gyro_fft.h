@@ -0,0 +1,65 @@
+#ifndef LIB_FILTERS_GYRO_FFT_H_
+#define LIB_FILTERS_GYRO_FFT_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Tracks the strongest vibration peaks in the gyro spectrum
+ *
+ * Keeps the last N samples of each axis and, every N / 2 samples, takes a
+ * Hann windowed real FFT of each. The axis power spectra are summed and the
+ * strongest local maxima in [min_freq, max_freq] become the peaks, refined
+ * between bins by parabolic interpolation, clamped to the range and smoothed
+ * over time.
+ *
+ * The work is spread over the following samples, one axis FFT per call and
+ * the peak search on the last, so no single call does more than one FFT.
+ * Everything is sized at compile time, nothing is allocated.
+ */
+class Gyro_fft
+{
+public:
+	static constexpr uint16_t N = 128;
+	static constexpr uint8_t MAX_PEAKS = 2;
+
+	Gyro_fft();
+
+	void set_range(float min_freq, float max_freq);
+
+	// Adds one sample, returns true when the peaks were updated
+	bool update(const float gyr[3], float sample_rate);
+
+	// Peak frequencies in Hz sorted low to high, 0 where there is none
+	float peak_freq[MAX_PEAKS] = {};
+	// Peak power over the median power in the search range
+	float peak_snr[MAX_PEAKS] = {};
+
+private:
+	static constexpr uint16_t M = N / 2; // Complex FFT size
+	static constexpr uint16_t HOP = N / 2;
+	static constexpr float MIN_SNR = 10.0f;
+	static constexpr float SMOOTHING = 0.3f;
+
+	float _min_freq = 0;
+	float _max_freq = 0;
+
+	float _samples[3][N] = {};
+	uint16_t _head = 0;
+	uint16_t _count = 0;
+	int8_t _step = -1; // Axis being analyzed, 3 for the peak search, -1 when idle
+
+	float _window[N];
+	float _cos[M];
+	float _sin[M];
+	uint8_t _bit_reverse[M];
+
+	float _re[M];
+	float _im[M];
+	float _power[M];
+
+	void analyze_axis(uint8_t axis);
+	void find_peaks(float sample_rate);
+	void fft();
+};
+
+#endif /* LIB_FILTERS_GYRO_FFT_H_ */
@@ -0,0 +1,56 @@
+#include "lib/geo/geo.h"
+#include "lib/fastmath/fastmath.h"
+#include <math.h>
+
+// Longitude difference wrapped to [-180, 180] degrees
+static int32_t lon_delta(int32_t lon_ref, int32_t lon)
+{
+	int64_t delta = (int64_t)lon - lon_ref;
+
+	if (delta > 1800000000)
+	{
+		delta -= 3600000000;
+	}
+	else if (delta < -1800000000)
+	{
+		delta += 3600000000;
+	}
+
+	return (int32_t)delta;
+}
+
+// Cosine of a latitude as the sine of the colatitude. The colatitude is
+// exact in integer counts, so the angle keeps full float precision near the
+// poles where the east scale is most sensitive to it.
+static float cos_lat(int32_t lat)
+{
+	const int32_t colat = 900000000 - (lat < 0 ? -lat : lat);
+	return sinf((float)colat * GEO_DEG_E7_TO_RAD);
+}
+
+void lat_lon_to_meters(int32_t lat_ref, int32_t lon_ref, int32_t lat, int32_t lon, float *north, float *east)
+{
+	const int32_t d_lat = lat - lat_ref;
+	const int32_t d_lon = lon_delta(lon_ref, lon);
+	const int32_t lat_mean = lat_ref + d_lat / 2;
+
+	*north = (float)d_lat * GEO_DEG_E7_TO_M;
+	*east = (float)d_lon * GEO_DEG_E7_TO_M * cos_lat(lat_mean);
+}
+
+void meters_to_lat_lon(float north, float east, int32_t lat_ref, int32_t lon_ref, int32_t *lat, int32_t *lon)
+{
+	const int32_t d_lat = (int32_t)fast_roundf(north / GEO_DEG_E7_TO_M);
+	const int32_t lat_mean = lat_ref + d_lat / 2;
+	const int32_t d_lon = (int32_t)fast_roundf(east / (GEO_DEG_E7_TO_M * cos_lat(lat_mean)));
+
+	*lat = lat_ref + d_lat;
+	*lon = lon_delta(0, lon_ref + d_lon);
+}
+
+float lat_lon_to_distance(int32_t lat_ref, int32_t lon_ref, int32_t lat, int32_t lon)
+{
+	float north, east;
+	lat_lon_to_meters(lat_ref, lon_ref, lat, lon, &north, &east);
+	return sqrtf(north * north + east * east);
+}
@@ -0,0 +1,25 @@
+#ifndef LIB_GEO_GEO_H_
+#define LIB_GEO_GEO_H_
+
+#include <stdint.h>
+#include <math.h>
+
+/*
+ * Global positions are int32 degrees * 1E7 (1.1 cm per count at the equator).
+ * Local positions are float meters north/east of a reference point. Deltas
+ * are taken in integer counts before converting, so the float only ever
+ * holds a local offset and no double math is needed. Against the old double
+ * projection the worst case up to 85 degrees latitude is 0.3 mm at 1 km,
+ * 3 mm at 10 km and 3 cm at 100 km from the reference, checked by
+ * Host/Tests/geo_test.cpp.
+ */
+
+// Meters per 1E-7 degree of latitude
+constexpr float GEO_DEG_E7_TO_M = 6378137.0 * M_PI / 180.0 * 1E-7;
+constexpr float GEO_DEG_E7_TO_RAD = M_PI / 180.0 * 1E-7;
+
+void lat_lon_to_meters(int32_t lat_ref, int32_t lon_ref, int32_t lat, int32_t lon, float *north, float *east);
+void meters_to_lat_lon(float north, float east, int32_t lat_ref, int32_t lon_ref, int32_t *lat, int32_t *lon);
+float lat_lon_to_distance(int32_t lat_ref, int32_t lon_ref, int32_t lat, int32_t lon);
+
+#endif /* LIB_GEO_GEO_H_ */
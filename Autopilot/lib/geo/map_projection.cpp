@@ -0,0 +1,67 @@
+#include "lib/geo/map_projection.h"
+#include "lib/geo/geo.h"
+#include "lib/fastmath/fastmath.h"
+#include <math.h>
+
+// Through the colatitude like lat_lon_to_meters, which is exact in integer
+// counts and keeps the east scale accurate near the poles
+void MapProjection::init(int32_t lat_ref, int32_t lon_ref)
+{
+	const float colat_rad = (float)(900000000 - (lat_ref < 0 ? -lat_ref : lat_ref)) * GEO_DEG_E7_TO_RAD;
+
+	_ref_lat = lat_ref;
+	_ref_lon = lon_ref;
+	_cos_ref = sinf(colat_rad);
+	_sin_ref = lat_ref < 0 ? -cosf(colat_rad) : cosf(colat_rad);
+	_initialized = true;
+}
+
+bool MapProjection::check_ref(int32_t lat_ref, int32_t lon_ref) const
+{
+	return _initialized && (lat_ref == _ref_lat) && (lon_ref == _ref_lon);
+}
+
+// cos(ref + d) with d half the latitude offset, expanded to third order in d
+float MapProjection::east_scale(int32_t d_lat) const
+{
+	const float d = 0.5f * (float)d_lat * GEO_DEG_E7_TO_RAD;
+	const float d2 = d * d;
+	return GEO_DEG_E7_TO_M * (_cos_ref * (1.0f - 0.5f * d2) - _sin_ref * d * (1.0f - d2 * (1.0f / 6.0f)));
+}
+
+void MapProjection::project(int32_t lat, int32_t lon, float *north, float *east) const
+{
+	const int32_t d_lat = lat - _ref_lat;
+	int64_t d_lon = (int64_t)lon - _ref_lon;
+
+	// Wrap across the antimeridian
+	if (d_lon > 1800000000)
+	{
+		d_lon -= 3600000000;
+	}
+	else if (d_lon < -1800000000)
+	{
+		d_lon += 3600000000;
+	}
+
+	*north = (float)d_lat * GEO_DEG_E7_TO_M;
+	*east = (float)d_lon * east_scale(d_lat);
+}
+
+void MapProjection::reproject(float north, float east, int32_t *lat, int32_t *lon) const
+{
+	const int32_t d_lat = (int32_t)fast_roundf(north / GEO_DEG_E7_TO_M);
+	int64_t new_lon = (int64_t)_ref_lon + (int32_t)fast_roundf(east / east_scale(d_lat));
+
+	if (new_lon > 1800000000)
+	{
+		new_lon -= 3600000000;
+	}
+	else if (new_lon < -1800000000)
+	{
+		new_lon += 3600000000;
+	}
+
+	*lat = _ref_lat + d_lat;
+	*lon = (int32_t)new_lon;
+}
@@ -0,0 +1,39 @@
+#ifndef LIB_GEO_MAP_PROJECTION_H_
+#define LIB_GEO_MAP_PROJECTION_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Flat-earth projection around a fixed reference point
+ *
+ * Same math as lat_lon_to_meters, but the sin/cos of the reference latitude
+ * are computed once in init(). The mean-latitude cosine is then expanded
+ * around the reference, so project() and reproject() need no trig. The
+ * expansion costs a little accuracy near the poles, up to 85 degrees latitude
+ * the worst case against the double projection is 0.4 mm at 1 km, 4 mm at
+ * 10 km and 4 cm at 100 km, checked by Host/Tests/geo_test.cpp.
+ */
+class MapProjection
+{
+public:
+	void init(int32_t lat_ref, int32_t lon_ref);
+
+	bool is_initialized() const { return _initialized; };
+	int32_t get_ref_lat() const { return _ref_lat; };
+	int32_t get_ref_lon() const { return _ref_lon; };
+	bool check_ref(int32_t lat_ref, int32_t lon_ref) const;
+
+	void project(int32_t lat, int32_t lon, float *north, float *east) const;
+	void reproject(float north, float east, int32_t *lat, int32_t *lon) const;
+
+private:
+	int32_t _ref_lat = 0;
+	int32_t _ref_lon = 0;
+	float _cos_ref = 1;
+	float _sin_ref = 0;
+	bool _initialized = false;
+
+	float east_scale(int32_t d_lat) const;
+};
+
+#endif /* LIB_GEO_MAP_PROJECTION_H_ */
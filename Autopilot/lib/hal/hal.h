@@ -2,6 +2,16 @@
 #define LIB_HAL_HAL_H_
 
 #include "lib/data_bus/data_bus.h"
+#include "lib/pwm/pwm_scaling.h"
+
+// Outputs on one timer share a frame rate
+enum Pwm_group : uint8_t
+{
+	PWM_GROUP_SERVOS, // Elevator and aux 1-3
+	PWM_GROUP_RUDDER,
+	PWM_GROUP_THROTTLE,
+	PWM_GROUP_COUNT
+};
 
 class HAL
 {
@@ -10,45 +20,73 @@ public:
 
     virtual void init() = 0;
 
-    // Sensors
-    virtual bool read_imu(float *ax, float *ay, float *az, float *gx, float *gy, float *gz) = 0;
-    virtual bool read_mag(float *mx, float *my, float *mz) = 0;
-    virtual bool read_baro(float *alt) = 0;
-    virtual bool read_gnss(double *lat, double *lon, float* alt, uint8_t* sats, bool* fix) = 0;
+    // Sensors. Timestamps are when the sample was measured, not when it was read.
+    virtual bool read_imu(float *ax, float *ay, float *az, float *gx, float *gy, float *gz, uint64_t *timestamp) = 0;
+    virtual bool read_mag(float *mx, float *my, float *mz, uint64_t *timestamp) = 0;
+    virtual bool read_baro(float *alt, float *pressure, float *temperature, uint64_t *timestamp) = 0;
+    virtual bool read_gnss(GNSS_data* gnss) = 0;
     virtual bool read_optical_flow(int16_t *x, int16_t *y) = 0;
     virtual bool read_power_monitor(float *voltage, float* current) = 0;
 
-    // Telemetry
+    // Telemetry. Received bytes are copied out in bulk, or parsed in place
+    // with peek, which returns the next contiguous span, then consume.
     virtual void transmit_telem(uint8_t tx_buff[], int len) = 0;
-    virtual bool read_telem(uint8_t* byte) = 0;
-    virtual bool telem_buffer_empty() = 0;
+    virtual uint16_t read_telem(uint8_t* data, uint16_t len) = 0;
+    virtual uint16_t peek_telem(const uint8_t** data) = 0;
+    virtual void consume_telem(uint16_t len) = 0;
 
     // RC
     virtual void get_rc_input(uint16_t duty[], uint8_t num_channels) = 0;
 
     // Logger
     virtual void create_file(char name[], uint8_t len) = 0;
-    virtual bool write_storage(uint8_t byte) = 0;
+    virtual uint16_t write_storage(const uint8_t* data, uint16_t len) = 0;
+
+    // Mission storage. Requests complete asynchronously and the buffer must
+    // stay valid until mission_file_ready() returns true.
+    virtual bool read_mission_file(uint8_t file, uint32_t offset, void* data, uint32_t len) = 0;
+    virtual bool write_mission_file(uint8_t file, uint32_t offset, const void* data, uint32_t len) = 0;
+    virtual bool mission_file_ready(bool* success) = 0;
 
     // Debug
     virtual void debug_print(char* str) = 0;
     virtual void toggle_led() = 0;
 
-    // USB
-    virtual bool usb_buffer_empty() = 0;
+    // USB, same access as telemetry
     virtual void usb_transmit(uint8_t buf[], int len) = 0;
-    virtual bool usb_read(uint8_t *byte) = 0;
+    virtual uint16_t usb_read(uint8_t* data, uint16_t len) = 0;
+    virtual uint16_t usb_peek(const uint8_t** data) = 0;
+    virtual void usb_consume(uint16_t len) = 0;
 
-    // Control surfaces
+    // Control surfaces. Pulse widths in us, all outputs of a group latch on
+    // the same frame. A new rate starts on the next frame.
     virtual void set_pwm(uint16_t ele_duty, uint16_t rud_duty, uint16_t thr_duty,
 				 	     uint16_t aux1_duty, uint16_t aux2_duty, uint16_t aux3_duty) = 0;
+    virtual void set_pwm_rate(Pwm_group group, uint16_t rate_hz) = 0;
+
+    // While set, each new RC frame drives the elevator, rudder and throttle
+    // outputs from the receiver interrupt and set_pwm must not be called.
+    // The table is copied, nullptr stops it.
+    virtual void set_rc_passthrough(const Rc_passthrough* passthrough) = 0;
 
     // Time
     virtual void delay_us(uint64_t us) = 0;
     virtual uint64_t get_time_us() const = 0;
+    virtual uint32_t get_cycle_count() const = 0; // CPU cycles, for profiling
+
+    // Lockstep simulation. The first call switches get_time_us() to simulated
+    // time, which from then on only moves with these calls, and the HAL stops
+    // running the fast task itself. The main task is run as soon as USB data
+    // arrives so steps are not held to its period.
+    virtual void set_sim_time(uint64_t time_us) = 0;
 
-    // Scheduler
-    virtual void set_main_task(void (*task)()) = 0;
+    // Scheduler. The main task runs on a fixed timer. The fast task runs the
+    // sensor to actuator chain, on every IMU data ready interrupt when
+    // imu_sync is set, otherwise right after the main task. If the interrupt
+    // stops the timer takes over the fast task again. Tasks get the context
+    // they were registered with.
+    virtual void set_main_task(void (*task)(void* context), void* context) = 0;
+    virtual void set_fast_task(void (*task)(void* context), void* context, bool imu_sync) = 0;
 };
 
 #endif
@@ -1,25 +1,23 @@
 #include "l1_control.h"
 
+// Track unit vector and heading are precomputed per leg by the navigator
 void L1Control::navigate_waypoints(float x, float y, float vel_x, float vel_y, float ground_speed,
-					   	   	   	   float start_x, float start_y, float end_x, float end_y)
+					   	   	   	   float end_x, float end_y, float trk_unit_x, float trk_unit_y, float trk_hdg)
 {
-	// Calculate track heading (bearing from previous to target waypoint)
-	const float trk_hdg = atan2f(end_y - start_y, end_x - start_x);
-
 	// Compute cross-track error (perpendicular distance from aircraft to path)
-	const float xte = cosf(trk_hdg) * (y - end_y) - sinf(trk_hdg) * (x - end_x);
+	const float xte = trk_unit_x * (y - end_y) - trk_unit_y * (x - end_x);
 
 	// Calculate L1 distance and scale with speed
 	const float l1_dist = fmaxf(_l1_period * ground_speed / M_PI, 1.0);
 
 	// Calculate correction angle
-	const float correction_angle = asinf(clamp(xte / l1_dist, -1, 1)); // Domain of acos is [-1, 1]
+	const float correction_angle = fast_asinf(clamp(xte / l1_dist, -1, 1)); // Domain of acos is [-1, 1]
 
 	// Apply correction angle to track heading to compute heading setpoint
 	const float hdg_setpoint = trk_hdg - correction_angle;
 
 	// Calculate plane velocity heading
-	const float plane_hdg = atan2f(vel_x, vel_y);
+	const float plane_hdg = fast_atan2f(vel_x, vel_y);
 
 	// Calculate plane heading error
 	const float hdg_err = hdg_setpoint - plane_hdg;
@@ -28,10 +26,10 @@ void L1Control::navigate_waypoints(float x, float y, float vel_x, float vel_y, f
 	const float k_l1 = 4.0f * _l1_damping * _l1_damping;
 
 	// Calculate lateral acceleration using l1 guidance
-	const float lateral_accel = k_l1 * ground_speed * ground_speed / l1_dist * sinf(hdg_err);
+	const float lateral_accel = k_l1 * ground_speed * ground_speed / l1_dist * fast_sinf(hdg_err);
 
 	// Calculate roll to get desired lateral accel
-	const float roll = atanf(lateral_accel / G) * RAD_TO_DEG;
+	const float roll = fast_atan2f(lateral_accel, G) * RAD_TO_DEG;
 
 	// Return clamped roll angle
 	_roll_setpoint = clamp(roll, -_roll_limit, _roll_limit);
@@ -57,7 +55,7 @@ void L1Control::navigate_loiter(float x, float y, float vel_x, float vel_y, floa
 	// Compute vector from loiter center to aircraft position
 	float dx = x - target_x;
 	float dy = y - target_y;
-	float dist_to_center = sqrtf(dx * dx + dy * dy);
+	float dist_to_center = fast_sqrtf(dx * dx + dy * dy);
 
 	// Normalize the radial vector to get unit vector
 	float norm = fmaxf(dist_to_center, 0.001); // Prevent division by zero
@@ -83,11 +81,11 @@ void L1Control::navigate_loiter(float x, float y, float vel_x, float vel_y, floa
 	 // Compute error track angle (eta) between velocity vector and radial vector
 	float xtrack_vel = unit_dx * vel_y - unit_dy * vel_x;
 	float ltrack_vel = -(unit_dx * vel_x + unit_dy * vel_y);
-	float eta = atan2f(xtrack_vel, ltrack_vel);
+	float eta = fast_atan2f(xtrack_vel, ltrack_vel);
 	eta = fminf(fmaxf(eta, -M_PI / 2.0f), M_PI / 2.0f);
 
 	// Decide mode: circle vs capture
-	float accel_capture = k_l1 * ground_speed * ground_speed / l1_dist * sinf(eta);
+	float accel_capture = k_l1 * ground_speed * ground_speed / l1_dist * fast_sinf(eta);
 	bool outside_circle = xtrack_error > 0.0f;
 
 	if (((accel_capture < lateral_accel && direction > 0) ||
@@ -103,7 +101,7 @@ void L1Control::navigate_loiter(float x, float y, float vel_x, float vel_y, floa
 	}
 
 	// Calculate roll to get desired lateral accel
-	const float roll = atanf(lateral_accel / G) * RAD_TO_DEG;
+	const float roll = fast_atan2f(lateral_accel, G) * RAD_TO_DEG;
 
 	// Return clamped roll angle
 	_roll_setpoint = clamp(roll, -_roll_limit, _roll_limit);
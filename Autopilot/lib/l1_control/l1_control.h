@@ -7,13 +7,14 @@
 
 #include "lib/utils/utils.h"
 #include "lib/constants/constants.h"
+#include "lib/fastmath/fastmath.h"
 #include "math.h"
 
 class L1Control
 {
 public:
 	void navigate_waypoints(float x, float y, float vel_x, float vel_y, float ground_speed,
-			    			float start_x, float start_y, float end_x, float end_y);
+			    			float end_x, float end_y, float trk_unit_x, float trk_unit_y, float trk_hdg);
 	void navigate_loiter(float x, float y, float vel_x, float vel_y, float ground_speed,
 						 float target_x, float target_y, float radius, int8_t direction);
 
@@ -20,7 +20,9 @@
 // Header files
 
 #include <lib/madgwick/madgwick.h>
+#include <lib/fastmath/fastmath.h>
 #include <math.h>
+#include <string.h>
 
 //============================================================================================
 // Functions
@@ -33,6 +35,7 @@ Madgwick::Madgwick() {
 	q1 = 0.0f;
 	q2 = 0.0f;
 	q3 = 0.0f;
+	anglesComputed = false;
 }
 
 void Madgwick::set_dt(float dt)
@@ -46,6 +49,7 @@ void Madgwick::set_state(float q0_, float q1_, float q2_, float q3_)
 	q1 = q1_;
 	q2 = q2_;
 	q3 = q3_;
+	anglesComputed = false;
 }
 
 void Madgwick::set_beta(float beta)
@@ -53,7 +57,63 @@ void Madgwick::set_beta(float beta)
 	_beta = beta;
 }
 
-void Madgwick::update(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz) {
+void Madgwick::update(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz)
+{
+	stepAHRS(q0, q1, q2, q3, _beta, invSampleFreq, gx, gy, gz, ax, ay, az, mx, my, mz);
+	anglesComputed = false;
+}
+
+void Madgwick::updateIMU(float gx, float gy, float gz, float ax, float ay, float az)
+{
+	stepIMU(q0, q1, q2, q3, _beta, invSampleFreq, gx, gy, gz, ax, ay, az);
+	anglesComputed = false;
+}
+
+void Madgwick::updateGyro(float gx, float gy, float gz)
+{
+	stepGyro(q0, q1, q2, q3, invSampleFreq, gx, gy, gz);
+	anglesComputed = false;
+}
+
+//-------------------------------------------------------------------------------------------
+// Batched update
+//
+// Runs the filter over a block of samples (e.g. a drained IMU FIFO) with the
+// quaternion held in locals for the whole loop, so it is loaded and stored
+// once per block instead of once per sample. Each sample carries its own dt.
+// Zero magnetometer selects IMU fusion, zero accelerometer selects gyro-only
+// integration, same as update().
+
+void Madgwick::updateBatch(const MadgwickSample* samples, uint32_t count)
+{
+	float q0_ = q0;
+	float q1_ = q1;
+	float q2_ = q2;
+	float q3_ = q3;
+	const float beta = _beta;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const MadgwickSample& s = samples[i];
+		stepAHRS(q0_, q1_, q2_, q3_, beta, s.dt, s.gx, s.gy, s.gz, s.ax, s.ay, s.az, s.mx, s.my, s.mz);
+	}
+
+	q0 = q0_;
+	q1 = q1_;
+	q2 = q2_;
+	q3 = q3_;
+
+	if (count > 0)
+	{
+		anglesComputed = false;
+	}
+}
+
+//-------------------------------------------------------------------------------------------
+// AHRS algorithm step
+
+void Madgwick::stepAHRS(float& q0, float& q1, float& q2, float& q3, float beta, float dt,
+		float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz) {
 	float recipNorm;
 	float s0, s1, s2, s3;
 	float qDot1, qDot2, qDot3, qDot4;
@@ -62,7 +122,7 @@ void Madgwick::update(float gx, float gy, float gz, float ax, float ay, float az
 
 	// Use IMU algorithm if magnetometer measurement invalid (avoids NaN in magnetometer normalisation)
 	if((mx == 0.0f) && (my == 0.0f) && (mz == 0.0f)) {
-		updateIMU(gx, gy, gz, ax, ay, az);
+		stepIMU(q0, q1, q2, q3, beta, dt, gx, gy, gz, ax, ay, az);
 		return;
 	}
 
@@ -117,7 +177,7 @@ void Madgwick::update(float gx, float gy, float gz, float ax, float ay, float az
 		// Reference direction of Earth's magnetic field
 		hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
 		hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
-		_2bx = sqrtf(hx * hx + hy * hy);
+		_2bx = fast_sqrtf(hx * hx + hy * hy);
 		_2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
 		_4bx = 2.0f * _2bx;
 		_4bz = 2.0f * _2bz;
@@ -134,17 +194,17 @@ void Madgwick::update(float gx, float gy, float gz, float ax, float ay, float az
 		s3 *= recipNorm;
 
 		// Apply feedback step
-		qDot1 -= _beta * s0;
-		qDot2 -= _beta * s1;
-		qDot3 -= _beta * s2;
-		qDot4 -= _beta * s3;
+		qDot1 -= beta * s0;
+		qDot2 -= beta * s1;
+		qDot3 -= beta * s2;
+		qDot4 -= beta * s3;
 	}
 
 	// Integrate rate of change of quaternion to yield quaternion
-	q0 += qDot1 * invSampleFreq;
-	q1 += qDot2 * invSampleFreq;
-	q2 += qDot3 * invSampleFreq;
-	q3 += qDot4 * invSampleFreq;
+	q0 += qDot1 * dt;
+	q1 += qDot2 * dt;
+	q2 += qDot3 * dt;
+	q3 += qDot4 * dt;
 
 	// Normalise quaternion
 	recipNorm = invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
@@ -155,9 +215,10 @@ void Madgwick::update(float gx, float gy, float gz, float ax, float ay, float az
 }
 
 //-------------------------------------------------------------------------------------------
-// IMU algorithm update
+// IMU algorithm step
 
-void Madgwick::updateIMU(float gx, float gy, float gz, float ax, float ay, float az) {
+void Madgwick::stepIMU(float& q0, float& q1, float& q2, float& q3, float beta, float dt,
+		float gx, float gy, float gz, float ax, float ay, float az) {
 	float recipNorm;
 	float s0, s1, s2, s3;
 	float qDot1, qDot2, qDot3, qDot4;
@@ -210,17 +271,17 @@ void Madgwick::updateIMU(float gx, float gy, float gz, float ax, float ay, float
 		s3 *= recipNorm;
 
 		// Apply feedback step
-		qDot1 -= _beta * s0;
-		qDot2 -= _beta * s1;
-		qDot3 -= _beta * s2;
-		qDot4 -= _beta * s3;
+		qDot1 -= beta * s0;
+		qDot2 -= beta * s1;
+		qDot3 -= beta * s2;
+		qDot4 -= beta * s3;
 	}
 
 	// Integrate rate of change of quaternion to yield quaternion
-	q0 += qDot1 * invSampleFreq;
-	q1 += qDot2 * invSampleFreq;
-	q2 += qDot3 * invSampleFreq;
-	q3 += qDot4 * invSampleFreq;
+	q0 += qDot1 * dt;
+	q1 += qDot2 * dt;
+	q2 += qDot3 * dt;
+	q3 += qDot4 * dt;
 
 	// Normalise quaternion
 	recipNorm = invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
@@ -230,12 +291,10 @@ void Madgwick::updateIMU(float gx, float gy, float gz, float ax, float ay, float
 	q3 *= recipNorm;
 }
 
-void Madgwick::updateGyro(float gx, float gy, float gz)
+void Madgwick::stepGyro(float& q0, float& q1, float& q2, float& q3, float dt, float gx, float gy, float gz)
 {
 	float recipNorm;
-	float s0, s1, s2, s3;
 	float qDot1, qDot2, qDot3, qDot4;
-	float _2q0, _2q1, _2q2, _2q3, _4q0, _4q1, _4q2 ,_8q1, _8q2, q0q0, q1q1, q2q2, q3q3;
 
 	// Convert gyroscope degrees/sec to radians/sec
 	gx *= 0.0174533f;
@@ -249,10 +308,10 @@ void Madgwick::updateGyro(float gx, float gy, float gz)
 	qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
 
 	// Integrate rate of change of quaternion to yield quaternion
-	q0 += qDot1 * invSampleFreq;
-	q1 += qDot2 * invSampleFreq;
-	q2 += qDot3 * invSampleFreq;
-	q3 += qDot4 * invSampleFreq;
+	q0 += qDot1 * dt;
+	q1 += qDot2 * dt;
+	q2 += qDot3 * dt;
+	q3 += qDot4 * dt;
 
 	// Normalise quaternion
 	recipNorm = invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
@@ -269,9 +328,10 @@ void Madgwick::updateGyro(float gx, float gy, float gz)
 float Madgwick::invSqrt(float x) {
 	float halfx = 0.5f * x;
 	float y = x;
-	long i = *(long*)&y;
+	int32_t i;
+	memcpy(&i, &y, sizeof(i));
 	i = 0x5f3759df - (i>>1);
-	y = *(float*)&i;
+	memcpy(&y, &i, sizeof(y));
 	y = y * (1.5f - (halfx * y * y));
 	y = y * (1.5f - (halfx * y * y));
 	return y;
@@ -281,8 +341,13 @@ float Madgwick::invSqrt(float x) {
 
 void Madgwick::computeAngles()
 {
-	roll = atan2f(q0*q1 + q2*q3, 0.5f - q1*q1 - q2*q2);
-	pitch = asinf(-2.0f * (q1*q3 - q0*q2));
-	yaw = atan2f(q1*q2 + q0*q3, 0.5f - q2*q2 - q3*q3);
-}
+	if (anglesComputed)
+	{
+		return;
+	}
 
+	roll = fast_atan2f(q0*q1 + q2*q3, 0.5f - q1*q1 - q2*q2);
+	pitch = fast_asinf(-2.0f * (q1*q3 - q0*q2));
+	yaw = fast_atan2f(q1*q2 + q0*q3, 0.5f - q2*q2 - q3*q3);
+	anglesComputed = true;
+}
@@ -17,12 +17,28 @@
 #ifndef MadgwickAHRS_h
 #define MadgwickAHRS_h
 #include <math.h>
+#include <stdint.h>
+
+//--------------------------------------------------------------------------------------------
+// One IMU sample for updateBatch(). Gyro in deg/s, dt in seconds. Zero the
+// magnetometer to skip mag fusion, zero the accelerometer for gyro-only.
+struct MadgwickSample {
+    float gx, gy, gz;
+    float ax, ay, az;
+    float mx, my, mz;
+    float dt;
+};
 
 //--------------------------------------------------------------------------------------------
 // Variable declaration
 class Madgwick{
 private:
     static float invSqrt(float x);
+    static void stepAHRS(float& q0, float& q1, float& q2, float& q3, float beta, float dt,
+    		float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz);
+    static void stepIMU(float& q0, float& q1, float& q2, float& q3, float beta, float dt,
+    		float gx, float gy, float gz, float ax, float ay, float az);
+    static void stepGyro(float& q0, float& q1, float& q2, float& q3, float dt, float gx, float gy, float gz);
     float _beta;
     float q0;
     float q1;
@@ -32,6 +48,7 @@ private:
     float roll;
     float pitch;
     float yaw;
+    bool anglesComputed;	// Euler angles are computed lazily, once per state change
     void computeAngles();
 
 //-------------------------------------------------------------------------------------------
@@ -41,6 +58,7 @@ public:
     void update(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz);
     void updateIMU(float gx, float gy, float gz, float ax, float ay, float az);
     void updateGyro(float gx, float gy, float gz);
+    void updateBatch(const MadgwickSample* samples, uint32_t count);
     float get_q0() { return q0; };
     float get_q1() { return q1; };
     float get_q2() { return q2; };
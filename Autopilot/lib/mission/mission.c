@@ -1,53 +1,383 @@
 #include "mission.h"
+#include <stddef.h>
+#include <string.h>
 
-static uint8_t mission_version = 0;
-static float mission_altitude = 0;
-static bool altitude_set = false;
+static uint32_t crc32(const void* data, uint32_t len)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	uint32_t crc = 0xFFFFFFFF;
+
+	for (uint32_t i = 0; i < len; i++)
+	{
+		crc ^= bytes[i];
+
+		for (uint8_t bit = 0; bit < 8; bit++)
+		{
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+		}
+	}
+
+	return ~crc;
+}
+
+static uint32_t header_crc(const mission_data_t* header)
+{
+	return crc32(header, offsetof(mission_data_t, crc));
+}
+
+static uint32_t chunk_crc(const mission_chunk_t* chunk)
+{
+	return crc32(chunk->items, sizeof(chunk->items));
+}
+
+static uint16_t staging_num_items(const mission_context_t* mission)
+{
+	return mission->headers[mission->active_index ^ 1].num_items;
+}
+
+// First chunk of the window, it holds the waypoint before the requested one
+static uint16_t window_first_chunk(const mission_context_t* mission)
+{
+	const uint16_t num_items = mission_get(mission)->num_items;
+	uint16_t index = mission->requested_index > 0 ? mission->requested_index - 1 : 0;
+
+	if (index >= num_items)
+	{
+		index = num_items - 1;
+	}
+
+	return index / MISSION_CHUNK_ITEMS;
+}
+
+void mission_init(mission_context_t* mission)
+{
+	memset(mission, 0, sizeof(*mission));
+
+	for (uint8_t i = 0; i < MISSION_WINDOW_CHUNKS; i++)
+	{
+		mission->window_chunk[i] = MISSION_CHUNK_NONE;
+	}
+}
+
+const mission_data_t* mission_get(const mission_context_t* mission)
+{
+	return &mission->headers[mission->active_index];
+}
+
+mission_data_t* mission_get_staging(mission_context_t* mission)
+{
+	return &mission->headers[mission->active_index ^ 1];
+}
+
+void mission_commit_update(mission_context_t* mission, uint8_t file)
+{
+	// Staging writes must land before the swap is visible
+	__sync_synchronize();
+	mission->active_index ^= 1;
+	mission->active_file = file;
+	mission->version++;
+
+	for (uint8_t i = 0; i < MISSION_WINDOW_CHUNKS; i++)
+	{
+		mission->window_chunk[i] = MISSION_CHUNK_NONE;
+	}
+
+	// The last chunks of an upload are still in the upload buffers. For
+	// missions that fit in the window that is the whole mission.
+	if (mission->upload_state == MISSION_UPLOAD_RECEIVING && mission->upload_count > 0)
+	{
+		const uint16_t last_chunk = (mission->upload_count - 1) / MISSION_CHUNK_ITEMS;
+
+		for (uint16_t chunk = last_chunk > 0 ? last_chunk - 1 : 0; chunk <= last_chunk; chunk++)
+		{
+			const uint8_t slot = chunk % MISSION_WINDOW_CHUNKS;
+			mission->window[slot] = mission->upload_chunks[slot];
+			mission->window_chunk[slot] = chunk;
+		}
+	}
+
+	if (mission->upload_state == MISSION_UPLOAD_RECEIVING)
+	{
+		mission->upload_state = MISSION_UPLOAD_DONE;
+	}
+
+	mission->requested_index = 0;
+	mission->window_failed = false;
+	mission->window_version++;
+}
+
+bool mission_check_loaded(const mission_context_t* mission)
+{
+	return mission_get(mission)->num_items > 0;
+}
+
+uint8_t mission_get_version(const mission_context_t* mission)
+{
+	return mission->version;
+}
+
+uint8_t mission_get_file(const mission_context_t* mission)
+{
+	return mission->active_file;
+}
+
+bool mission_check_header(const mission_data_t* header)
+{
+	return header->magic == MISSION_FILE_MAGIC &&
+		   header->format_version == MISSION_FORMAT_VERSION &&
+		   header->crc == header_crc(header);
+}
+
+uint32_t mission_chunk_offset(uint16_t chunk)
+{
+	return sizeof(mission_data_t) + (uint32_t)chunk * sizeof(mission_chunk_t);
+}
+
+mission_data_t* mission_begin_update(mission_context_t* mission)
+{
+	mission_data_t* staging = mission_get_staging(mission);
+	memset(staging, 0, sizeof(*staging));
+
+	mission->upload_state = MISSION_UPLOAD_RECEIVING;
+	mission->upload_id++;
+	mission->upload_count = 0;
+	mission->upload_written = 0;
+
+	return staging;
+}
+
+// True when the buffer for the next item has been saved
+bool mission_upload_ready(const mission_context_t* mission)
+{
+	return mission->upload_state == MISSION_UPLOAD_RECEIVING &&
+		   mission->upload_count < staging_num_items(mission) &&
+		   mission->upload_count / MISSION_CHUNK_ITEMS < mission->upload_written + MISSION_WINDOW_CHUNKS;
+}
+
+bool mission_add_item(mission_context_t* mission, const mission_item_t* item)
+{
+	if (!mission_upload_ready(mission))
+	{
+		return false;
+	}
 
-static mission_data_t mission = {
-	.mission_type = MISSION_EMPTY,
-    .num_items = 0,
-    .loiter_radius = 0,
-    .loiter_direction = LOITER_LEFT,
-    .final_leg_dist = 0,
-    .glideslope_angle = 0,
-    .runway_heading = 0,
-    .last_item_index = 0
-};
+	const uint16_t chunk = mission->upload_count / MISSION_CHUNK_ITEMS;
+	const uint8_t index = mission->upload_count % MISSION_CHUNK_ITEMS;
+	mission_chunk_t* buffer = &mission->upload_chunks[chunk % MISSION_WINDOW_CHUNKS];
 
-void mission_set(const mission_data_t new_mission)
+	if (index == 0)
+	{
+		memset(buffer, 0, sizeof(*buffer));
+	}
+
+	buffer->items[index] = *item;
+	mission->upload_count++;
+
+	if (index == MISSION_CHUNK_ITEMS - 1 || mission->upload_count == staging_num_items(mission))
+	{
+		buffer->crc = chunk_crc(buffer);
+	}
+
+	return true;
+}
+
+mission_upload_state_t mission_get_upload_state(const mission_context_t* mission)
+{
+	return mission->upload_state;
+}
+
+uint8_t mission_get_upload_id(const mission_context_t* mission)
+{
+	return mission->upload_id;
+}
+
+// Next complete chunk waiting to be saved
+const mission_chunk_t* mission_upload_get_chunk(const mission_context_t* mission, uint16_t* chunk)
+{
+	const uint32_t saved_items = (uint32_t)mission->upload_written * MISSION_CHUNK_ITEMS;
+
+	if (mission->upload_state != MISSION_UPLOAD_RECEIVING || saved_items >= mission->upload_count)
+	{
+		return NULL;
+	}
+
+	if (mission->upload_count - saved_items < MISSION_CHUNK_ITEMS &&
+		mission->upload_count < staging_num_items(mission))
+	{
+		return NULL;
+	}
+
+	*chunk = mission->upload_written;
+	return &mission->upload_chunks[mission->upload_written % MISSION_WINDOW_CHUNKS];
+}
+
+void mission_upload_chunk_done(mission_context_t* mission, uint16_t chunk)
+{
+	if (chunk == mission->upload_written)
+	{
+		mission->upload_written++;
+	}
+}
+
+// Sealed header once every item has been received and saved
+const mission_data_t* mission_upload_get_header(mission_context_t* mission)
+{
+	mission_data_t* staging = mission_get_staging(mission);
+
+	if (mission->upload_state != MISSION_UPLOAD_RECEIVING ||
+		mission->upload_count < staging->num_items ||
+		mission->upload_written * MISSION_CHUNK_ITEMS < mission->upload_count)
+	{
+		return NULL;
+	}
+
+	staging->magic = MISSION_FILE_MAGIC;
+	staging->format_version = MISSION_FORMAT_VERSION;
+	staging->sequence = mission_get(mission)->sequence + 1;
+	staging->crc = header_crc(staging);
+
+	return staging;
+}
+
+void mission_abort_update(mission_context_t* mission)
+{
+	mission->upload_state = MISSION_UPLOAD_FAILED;
+}
+
+void mission_request_window(mission_context_t* mission, uint16_t index)
+{
+	mission->requested_index = index;
+}
+
+bool mission_get_item(const mission_context_t* mission, uint16_t index, mission_item_t* item)
+{
+	const uint16_t chunk = index / MISSION_CHUNK_ITEMS;
+	const uint8_t slot = chunk % MISSION_WINDOW_CHUNKS;
+
+	if (index >= mission_get(mission)->num_items || mission->window_chunk[slot] != chunk)
+	{
+		return false;
+	}
+
+	*item = mission->window[slot].items[index % MISSION_CHUNK_ITEMS];
+	return true;
+}
+
+// Contiguous range of resident items [first, end) starting at the window
+bool mission_get_window_range(const mission_context_t* mission, uint16_t* first, uint16_t* end)
+{
+	const uint16_t num_items = mission_get(mission)->num_items;
+
+	if (num_items == 0)
+	{
+		return false;
+	}
+
+	const uint16_t first_chunk = window_first_chunk(mission);
+	uint32_t end_index = first_chunk * MISSION_CHUNK_ITEMS;
+
+	for (uint16_t chunk = first_chunk; chunk < first_chunk + MISSION_WINDOW_CHUNKS; chunk++)
+	{
+		if (mission->window_chunk[chunk % MISSION_WINDOW_CHUNKS] != chunk || end_index >= num_items)
+		{
+			break;
+		}
+
+		end_index += MISSION_CHUNK_ITEMS;
+	}
+
+	if (end_index == first_chunk * MISSION_CHUNK_ITEMS)
+	{
+		return false;
+	}
+
+	*first = first_chunk * MISSION_CHUNK_ITEMS;
+	*end = end_index < num_items ? end_index : num_items;
+	return true;
+}
+
+uint16_t mission_get_window_version(const mission_context_t* mission)
 {
-	mission = new_mission;
-	mission_version++;
+	return mission->window_version;
 }
 
-mission_data_t mission_get()
+bool mission_window_get_missing(const mission_context_t* mission, uint16_t* chunk)
 {
-	return mission;
+	const uint16_t num_items = mission_get(mission)->num_items;
+
+	if (num_items == 0 || mission->window_failed)
+	{
+		return false;
+	}
+
+	const uint16_t first_chunk = window_first_chunk(mission);
+
+	for (uint16_t i = first_chunk; i < first_chunk + MISSION_WINDOW_CHUNKS; i++)
+	{
+		if ((uint32_t)i * MISSION_CHUNK_ITEMS >= num_items)
+		{
+			break;
+		}
+
+		if (mission->window_chunk[i % MISSION_WINDOW_CHUNKS] != i)
+		{
+			*chunk = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Slot is marked empty while the storage driver fills it. Readers keep what
+// they built from the old window until a chunk is released, so the version
+// only changes then.
+mission_chunk_t* mission_window_claim(mission_context_t* mission, uint16_t chunk)
+{
+	const uint8_t slot = chunk % MISSION_WINDOW_CHUNKS;
+
+	mission->window_chunk[slot] = MISSION_CHUNK_NONE;
+
+	return &mission->window[slot];
+}
+
+bool mission_window_release(mission_context_t* mission, uint16_t chunk, bool success)
+{
+	const uint8_t slot = chunk % MISSION_WINDOW_CHUNKS;
+
+	if (!success || mission->window[slot].crc != chunk_crc(&mission->window[slot]))
+	{
+		return false;
+	}
+
+	mission->window_chunk[slot] = chunk;
+	mission->window_version++;
+
+	return true;
 }
 
-bool mission_check_loaded()
+void mission_window_set_failed(mission_context_t* mission)
 {
-	return (mission.num_items > 0) && (mission.last_item_index == mission.num_items);
+	mission->window_failed = true;
 }
 
-uint8_t mission_get_version()
+bool mission_check_usable(const mission_context_t* mission)
 {
-	return mission_version;
+	return mission_check_loaded(mission) && !mission->window_failed;
 }
 
-void mission_set_altitude(float altitude)
+void mission_set_altitude(mission_context_t* mission, float altitude)
 {
-	mission_altitude = altitude;
-	altitude_set = true;
+	mission->altitude = altitude;
+	mission->altitude_set = true;
 }
 
-float mission_get_altitude()
+float mission_get_altitude(const mission_context_t* mission)
 {
-	return mission_altitude;
+	return mission->altitude;
 }
 
-bool mission_check_altitude_set()
+bool mission_check_altitude_set(const mission_context_t* mission)
 {
-	return altitude_set;
+	return mission->altitude_set;
 }
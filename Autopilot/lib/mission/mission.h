@@ -8,7 +8,24 @@
 extern "C" {
 #endif
 
-#define MAX_MISSION_ITEMS 256
+/*
+ * Missions are stored on the SD card as a header followed by fixed size
+ * chunks of items, each chunk with its own CRC. Only the header and a window
+ * of two chunks around the current waypoint are held in RAM, so memory use
+ * does not depend on mission length.
+ *
+ * There are two mission files. Uploads go to the file that is not active and
+ * the header is written last, so a power loss mid-upload leaves the previous
+ * mission intact. At boot the valid file with the newest sequence is loaded.
+ */
+
+#define MISSION_MAX_ITEMS 65535
+#define MISSION_CHUNK_ITEMS 16
+#define MISSION_WINDOW_CHUNKS 2
+#define MISSION_WINDOW_ITEMS (MISSION_CHUNK_ITEMS * MISSION_WINDOW_CHUNKS)
+#define MISSION_CHUNK_NONE 0xFFFF
+#define MISSION_FILE_MAGIC 0x4E53494D // "MISN"
+#define MISSION_FORMAT_VERSION 1
 
 typedef enum
 {
@@ -24,31 +41,121 @@ typedef enum
 	LOITER_RIGHT
 } loiter_direction_t;
 
+typedef enum
+{
+	MISSION_UPLOAD_IDLE,
+	MISSION_UPLOAD_RECEIVING,
+	MISSION_UPLOAD_DONE,
+	MISSION_UPLOAD_FAILED
+} mission_upload_state_t;
+
+// 12 bytes
 typedef struct
 {
-	double latitude;
-	double longitude;
+	int32_t latitude; // deg * 1E7
+	int32_t longitude; // deg * 1E7
+	int16_t altitude; // dm above home
+	uint8_t type; // mission_type_t
+	uint8_t reserved;
 } mission_item_t;
 
-typedef struct {
-	mission_item_t mission_items[MAX_MISSION_ITEMS];
-	mission_type_t mission_type;
-	uint8_t num_items;
+// Unit of storage on the SD card. Items past the end of the mission are zero.
+typedef struct
+{
+	mission_item_t items[MISSION_CHUNK_ITEMS];
+	uint32_t crc; // CRC-32 of items
+} mission_chunk_t;
+
+// Also the file header, stored at offset 0
+typedef struct
+{
+	uint32_t magic;
+	uint16_t format_version;
+	uint16_t num_items;
+	uint8_t mission_type; // mission_type_t
+	uint8_t loiter_direction; // loiter_direction_t
+	uint16_t reserved;
+	uint32_t sequence; // Incremented every upload, newest file wins at boot
 	float loiter_radius;
-	loiter_direction_t loiter_direction;
 	float final_leg_dist;
 	float glideslope_angle;
 	float runway_heading;
-	uint8_t last_item_index;
+	uint32_t crc; // CRC-32 of the preceding fields
 } mission_data_t;
 
-void mission_set(const mission_data_t new_mission);
-mission_data_t mission_get();
-bool mission_check_loaded();
-uint8_t mission_get_version();
-void mission_set_altitude(float altitude);
-float mission_get_altitude();
-bool mission_check_altitude_set();
+// State of one autopilot instance, owned by the caller and set up with
+// mission_init()
+typedef struct
+{
+	uint8_t version;
+	float altitude;
+	bool altitude_set;
+
+	// Active header and staging header, zero initialized as empty missions
+	mission_data_t headers[2];
+	volatile uint8_t active_index;
+	uint8_t active_file;
+
+	// Upload chunk buffers, chunk c is always assembled in buffer c % MISSION_WINDOW_CHUNKS
+	mission_chunk_t upload_chunks[MISSION_WINDOW_CHUNKS];
+	mission_upload_state_t upload_state;
+	uint8_t upload_id;
+	uint16_t upload_count; // Items received
+	uint16_t upload_written; // Chunks saved
+
+	// Window, chunk c is always held in slot c % MISSION_WINDOW_CHUNKS
+	mission_chunk_t window[MISSION_WINDOW_CHUNKS];
+	uint16_t window_chunk[MISSION_WINDOW_CHUNKS];
+	uint16_t window_version;
+	uint16_t requested_index;
+	bool window_failed; // A chunk of the active mission could not be read
+} mission_context_t;
+
+void mission_init(mission_context_t* mission);
+
+/*
+ * The active mission header is immutable. Uploads are written into a separate
+ * staging header and swapped in atomically by mission_commit_update(). Readers
+ * get a pointer and never copy.
+ */
+const mission_data_t* mission_get(const mission_context_t* mission);
+mission_data_t* mission_get_staging(mission_context_t* mission);
+void mission_commit_update(mission_context_t* mission, uint8_t file);
+bool mission_check_loaded(const mission_context_t* mission);
+uint8_t mission_get_version(const mission_context_t* mission);
+uint8_t mission_get_file(const mission_context_t* mission);
+bool mission_check_header(const mission_data_t* header);
+uint32_t mission_chunk_offset(uint16_t chunk);
+
+// Upload, items are streamed through two chunk buffers to the SD card
+mission_data_t* mission_begin_update(mission_context_t* mission);
+bool mission_upload_ready(const mission_context_t* mission);
+bool mission_add_item(mission_context_t* mission, const mission_item_t* item);
+mission_upload_state_t mission_get_upload_state(const mission_context_t* mission);
+uint8_t mission_get_upload_id(const mission_context_t* mission);
+const mission_chunk_t* mission_upload_get_chunk(const mission_context_t* mission, uint16_t* chunk);
+void mission_upload_chunk_done(mission_context_t* mission, uint16_t chunk);
+const mission_data_t* mission_upload_get_header(mission_context_t* mission);
+void mission_abort_update(mission_context_t* mission);
+
+// Window of items around the current waypoint
+void mission_request_window(mission_context_t* mission, uint16_t index);
+bool mission_get_item(const mission_context_t* mission, uint16_t index, mission_item_t* item);
+bool mission_get_window_range(const mission_context_t* mission, uint16_t* first, uint16_t* end);
+uint16_t mission_get_window_version(const mission_context_t* mission);
+bool mission_window_get_missing(const mission_context_t* mission, uint16_t* chunk);
+mission_chunk_t* mission_window_claim(mission_context_t* mission, uint16_t chunk);
+bool mission_window_release(mission_context_t* mission, uint16_t chunk, bool success);
+
+// Set by the storage driver once it gives up on a chunk, cleared by the next
+// mission. The rest of the mission cannot be flown.
+void mission_window_set_failed(mission_context_t* mission);
+bool mission_check_usable(const mission_context_t* mission);
+
+// Commanded altitude for loiter and landing, waypoint items carry their own
+void mission_set_altitude(mission_context_t* mission, float altitude);
+float mission_get_altitude(const mission_context_t* mission);
+bool mission_check_altitude_set(const mission_context_t* mission);
 
 #ifdef __cplusplus
 }
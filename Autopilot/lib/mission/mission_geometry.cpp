@@ -0,0 +1,127 @@
+#include "lib/mission/mission_geometry.h"
+#include "lib/constants/constants.h"
+#include "lib/utils/utils.h"
+#include <math.h>
+
+static void set_leg(mission_leg_s& leg, float start_north, float start_east, float end_north, float end_east)
+{
+	const float d_north = end_north - start_north;
+	const float d_east = end_east - start_east;
+
+	leg.end_north = end_north;
+	leg.end_east = end_east;
+	leg.length = sqrtf(d_north * d_north + d_east * d_east);
+
+	if (leg.length > 0)
+	{
+		leg.unit_north = d_north / leg.length;
+		leg.unit_east = d_east / leg.length;
+		leg.bearing = atan2f(d_east, d_north);
+	}
+	else
+	{
+		leg.unit_north = 1;
+		leg.unit_east = 0;
+		leg.bearing = 0;
+	}
+}
+
+void MissionGeometry::build(const mission_context_t* context, const MapProjection& projection)
+{
+	const mission_data_t& mission = *mission_get(context);
+
+	_num_legs = mission.num_items;
+	_first_leg = 0;
+	_end_leg = 0;
+	_landing = landing_s{};
+
+	uint16_t first, end;
+	if (!mission_get_window_range(context, &first, &end))
+	{
+		return;
+	}
+
+	float start_north = 0;
+	float start_east = 0;
+
+	for (uint16_t i = first; i < end; i++)
+	{
+		mission_item_t item;
+		mission_get_item(context, i, &item);
+
+		float end_north, end_east;
+		projection.project(item.latitude, item.longitude, &end_north, &end_east);
+
+		mission_leg_s& leg = _legs[i % MISSION_WINDOW_ITEMS];
+		set_leg(leg, start_north, start_east, end_north, end_east);
+		leg.end_alt = item.altitude * 0.1f;
+
+		start_north = end_north;
+		start_east = end_east;
+	}
+
+	// The first leg in the window starts at a waypoint that is not loaded
+	_first_leg = first > 0 ? first + 1 : 0;
+	_end_leg = end;
+
+	if (mission.mission_type == MISSION_LAND && end == _num_legs)
+	{
+		build_landing(mission);
+	}
+}
+
+const mission_leg_s& MissionGeometry::get_leg(uint16_t index) const
+{
+	static const mission_leg_s empty_leg{};
+
+	if (!check_leg(index))
+	{
+		return empty_leg;
+	}
+
+	return _legs[index % MISSION_WINDOW_ITEMS];
+}
+
+void MissionGeometry::get_leg_start(uint16_t index, float *north, float *east) const
+{
+	if (index == 0 || !check_leg(index))
+	{
+		*north = 0;
+		*east = 0;
+		return;
+	}
+
+	*north = _legs[(index - 1) % MISSION_WINDOW_ITEMS].end_north;
+	*east = _legs[(index - 1) % MISSION_WINDOW_ITEMS].end_east;
+}
+
+// Touchdown is the last waypoint. The glideslope starts final_leg_dist out
+// along the runway heading, and the loiter circle is tangent to the final
+// approach at that point.
+void MissionGeometry::build_landing(const mission_data_t& mission)
+{
+	const mission_leg_s& touchdown = _legs[(_num_legs - 1) % MISSION_WINDOW_ITEMS];
+	const float runway_rad = mission.runway_heading * DEG_TO_RAD;
+	const float runway_north = cosf(runway_rad);
+	const float runway_east = sinf(runway_rad);
+
+	_landing.loiter_direction = mission.loiter_direction == LOITER_RIGHT ? 1 : -1;
+
+	const float perpendicular_rad = (mission.runway_heading - 90 * _landing.loiter_direction) * DEG_TO_RAD;
+	const float glideslope_rad = mission.glideslope_angle * DEG_TO_RAD;
+
+	_landing.touchdown_north = touchdown.end_north;
+	_landing.touchdown_east = touchdown.end_east;
+	_landing.glideslope_start_north = touchdown.end_north + mission.final_leg_dist * runway_north;
+	_landing.glideslope_start_east = touchdown.end_east + mission.final_leg_dist * runway_east;
+	_landing.approach_unit_north = -runway_north;
+	_landing.approach_unit_east = -runway_east;
+	_landing.approach_bearing = wrap_pi(runway_rad + M_PI);
+	_landing.runway_heading = mission.runway_heading;
+	_landing.loiter_north = _landing.glideslope_start_north + mission.loiter_radius * cosf(perpendicular_rad);
+	_landing.loiter_east = _landing.glideslope_start_east + mission.loiter_radius * sinf(perpendicular_rad);
+	_landing.loiter_radius = mission.loiter_radius;
+	_landing.tan_glideslope = tanf(glideslope_rad);
+	_landing.sin_glideslope = sinf(glideslope_rad);
+	_landing.loiter_alt = mission.final_leg_dist * _landing.tan_glideslope;
+}
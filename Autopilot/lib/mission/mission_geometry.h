@@ -0,0 +1,49 @@
+#ifndef LIB_MISSION_MISSION_GEOMETRY_H_
+#define LIB_MISSION_MISSION_GEOMETRY_H_
+
+#include "lib/mission/mission.h"
+#include "lib/geo/map_projection.h"
+#include "lib/data_bus/nodes.h"
+
+struct mission_leg_s
+{
+	float end_north = 0;
+	float end_east = 0;
+	float unit_north = 1;
+	float unit_east = 0;
+	float length = 0;
+	float bearing = 0; // Radians
+	float end_alt = 0; // Meters above home
+};
+
+/**
+ * @brief Mission window converted to local NED when it, the mission or the
+ * reference changes
+ *
+ * Leg i runs from waypoint i - 1 to waypoint i. The first leg starts at the
+ * local origin. Only legs whose waypoints are both in the mission window are
+ * valid. Everything the control path needs is precomputed here, so per tick
+ * work is reduced to dot products against these vectors.
+ */
+class MissionGeometry
+{
+public:
+	void build(const mission_context_t* context, const MapProjection& projection);
+
+	uint16_t get_num_legs() const { return _num_legs; };
+	bool check_leg(uint16_t index) const { return index >= _first_leg && index < _end_leg; };
+	const mission_leg_s& get_leg(uint16_t index) const;
+	void get_leg_start(uint16_t index, float *north, float *east) const;
+	const landing_s& get_landing() const { return _landing; };
+
+private:
+	mission_leg_s _legs[MISSION_WINDOW_ITEMS]; // Leg i is in _legs[i % MISSION_WINDOW_ITEMS]
+	uint16_t _num_legs = 0;
+	uint16_t _first_leg = 0; // Valid legs are [_first_leg, _end_leg)
+	uint16_t _end_leg = 0;
+	landing_s _landing;
+
+	void build_landing(const mission_data_t& mission);
+};
+
+#endif /* LIB_MISSION_MISSION_GEOMETRY_H_ */
@@ -1,7 +1,8 @@
 #include "module.h"
 
-Module::Module(HAL* hal, DataBus* data_bus)
+Module::Module(HAL* hal, DataBus* data_bus, param_context_t* params)
 {
 	_hal = hal;
 	_data_bus = data_bus;
+	_params = params;
 }
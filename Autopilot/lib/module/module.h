@@ -3,6 +3,7 @@
 
 #include <lib/data_bus/data_bus.h>
 #include <lib/hal/hal.h>
+#include <lib/parameters/params.h>
 
 /**
  * Abstract module class
@@ -10,7 +11,7 @@
 class Module
 {
 public:
-	Module(HAL* hal, DataBus* data_bus);
+	Module(HAL* hal, DataBus* data_bus, param_context_t* params);
 	virtual ~Module() {};
 
 	virtual void update() = 0;
@@ -18,6 +19,7 @@ public:
 protected:
 	HAL* _hal;
 	DataBus* _data_bus;
+	param_context_t* _params;
 };
 
 #endif /* LIB_MODULE_MODULE_H_ */
@@ -2,20 +2,6 @@
 #include <string.h>
 #include <stdbool.h>
 
-typedef struct {
-    const char *name;
-    param_type_t type;
-    bool is_set;           // Flag indicating if parameter has been set
-    union {
-        int32_t i32_val;   // Integer value
-        float float_val;   // Float value
-    } value;
-} param_entry_t;
-
-#define MAX_PARAMS 256
-static param_entry_t param_table[MAX_PARAMS] = {0};
-static uint16_t param_count = 0;
-
 // TODO: Switch to CRC32 checksum to reduce collisions
 static uint32_t param_hash(const char *str) {
     uint32_t hash = 5381; // DJB2
@@ -26,33 +12,24 @@ static uint32_t param_hash(const char *str) {
     return hash;
 }
 
-static param_t param_add(const char *name, param_type_t type) {
-    if (param_count >= MAX_PARAMS) return PARAM_INVALID;
-
-    param_table[param_count].name = name;
-    param_table[param_count].type = type;
-    param_table[param_count].is_set = false;
-
-    return param_count++; // Return handle (index)
+static void param_add(param_context_t *params, param_t param, const char *name, param_type_t type) {
+    params->table[param].name = name;
+    params->table[param].type = type;
+    params->table[param].is_set = false;
 }
 
-// Define all parameters
-#define PARAM(name, type) param_t name;
-#include "params_def.h"
-#undef PARAM
-
 // Register parameters
-void param_init(void) {
-	#define PARAM(name, type) name = param_add(#name, type);
+void param_init(param_context_t *params) {
+	#define PARAM(name, type) param_add(params, name, #name, type);
     #include "params_def.h"
     #undef PARAM
 }
 
-param_t param_find(const char *name) {
+param_t param_find(const param_context_t *params, const char *name) {
     uint32_t target_hash = param_hash(name);
 
-    for (param_t i = 0; i < param_count; i++) {
-        if (param_hash(param_table[i].name) == target_hash) {
+    for (param_t i = 0; i < PARAM_COUNT; i++) {
+        if (param_hash(params->table[i].name) == target_hash) {
             return i; // Return handle (index)
         }
     }
@@ -60,52 +37,52 @@ param_t param_find(const char *name) {
     return PARAM_INVALID; // Not found
 }
 
-int param_get(param_t param, void *val) {
-    if (param >= param_count || !param_table[param].is_set) {
+int param_get(const param_context_t *params, param_t param, void *val) {
+    if (param >= PARAM_COUNT || !params->table[param].is_set) {
         return -1; // Error: parameter not valid or not set
     }
 
-    switch (param_table[param].type) {
+    switch (params->table[param].type) {
         case PARAM_TYPE_INT32:
-            *((int32_t *)val) = param_table[param].value.i32_val;
+            *((int32_t *)val) = params->table[param].value.i32_val;
             return 0;
         case PARAM_TYPE_FLOAT:
-            *((float *)val) = param_table[param].value.float_val;
+            *((float *)val) = params->table[param].value.float_val;
             return 0;
         default:
             return -1; // Error: unknown type
     }
 }
 
-int param_set_int32(param_t param, int32_t val) {
-    if (param >= param_count || param_table[param].type != PARAM_TYPE_INT32) {
+int param_set_int32(param_context_t *params, param_t param, int32_t val) {
+    if (param >= PARAM_COUNT || params->table[param].type != PARAM_TYPE_INT32) {
         return -1; // Error
     }
-    param_table[param].value.i32_val = val;
-    param_table[param].is_set = true;
+    params->table[param].value.i32_val = val;
+    params->table[param].is_set = true;
     return 0;
 }
 
-int param_set_float(param_t param, float val) {
-    if (param >= param_count || param_table[param].type != PARAM_TYPE_FLOAT) {
+int param_set_float(param_context_t *params, param_t param, float val) {
+    if (param >= PARAM_COUNT || params->table[param].type != PARAM_TYPE_FLOAT) {
         return -1; // Error
     }
-    param_table[param].value.float_val = val;
-    param_table[param].is_set = true;
+    params->table[param].value.float_val = val;
+    params->table[param].is_set = true;
     return 0;
 }
 
-param_type_t param_get_type(param_t param) {
-    if (param >= param_count) {
+param_type_t param_get_type(const param_context_t *params, param_t param) {
+    if (param >= PARAM_COUNT) {
         return PARAM_TYPE_UNKNOWN;
     }
-    return param_table[param].type;
+    return params->table[param].type;
 }
 
 // Check if all parameters have been set
-bool param_all_set(void) {
-    for (param_t i = 0; i < param_count; i++) {
-        if (!param_table[i].is_set) {
+bool param_all_set(const param_context_t *params) {
+    for (param_t i = 0; i < PARAM_COUNT; i++) {
+        if (!params->table[i].is_set) {
             return false;
         }
     }
@@ -18,18 +18,37 @@ typedef uint16_t param_t;
 
 #define PARAM_INVALID 0xFFFF
 
-// Declare all parameter handles
-#define PARAM(name, type) extern param_t name;
+// Parameter handles are indices in declaration order, the same for every
+// parameter table
+enum {
+#define PARAM(name, type) name,
 #include "params_def.h"
 #undef PARAM
-
-void param_init(void);
-param_t param_find(const char *name);
-int param_get(param_t param, void *val);
-int param_set_int32(param_t param, int32_t val);
-int param_set_float(param_t param, float val);
-param_type_t param_get_type(param_t param);
-bool param_all_set(void);
+    PARAM_COUNT
+};
+
+typedef struct {
+    const char *name;
+    param_type_t type;
+    bool is_set;           // Flag indicating if parameter has been set
+    union {
+        int32_t i32_val;   // Integer value
+        float float_val;   // Float value
+    } value;
+} param_entry_t;
+
+// Values of one autopilot instance, owned by the caller
+typedef struct {
+    param_entry_t table[PARAM_COUNT];
+} param_context_t;
+
+void param_init(param_context_t *params);
+param_t param_find(const param_context_t *params, const char *name);
+int param_get(const param_context_t *params, param_t param, void *val);
+int param_set_int32(param_context_t *params, param_t param, int32_t val);
+int param_set_float(param_context_t *params, param_t param, float val);
+param_type_t param_get_type(const param_context_t *params, param_t param);
+bool param_all_set(const param_context_t *params);
 
 #ifdef __cplusplus
 }
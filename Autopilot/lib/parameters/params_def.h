@@ -14,10 +14,19 @@ PARAM(LND_FL_ALT, PARAM_TYPE_FLOAT) // Altitude to start flare, m
 PARAM(LND_FL_SINK, PARAM_TYPE_FLOAT) // Target sink rate for flare, m/s
 
 // Attitude Control
-PARAM(ATT_PTCH_KP, PARAM_TYPE_FLOAT) // Pitch control proportional gain
-PARAM(ATT_PTCH_KI, PARAM_TYPE_FLOAT) // Pitch control integral gain
-PARAM(ATT_ROLL_KP, PARAM_TYPE_FLOAT) // Roll control proportional gain
-PARAM(ATT_ROLL_KI, PARAM_TYPE_FLOAT) // Roll control integral gain
+PARAM(ATT_PTCH_KP, PARAM_TYPE_FLOAT) // Pitch angle gain, rate setpoint per angle error, 1/s
+PARAM(ATT_ROLL_KP, PARAM_TYPE_FLOAT) // Roll angle gain, rate setpoint per angle error, 1/s
+PARAM(ATT_RATE_MAX, PARAM_TYPE_FLOAT) // Maximum roll and pitch rate setpoint, deg/s
+PARAM(ATT_PR_KP, PARAM_TYPE_FLOAT) // Pitch rate proportional gain
+PARAM(ATT_PR_KI, PARAM_TYPE_FLOAT) // Pitch rate integral gain
+PARAM(ATT_PR_KD, PARAM_TYPE_FLOAT) // Pitch rate derivative gain
+PARAM(ATT_PR_FF, PARAM_TYPE_FLOAT) // Pitch rate feed forward
+PARAM(ATT_RR_KP, PARAM_TYPE_FLOAT) // Roll rate proportional gain
+PARAM(ATT_RR_KI, PARAM_TYPE_FLOAT) // Roll rate integral gain
+PARAM(ATT_RR_KD, PARAM_TYPE_FLOAT) // Roll rate derivative gain
+PARAM(ATT_RR_FF, PARAM_TYPE_FLOAT) // Roll rate feed forward
+PARAM(ATT_SP_CUTOFF, PARAM_TYPE_FLOAT) // Rate setpoint low pass cutoff, Hz
+PARAM(ATT_D_CUTOFF, PARAM_TYPE_FLOAT) // Rate derivative low pass cutoff, Hz
 
 // TECS
 PARAM(TECS_THR_KP, PARAM_TYPE_FLOAT) // Total energy control proportional gain
@@ -52,6 +61,9 @@ PARAM(PWM_REV_RUD, PARAM_TYPE_INT32) // Reverse rudder channel
 PARAM(PWM_REV_AUX1, PARAM_TYPE_INT32) // Reverse auxiliary channel 1
 PARAM(PWM_REV_AUX2, PARAM_TYPE_INT32) // Reverse auxiliary channel 2
 PARAM(PWM_REV_AUX3, PARAM_TYPE_INT32) // Reverse auxiliary channel 3
+PARAM(PWM_RATE_SRV, PARAM_TYPE_INT32) // Frame rate elevator and auxiliary channels, Hz
+PARAM(PWM_RATE_RUD, PARAM_TYPE_INT32) // Frame rate rudder, Hz
+PARAM(PWM_RATE_THR, PARAM_TYPE_INT32) // Frame rate throttle, Hz
 
 // RC transmitter input
 PARAM(RC_MAX_DUTY, PARAM_TYPE_INT32) // Stick input max duty, us
@@ -62,6 +74,16 @@ PARAM(AHRS_BETA_GAIN, PARAM_TYPE_FLOAT) // Madgwick filter beta gain
 PARAM(AHRS_MAG_DECL, PARAM_TYPE_FLOAT) // Magnetic declination, deg
 PARAM(AHRS_ACC_MAX, PARAM_TYPE_FLOAT) // Max accel for fusion, g
 
+// IMU filters
+PARAM(IMU_GYR_CUTOFF, PARAM_TYPE_FLOAT) // Gyro low pass cutoff, Hz, 0 to disable
+PARAM(IMU_ACC_CUTOFF, PARAM_TYPE_FLOAT) // Accel low pass cutoff, Hz, 0 to disable
+PARAM(IMU_NOTCH_FREQ, PARAM_TYPE_FLOAT) // Gyro notch center frequency, Hz, 0 to disable
+PARAM(IMU_NOTCH_BW, PARAM_TYPE_FLOAT) // Gyro notch bandwidth, Hz
+PARAM(IMU_DNF_EN, PARAM_TYPE_INT32) // Enable dynamic gyro notches tracking vibration peaks
+PARAM(IMU_DNF_MIN, PARAM_TYPE_FLOAT) // Dynamic notch search range minimum, Hz
+PARAM(IMU_DNF_MAX, PARAM_TYPE_FLOAT) // Dynamic notch search range maximum, Hz
+PARAM(IMU_DNF_BW, PARAM_TYPE_FLOAT) // Dynamic notch bandwidth, Hz
+
 // Sensor calibration
 PARAM(GYR_OFF_X, PARAM_TYPE_FLOAT)
 PARAM(GYR_OFF_Y, PARAM_TYPE_FLOAT)
@@ -84,7 +106,10 @@ PARAM(MAG_SI_ZZ, PARAM_TYPE_FLOAT)
 
 // Kalman filter
 PARAM(EKF_BARO_VAR, PARAM_TYPE_FLOAT) // Barometer variance
-PARAM(EKF_GNSS_VAR, PARAM_TYPE_FLOAT) // GNSS variance
+PARAM(EKF_GNSS_VAR, PARAM_TYPE_FLOAT) // Minimum GNSS position variance (m^2)
 PARAM(EKF_OF_VAR, PARAM_TYPE_FLOAT) // Optical flow variance
 PARAM(EKF_OF_MIN, PARAM_TYPE_INT32) // Minimum accepted reading, pixels/sec
 PARAM(EKF_OF_MAX, PARAM_TYPE_INT32) // Maximum accepted reading, pixels/sec
+
+// Logging
+PARAM(LOG_SENSORS, PARAM_TYPE_INT32) // Log every sensor sample for replay, 0 or 1
@@ -12,11 +12,7 @@ float PI_control::get_output(float state,
 {
     float error = setpoint - state;
 
-    if (kI != 0)
-    {
-    	_integral += error * dt;
-    	_integral = clamp(_integral, -integral_limit / kI, integral_limit / kI);
-    }
+    integrate(error, kI, integral_limit, dt);
 
     float output = trim + kP * error + kI * _integral;
     output = clamp(output, output_min, output_max);
@@ -29,6 +25,20 @@ float PI_control::get_integral()
 	return _integral;
 }
 
+void PI_control::reset()
+{
+	_integral = 0;
+}
+
+void PI_control::integrate(float error, float kI, float integral_limit, float dt)
+{
+    if (kI != 0)
+    {
+    	_integral += error * dt;
+    	_integral = clamp(_integral, -integral_limit / kI, integral_limit / kI);
+    }
+}
+
 float PI_control::clamp(float n, float min, float max)
 {
     if (n > max)
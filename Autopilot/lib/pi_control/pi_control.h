@@ -14,9 +14,13 @@ public:
     				 float trim,
 					 float dt);
     float get_integral();
+    void reset();
 
-private:
+protected:
     float _integral = 0;
+
+    // Anti-windup, keeps the integral term within +-integral_limit
+    void integrate(float error, float kI, float integral_limit, float dt);
     float clamp(float n, float min, float max);
 };
 
@@ -0,0 +1,73 @@
+#include "lib/pi_control/pid_control.h"
+
+float PID_control::get_output(float state,
+							  float setpoint,
+							  float kP,
+							  float kI,
+							  float kD,
+							  float kFF,
+							  float integral_limit,
+							  float output_min,
+							  float output_max,
+							  float trim,
+							  float setpoint_cutoff,
+							  float derivative_cutoff,
+							  float dt)
+{
+	if (!_initialized)
+	{
+		_setpoint = setpoint;
+		_last_state = state;
+		_derivative = 0;
+		_initialized = true;
+	}
+
+	_setpoint += lowpass_gain(setpoint_cutoff, dt) * (setpoint - _setpoint);
+
+	const float derivative = -(state - _last_state) / dt;
+	_last_state = state;
+	_derivative += lowpass_gain(derivative_cutoff, dt) * (derivative - _derivative);
+
+	const float error = _setpoint - state;
+
+	if (!(_saturation > 0 && error > 0) && !(_saturation < 0 && error < 0))
+	{
+		integrate(error, kI, integral_limit, dt);
+	}
+
+	const float output = trim + kFF * _setpoint + kP * error + kI * _integral + kD * _derivative;
+
+	if (output > output_max)
+	{
+		_saturation = 1;
+	}
+	else if (output < output_min)
+	{
+		_saturation = -1;
+	}
+	else
+	{
+		_saturation = 0;
+	}
+
+	return clamp(output, output_min, output_max);
+}
+
+void PID_control::reset()
+{
+	PI_control::reset();
+	_initialized = false;
+	_saturation = 0;
+}
+
+// Discrete first order low pass, alpha = dt / (dt + 1 / (2 pi fc))
+float PID_control::lowpass_gain(float cutoff, float dt)
+{
+	if (cutoff <= 0)
+	{
+		return 1;
+	}
+
+	const float rc = 1.0f / (6.28318531f * cutoff);
+	return dt / (dt + rc);
+}
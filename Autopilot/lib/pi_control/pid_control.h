@@ -0,0 +1,46 @@
+#ifndef LIB_PI_CONTROL_PID_CONTROL_H_
+#define LIB_PI_CONTROL_PID_CONTROL_H_
+
+#include "lib/pi_control/pi_control.h"
+
+/**
+ * @brief PID with setpoint filtering and feed forward, for inner loops
+ *
+ * The setpoint goes through a first order low pass before anything uses it.
+ * The derivative acts on the measurement, so setpoint steps do not kick,
+ * and is low pass filtered since it amplifies sensor noise. Feed forward
+ * scales the filtered setpoint. A cutoff of 0 disables that filter.
+ *
+ * Anti-windup is the integral clamp shared with PI_control. On top of that
+ * the integral is held while the output is saturated in the direction the
+ * error would push it.
+ */
+class PID_control : public PI_control
+{
+public:
+	float get_output(float state,
+					 float setpoint,
+					 float kP,
+					 float kI,
+					 float kD,
+					 float kFF,
+					 float integral_limit,
+					 float output_min,
+					 float output_max,
+					 float trim,
+					 float setpoint_cutoff,
+					 float derivative_cutoff,
+					 float dt);
+	void reset();
+
+private:
+	bool _initialized = false;
+	float _setpoint = 0;
+	float _last_state = 0;
+	float _derivative = 0;
+	int _saturation = 0; // Sign of the last saturated output, 0 if not saturated
+
+	static float lowpass_gain(float cutoff, float dt);
+};
+
+#endif /* LIB_PI_CONTROL_PID_CONTROL_H_ */
@@ -0,0 +1,17 @@
+#include "lib/pwm/pwm_scaling.h"
+
+// Reversing swaps which end of the input range gives out_min
+void Pwm_scaling::set(float in_min, float in_max, float out_min, float out_max, bool reverse)
+{
+	if (reverse)
+	{
+		const float temp = out_min;
+		out_min = out_max;
+		out_max = temp;
+	}
+
+	scale = in_max != in_min ? (out_max - out_min) / (in_max - in_min) : 0;
+	offset = out_min - scale * in_min;
+	pwm_min = out_min < out_max ? out_min : out_max;
+	pwm_max = out_min < out_max ? out_max : out_min;
+}
@@ -0,0 +1,46 @@
+#ifndef LIB_PWM_PWM_SCALING_H_
+#define LIB_PWM_PWM_SCALING_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Linear map from an input range to a pulse width
+ *
+ * Precomputed from the PWM parameters, so the mixer and the RC passthrough
+ * produce the same pulse for the same stick and the interrupt only does a
+ * multiply add. Inputs outside the range give the end pulse widths.
+ */
+struct Pwm_scaling
+{
+	float scale = 0; // us per input unit
+	float offset = 0; // us at an input of 0
+	float pwm_min = 0;
+	float pwm_max = 0;
+
+	void set(float in_min, float in_max, float out_min, float out_max, bool reverse);
+
+	uint16_t apply(float x) const
+	{
+		float pwm = scale * x + offset;
+
+		if (pwm < pwm_min) pwm = pwm_min;
+		if (pwm > pwm_max) pwm = pwm_max;
+
+		return (uint16_t)(pwm + 0.5f);
+	}
+};
+
+// Stick channels straight to the outputs in manual direct mode. Inputs are
+// raw receiver values.
+struct Rc_passthrough
+{
+	uint8_t ele_ch;
+	uint8_t rud_ch;
+	uint8_t thr_ch;
+	uint16_t conn_threshold; // Frames with the throttle channel at or below are dropped
+	Pwm_scaling ele;
+	Pwm_scaling rud;
+	Pwm_scaling thr;
+};
+
+#endif /* LIB_PWM_PWM_SCALING_H_ */
@@ -15,44 +15,6 @@ float clamp(float n, float min, float max)
     return n;
 }
 
-double lat_lon_to_distance(double lat_ref, double lon_ref, double lat, double lon) {
-    double earth_radius = 6378137.0; // Earth's radius in meters
-
-    double dLat = (lat - lat_ref) * M_PI / 180.0;
-    double dLon = (lon - lon_ref) * M_PI / 180.0;
-
-    double lat1 = lat_ref * M_PI / 180.0;
-    double lat2 = lat * M_PI / 180.0;
-
-    double a = sin(dLat / 2) * sin(dLat / 2) +
-               cos(lat1) * cos(lat2) * sin(dLon / 2) * sin(dLon / 2);
-
-    double c = 2 * atan2(sqrt(a), sqrt(1 - a));
-
-    return earth_radius * c; // Great-circle distance in meters
-}
-
-void lat_lon_to_meters(double lat_ref, double lon_ref, double lat, double lon, double *north, double *east) {
-	double earth_radius = 6378137.0;
-
-    double dLat = (lat - lat_ref) * M_PI / 180.0;
-    double dLon = (lon - lon_ref) * M_PI / 180.0;
-
-    double meanLat = (lat + lat_ref) / 2.0 * M_PI / 180.0;
-
-    *north = dLat * earth_radius;
-    *east = dLon * earth_radius * cos(meanLat);
-}
-
-void meters_to_lat_lon(double north, double east, double refLat, double refLon, double *lat, double *lon) {
-	double earth_radius = 6378137.0;
-
-    double refLatRad = refLat * M_PI / 180.0;
-
-    *lat = refLat + (north / earth_radius) * (180.0 / M_PI);
-    *lon = refLon + (east / (earth_radius * cos(refLatRad))) * (180.0 / M_PI);
-}
-
 float map(float x, float in_min, float in_max, float out_min, float out_max) {
     // Ensure the input value is within the input range
     if (x < in_min) {
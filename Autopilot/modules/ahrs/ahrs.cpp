@@ -1,7 +1,7 @@
 #include "modules/ahrs/ahrs.h"
 
-AHRS::AHRS(HAL* hal, DataBus* data_bus)
-	: Module(hal, data_bus),
+AHRS::AHRS(HAL* hal, DataBus* data_bus, param_context_t* params)
+	: Module(hal, data_bus, params),
 	  avg_ax(window_size, window_ax),
 	  avg_ay(window_size, window_ay),
 	  avg_az(window_size, window_az),
@@ -17,22 +17,32 @@ AHRS::AHRS(HAL* hal, DataBus* data_bus)
 
 void AHRS::parameters_update()
 {
-	param_get(AHRS_MAG_DECL, &_mag_decl);
-	param_get(AHRS_BETA_GAIN, &_ahrs_beta_gain);
-	param_get(AHRS_ACC_MAX, &_ahrs_acc_max);
+	param_get(_params, AHRS_MAG_DECL, &_mag_decl);
+	param_get(_params, AHRS_BETA_GAIN, &_ahrs_beta_gain);
+	param_get(_params, AHRS_ACC_MAX, &_ahrs_acc_max);
 
-	filter.set_dt(_dt);
 	filter.set_beta(_ahrs_beta_gain);
+
+	update_declination();
+}
+
+void AHRS::update_declination()
+{
+	if (_mag_decl == _decl_cached)
+	{
+		return;
+	}
+
+	const float half_angle = 0.5f * (180.0f + _mag_decl) * DEG_TO_RAD;
+	_decl_q0 = cosf(half_angle);
+	_decl_q3 = sinf(half_angle);
+	_decl_cached = _mag_decl;
 }
 
 void AHRS::update()
 {
 	parameters_update();
 
-	const uint64_t time = _hal->get_time_us();
-	_dt = clamp((time - _last_time) * US_TO_S, DT_MIN, DT_MAX);
-	_last_time = time;
-
 	_modes_data = _modes_sub.get();
 
 	if (_modes_data.system_mode != System_mode::LOAD_PARAMS)
@@ -54,6 +64,7 @@ void AHRS::update_initialization()
 	{
 		_imu_data = _imu_sub.get();
 		_mag_data = _mag_sub.get();
+		_last_time = _imu_data.timestamp;
 
 		avg_ax.add(_imu_data.ax);
 		avg_ay.add(_imu_data.ay);
@@ -77,6 +88,11 @@ void AHRS::update_running()
 	{
 		_imu_data = _imu_sub.get();
 
+		// Integrate over the time between samples, not between calls
+		_dt = clamp((_imu_data.timestamp - _last_time) * US_TO_S, DT_MIN, DT_MAX);
+		_last_time = _imu_data.timestamp;
+		filter.set_dt(_dt);
+
 		if (is_accel_reliable())
 		{
 			if (_mag_sub.check_new())
@@ -118,14 +134,47 @@ void AHRS::update_gyro()
 
 void AHRS::publish_ahrs()
 {
-	_ahrs_data.roll = filter.getRoll();
-	_ahrs_data.pitch = filter.getPitch();
+	const float q0 = filter.get_q0();
+	const float q1 = filter.get_q1();
+	const float q2 = filter.get_q2();
+	const float q3 = filter.get_q3();
 
-	// Add magnetic declination and normalize to [-180, 180]
+	// Rotate about down by 180 deg plus magnetic declination
 	// TODO: THIS DOES NOT WORK BECAUSE IF MAG IS TURNED OFF... IT WILL SUBTRACT DECL EVEN IF THERES NONE
-	_ahrs_data.yaw = fmod(filter.getYaw() + _mag_decl + 180.0f, 360.0f) - 180.0f;
-
-	_ahrs_data.timestamp = _hal->get_time_us();
+	float* q = _ahrs_data.q;
+	q[0] = _decl_q0 * q0 - _decl_q3 * q3;
+	q[1] = _decl_q0 * q1 - _decl_q3 * q2;
+	q[2] = _decl_q0 * q2 + _decl_q3 * q1;
+	q[3] = _decl_q0 * q3 + _decl_q3 * q0;
+
+	const float q0q0 = q[0] * q[0];
+	const float q0q1 = q[0] * q[1];
+	const float q0q2 = q[0] * q[2];
+	const float q0q3 = q[0] * q[3];
+	const float q1q1 = q[1] * q[1];
+	const float q1q2 = q[1] * q[2];
+	const float q1q3 = q[1] * q[3];
+	const float q2q2 = q[2] * q[2];
+	const float q2q3 = q[2] * q[3];
+	const float q3q3 = q[3] * q[3];
+
+	float (*dcm)[3] = _ahrs_data.dcm;
+	dcm[0][0] = q0q0 + q1q1 - q2q2 - q3q3;
+	dcm[0][1] = 2.0f * (q1q2 - q0q3);
+	dcm[0][2] = 2.0f * (q1q3 + q0q2);
+	dcm[1][0] = 2.0f * (q1q2 + q0q3);
+	dcm[1][1] = q0q0 - q1q1 + q2q2 - q3q3;
+	dcm[1][2] = 2.0f * (q2q3 - q0q1);
+	dcm[2][0] = 2.0f * (q1q3 - q0q2);
+	dcm[2][1] = 2.0f * (q2q3 + q0q1);
+	dcm[2][2] = q0q0 - q1q1 - q2q2 + q3q3;
+
+	// Yaw comes out of atan2 already in [-180, 180]
+	_ahrs_data.roll = fast_atan2f(dcm[2][1], dcm[2][2]) * RAD_TO_DEG;
+	_ahrs_data.pitch = -fast_asinf(dcm[2][0]) * RAD_TO_DEG;
+	_ahrs_data.yaw = fast_atan2f(dcm[1][0], dcm[0][0]) * RAD_TO_DEG;
+
+	_ahrs_data.timestamp = _imu_data.timestamp;
 
 	_ahrs_pub.publish(_ahrs_data);
 }
@@ -141,9 +190,9 @@ void AHRS::set_initial_angles()
 	float mz = -avg_mz.getAverage();
 
 	float roll_initial = atan2f(ay, az);
-	float pitch_initial = atan2f(-ax, sqrtf(powf(ay, 2) + powf(az, 2)));
+	float pitch_initial = atan2f(-ax, sqrtf(ay * ay + az * az));
 
-	float norm = sqrtf(powf(mx, 2) + powf(my, 2) + powf(mz, 2));
+	float norm = sqrtf(mx * mx + my * my + mz * mz);
 
 	if (norm == 0)
 	{
@@ -182,9 +231,9 @@ void AHRS::set_initial_angles()
 
 bool AHRS::is_accel_reliable()
 {
-	float accel_magnitude = sqrtf(powf(_imu_data.ax, 2) +
-								  powf(_imu_data.ay, 2) +
-								  powf(_imu_data.az, 2));
+	float accel_magnitude = fast_sqrtf(_imu_data.ax * _imu_data.ax +
+									   _imu_data.ay * _imu_data.ay +
+									   _imu_data.az * _imu_data.az);
 
 	// Assuming 1g reference
 	return fabs(accel_magnitude - 1.0f) < _ahrs_acc_max;
@@ -6,6 +6,7 @@
 #include <lib/module/module.h>
 #include "lib/data_bus/data_bus.h"
 #include "lib/madgwick/madgwick.h"
+#include "lib/fastmath/fastmath.h"
 #include "lib/moving_average/moving_avg.h"
 #include "lib/parameters/params.h"
 #include "lib/utils/utils.h"
@@ -15,7 +16,7 @@
 class AHRS : public Module
 {
 public:
-    AHRS(HAL* hal, DataBus* data_bus);
+    AHRS(HAL* hal, DataBus* data_bus, param_context_t* params);
 
     void update() override;
 
@@ -55,7 +56,13 @@ private:
 	float _ahrs_beta_gain;
 	float _ahrs_acc_max;
 
+	// Yaw offset quaternion (rotation of 180 deg + declination about down)
+	float _decl_cached = NAN;
+	float _decl_q0 = 1;
+	float _decl_q3 = 0;
+
 	void parameters_update();
+	void update_declination();
 
 	void update_initialization();
 	void update_running();
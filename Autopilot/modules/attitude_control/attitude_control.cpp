@@ -1,8 +1,9 @@
 #include "attitude_control.h"
 
-AttitudeControl::AttitudeControl(HAL* hal, DataBus* data_bus)
-	: Module(hal, data_bus),
+AttitudeControl::AttitudeControl(HAL* hal, DataBus* data_bus, param_context_t* params)
+	: Module(hal, data_bus, params),
 	  _ahrs_sub(data_bus->ahrs_node),
+	  _imu_sub(data_bus->imu_node),
 	  _modes_sub(data_bus->modes_node),
 	  _position_control_sub(data_bus->position_control_node),
 	  _rc_sub(data_bus->rc_node),
@@ -10,26 +11,37 @@ AttitudeControl::AttitudeControl(HAL* hal, DataBus* data_bus)
 {
 }
 
-// TODO: Reset integrals when mode change detected
-
+// Step between the attitude samples being controlled
 void AttitudeControl::update_time()
 {
-	const uint64_t time = _hal->get_time_us();
-	_dt = clamp((time - _last_time) * US_TO_S, DT_MIN, DT_MAX);
-	_last_time = time;
+	if (_ahrs_data.timestamp != _last_time)
+	{
+		_dt = clamp((_ahrs_data.timestamp - _last_time) * US_TO_S, DT_MIN, DT_MAX);
+		_last_time = _ahrs_data.timestamp;
+	}
 }
 
 void AttitudeControl::update_parameters()
 {
-	param_get(ATT_ROLL_KP, &_roll_kp);
-	param_get(ATT_ROLL_KI, &_roll_ki);
-	param_get(ATT_PTCH_KP, &_ptch_kp);
-	param_get(ATT_PTCH_KI, &_ptch_ki);
+	param_get(_params, ATT_ROLL_KP, &_roll_kp);
+	param_get(_params, ATT_PTCH_KP, &_ptch_kp);
+	param_get(_params, ATT_RATE_MAX, &_rate_max);
+	param_get(_params, ATT_RR_KP, &_roll_rate_kp);
+	param_get(_params, ATT_RR_KI, &_roll_rate_ki);
+	param_get(_params, ATT_RR_KD, &_roll_rate_kd);
+	param_get(_params, ATT_RR_FF, &_roll_rate_ff);
+	param_get(_params, ATT_PR_KP, &_ptch_rate_kp);
+	param_get(_params, ATT_PR_KI, &_ptch_rate_ki);
+	param_get(_params, ATT_PR_KD, &_ptch_rate_kd);
+	param_get(_params, ATT_PR_FF, &_ptch_rate_ff);
+	param_get(_params, ATT_SP_CUTOFF, &_sp_cutoff);
+	param_get(_params, ATT_D_CUTOFF, &_d_cutoff);
 }
 
 void AttitudeControl::poll_vehicle_data()
 {
 	_ahrs_data = _ahrs_sub.get();
+	_imu_data = _imu_sub.get();
 	_modes_data = _modes_sub.get();
 	_position_control = _position_control_sub.get();
 	_rc_data = _rc_sub.get();
@@ -37,9 +49,9 @@ void AttitudeControl::poll_vehicle_data()
 
 void AttitudeControl::update()
 {
-	update_time();
 	update_parameters();
 	poll_vehicle_data();
+	update_time();
 
 	if (_modes_data.system_mode == System_mode::FLIGHT)
 	{
@@ -72,6 +84,8 @@ void AttitudeControl::handle_manual_mode()
 
 void AttitudeControl::update_direct()
 {
+	reset_controllers();
+
 	_ctrl_cmd_data.rud_cmd = _rc_data.ail_norm;
 	_ctrl_cmd_data.ele_cmd = _rc_data.ele_norm;
 }
@@ -94,13 +108,43 @@ void AttitudeControl::publish_status()
 
 void AttitudeControl::control_roll_ptch()
 {
-	_ctrl_cmd_data.rud_cmd = roll_controller.get_output(
-		_ahrs_data.roll, _position_control.roll_setpoint,
-		_roll_kp, _roll_ki, 1, -1, 1, 0, _dt
+	if (_ahrs_data.timestamp - _angle_loop_time >= ANGLE_LOOP_PERIOD_US)
+	{
+		_angle_loop_time = _ahrs_data.timestamp;
+		control_angle();
+	}
+
+	control_rate();
+}
+
+void AttitudeControl::control_angle()
+{
+	_roll_rate_setpoint = clamp(_roll_kp * (_position_control.roll_setpoint - _ahrs_data.roll),
+								-_rate_max, _rate_max);
+	_pitch_rate_setpoint = clamp(_ptch_kp * (_position_control.pitch_setpoint - _ahrs_data.pitch),
+								 -_rate_max, _rate_max);
+}
+
+// Euler rate setpoints are tracked as body rates, close enough at the bank
+// and pitch angles a plane flies at
+void AttitudeControl::control_rate()
+{
+	_ctrl_cmd_data.rud_cmd = roll_rate_controller.get_output(
+		_imu_data.gx, _roll_rate_setpoint,
+		_roll_rate_kp, _roll_rate_ki, _roll_rate_kd, _roll_rate_ff,
+		RATE_INTEGRAL_LIMIT, -1, 1, 0, _sp_cutoff, _d_cutoff, _dt
 	);
 
-	_ctrl_cmd_data.ele_cmd = pitch_controller.get_output(
-		_ahrs_data.pitch, _position_control.pitch_setpoint,
-		_ptch_kp, _ptch_ki, 1, -1, 1, 0, _dt
+	_ctrl_cmd_data.ele_cmd = pitch_rate_controller.get_output(
+		_imu_data.gy, _pitch_rate_setpoint,
+		_ptch_rate_kp, _ptch_rate_ki, _ptch_rate_kd, _ptch_rate_ff,
+		RATE_INTEGRAL_LIMIT, -1, 1, 0, _sp_cutoff, _d_cutoff, _dt
 	);
 }
+
+void AttitudeControl::reset_controllers()
+{
+	roll_rate_controller.reset();
+	pitch_rate_controller.reset();
+	_angle_loop_time = 0;
+}
@@ -4,27 +4,41 @@
 #include <lib/constants/constants.h>
 #include <lib/hal/hal.h>
 #include <lib/module/module.h>
-#include "lib/pi_control/pi_control.h"
+#include "lib/pi_control/pid_control.h"
 #include "lib/utils/utils.h"
 #include "lib/parameters/params.h"
 #include <math.h>
 #include <cstdio>
 
+/**
+ * @brief Roll and pitch control, cascaded angle and rate loops
+ *
+ * Runs on every attitude sample. The outer loop turns angle error into a
+ * rate setpoint at ANGLE_LOOP_PERIOD_US, the inner loop tracks it against
+ * the gyro on every sample.
+ */
 class AttitudeControl : public Module
 {
 public:
-	AttitudeControl(HAL* hal, DataBus* data_bus);
+	AttitudeControl(HAL* hal, DataBus* data_bus, param_context_t* params);
 
 	void update() override;
 
 private:
+	static constexpr uint64_t ANGLE_LOOP_PERIOD_US = 10000;
+	static constexpr float RATE_INTEGRAL_LIMIT = 1;
+
 	uint64_t _last_time = 0;
 	float _dt = 0;
+	uint64_t _angle_loop_time = 0;
 
-	PI_control roll_controller;
-	PI_control pitch_controller;
+	PID_control roll_rate_controller;
+	PID_control pitch_rate_controller;
+	float _roll_rate_setpoint = 0; // deg/s
+	float _pitch_rate_setpoint = 0;
 
 	Subscriber<AHRS_data> _ahrs_sub;
+	Subscriber<IMU_data> _imu_sub;
 	Subscriber<position_control_s> _position_control_sub;
 	Subscriber<Modes_data> _modes_sub;
 	Subscriber<RC_data> _rc_sub;
@@ -32,6 +46,7 @@ private:
 	Publisher<Ctrl_cmd_data> _ctrl_cmd_pub;
 
 	AHRS_data _ahrs_data;
+	IMU_data _imu_data;
 	RC_data _rc_data;
 	position_control_s _position_control;
 	Modes_data _modes_data;
@@ -39,9 +54,18 @@ private:
 
 	// Parameters
 	float _roll_kp;
-	float _roll_ki;
 	float _ptch_kp;
-	float _ptch_ki;
+	float _rate_max;
+	float _roll_rate_kp;
+	float _roll_rate_ki;
+	float _roll_rate_kd;
+	float _roll_rate_ff;
+	float _ptch_rate_kp;
+	float _ptch_rate_ki;
+	float _ptch_rate_kd;
+	float _ptch_rate_ff;
+	float _sp_cutoff;
+	float _d_cutoff;
 
 	void update_time();
 	void update_parameters();
@@ -55,6 +79,9 @@ private:
 	void publish_status();
 
 	void control_roll_ptch();
+	void control_angle();
+	void control_rate();
+	void reset_controllers();
 };
 
 #endif /* CONTROL_H_ */
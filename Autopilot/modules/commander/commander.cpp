@@ -1,7 +1,8 @@
 #include "modules/commander/commander.h"
 
-Commander::Commander(HAL* hal, DataBus* data_bus)
-	: Module(hal, data_bus),
+Commander::Commander(HAL* hal, DataBus* data_bus, param_context_t* params, mission_context_t* mission)
+	: Module(hal, data_bus, params),
+	  _mission(mission),
 	  _ahrs_sub(data_bus->ahrs_node),
 	  _local_pos_sub(data_bus->local_position_node),
 	  _rc_sub(data_bus->rc_node),
@@ -17,8 +18,8 @@ Commander::Commander(HAL* hal, DataBus* data_bus)
 
 void Commander::update_parameters()
 {
-	param_get(TKO_ALT, &_takeoff_alt);
-	param_get(LND_FL_ALT, &_flare_alt);
+	param_get(_params, TKO_ALT, &_takeoff_alt);
+	param_get(_params, LND_FL_ALT, &_flare_alt);
 }
 
 void Commander::poll_vehicle_data()
@@ -52,7 +53,7 @@ void Commander::update()
 
 void Commander::update_config()
 {
-	if (param_all_set())
+	if (param_all_set(_params))
 	{
 		_modes_data.system_mode = System_mode::STARTUP;
 	}
@@ -68,8 +69,9 @@ void Commander::update_startup()
 		_local_pos.converged &&
 		_rc_data.tx_conn &&
 		transmitter_safe &&
-		mission_get().mission_type != MISSION_EMPTY &&
-		mission_check_altitude_set())
+		mission_get(_mission)->mission_type != MISSION_EMPTY &&
+		mission_check_usable(_mission) &&
+		mission_check_altitude_set(_mission))
 	{
 		_modes_data.system_mode = System_mode::FLIGHT;
 	}
@@ -13,11 +13,13 @@ static constexpr float TAKEOFF_DETECT_THR = 0.9;
 class Commander : public Module
 {
 public:
-	Commander(HAL* hal, DataBus* data_bus);
+	Commander(HAL* hal, DataBus* data_bus, param_context_t* params, mission_context_t* mission);
 
 	void update() override;
 
 private:
+	mission_context_t* _mission;
+
 	Subscriber<AHRS_data> _ahrs_sub;
 	Subscriber<local_position_s> _local_pos_sub;
 	Subscriber<RC_data> _rc_sub;
@@ -0,0 +1,241 @@
+#include "modules/mission_storage/mission_storage.h"
+
+MissionStorage::MissionStorage(HAL* hal, DataBus* data_bus, param_context_t* params, mission_context_t* mission)
+	: Module(hal, data_bus, params),
+	  _mission(mission)
+{
+}
+
+void MissionStorage::update()
+{
+	bool success;
+	if (!_hal->mission_file_ready(&success))
+	{
+		return;
+	}
+
+	if (_request != Request::NONE)
+	{
+		finish_request(success);
+		_request = Request::NONE;
+	}
+
+	if (start_load())
+	{
+		return;
+	}
+
+	// Refilling the window comes first unless the card stopped answering,
+	// then uploads are still allowed to fall back to RAM
+	if (_window_failures > 0)
+	{
+		if (!start_save())
+		{
+			start_window();
+		}
+	}
+	else if (!start_window())
+	{
+		start_save();
+	}
+}
+
+void MissionStorage::finish_request(bool success)
+{
+	switch (_request)
+	{
+	case Request::LOAD_HEADER:
+		if (success && mission_check_header(&_load_header) &&
+			mission_get_upload_state(_mission) == MISSION_UPLOAD_IDLE &&
+			(!mission_check_loaded(_mission) || (int32_t)(_load_header.sequence - mission_get(_mission)->sequence) > 0))
+		{
+			*mission_get_staging(_mission) = _load_header;
+			mission_commit_update(_mission, _load_file);
+			printf("Mission loaded from file %d, %d items\n", _load_file, _load_header.num_items);
+		}
+
+		_load_file++;
+		break;
+	case Request::LOAD_CHUNK:
+		if (mission_window_release(_mission, _chunk, success))
+		{
+			_window_failures = 0;
+			break;
+		}
+
+		_window_failures++;
+
+		if (_window_failures == 1)
+		{
+			printf("Mission chunk %d failed to load, retrying\n", _chunk);
+		}
+
+		if (_window_failures >= MISSION_CHUNK_RETRIES)
+		{
+			mission_window_set_failed(_mission);
+			printf("Mission chunk %d failed %d times, mission unusable\n", _chunk, _window_failures);
+		}
+		else
+		{
+			_window_retry_time = _hal->get_time_us() + (MISSION_CHUNK_RETRY_DELAY_US << (_window_failures - 1));
+		}
+		break;
+	case Request::CLEAR_HEADER:
+	case Request::SAVE_CHUNK:
+	case Request::SAVE_HEADER:
+		// Ignore results from an upload that has since been restarted
+		if (mission_get_upload_id(_mission) != _upload_id ||
+			mission_get_upload_state(_mission) != MISSION_UPLOAD_RECEIVING)
+		{
+			break;
+		}
+
+		if (!success)
+		{
+			save_failed();
+		}
+		else if (_request == Request::SAVE_CHUNK)
+		{
+			mission_upload_chunk_done(_mission, _chunk);
+		}
+		else if (_request == Request::SAVE_HEADER)
+		{
+			mission_commit_update(_mission, mission_get_file(_mission) ^ 1);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+// Check both files at boot, the newest valid one becomes the active mission
+bool MissionStorage::start_load()
+{
+	if (_load_file >= 2)
+	{
+		return false;
+	}
+
+	// An upload started before the card was read takes precedence
+	if (mission_get_upload_state(_mission) != MISSION_UPLOAD_IDLE)
+	{
+		_load_file = 2;
+		return false;
+	}
+
+	if (_hal->read_mission_file(_load_file, 0, &_load_header, sizeof(_load_header)))
+	{
+		_request = Request::LOAD_HEADER;
+	}
+
+	return true;
+}
+
+bool MissionStorage::start_window()
+{
+	// Every mission gets a fresh set of retries
+	if (mission_get_version(_mission) != _window_mission_version)
+	{
+		_window_mission_version = mission_get_version(_mission);
+		_window_failures = 0;
+	}
+
+	uint16_t chunk;
+	if (!mission_window_get_missing(_mission, &chunk) ||
+		(_window_failures > 0 && _hal->get_time_us() < _window_retry_time))
+	{
+		return false;
+	}
+
+	mission_chunk_t* buffer = mission_window_claim(_mission, chunk);
+
+	if (_hal->read_mission_file(mission_get_file(_mission), mission_chunk_offset(chunk), buffer, sizeof(*buffer)))
+	{
+		_chunk = chunk;
+		_request = Request::LOAD_CHUNK;
+	}
+
+	return true;
+}
+
+// Uploads go to the inactive file. Its header is cleared first and written
+// last, so the file is only valid once every chunk is on the card.
+bool MissionStorage::start_save()
+{
+	if (mission_get_upload_state(_mission) != MISSION_UPLOAD_RECEIVING)
+	{
+		return false;
+	}
+
+	const uint8_t file = mission_get_file(_mission) ^ 1;
+
+	if (mission_get_upload_id(_mission) != _upload_id)
+	{
+		_upload_id = mission_get_upload_id(_mission);
+		_upload_ram_only = false;
+
+		if (_hal->write_mission_file(file, 0, &_empty_header, sizeof(_empty_header)))
+		{
+			_request = Request::CLEAR_HEADER;
+		}
+
+		return true;
+	}
+
+	uint16_t chunk;
+	const mission_chunk_t* buffer = mission_upload_get_chunk(_mission, &chunk);
+
+	if (buffer != nullptr)
+	{
+		if (_upload_ram_only)
+		{
+			mission_upload_chunk_done(_mission, chunk);
+			return false;
+		}
+
+		if (_hal->write_mission_file(file, mission_chunk_offset(chunk), buffer, sizeof(*buffer)))
+		{
+			_chunk = chunk;
+			_request = Request::SAVE_CHUNK;
+		}
+
+		return true;
+	}
+
+	const mission_data_t* header = mission_upload_get_header(_mission);
+
+	if (header != nullptr)
+	{
+		if (_upload_ram_only)
+		{
+			// Keep the old file active so it is what loads on the next boot
+			mission_commit_update(_mission, mission_get_file(_mission));
+			printf("Mission not saved, flying from RAM\n");
+			return false;
+		}
+
+		if (_hal->write_mission_file(file, 0, header, sizeof(*header)))
+		{
+			_request = Request::SAVE_HEADER;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+// Missions that fit in the window never need to be read back, so they can
+// still be flown without a card. Anything longer is rejected.
+void MissionStorage::save_failed()
+{
+	if (mission_get_staging(_mission)->num_items <= MISSION_WINDOW_ITEMS)
+	{
+		_upload_ram_only = true;
+	}
+	else
+	{
+		mission_abort_update(_mission);
+		printf("Mission save failed\n");
+	}
+}
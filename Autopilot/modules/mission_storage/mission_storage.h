@@ -0,0 +1,66 @@
+#ifndef MODULES_MISSION_STORAGE_MISSION_STORAGE_H_
+#define MODULES_MISSION_STORAGE_MISSION_STORAGE_H_
+
+#include <lib/hal/hal.h>
+#include <lib/module/module.h>
+#include "lib/mission/mission.h"
+#include <stdio.h>
+
+// Reads of a window chunk that fails its CRC or read are retried with a
+// doubling delay, then the mission is flagged unusable
+static constexpr uint8_t MISSION_CHUNK_RETRIES = 5;
+static constexpr uint64_t MISSION_CHUNK_RETRY_DELAY_US = 50000;
+
+/**
+ * @brief Moves missions between the SD card and the in RAM mission store
+ *
+ * Loads the newest valid mission file at boot, keeps the mission window
+ * filled around the current waypoint and saves uploads. The HAL services one
+ * file request at a time, so each update either finishes the request in
+ * flight or starts the next one.
+ */
+class MissionStorage : public Module
+{
+public:
+	MissionStorage(HAL* hal, DataBus* data_bus, param_context_t* params, mission_context_t* mission);
+
+	void update() override;
+
+private:
+	mission_context_t* _mission;
+
+	enum class Request
+	{
+		NONE,
+		LOAD_HEADER,
+		LOAD_CHUNK,
+		CLEAR_HEADER,
+		SAVE_CHUNK,
+		SAVE_HEADER
+	};
+
+	Request _request = Request::NONE;
+	uint16_t _chunk = 0;
+
+	// Boot
+	uint8_t _load_file = 0;
+	mission_data_t _load_header{};
+
+	// Window
+	uint8_t _window_failures = 0; // Consecutive failed chunk reads
+	uint64_t _window_retry_time = 0;
+	uint8_t _window_mission_version = 0;
+
+	// Upload
+	uint8_t _upload_id = 0;
+	bool _upload_ram_only = false;
+	const mission_data_t _empty_header{};
+
+	void finish_request(bool success);
+	bool start_load();
+	bool start_window();
+	bool start_save();
+	void save_failed();
+};
+
+#endif /* MODULES_MISSION_STORAGE_MISSION_STORAGE_H_ */
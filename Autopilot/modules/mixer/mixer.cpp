@@ -1,7 +1,7 @@
 #include "modules/mixer/mixer.h"
 
-Mixer::Mixer(HAL* hal, DataBus* data_bus)
-	: Module(hal, data_bus),
+Mixer::Mixer(HAL* hal, DataBus* data_bus, param_context_t* params)
+	: Module(hal, data_bus, params),
 	  _modes_sub(data_bus->modes_node),
 	  _ctrl_cmd_sub(data_bus->ctrl_cmd_node),
 	  _position_control_sub(data_bus->position_control_node),
@@ -11,30 +11,71 @@ Mixer::Mixer(HAL* hal, DataBus* data_bus)
 
 void Mixer::parameters_update()
 {
-	param_get(PWM_MIN_ELE, &_pwm_min_ele);
-	param_get(PWM_MAX_ELE, &_pwm_max_ele);
-	param_get(PWM_MIN_RUD, &_pwm_min_rud);
-	param_get(PWM_MAX_RUD, &_pwm_max_rud);
-	param_get(PWM_MIN_THR, &_pwm_min_thr);
-	param_get(PWM_MAX_THR, &_pwm_max_thr);
-	param_get(PWM_REV_ELE, &_rev_ele);
-	param_get(PWM_REV_RUD, &_rev_rud);
+	param_get(_params, PWM_MIN_ELE, &_pwm_min_ele);
+	param_get(_params, PWM_MAX_ELE, &_pwm_max_ele);
+	param_get(_params, PWM_MIN_RUD, &_pwm_min_rud);
+	param_get(_params, PWM_MAX_RUD, &_pwm_max_rud);
+	param_get(_params, PWM_MIN_THR, &_pwm_min_thr);
+	param_get(_params, PWM_MAX_THR, &_pwm_max_thr);
+	param_get(_params, PWM_REV_ELE, &_rev_ele);
+	param_get(_params, PWM_REV_RUD, &_rev_rud);
+	param_get(_params, PWM_RATE_SRV, &_pwm_rate[PWM_GROUP_SERVOS]);
+	param_get(_params, PWM_RATE_RUD, &_pwm_rate[PWM_GROUP_RUDDER]);
+	param_get(_params, PWM_RATE_THR, &_pwm_rate[PWM_GROUP_THROTTLE]);
+	param_get(_params, RC_MIN_DUTY, &_rc_min_duty);
+	param_get(_params, RC_MAX_DUTY, &_rc_max_duty);
+}
+
+// The passthrough maps the receiver range straight to the outputs, the same
+// as RCHandler normalizing it followed by the mixer
+void Mixer::update_scaling()
+{
+	_ele_scaling.set(-1, 1, _pwm_min_ele, _pwm_max_ele, _rev_ele);
+	_rud_scaling.set(-1, 1, _pwm_min_rud, _pwm_max_rud, _rev_rud);
+	_thr_scaling.set(0, 1, _pwm_min_thr, _pwm_max_thr, false);
+
+	_passthrough.ele_ch = ELE_CH;
+	_passthrough.rud_ch = AIL_CH;
+	_passthrough.thr_ch = THR_CH;
+	_passthrough.conn_threshold = TX_CONN_THRESHOLD;
+	_passthrough.ele.set(_rc_min_duty, _rc_max_duty, _pwm_min_ele, _pwm_max_ele, _rev_ele);
+	_passthrough.rud.set(_rc_min_duty, _rc_max_duty, _pwm_min_rud, _pwm_max_rud, _rev_rud);
+	_passthrough.thr.set(_rc_min_duty, _rc_max_duty, _pwm_min_thr, _pwm_max_thr, false);
+}
+
+// Only written when changed, the HAL clamps to what the timers support
+void Mixer::update_rates()
+{
+	for (uint8_t i = 0; i < PWM_GROUP_COUNT; i++)
+	{
+		const uint16_t rate = clamp(_pwm_rate[i], 0, UINT16_MAX);
+
+		if (rate != _applied_rate[i])
+		{
+			_hal->set_pwm_rate((Pwm_group)i, rate);
+			_applied_rate[i] = rate;
+		}
+	}
 }
 
 void Mixer::update()
 {
 	parameters_update();
+	update_scaling();
 
 	_modes_data = _modes_sub.get();
 	_position_control = _position_control_sub.get();
 	_ctrl_cmd_data = _ctrl_cmd_sub.get();
 
+	update_passthrough();
+
 	switch (_modes_data.system_mode)
 	{
 	case System_mode::LOAD_PARAMS:
 		update_config();
 		break;
 	case System_mode::STARTUP:
+		update_rates();
 		update_startup();
 		break;
 	case System_mode::FLIGHT:
@@ -43,6 +84,27 @@ void Mixer::update()
 	}
 }
 
+// In manual direct mode the HAL drives the outputs from the receiver
+// interrupt, so the sticks skip the main task and the modules in between.
+// Sent on every update so parameter changes apply.
+void Mixer::update_passthrough()
+{
+	const bool active = _modes_data.system_mode == System_mode::FLIGHT &&
+						_modes_data.flight_mode == Flight_mode::MANUAL &&
+						_modes_data.manual_mode == Manual_mode::DIRECT;
+
+	if (active)
+	{
+		_hal->set_rc_passthrough(&_passthrough);
+	}
+	else if (_passthrough_active)
+	{
+		_hal->set_rc_passthrough(nullptr);
+	}
+
+	_passthrough_active = active;
+}
+
 void Mixer::update_config()
 {
 	_hal->set_pwm(0, 0, 0, 0, 0, 0);
@@ -55,17 +117,9 @@ void Mixer::update_startup()
 
 void Mixer::update_flight()
 {
-	_elevator_duty = map(
-		_rev_ele ? -_ctrl_cmd_data.ele_cmd : _ctrl_cmd_data.ele_cmd,
-		-1, 1, _pwm_min_ele, _pwm_max_ele
-	);
-
-	_rudder_duty = map(
-		_rev_rud ? -_ctrl_cmd_data.rud_cmd : _ctrl_cmd_data.rud_cmd,
-	    -1, 1, _pwm_min_rud, _pwm_max_rud
-	);
-
-	_throttle_duty = map(_position_control.throttle_setpoint, 0, 1, _pwm_min_thr, _pwm_max_thr);
+	_elevator_duty = _ele_scaling.apply(_ctrl_cmd_data.ele_cmd);
+	_rudder_duty = _rud_scaling.apply(_ctrl_cmd_data.rud_cmd);
+	_throttle_duty = _thr_scaling.apply(_position_control.throttle_setpoint);
 
 	_hitl_output_pub.publish(HITL_output_data{
 		_elevator_duty,
@@ -74,5 +128,8 @@ void Mixer::update_flight()
 		_hal->get_time_us()
 	});
 
-	_hal->set_pwm(_elevator_duty, _rudder_duty, _throttle_duty, 0, 0, 0);
+	if (!_passthrough_active)
+	{
+		_hal->set_pwm(_elevator_duty, _rudder_duty, _throttle_duty, 0, 0, 0);
+	}
 }
@@ -4,12 +4,14 @@
 #include <lib/hal/hal.h>
 #include <lib/module/module.h>
 #include "lib/parameters/params.h"
+#include "lib/pwm/pwm_scaling.h"
 #include "lib/utils/utils.h"
+#include "modules/rc_handler/rc_handler.h"
 
 class Mixer : public Module
 {
 public:
-	Mixer(HAL* hal, DataBus* data_bus);
+	Mixer(HAL* hal, DataBus* data_bus, param_context_t* params);
 
 	void update() override;
 
@@ -28,6 +30,12 @@ private:
 	uint16_t _rudder_duty = 0;
 	uint16_t _throttle_duty = 0;
 
+	Pwm_scaling _ele_scaling;
+	Pwm_scaling _rud_scaling;
+	Pwm_scaling _thr_scaling;
+	Rc_passthrough _passthrough{};
+	bool _passthrough_active = false;
+
 	// Parameters
 	int32_t _pwm_min_ele;
 	int32_t _pwm_max_ele;
@@ -37,8 +45,16 @@ private:
 	int32_t _pwm_max_thr;
 	int32_t _rev_ele;
 	int32_t _rev_rud;
+	int32_t _pwm_rate[PWM_GROUP_COUNT];
+	int32_t _rc_min_duty;
+	int32_t _rc_max_duty;
+
+	uint16_t _applied_rate[PWM_GROUP_COUNT] = {};
 
 	void parameters_update();
+	void update_rates();
+	void update_scaling();
+	void update_passthrough();
 
 	void update_config();
 	void update_startup();
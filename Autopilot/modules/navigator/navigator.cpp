@@ -9,16 +9,18 @@
 
 // PX4 uses local position and converts waypoint lat/lon to NED
 
-Navigator::Navigator(HAL* hal, DataBus* data_bus)
-	: Module(hal, data_bus),
+Navigator::Navigator(HAL* hal, DataBus* data_bus, param_context_t* params, mission_context_t* mission)
+	: Module(hal, data_bus, params),
+	  _mission(mission),
 	  _local_pos_sub(data_bus->local_position_node),
-	  _waypoint_pub(data_bus->waypoint_node)
+	  _waypoint_pub(data_bus->waypoint_node),
+	  _landing_pub(data_bus->landing_node)
 {
 }
 
 void Navigator::parameters_update()
 {
-	param_get(NAV_ACC_RAD, &_acc_rad);
+	param_get(_params, NAV_ACC_RAD, &_acc_rad);
 }
 
 void Navigator::update()
@@ -27,82 +29,114 @@ void Navigator::update()
 
 	_local_pos = _local_pos_sub.get();
 
-	// Reset waypoint index if there is a new mission
-	if (mission_get_version() > _last_mission_version)
+	if (!_local_pos.ref_xy_set)
 	{
-		_last_mission_version = mission_get_version();
-		_curr_wp_idx = 0;
+		return;
 	}
 
-	switch (mission_get().mission_type)
+	update_geometry();
+
+	if (mission_get(_mission)->mission_type == mission_type_t::MISSION_WAYPOINT)
 	{
-	case mission_type_t::MISSION_LOITER:
-	case mission_type_t::MISSION_LAND:
-		update_loiter_land();
-		break;
-	case mission_type_t::MISSION_WAYPOINT:
 		update_waypoint();
-		break;
 	}
 }
 
-void Navigator::update_loiter_land()
+// Convert the mission window to local NED only when it, the mission or the
+// local origin changes
+void Navigator::update_geometry()
 {
-	// Get target waypoint
-	const mission_item_t& target_wp = mission_get().mission_items[_curr_wp_idx];
+	const bool new_mission = mission_get_version(_mission) != _last_mission_version;
+	const bool new_ref = !_map_projection.check_ref(_local_pos.ref_lat, _local_pos.ref_lon);
+	const bool new_window = mission_get_window_version(_mission) != _last_window_version;
 
-	// Convert waypoint to local NED coordinates
-	double tgt_north, tgt_east;
-	lat_lon_to_meters(_local_pos.ref_lat, _local_pos.ref_lon,
-					  target_wp.latitude, target_wp.longitude, &tgt_north, &tgt_east);
+	if (!new_mission && !new_ref && !new_window)
+	{
+		return;
+	}
 
-	_waypoint_pub.publish(
-		waypoint_s{
-			.previous_north = 0,
-			.previous_east = 0,
-			.current_north = (float)tgt_north,
-			.current_east = (float)tgt_east,
-			.current_index = _curr_wp_idx,
-			.num_waypoints = mission_get().num_items,
-			.timestamp = _hal->get_time_us()
+	if (new_mission)
+	{
+		// Reset waypoint index if there is a new mission
+		_last_mission_version = mission_get_version(_mission);
+		_curr_wp_idx = 0;
+
+		// Landing only needs the touchdown point, which is the last item
+		if (mission_get(_mission)->mission_type == MISSION_LAND && mission_get(_mission)->num_items > 0)
+		{
+			mission_request_window(_mission, mission_get(_mission)->num_items - 1);
 		}
-	);
+		else
+		{
+			mission_request_window(_mission, _curr_wp_idx);
+		}
+	}
+
+	_last_window_version = mission_get_window_version(_mission);
+
+	if (new_ref)
+	{
+		_map_projection.init(_local_pos.ref_lat, _local_pos.ref_lon);
+	}
+
+	_mission_geometry.build(_mission, _map_projection);
+
+	landing_s landing = _mission_geometry.get_landing();
+	landing.timestamp = _hal->get_time_us();
+	_landing_pub.publish(landing);
+
+	publish_waypoint();
 }
 
 void Navigator::update_waypoint()
 {
-	// Get target waypoint
-	const mission_item_t& target_wp = mission_get().mission_items[_curr_wp_idx];
-
-	// Convert waypoint to local NED coordinates
-	double tgt_north, tgt_east;
-	lat_lon_to_meters(_local_pos.ref_lat, _local_pos.ref_lon,
-					  target_wp.latitude, target_wp.longitude, &tgt_north, &tgt_east);
+	if (!_mission_geometry.check_leg(_curr_wp_idx))
+	{
+		return;
+	}
 
-	float dist_to_wp = distance(_local_pos.x, tgt_north, _local_pos.y, tgt_east);
+	const mission_leg_s& leg = _mission_geometry.get_leg(_curr_wp_idx);
 
 	// Check distance to waypoint to determine if waypoint reached
-	if ((dist_to_wp < _acc_rad) && (_curr_wp_idx < mission_get().num_items - 1))
+	const float d_north = leg.end_north - _local_pos.x;
+	const float d_east = leg.end_east - _local_pos.y;
+
+	if ((d_north * d_north + d_east * d_east < _acc_rad * _acc_rad) &&
+		(_curr_wp_idx < _mission_geometry.get_num_legs() - 1))
 	{
 		_curr_wp_idx++; // Move to next waypoint
+		mission_request_window(_mission, _curr_wp_idx);
+		publish_waypoint();
+	}
+}
 
-		// Publish waypoint
-		const mission_item_t& prev_wp = mission_get().mission_items[_curr_wp_idx - 1];
-
-		double prev_north, prev_east;
-		lat_lon_to_meters(_local_pos.ref_lat, _local_pos.ref_lon,
-						  prev_wp.latitude, prev_wp.longitude, &prev_north, &prev_east);
-
-		_waypoint_pub.publish(
-			waypoint_s{
-				.previous_north = (float)prev_north,
-				.previous_east = (float)prev_east,
-				.current_north = (float)tgt_north,
-				.current_east = (float)tgt_east,
-				.current_index = _curr_wp_idx,
-				.num_waypoints = mission_get().num_items,
-				.timestamp = _hal->get_time_us()
-			}
-		);
+// Waits for the window to be refilled if the leg is not loaded yet
+void Navigator::publish_waypoint()
+{
+	if (!_mission_geometry.check_leg(_curr_wp_idx))
+	{
+		return;
 	}
+
+	const mission_leg_s& leg = _mission_geometry.get_leg(_curr_wp_idx);
+
+	float prev_north, prev_east;
+	_mission_geometry.get_leg_start(_curr_wp_idx, &prev_north, &prev_east);
+
+	_waypoint_pub.publish(
+		waypoint_s{
+			.previous_north = prev_north,
+			.previous_east = prev_east,
+			.current_north = leg.end_north,
+			.current_east = leg.end_east,
+			.unit_north = leg.unit_north,
+			.unit_east = leg.unit_east,
+			.length = leg.length,
+			.bearing = leg.bearing,
+			.current_alt = leg.end_alt,
+			.current_index = _curr_wp_idx,
+			.num_waypoints = _mission_geometry.get_num_legs(),
+			.timestamp = _hal->get_time_us()
+		}
+	);
 }
@@ -4,31 +4,41 @@
 #include <lib/hal/hal.h>
 #include <lib/module/module.h>
 #include "lib/data_bus/data_bus.h"
+#include "lib/geo/map_projection.h"
 #include "lib/mission/mission.h"
+#include "lib/mission/mission_geometry.h"
 #include "lib/parameters/params.h"
 #include "lib/utils/utils.h"
 
 class Navigator : public Module
 {
 public:
-	Navigator(HAL* hal, DataBus* data_bus);
+	Navigator(HAL* hal, DataBus* data_bus, param_context_t* params, mission_context_t* mission);
 
 	void update() override;
 
 private:
+	mission_context_t* _mission;
+
 	Subscriber<local_position_s> _local_pos_sub;
 	Publisher<waypoint_s> _waypoint_pub;
+	Publisher<landing_s> _landing_pub;
 
 	local_position_s _local_pos;
-	uint8_t _curr_wp_idx = 1;
+	uint16_t _curr_wp_idx = 0;
 	uint8_t _last_mission_version = 0;
+	uint16_t _last_window_version = 0;
+
+	MapProjection _map_projection;
+	MissionGeometry _mission_geometry;
 
 	// Parameters
 	float _acc_rad;
 
 	void parameters_update();
+	void update_geometry();
 	void update_waypoint();
-	void update_loiter_land();
+	void publish_waypoint();
 };
 
 
@@ -1,21 +1,26 @@
 #include "position_control.h"
 
-PositionControl::PositionControl(HAL* hal, DataBus* data_bus)
-	: Module(hal, data_bus),
+PositionControl::PositionControl(HAL* hal, DataBus* data_bus, param_context_t* params, mission_context_t* mission)
+	: Module(hal, data_bus, params),
+	  _mission(mission),
 	  _ahrs_sub(data_bus->ahrs_node),
 	  _local_pos_sub(data_bus->local_position_node),
 	  _modes_sub(data_bus->modes_node),
 	  _waypoint_sub(data_bus->waypoint_node),
+	  _landing_sub(data_bus->landing_node),
 	  _rc_sub(data_bus->rc_node),
 	  _position_control_pub(data_bus->position_control_node)
 {
 }
 
+// Step between the position estimates being controlled
 void PositionControl::update_time()
 {
-	const uint64_t time = _hal->get_time_us();
-	_dt = clamp((time - _last_time) * US_TO_S, DT_MIN, DT_MAX);
-	_last_time = time;
+	if (_local_pos.timestamp != _last_time)
+	{
+		_dt = clamp((_local_pos.timestamp - _last_time) * US_TO_S, DT_MIN, DT_MAX);
+		_last_time = _local_pos.timestamp;
+	}
 }
 
 void PositionControl::poll_vehicle_data()
@@ -24,29 +29,30 @@ void PositionControl::poll_vehicle_data()
 	_local_pos = _local_pos_sub.get();
 	_modes_data = _modes_sub.get();
 	_waypoint = _waypoint_sub.get();
+	_landing = _landing_sub.get();
 	_rc_data = _rc_sub.get();
 }
 
 void PositionControl::update_parameters()
 {
-	param_get(L1_ROLL_LIM, &_roll_limit);
-	param_get(TECS_PTCH_LIM, &_pitch_limit);
-	param_get(TKO_PTCH, &_takeoff_pitch);
-	param_get(MIS_SPD, &_cruise_speed);
-	param_get(LND_SPD, &_landing_speed);
-	param_get(NAV_ACC_RAD, &_acceptance_radius);
-	param_get(LND_FL_SINK, &_flare_sink_rate);
-	param_get(LND_FL_ALT, &_flare_alt);
+	param_get(_params, L1_ROLL_LIM, &_roll_limit);
+	param_get(_params, TECS_PTCH_LIM, &_pitch_limit);
+	param_get(_params, TKO_PTCH, &_takeoff_pitch);
+	param_get(_params, MIS_SPD, &_cruise_speed);
+	param_get(_params, LND_SPD, &_landing_speed);
+	param_get(_params, NAV_ACC_RAD, &_acceptance_radius);
+	param_get(_params, LND_FL_SINK, &_flare_sink_rate);
+	param_get(_params, LND_FL_ALT, &_flare_alt);
 
 	TECS::Param tecs_param = {0};
-	param_get(MIN_SPD, &tecs_param.min_spd);
-	param_get(MAX_SPD, &tecs_param.max_spd);
-	param_get(TECS_PTCH_KP, &tecs_param.pitch_gain);
-	param_get(TECS_PTCH_KI, &tecs_param.pitch_integral_gain);
-	param_get(TECS_PTCH_LIM, &tecs_param.max_pitch);
-	param_get(TECS_THR_KP, &tecs_param.throttle_gain);
-	param_get(TECS_THR_KI, &tecs_param.throttle_integral_gain);
-	param_get(MIS_THR, &tecs_param.throttle_trim);
+	param_get(_params, MIN_SPD, &tecs_param.min_spd);
+	param_get(_params, MAX_SPD, &tecs_param.max_spd);
+	param_get(_params, TECS_PTCH_KP, &tecs_param.pitch_gain);
+	param_get(_params, TECS_PTCH_KI, &tecs_param.pitch_integral_gain);
+	param_get(_params, TECS_PTCH_LIM, &tecs_param.max_pitch);
+	param_get(_params, TECS_THR_KP, &tecs_param.throttle_gain);
+	param_get(_params, TECS_THR_KI, &tecs_param.throttle_integral_gain);
+	param_get(_params, MIS_THR, &tecs_param.throttle_trim);
 	tecs_param.min_pitch = -tecs_param.max_pitch;
 	tecs_param.alt_weight = 1;
 	tecs_param.min_throttle = 0;
@@ -54,9 +60,9 @@ void PositionControl::update_parameters()
 	_tecs.set_param(tecs_param);
 
 	float l1_period, l1_damping, roll_limit;
-	param_get(L1_PERIOD, &l1_period);
-	param_get(L1_DAMPING, &l1_damping);
-	param_get(L1_ROLL_LIM, &roll_limit);
+	param_get(_params, L1_PERIOD, &l1_period);
+	param_get(_params, L1_DAMPING, &l1_damping);
+	param_get(_params, L1_ROLL_LIM, &roll_limit);
 	_l1_control.set_l1_period(l1_period);
 	_l1_control.set_l1_damping(l1_damping);
 	_l1_control.set_roll_limit(roll_limit);
@@ -64,8 +70,8 @@ void PositionControl::update_parameters()
 
 void PositionControl::update()
 {
-	update_time();
 	poll_vehicle_data();
+	update_time();
 	update_parameters();
 
 	if (_modes_data.system_mode == System_mode::FLIGHT)
@@ -135,12 +141,12 @@ void PositionControl::update_takeoff()
 
 void PositionControl::update_mission()
 {
-	if (mission_get().mission_type != MISSION_LAND)
+	if (mission_get(_mission)->mission_type != MISSION_LAND)
 	{
 		reset_landing_state();
 	}
 
-	switch (mission_get().mission_type)
+	switch (mission_get(_mission)->mission_type)
 	{
 	case MISSION_EMPTY:
 		break;
@@ -159,11 +165,11 @@ void PositionControl::update_mission()
 void PositionControl::update_mission_waypoint()
 {
 	_l1_control.navigate_waypoints(_local_pos.x, _local_pos.y, _local_pos.vx, _local_pos.vy, _local_pos.gnd_spd,
-								   _waypoint.previous_north, _waypoint.previous_east,
-								   _waypoint.current_north, _waypoint.current_east);
+								   _waypoint.current_north, _waypoint.current_east,
+								   _waypoint.unit_north, _waypoint.unit_east, _waypoint.bearing);
 
-	// Update TECS
-	_tecs_setpoint.alt = mission_get_altitude();
+	// Update TECS, each waypoint carries its own altitude
+	_tecs_setpoint.alt = _waypoint.current_alt;
 	_tecs_setpoint.spd = _cruise_speed;
 	_tecs.set_alt_weight(1);
 
@@ -176,7 +182,7 @@ void PositionControl::update_mission_loiter()
 {
 	int8_t direction;
 
-	if (mission_get().loiter_direction == LOITER_RIGHT)
+	if (mission_get(_mission)->loiter_direction == LOITER_RIGHT)
 	{
 		direction = 1;
 	}
@@ -187,10 +193,10 @@ void PositionControl::update_mission_loiter()
 
 	_l1_control.navigate_loiter(_local_pos.x, _local_pos.y, _local_pos.vx, _local_pos.vy,
 								_local_pos.gnd_spd, _waypoint.current_north, _waypoint.current_east,
-								mission_get().loiter_radius, direction);
+								mission_get(_mission)->loiter_radius, direction);
 
 	// Update TECS
-	_tecs_setpoint.alt = mission_get_altitude();
+	_tecs_setpoint.alt = mission_get_altitude(_mission);
 	_tecs_setpoint.spd = _cruise_speed;
 	_tecs.set_alt_weight(1);
 
@@ -217,45 +223,19 @@ void PositionControl::update_land()
 
 void PositionControl::update_land_loiter()
 {
-	int8_t direction;
-
-	if (mission_get().loiter_direction == LOITER_RIGHT)
-	{
-		direction = 1;
-	}
-	else
-	{
-		direction = -1;
-	}
-
-	// Get position of the start of the glideslope
-	float glideslope_start_north, glideslope_start_east;
-
-	move_point(_waypoint.current_north, _waypoint.current_east, mission_get().final_leg_dist, mission_get().runway_heading,
-			   &glideslope_start_north, &glideslope_start_east);
-
-	// Calculate heading perpendicular to the runway in the direction of the loiter point
-	float perpendicular_heading = mission_get().runway_heading - 90 * direction;
-
-	// Calculate the position of the loiter point
-	float loiter_north, loiter_east;
-
-	move_point(glideslope_start_north, glideslope_start_east, mission_get().loiter_radius, perpendicular_heading,
-			   &loiter_north, &loiter_east);
-
+	// Loiter circle tangent to the final approach, precomputed by the navigator
 	_l1_control.navigate_loiter(_local_pos.x, _local_pos.y, _local_pos.vx, _local_pos.vy,
-								_local_pos.gnd_spd, loiter_north, loiter_east,
-								mission_get().loiter_radius, direction);
+								_local_pos.gnd_spd, _landing.loiter_north, _landing.loiter_east,
+								_landing.loiter_radius, _landing.loiter_direction);
 
 	if (_l1_control.get_circle_mode())
 	{
-		// Calculate loiter altitude
-		float altitude_setpoint = mission_get().final_leg_dist * tanf(mission_get().glideslope_angle * DEG_TO_RAD);
+		const float altitude_setpoint = _landing.loiter_alt;
 
 		_tecs_setpoint.alt = altitude_setpoint;
 		_tecs_setpoint.spd = _landing_speed;
 
-		float heading_error = fabs(_ahrs_data.yaw - mission_get().runway_heading); // TODO: Use position or something, not yaw
+		float heading_error = fabs(_ahrs_data.yaw - _landing.runway_heading); // TODO: Use position or something, not yaw
 		float altitude_error = fabs(-_local_pos.z - altitude_setpoint);
 		float speed_error = fabs(_local_pos.gnd_spd - _landing_speed);
 
@@ -267,7 +247,7 @@ void PositionControl::update_land_loiter()
 	}
 	else
 	{
-		_tecs_setpoint.alt = mission_get_altitude();
+		_tecs_setpoint.alt = mission_get_altitude(_mission);
 		_tecs_setpoint.spd = _cruise_speed;
 	}
 
@@ -279,27 +259,19 @@ void PositionControl::update_land_loiter()
 
 void PositionControl::update_land_glideslope()
 {
-	// Get position of the start of the glideslope
-	float glideslope_start_north, glideslope_start_east;
-
-	move_point(_waypoint.current_north, _waypoint.current_east, mission_get().final_leg_dist, mission_get().runway_heading,
-			   &glideslope_start_north, &glideslope_start_east);
-
 	_l1_control.navigate_waypoints(_local_pos.x, _local_pos.y, _local_pos.vx, _local_pos.vy, _local_pos.gnd_spd,
-								   glideslope_start_north, glideslope_start_east,
-								   _waypoint.current_north, _waypoint.current_east);
+								   _landing.touchdown_north, _landing.touchdown_east,
+								   _landing.approach_unit_north, _landing.approach_unit_east,
+								   _landing.approach_bearing);
 
-	// Follow glideslope
-	const float along_track_dist = compute_along_track_distance(
-		_waypoint.previous_north, _waypoint.previous_east,
-		_waypoint.current_north, _waypoint.current_east,
-		_local_pos.x, _local_pos.y
-	);
+	// Follow glideslope, height proportional to the remaining distance along the approach
+	const float dist_to_touchdown = (_landing.touchdown_north - _local_pos.x) * _landing.approach_unit_north +
+									(_landing.touchdown_east - _local_pos.y) * _landing.approach_unit_east;
 
-	float z_setpoint = along_track_dist * tanf(mission_get().glideslope_angle * DEG_TO_RAD);
+	const float altitude_setpoint = dist_to_touchdown * _landing.tan_glideslope;
 
 	// Update TECS
-	_tecs_setpoint.alt = -z_setpoint;
+	_tecs_setpoint.alt = altitude_setpoint;
 	_tecs_setpoint.spd = _landing_speed;
 	_tecs.set_alt_weight(1);
 	tecs_update_pitch_throttle();
@@ -316,7 +288,7 @@ void PositionControl::update_land_glideslope()
 
 void PositionControl::update_land_flare()
 {
-	const float glideslope_sink_rate = _landing_speed * sinf(mission_get().glideslope_angle * DEG_TO_RAD);
+	const float glideslope_sink_rate = _landing_speed * _landing.sin_glideslope;
 	const float initial_altitude = fmaxf(_flare_alt, 0);
 	const float initial_sink_rate = fmaxf(glideslope_sink_rate, _flare_sink_rate);
 	const float clamped_vehicle_altitude = clamp(-_local_pos.z, 0, initial_altitude);
@@ -353,31 +325,3 @@ void PositionControl::reset_landing_state()
 {
 	_landing_state = LandingState::LOITER;
 }
-
-// Helper function to compute along-track distance (projected aircraft position onto path)
-float PositionControl::compute_along_track_distance(float start_n, float start_e,
-												    float end_n, float end_e,
-											 	    float pos_n, float pos_e)
-{
-	const float vec_north = end_n - start_n;
-	const float vec_east = end_e - start_e;
-	const float vec_norm = sqrtf(vec_north * vec_north + vec_east * vec_east);
-
-	if (vec_norm == 0) return 0.0f;
-
-	const float proj_factor = ((pos_n - start_n) * vec_north + (pos_e - start_e) * vec_east) /
-							  (vec_norm * vec_norm);
-	return proj_factor * vec_norm;
-}
-
-void PositionControl::move_point(float north, float east, float distance, float bearing_deg,
-								 float *new_north, float *new_east)
-{
-	/*
-	 * Calculate new position after moving a given distance from
-	 * an original point at a given bearing
-	 */
-	float bearing_rad = bearing_deg * DEG_TO_RAD;
-	*new_north = north + distance * cosf(bearing_rad);
-	*new_east = east + distance * sinf(bearing_rad);
-}
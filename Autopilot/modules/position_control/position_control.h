@@ -16,11 +16,13 @@
 class PositionControl : public Module
 {
 public:
-	PositionControl(HAL* hal, DataBus* data_bus);
+	PositionControl(HAL* hal, DataBus* data_bus, param_context_t* params, mission_context_t* mission);
 
 	void update() override;
 
 private:
+	mission_context_t* _mission;
+
 	enum class LandingState {
 		LOITER,
 		GLIDESLOPE,
@@ -31,6 +33,7 @@ private:
 	Subscriber<local_position_s> _local_pos_sub;
 	Subscriber<Modes_data> _modes_sub;
 	Subscriber<waypoint_s> _waypoint_sub;
+	Subscriber<landing_s> _landing_sub;
 	Subscriber<RC_data> _rc_sub;
 
 	Publisher<position_control_s> _position_control_pub;
@@ -39,6 +42,7 @@ private:
 	AHRS_data _ahrs_data{};
 	local_position_s _local_pos;
 	waypoint_s _waypoint{};
+	landing_s _landing{};
 	position_control_s _position_control{};
 	RC_data _rc_data{};
 	tecs_setpoint_s _tecs_setpoint;
@@ -87,11 +91,6 @@ private:
 	void reset_landing_state();
 
 	void tecs_update_pitch_throttle();
-
-	float compute_along_track_distance(float start_n, float start_e, float end_n, float end_e,
-			 	 	 	 	 	 	   float pos_n, float pos_e);
-	void move_point(float north, float east, float distance, float bearing_deg,
-					float *new_north, float *new_east);
 };
 
 #endif /* L1_CONTROLLER_H_ */
@@ -1,7 +1,7 @@
 #include "position_estimator.h"
 
-PositionEstimator::PositionEstimator(HAL* hal, DataBus* data_bus)
-	: Module(hal, data_bus),
+PositionEstimator::PositionEstimator(HAL* hal, DataBus* data_bus, param_context_t* params)
+	: Module(hal, data_bus, params),
 	  kalman(n, m),
 	  _modes_sub(data_bus->modes_node),
 	  _imu_sub(data_bus->imu_node),
@@ -15,20 +15,16 @@ PositionEstimator::PositionEstimator(HAL* hal, DataBus* data_bus)
 
 void PositionEstimator::parameters_update()
 {
-	param_get(EKF_GNSS_VAR, &_gnss_variance);
-	param_get(EKF_BARO_VAR, &_baro_variance);
-	param_get(EKF_OF_MIN, &_of_min);
-	param_get(EKF_OF_MAX, &_of_max);
+	param_get(_params, EKF_GNSS_VAR, &_gnss_variance);
+	param_get(_params, EKF_BARO_VAR, &_baro_variance);
+	param_get(_params, EKF_OF_MIN, &_of_min);
+	param_get(_params, EKF_OF_MAX, &_of_max);
 }
 
 void PositionEstimator::update()
 {
 	parameters_update();
 
-	const uint64_t time = _hal->get_time_us();
-	_dt = clamp((time - _last_time) * US_TO_S, DT_MIN, DT_MAX);
-	_last_time = time;
-
 	_modes_data = _modes_sub.get();
 
 	if (_modes_data.system_mode != System_mode::LOAD_PARAMS)
@@ -48,6 +44,12 @@ void PositionEstimator::update_initialization()
 {
 	_ahrs_data = _ahrs_sub.get();
 
+	if (_imu_sub.check_new())
+	{
+		_imu_data = _imu_sub.get();
+		_last_time = _imu_data.timestamp;
+	}
+
 	if (_gnss_sub.check_new())
 	{
 		_gnss_data = _gnss_sub.get();
@@ -99,7 +101,12 @@ void PositionEstimator::update_running()
 	if (_gnss_sub.check_new())
 	{
 		_gnss_data = _gnss_sub.get();
-		update_gps();
+
+		// Without a 3D fix the position is stale or zero, don't fuse it
+		if (_gnss_data.fix)
+		{
+			update_gps();
+		}
 	}
 
 	if (_baro_sub.check_new())
@@ -111,13 +118,14 @@ void PositionEstimator::update_running()
 
 void PositionEstimator::predict_accel()
 {
+	// Predict over the time between the samples used, not between calls
+	_dt = clamp((_imu_data.timestamp - _last_time) * US_TO_S, DT_MIN, DT_MAX);
+	_last_time = _imu_data.timestamp;
+
+	// Rotate body frame acceleration to NED with the rotation matrix published by AHRS
+	const Eigen::Map<const Eigen::Matrix<float, 3, 3, Eigen::RowMajor>> dcm(&_ahrs_data.dcm[0][0]);
 	Eigen::Vector3f acc_inertial(_imu_data.ax, _imu_data.ay, _imu_data.az);
-	Eigen::Vector3f acc_ned = inertial_to_ned(
-		acc_inertial * G,
-		_ahrs_data.roll * DEG_TO_RAD,
-		_ahrs_data.pitch * DEG_TO_RAD,
-		_ahrs_data.yaw * DEG_TO_RAD
-	);
+	Eigen::Vector3f acc_ned = dcm * (acc_inertial * G);
 
 	// Gravity correction
 	acc_ned(2) += G;
@@ -129,11 +137,15 @@ void PositionEstimator::predict_accel()
 
 void PositionEstimator::update_gps()
 {
+	// The reference trig is computed once, not on every fix
+	if (!_map_projection.check_ref(_local_pos.ref_lat, _local_pos.ref_lon))
+	{
+		_map_projection.init(_local_pos.ref_lat, _local_pos.ref_lon);
+	}
+
 	// Convert lat/lon to meters
-	double gnss_north_meters, gnss_east_meters;
-	lat_lon_to_meters(_local_pos.ref_lat, _local_pos.ref_lon,
-					  _gnss_data.lat, _gnss_data.lon,
-					  &gnss_north_meters, &gnss_east_meters);
+	float gnss_north_meters, gnss_east_meters;
+	_map_projection.project(_gnss_data.lat, _gnss_data.lon, &gnss_north_meters, &gnss_east_meters);
 
 	Eigen::VectorXf y(2);
 	y << gnss_north_meters, gnss_east_meters;
@@ -142,13 +154,39 @@ void PositionEstimator::update_gps()
 	H << 1, 0, 0, 0, 0, 0,
 		 0, 1, 0, 0, 0, 0;
 
-	Eigen::DiagonalMatrix<float, 2> R(_gnss_variance, _gnss_variance);
+	// Reported accuracy, never trusted more than EKF_GNSS_VAR. Receivers
+	// that don't report it get EKF_GNSS_VAR.
+	const float h_var = _gnss_data.h_acc * _gnss_data.h_acc;
+	const float variance = h_var > _gnss_variance ? h_var : _gnss_variance;
+	Eigen::DiagonalMatrix<float, 2> R(variance, variance);
 
 	kalman.update(R, H, y);
 
+	// Only receivers that report velocity fill in its accuracy
+	if (_gnss_data.s_acc > 0)
+	{
+		update_gps_velocity();
+	}
+
 	update_plane();
 }
 
+void PositionEstimator::update_gps_velocity()
+{
+	Eigen::VectorXf y(2);
+	y << _gnss_data.vel_n, _gnss_data.vel_e;
+
+	Eigen::MatrixXf H(2, n);
+	H << 0, 0, 0, 1, 0, 0,
+		 0, 0, 0, 0, 1, 0;
+
+	const float s_acc = _gnss_data.s_acc > GNSS_S_ACC_MIN ? _gnss_data.s_acc : GNSS_S_ACC_MIN;
+	const float variance = s_acc * s_acc;
+	Eigen::DiagonalMatrix<float, 2> R(variance, variance);
+
+	kalman.update(R, H, y);
+}
+
 void PositionEstimator::update_baro()
 {
 	Eigen::VectorXf y(1);
@@ -166,8 +204,10 @@ void PositionEstimator::update_baro()
 
 void PositionEstimator::update_of_agl()
 {
-	float flow = sqrtf(powf(_of_data.x, 2) + powf(_of_data.y, 2));
-	float angular_rate = sqrtf(powf(_imu_data.gx, 2) + powf(_imu_data.gy, 2)) * DEG_TO_RAD;
+	const float flow_x = _of_data.x;
+	const float flow_y = _of_data.y;
+	float flow = fast_sqrtf(flow_x * flow_x + flow_y * flow_y);
+	float angular_rate = fast_sqrtf(_imu_data.gx * _imu_data.gx + _imu_data.gy * _imu_data.gy) * DEG_TO_RAD;
 	float alt = _local_pos.gnd_spd / (flow - angular_rate);
 	printf("OF AGL: %f\n", alt);
 }
@@ -182,38 +222,18 @@ void PositionEstimator::update_plane()
 	_local_pos.vx = est(3, 0);
 	_local_pos.vy = est(4, 0);
 	_local_pos.vz = est(5, 0);
-	_local_pos.gnd_spd = sqrtf(powf(est(3, 0), 2) + powf(est(4, 0), 2));
+	_local_pos.gnd_spd = fast_sqrtf(_local_pos.vx * _local_pos.vx + _local_pos.vy * _local_pos.vy);
 	_local_pos.terr_hgt = 0;
-	_local_pos.timestamp = _hal->get_time_us();
+	_local_pos.timestamp = _imu_data.timestamp;
 
 	_local_pos_pub.publish(_local_pos);
 }
 
-// Function to rotate IMU measurements from inertial frame to NED frame
-Eigen::Vector3f PositionEstimator::inertial_to_ned(const Eigen::Vector3f& imu_measurement,
-												   float roll, float pitch, float yaw)
-{
-    // Precompute trigonometric functions
-    const float cr = cosf(roll);
-    const float sr = sinf(roll);
-    const float cp = cosf(pitch);
-    const float sp = sinf(pitch);
-    const float cy = cosf(yaw);
-    const float sy = sinf(yaw);
-
-    // Construct the rotation matrix (ZYX convention: yaw -> pitch -> roll)
-    Eigen::Matrix3f R;
-	R << cy*cp, cy*sp*sr - sy*cr, cy*sp*cr + sy*sr,
-		 sy*cp, sy*sp*sr + cy*cr, sy*sp*cr - cy*sr,
-		 -sp,   cp*sr,            cp*cr;
-
-    // Rotate the measurement
-    return R * imu_measurement;
-}
-
 bool PositionEstimator::is_of_reliable()
 {
-	float flow = sqrtf(powf(_of_data.x, 2) + powf(_of_data.y, 2));
+	const float flow_x = _of_data.x;
+	const float flow_y = _of_data.y;
+	float flow = fast_sqrtf(flow_x * flow_x + flow_y * flow_y);
 	return flow > _of_min && flow < _of_max;
 }
 
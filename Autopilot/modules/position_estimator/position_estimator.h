@@ -5,6 +5,8 @@
 #include <lib/hal/hal.h>
 #include <lib/module/module.h>
 #include "lib/parameters/params.h"
+#include "lib/fastmath/fastmath.h"
+#include "lib/geo/map_projection.h"
 #include "lib/kalman/kalman.h"
 #include "lib/utils/utils.h"
 #include <stdio.h>
@@ -12,13 +14,16 @@
 static constexpr int n = 6;
 static constexpr int m = 3;
 
+// Lower bound on the reported speed accuracy (m/s), receivers are optimistic
+static constexpr float GNSS_S_ACC_MIN = 0.1f;
+
 /**
  * @brief Calculates the position and altitude of the plane
  */
 class PositionEstimator : public Module
 {
 public:
-    PositionEstimator(HAL* hal, DataBus* data_bus);
+    PositionEstimator(HAL* hal, DataBus* data_bus, param_context_t* params);
 
     void update() override;
 
@@ -27,6 +32,7 @@ private:
 	float _dt = 0;
 
     Kalman kalman;
+    MapProjection _map_projection;
 
     Subscriber<Modes_data> _modes_sub;
     Subscriber<IMU_data> _imu_sub;
@@ -58,6 +64,7 @@ private:
 
     void predict_accel();
 	void update_gps();
+	void update_gps_velocity();
 	void update_baro();
 	void update_plane();
 	void update_of_agl();
@@ -67,8 +74,6 @@ private:
     Eigen::MatrixXf get_b(float dt);
     Eigen::MatrixXf get_q();
 
-	Eigen::Vector3f inertial_to_ned(const Eigen::Vector3f& imu_measurement, float roll, float pitch, float yaw);
-
 	bool is_of_reliable();
 };
 
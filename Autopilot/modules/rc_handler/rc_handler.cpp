@@ -1,7 +1,7 @@
 #include "modules/rc_handler/rc_handler.h"
 
-RCHandler::RCHandler(HAL* hal, DataBus* data_bus)
-	: Module(hal, data_bus),
+RCHandler::RCHandler(HAL* hal, DataBus* data_bus, param_context_t* params)
+	: Module(hal, data_bus, params),
 	  _modes_sub(data_bus->modes_node),
 	  _rc_pub(data_bus->rc_node)
 {
@@ -9,8 +9,8 @@ RCHandler::RCHandler(HAL* hal, DataBus* data_bus)
 
 void RCHandler::parameters_update()
 {
-	param_get(RC_MIN_DUTY, &_min_duty);
-	param_get(RC_MAX_DUTY, &_max_duty);
+	param_get(_params, RC_MIN_DUTY, &_min_duty);
+	param_get(_params, RC_MAX_DUTY, &_max_duty);
 }
 
 void RCHandler::update()
@@ -22,7 +22,7 @@ constexpr uint16_t TX_CONN_THRESHOLD = 500; // Transmitter channels must be abov
 class RCHandler : public Module
 {
 public:
-	RCHandler(HAL* hal, DataBus* data_bus);
+	RCHandler(HAL* hal, DataBus* data_bus, param_context_t* params);
 
 	void update() override;
 
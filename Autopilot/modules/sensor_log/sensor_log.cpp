@@ -0,0 +1,191 @@
+#include "modules/sensor_log/sensor_log.h"
+#include <atomic>
+
+SensorLog::SensorLog(HAL* hal, DataBus* data_bus, param_context_t* params)
+	: Module(hal, data_bus, params),
+	  _modes_sub(data_bus->modes_node),
+	  _imu_sub(data_bus->imu_node),
+	  _mag_sub(data_bus->mag_node),
+	  _baro_sub(data_bus->baro_node),
+	  _gnss_sub(data_bus->gnss_node),
+	  _of_sub(data_bus->of_node)
+{
+}
+
+// Fast task. Returns until the parameter is loaded, param_get leaves
+// _enabled at 0.
+void SensorLog::update()
+{
+	param_get(_params, LOG_SENSORS, &_enabled);
+
+	if (!_enabled)
+	{
+		return;
+	}
+
+	uint8_t packet[MAX_PACKET_LEN];
+
+	if (_mag_sub.check_new())
+	{
+		const Mag_data mag = _mag_sub.get();
+		const aplink_log_mag_t msg = {mag.timestamp, mag.x, mag.y, mag.z};
+		write_record(packet, aplink_log_mag_pack(msg, packet));
+	}
+
+	if (_baro_sub.check_new())
+	{
+		const Baro_data baro = _baro_sub.get();
+		const aplink_log_baro_t msg = {baro.timestamp, baro.alt, baro.pressure, baro.temperature};
+		write_record(packet, aplink_log_baro_pack(msg, packet));
+	}
+
+	if (_gnss_sub.check_new())
+	{
+		const GNSS_data gnss = _gnss_sub.get();
+		const aplink_log_gnss_t msg = {
+			gnss.timestamp, gnss.lat, gnss.lon, gnss.asl,
+			gnss.vel_n, gnss.vel_e, gnss.vel_d, gnss.h_acc, gnss.v_acc, gnss.s_acc,
+			gnss.sats, gnss.fix, (uint16_t)gnss.year, (uint8_t)gnss.month, (uint8_t)gnss.day,
+			(uint8_t)gnss.hours, (uint8_t)gnss.minutes, (uint8_t)gnss.seconds
+		};
+		write_record(packet, aplink_log_gnss_pack(msg, packet));
+	}
+
+	if (_of_sub.check_new())
+	{
+		const OF_data of = _of_sub.get();
+		const aplink_log_of_t msg = {of.timestamp, of.x, of.y};
+		write_record(packet, aplink_log_of_pack(msg, packet));
+	}
+
+	// Last, the replay runs the fast modules when it reads an IMU record
+	if (_imu_sub.check_new())
+	{
+		const IMU_data imu = _imu_sub.get();
+		const aplink_log_imu_t msg = {imu.timestamp, imu.gx, imu.gy, imu.gz, imu.ax, imu.ay, imu.az};
+		write_record(packet, aplink_log_imu_pack(msg, packet));
+	}
+}
+
+void SensorLog::write_record(const uint8_t* packet, uint16_t len)
+{
+	const uint16_t head = _head;
+
+	if (BUFFER_SIZE - 1 - used(head) < len)
+	{
+		_overflow_bytes = _overflow_bytes + len;
+		return;
+	}
+
+	for (uint16_t i = 0; i < len; i++)
+	{
+		_buffer[(head + i) % BUFFER_SIZE] = packet[i];
+	}
+
+	// The record has to be in the ring before the main task can see it
+	std::atomic_signal_fence(std::memory_order_release);
+	_head = (head + len) % BUFFER_SIZE;
+}
+
+void SensorLog::begin_tick()
+{
+	if (!_enabled)
+	{
+		return;
+	}
+
+	// Nothing was written for a while, the SD card is not keeping up
+	if (_num_ticks == MAX_TICKS)
+	{
+		discard();
+	}
+
+	Tick& tick = _ticks[_num_ticks++];
+	tick.mark = _head;
+	tick.time_us = _hal->get_time_us();
+	std::atomic_signal_fence(std::memory_order_acquire);
+}
+
+void SensorLog::flush()
+{
+	if (!_enabled || _num_ticks == 0)
+	{
+		return;
+	}
+
+	// After Commander, the fast task sees these modes from now on
+	_ticks[_num_ticks - 1].modes = _modes_sub.get();
+
+	uint8_t written = 0;
+
+	while (written < _num_ticks && write_until(_ticks[written].mark) && write_tick(_ticks[written]))
+	{
+		written++;
+	}
+
+	for (uint8_t i = written; i < _num_ticks; i++)
+	{
+		_ticks[i - written] = _ticks[i];
+	}
+
+	_num_ticks -= written;
+
+	// No log file yet, or the card fell far behind
+	if (used(_head) > BUFFER_SIZE / 2)
+	{
+		discard();
+	}
+}
+
+// Records are whole packets, so the length follows from the header
+bool SensorLog::write_until(uint16_t end)
+{
+	uint8_t packet[MAX_PACKET_LEN];
+
+	while (_tail != end)
+	{
+		const uint16_t tail = _tail;
+		const uint16_t len = aplink_calc_packet_size(_buffer[(tail + 1) % BUFFER_SIZE]);
+
+		for (uint16_t i = 0; i < len; i++)
+		{
+			packet[i] = _buffer[(tail + i) % BUFFER_SIZE];
+		}
+
+		if (_hal->write_storage(packet, len) != len)
+		{
+			return false;
+		}
+
+		_tail = (tail + len) % BUFFER_SIZE;
+	}
+
+	return true;
+}
+
+bool SensorLog::write_tick(const Tick& tick)
+{
+	const aplink_log_tick_t msg = {
+		tick.time_us,
+		(uint8_t)tick.modes.system_mode,
+		(uint8_t)tick.modes.flight_mode,
+		(uint8_t)tick.modes.auto_mode,
+		(uint8_t)tick.modes.manual_mode,
+		_discarded_bytes + _overflow_bytes
+	};
+
+	uint8_t packet[MAX_PACKET_LEN];
+	const uint16_t len = aplink_log_tick_pack(msg, packet);
+
+	return _hal->write_storage(packet, len) == len;
+}
+
+// Pending ticks count as discarded too, any gap shows in the next tick
+void SensorLog::discard()
+{
+	const uint16_t head = _head;
+
+	_discarded_bytes += used(head) + _num_ticks * aplink_calc_packet_size(sizeof(aplink_log_tick_t));
+	_tail = head;
+	_num_ticks = 0;
+}
@@ -0,0 +1,79 @@
+#ifndef MODULES_SENSOR_LOG_SENSOR_LOG_H_
+#define MODULES_SENSOR_LOG_SENSOR_LOG_H_
+
+#include "lib/data_bus/data_bus.h"
+#include "lib/hal/hal.h"
+#include "lib/module/module.h"
+#include <stdint.h>
+
+extern "C"
+{
+#include "lib/aplink_c/aplink.h"
+#include "lib/aplink_c/aplink_messages.h"
+}
+
+/**
+ * Records the sensor topics of the data bus for log replay
+ *
+ * update() runs in the fast task after Sensors and packs every new sample
+ * into a ring, with the IMU last, so a replay can run the fast modules on
+ * each IMU record. The main task calls begin_tick() before its modules and
+ * flush() after Storage. flush() writes the samples up to each tick, then
+ * a LOG_TICK record with the modes, so the replay also knows when the main
+ * modules ran.
+ *
+ * Records are held while the log file is not open yet or the SD card falls
+ * behind. Once more than half the ring is waiting they are discarded, and
+ * the running count of discarded bytes in every LOG_TICK tells the replay
+ * the log has a gap, or does not start at boot.
+ */
+class SensorLog : public Module
+{
+public:
+	SensorLog(HAL* hal, DataBus* data_bus, param_context_t* params);
+
+	void update() override;
+
+	// Main task
+	void begin_tick();
+	void flush();
+
+private:
+	static constexpr uint16_t BUFFER_SIZE = 8192;
+	static constexpr uint8_t MAX_TICKS = 16;
+
+	struct Tick
+	{
+		uint16_t mark; // Ring position when the main task started
+		uint64_t time_us;
+		Modes_data modes;
+	};
+
+	int32_t _enabled = 0;
+
+	Subscriber<Modes_data> _modes_sub;
+	Subscriber<IMU_data> _imu_sub;
+	Subscriber<Mag_data> _mag_sub;
+	Subscriber<Baro_data> _baro_sub;
+	Subscriber<GNSS_data> _gnss_sub;
+	Subscriber<OF_data> _of_sub;
+
+	// Filled by the fast task, emptied by the main task
+	uint8_t _buffer[BUFFER_SIZE];
+	volatile uint16_t _head = 0;
+	volatile uint16_t _tail = 0;
+	volatile uint32_t _overflow_bytes = 0;
+
+	// Main task only
+	Tick _ticks[MAX_TICKS];
+	uint8_t _num_ticks = 0;
+	uint32_t _discarded_bytes = 0;
+
+	void write_record(const uint8_t* packet, uint16_t len);
+	bool write_until(uint16_t end);
+	bool write_tick(const Tick& tick);
+	void discard();
+	uint16_t used(uint16_t head) const { return (uint16_t)((head - _tail + BUFFER_SIZE) % BUFFER_SIZE); }
+};
+
+#endif /* MODULES_SENSOR_LOG_SENSOR_LOG_H_ */
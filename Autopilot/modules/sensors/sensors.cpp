@@ -1,7 +1,7 @@
 #include "sensors.h"
 
-Sensors::Sensors(HAL* hal, DataBus* data_bus)
-	: Module(hal, data_bus),
+Sensors::Sensors(HAL* hal, DataBus* data_bus, param_context_t* params)
+	: Module(hal, data_bus, params),
 	  _modes_sub(data_bus->modes_node),
 	  _hitl_sensors_sub(data_bus->hitl_sensors_node),
 	  _imu_pub(data_bus->imu_node),
@@ -11,30 +11,39 @@ Sensors::Sensors(HAL* hal, DataBus* data_bus)
 	  _gnss_pub(data_bus->gnss_node),
 	  _power_pub(data_bus->power_node),
 	  _unc_imu_pub(data_bus->uncalibrated_imu_node),
-	  _unc_mag_pub(data_bus->uncalibrated_mag_node)
+	  _unc_mag_pub(data_bus->uncalibrated_mag_node),
+	  _gyro_fft_pub(data_bus->gyro_fft_node)
 {
 }
 
 void Sensors::parameters_update()
 {
-	param_get(GYR_OFF_X, &_gyr_off_x);
-	param_get(GYR_OFF_Y, &_gyr_off_y);
-	param_get(GYR_OFF_Z, &_gyr_off_z);
-	param_get(ACC_OFF_X, &_acc_off_x);
-	param_get(ACC_OFF_Y, &_acc_off_y);
-	param_get(ACC_OFF_Z, &_acc_off_z);
-	param_get(MAG_HI_X, &_hi_x);
-	param_get(MAG_HI_Y, &_hi_y);
-	param_get(MAG_HI_Z, &_hi_z);
-	param_get(MAG_SI_XX, &_si_xx);
-	param_get(MAG_SI_XY, &_si_xy);
-	param_get(MAG_SI_XZ, &_si_xz);
-	param_get(MAG_SI_YX, &_si_yx);
-	param_get(MAG_SI_YY, &_si_yy);
-	param_get(MAG_SI_YZ, &_si_yz);
-	param_get(MAG_SI_ZX, &_si_zx);
-	param_get(MAG_SI_ZY, &_si_zy);
-	param_get(MAG_SI_ZZ, &_si_zz);
+	param_get(_params, GYR_OFF_X, &_gyr_off_x);
+	param_get(_params, GYR_OFF_Y, &_gyr_off_y);
+	param_get(_params, GYR_OFF_Z, &_gyr_off_z);
+	param_get(_params, ACC_OFF_X, &_acc_off_x);
+	param_get(_params, ACC_OFF_Y, &_acc_off_y);
+	param_get(_params, ACC_OFF_Z, &_acc_off_z);
+	param_get(_params, MAG_HI_X, &_hi_x);
+	param_get(_params, MAG_HI_Y, &_hi_y);
+	param_get(_params, MAG_HI_Z, &_hi_z);
+	param_get(_params, MAG_SI_XX, &_si_xx);
+	param_get(_params, MAG_SI_XY, &_si_xy);
+	param_get(_params, MAG_SI_XZ, &_si_xz);
+	param_get(_params, MAG_SI_YX, &_si_yx);
+	param_get(_params, MAG_SI_YY, &_si_yy);
+	param_get(_params, MAG_SI_YZ, &_si_yz);
+	param_get(_params, MAG_SI_ZX, &_si_zx);
+	param_get(_params, MAG_SI_ZY, &_si_zy);
+	param_get(_params, MAG_SI_ZZ, &_si_zz);
+	param_get(_params, IMU_GYR_CUTOFF, &_gyr_cutoff);
+	param_get(_params, IMU_ACC_CUTOFF, &_acc_cutoff);
+	param_get(_params, IMU_NOTCH_FREQ, &_notch_freq);
+	param_get(_params, IMU_NOTCH_BW, &_notch_bw);
+	param_get(_params, IMU_DNF_EN, &_dnf_enable);
+	param_get(_params, IMU_DNF_MIN, &_dnf_min);
+	param_get(_params, IMU_DNF_MAX, &_dnf_max);
+	param_get(_params, IMU_DNF_BW, &_dnf_bw);
 }
 
 void Sensors::update()
@@ -79,10 +88,11 @@ void Sensors::update_load_params()
 void Sensors::update_flight()
 {
 	float ax, ay, az, gx, gy, gz;
+	uint64_t imu_time;
 
-	if (_hal->read_imu(&ax, &ay, &az, &gx, &gy, &gz))
+	if (_hal->read_imu(&ax, &ay, &az, &gx, &gy, &gz, &imu_time))
 	{
-		_unc_imu_pub.publish(uncalibrated_imu_s{gx, gy, gz, ax, ay, az, _hal->get_time_us()});
+		_unc_imu_pub.publish(uncalibrated_imu_s{gx, gy, gz, ax, ay, az, imu_time});
 
 		// Apply IMU calibration
 		gx -= -_gyr_off_x;
@@ -92,21 +102,26 @@ void Sensors::update_flight()
 		ay -= _acc_off_y;
 		az -= _acc_off_z;
 
-		_imu_pub.publish(IMU_data{gx, gy, gz, ax, ay, az, _hal->get_time_us()});
+		float gyr[3] = {gx, gy, gz};
+		float acc[3] = {ax, ay, az};
+		filter_imu(gyr, acc, imu_time);
+
+		_imu_pub.publish(IMU_data{gyr[0], gyr[1], gyr[2], acc[0], acc[1], acc[2], imu_time});
 	}
 
-	float baro_alt;
+	Baro_data baro;
 
-	if (_hal->read_baro(&baro_alt))
+	if (_hal->read_baro(&baro.alt, &baro.pressure, &baro.temperature, &baro.timestamp))
 	{
-		_baro_pub.publish(Baro_data{baro_alt, _hal->get_time_us()});
+		_baro_pub.publish(baro);
 	}
 
 	float mx, my, mz;
+	uint64_t mag_time;
 
-	if (_hal->read_mag(&mx, &my, &mz))
+	if (_hal->read_mag(&mx, &my, &mz, &mag_time))
 	{
-		_unc_mag_pub.publish(uncalibrated_mag_s{mx, my, mz, _hal->get_time_us()});
+		_unc_mag_pub.publish(uncalibrated_mag_s{mx, my, mz, mag_time});
 
 		// Apply hard-iron offsets
 		mx -= _hi_x;
@@ -118,7 +133,14 @@ void Sensors::update_flight()
 		my = _si_yx * mx + _si_yy * my + _si_yz * mz;
 		mz = _si_zx * mx + _si_zy * my + _si_zz * mz;
 
-		_mag_pub.publish(Mag_data{mx, my, mz, _hal->get_time_us()});
+		_mag_pub.publish(Mag_data{mx, my, mz, mag_time});
+	}
+
+	GNSS_data gnss;
+
+	if (_hal->read_gnss(&gnss))
+	{
+		_gnss_pub.publish(gnss);
 	}
 
 	int16_t of_x, of_y;
@@ -129,6 +151,114 @@ void Sensors::update_flight()
 	}
 }
 
+// Runs on every raw sample, before anything downstream sees it
+void Sensors::filter_imu(float gyr[3], float acc[3], uint64_t timestamp)
+{
+	const float dt = (timestamp - _last_imu_time) * US_TO_S;
+	_last_imu_time = timestamp;
+
+	// A gap is not the sample rate and leaves the filter state stale. The
+	// filters restart from this sample and keep the coefficients of the
+	// nominal rate, so nothing downstream sees an unfiltered step.
+	if (dt <= 0 || dt > DT_MAX)
+	{
+		reset_imu_filters(gyr, acc);
+	}
+	else
+	{
+		_imu_dt = _imu_dt > 0 ? _imu_dt + IMU_DT_GAIN * (dt - _imu_dt) : dt;
+
+		const float rate = 1.0f / _imu_dt;
+
+		if (fabsf(rate - _filter_rate) > IMU_RATE_TOLERANCE * _filter_rate ||
+			_gyr_cutoff != _filter_gyr_cutoff || _acc_cutoff != _filter_acc_cutoff ||
+			_notch_freq != _filter_notch_freq || _notch_bw != _filter_notch_bw)
+		{
+			design_imu_filters(gyr, acc);
+		}
+
+		if (_dnf_enable)
+		{
+			update_dynamic_notches(gyr, timestamp);
+		}
+	}
+
+	if (_dnf_enable)
+	{
+		for (uint8_t i = 0; i < Gyro_fft::MAX_PEAKS; i++)
+		{
+			_gyr_dyn_notch[i].apply(gyr);
+		}
+	}
+
+	_gyr_notch.apply(gyr);
+	_gyr_lowpass.apply(gyr);
+	_acc_lowpass.apply(acc);
+}
+
+void Sensors::design_imu_filters(const float gyr[3], const float acc[3])
+{
+	const bool first = _filter_rate == 0;
+
+	_filter_rate = 1.0f / _imu_dt;
+	_filter_gyr_cutoff = _gyr_cutoff;
+	_filter_acc_cutoff = _acc_cutoff;
+	_filter_notch_freq = _notch_freq;
+	_filter_notch_bw = _notch_bw;
+
+	_gyr_notch.set_coeffs(biquad_notch(_filter_rate, _notch_freq, _notch_bw));
+	_gyr_lowpass.set_coeffs(biquad_lowpass(_filter_rate, _gyr_cutoff));
+	_acc_lowpass.set_coeffs(biquad_lowpass(_filter_rate, _acc_cutoff));
+
+	if (first)
+	{
+		reset_imu_filters(gyr, acc);
+	}
+}
+
+void Sensors::reset_imu_filters(const float gyr[3], const float acc[3])
+{
+	_gyr_notch.reset(gyr);
+	_gyr_lowpass.reset(gyr);
+	_acc_lowpass.reset(acc);
+
+	for (uint8_t i = 0; i < Gyro_fft::MAX_PEAKS; i++)
+	{
+		_gyr_dyn_notch[i].reset(gyr);
+	}
+}
+
+// The FFT sees the gyro before any notch, otherwise it would lose the
+// peaks it is tracking
+void Sensors::update_dynamic_notches(const float gyr[3], uint64_t timestamp)
+{
+	_gyro_fft.set_range(_dnf_min, _dnf_max);
+
+	const uint32_t start = _hal->get_cycle_count();
+	const bool updated = _gyro_fft.update(gyr, _filter_rate);
+	const uint32_t cycles = _hal->get_cycle_count() - start;
+
+	if (cycles > _gyro_fft_data.cycles_max)
+	{
+		_gyro_fft_data.cycles_max = cycles;
+	}
+
+	if (!updated)
+	{
+		return;
+	}
+
+	for (uint8_t i = 0; i < Gyro_fft::MAX_PEAKS; i++)
+	{
+		_gyr_dyn_notch[i].set_coeffs(biquad_notch(_filter_rate, _gyro_fft.peak_freq[i], _dnf_bw));
+		_gyro_fft_data.peak_freq[i] = _gyro_fft.peak_freq[i];
+		_gyro_fft_data.peak_snr[i] = _gyro_fft.peak_snr[i];
+	}
+
+	_gyro_fft_data.timestamp = timestamp;
+	_gyro_fft_pub.publish(_gyro_fft_data);
+}
+
 void Sensors::update_hitl()
 {
 	if (_hitl_sensors_sub.check_new())
@@ -153,13 +283,13 @@ void Sensors::update_hitl()
 		});
 
 		_baro_pub.publish(Baro_data{
-			_hitl_sensors.baro_asl,
-			_hal->get_time_us()
+			.alt = _hitl_sensors.baro_asl,
+			.timestamp = _hal->get_time_us()
 		});
 
 		_gnss_pub.publish(GNSS_data{
-			.lat = (double)_hitl_sensors.gps_lat / 1E7,
-			.lon = (double)_hitl_sensors.gps_lon / 1E7,
+			.lat = _hitl_sensors.gps_lat,
+			.lon = _hitl_sensors.gps_lon,
 			.sats = 10,
 			.fix = true,
 			.timestamp = _hal->get_time_us()
@@ -2,13 +2,16 @@
 #define MODULES_SENSORS_SENSORS_H_
 
 #include "lib/constants/constants.h"
+#include "lib/filters/biquad.h"
+#include "lib/filters/gyro_fft.h"
 #include "lib/module/module.h"
 #include "lib/parameters/params.h"
+#include <math.h>
 
 class Sensors : Module
 {
 public:
-	Sensors(HAL* hal, DataBus* data_bus);
+	Sensors(HAL* hal, DataBus* data_bus, param_context_t* params);
 
 	void update() override;
 
@@ -24,12 +27,32 @@ private:
 	Publisher<Power_data> _power_pub;
 	Publisher<uncalibrated_imu_s> _unc_imu_pub;
 	Publisher<uncalibrated_mag_s> _unc_mag_pub;
+	Publisher<gyro_fft_s> _gyro_fft_pub;
 
 	Modes_data _modes_data;
 	hitl_sensors_s _hitl_sensors;
 
 	bool _enable_hitl = false;
 
+	// IMU filters, designed for the sample rate measured from the timestamps
+	static constexpr float IMU_DT_GAIN = 0.01f;
+	static constexpr float IMU_RATE_TOLERANCE = 0.1f;
+	Biquad3 _gyr_notch;
+	Biquad3 _gyr_lowpass;
+	Biquad3 _acc_lowpass;
+	uint64_t _last_imu_time = 0;
+	float _imu_dt = 0;
+	float _filter_rate = 0;
+	float _filter_gyr_cutoff = -1;
+	float _filter_acc_cutoff = -1;
+	float _filter_notch_freq = -1;
+	float _filter_notch_bw = -1;
+
+	// Dynamic notches, retuned to the vibration peaks found by the FFT
+	Gyro_fft _gyro_fft;
+	Biquad3 _gyr_dyn_notch[Gyro_fft::MAX_PEAKS];
+	gyro_fft_s _gyro_fft_data;
+
 	// Parameters
 	float _gyr_off_x;
 	float _gyr_off_y;
@@ -49,12 +72,24 @@ private:
 	float _si_zx;
 	float _si_zy;
 	float _si_zz;
+	float _gyr_cutoff;
+	float _acc_cutoff;
+	float _notch_freq;
+	float _notch_bw;
+	int32_t _dnf_enable;
+	float _dnf_min;
+	float _dnf_max;
+	float _dnf_bw;
 
 	void parameters_update();
 
 	void update_load_params();
 	void update_flight();
 	void update_hitl();
+	void filter_imu(float gyr[3], float acc[3], uint64_t timestamp);
+	void design_imu_filters(const float gyr[3], const float acc[3]);
+	void reset_imu_filters(const float gyr[3], const float acc[3]);
+	void update_dynamic_notches(const float gyr[3], uint64_t timestamp);
 };
 
 #endif /* MODULES_SENSORS_SENSORS_H_ */
@@ -1,7 +1,7 @@
 #include "modules/storage/storage.h"
 
-Storage::Storage(HAL* hal, DataBus* data_bus)
-	: Module(hal, data_bus),
+Storage::Storage(HAL* hal, DataBus* data_bus, param_context_t* params)
+	: Module(hal, data_bus, params),
 	  _imu_sub(data_bus->imu_node),
 	  _baro_sub(data_bus->baro_node),
 	  _modes_sub(data_bus->modes_node),
@@ -55,8 +55,8 @@ void Storage::write()
 	msg.roll = _ahrs_data.roll;
 	msg.pitch = _ahrs_data.pitch;
 	msg.yaw = _ahrs_data.yaw;
-	msg.lat = _gnss_data.lat;
-	msg.lon = _gnss_data.lon;
+	msg.lat = _gnss_data.lat * 1E-7f;
+	msg.lon = _gnss_data.lon * 1E-7f;
 	msg.system_mode = get_mode_id(
 		_modes_data.system_mode,
 		_modes_data.flight_mode,
@@ -66,8 +66,5 @@ void Storage::write()
 
 	uint8_t buffer[MAX_PACKET_LEN];
 	uint16_t size = aplink_flight_log_pack(msg, buffer);
-	for (int i = 0; i < size; i++)
-	{
-		_hal->write_storage(buffer[i]);
-	}
+	_hal->write_storage(buffer, size);
 }
@@ -18,7 +18,7 @@ extern "C"
 class Storage : public Module
 {
 public:
-	Storage(HAL* hal, DataBus* data_bus);
+	Storage(HAL* hal, DataBus* data_bus, param_context_t* params);
 
 	void update() override;
 
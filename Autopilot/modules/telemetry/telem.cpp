@@ -2,8 +2,9 @@
 
 // How to notify all other classes that waypoints have been loaded?
 
-Telem::Telem(HAL* hal, DataBus* data_bus)
-	: Module(hal, data_bus),
+Telem::Telem(HAL* hal, DataBus* data_bus, param_context_t* params, mission_context_t* mission)
+	: Module(hal, data_bus, params),
+	  _mission(mission),
 	  _local_pos_sub(data_bus->local_position_node),
 	  _ahrs_sub(data_bus->ahrs_node),
 	  _gnss_sub(data_bus->gnss_node),
@@ -28,10 +29,12 @@ void Telem::update()
 	_gnss_data = _gnss_sub.get();
 
 	send_telemetry();
+	update_mission_upload();
 
 	if (read_telem(&telem_msg))
 	{
-		if (telem_msg.msg_id == WAYPOINTS_COUNT_MSG_ID)
+		if (telem_msg.msg_id == WAYPOINTS_COUNT_MSG_ID ||
+			telem_msg.msg_id == WAYPOINTS_COUNT_V2_MSG_ID)
 		{
 			update_waypoints_count();
 		}
@@ -40,7 +43,8 @@ void Telem::update()
 		{
 			update_param_set();
 		}
-		else if (telem_msg.msg_id == MISSION_ITEM_MSG_ID)
+		else if (telem_msg.msg_id == MISSION_ITEM_MSG_ID ||
+				 telem_msg.msg_id == MISSION_ITEM_V2_MSG_ID)
 		{
 			update_waypoint();
 		}
@@ -69,8 +73,8 @@ void Telem::send_telemetry()
 		vehicle_status_full.yaw = (int16_t)(_ahrs_data.yaw * 100);
 		vehicle_status_full.alt = (int16_t)(-_local_pos.z * 100);
 		vehicle_status_full.spd = (int16_t)(_local_pos.gnd_spd * 100);
-		vehicle_status_full.lat = (int32_t)(_gnss_data.lat * 1E7);
-		vehicle_status_full.lon = (int32_t)(_gnss_data.lon * 1E7);
+		vehicle_status_full.lat = _gnss_data.lat;
+		vehicle_status_full.lon = _gnss_data.lon;
 		vehicle_status_full.mode_id = get_mode_id(
 			_modes_data.system_mode,
 			_modes_data.flight_mode,
@@ -88,8 +92,8 @@ void Telem::send_telemetry()
 		last_gps_raw_transmit_s = current_time_s;
 
 		aplink_gps_raw gps_raw;
-		gps_raw.lat = (int32_t)(_gnss_data.lat * 1E7);
-		gps_raw.lon = (int32_t)(_gnss_data.lon * 1E7);
+		gps_raw.lat = _gnss_data.lat;
+		gps_raw.lon = _gnss_data.lon;
 		gps_raw.sats = _gnss_data.sats;
 		gps_raw.fix = _gnss_data.fix;
 
@@ -117,10 +121,14 @@ void Telem::send_telemetry()
 	{
 		last_control_sp_transmit_s = current_time_s;
 
+		// Waypoint missions fly the altitude of the current waypoint
+		const float alt_sp = mission_get(_mission)->mission_type == MISSION_WAYPOINT ?
+			_waypoint_sub.get().current_alt : mission_get_altitude(_mission);
+
 		aplink_control_setpoints control_setpoints;
 		control_setpoints.roll_sp = 0;
 		control_setpoints.pitch_sp = 0;
-		control_setpoints.alt_sp = (int16_t)(mission_get_altitude() * 1e2);
+		control_setpoints.alt_sp = (int16_t)(alt_sp * 1e2);
 		control_setpoints.spd_sp = 0;
 
 		uint8_t packet[MAX_PACKET_LEN];
@@ -158,26 +166,26 @@ void Telem::update_param_set()
 	printf("Telem param name: %s\n", param_set.name);
 
 	bool success = false;
-	param_t param = param_find(param_set.name);
+	param_t param = param_find(_params, param_set.name);
 	if (param == PARAM_INVALID)
 	{
 		printf("Param not found\n");
 	}
-	else if (param_get_type(param) == PARAM_TYPE_FLOAT &&
+	else if (param_get_type(_params, param) == PARAM_TYPE_FLOAT &&
 			 param_set.type == APLINK_PARAM_TYPE::APLINK_PARAM_TYPE_FLOAT)
 	{
 		float value;
 		memcpy(&value, param_set.value, sizeof(value));
-		param_set_float(param, value);
+		param_set_float(_params, param, value);
 		success = true;
 		printf("Telem params set, value: %f\n", value);
 	}
-	else if (param_get_type(param) == PARAM_TYPE_INT32 &&
+	else if (param_get_type(_params, param) == PARAM_TYPE_INT32 &&
 			 param_set.type == APLINK_PARAM_TYPE::APLINK_PARAM_TYPE_INT32)
 	{
 		int32_t value;
 		memcpy(&value, param_set.value, sizeof(value));
-		param_set_int32(param, value);
+		param_set_int32(_params, param, value);
 		success = true;
 		printf("Telem params set, value: %d\n", value);
 	}
@@ -195,87 +203,164 @@ void Telem::update_param_set()
 	}
 }
 
+// The original messages carry a uint8_t count and index and no altitude, the
+// V2 messages a uint16_t count and index and a per-item altitude. Replies
+// use the same version as the count that started the upload.
 void Telem::update_waypoints_count()
 {
-	aplink_waypoints_count waypoints_count{};
-	aplink_waypoints_count_unpack(&telem_msg, &waypoints_count);
+	aplink_waypoints_count_v2 waypoints_count{};
+
+	if (telem_msg.msg_id == WAYPOINTS_COUNT_V2_MSG_ID)
+	{
+		if (!aplink_waypoints_count_v2_unpack(&telem_msg, &waypoints_count))
+		{
+			return;
+		}
+	}
+	else
+	{
+		aplink_waypoints_count count_v1;
+
+		if (!aplink_waypoints_count_unpack(&telem_msg, &count_v1))
+		{
+			return;
+		}
+
+		waypoints_count.num_waypoints = count_v1.num_waypoints;
+		waypoints_count.type = count_v1.type;
+		waypoints_count.radius = count_v1.radius;
+		waypoints_count.direction = count_v1.direction;
+		waypoints_count.final_leg = count_v1.final_leg;
+		waypoints_count.glideslope = count_v1.glideslope;
+		waypoints_count.runway_heading = count_v1.runway_heading;
+	}
+
+	_mission_upload_v2 = telem_msg.msg_id == WAYPOINTS_COUNT_V2_MSG_ID;
 
 	// Reset Counter
 	_last_waypoint_loaded = 0;
 
+	// Items are streamed to storage and the mission is swapped in once saved
+	mission_data_t* mission_staging = mission_begin_update(_mission);
+
 	// Store data
-	_mission_data.num_items = waypoints_count.num_waypoints;
+	mission_staging->num_items = waypoints_count.num_waypoints;
 
 	switch (waypoints_count.type)
 	{
 	case APLINK_MISSION_ITEM_TYPE::APLINK_MISSION_ITEM_TYPE_WAYPOINT:
-		_mission_data.mission_type = MISSION_WAYPOINT;
+		mission_staging->mission_type = MISSION_WAYPOINT;
 		break;
 	case APLINK_MISSION_ITEM_TYPE::APLINK_MISSION_ITEM_TYPE_LOITER:
-		_mission_data.mission_type = MISSION_LOITER;
+		mission_staging->mission_type = MISSION_LOITER;
 		break;
 	case APLINK_MISSION_ITEM_TYPE::APLINK_MISSION_ITEM_TYPE_LAND:
-		_mission_data.mission_type = MISSION_LAND;
+		mission_staging->mission_type = MISSION_LAND;
 		break;
 	}
 
 	switch (waypoints_count.direction)
 	{
 	case APLINK_LOITER_DIRECTION::APLINK_LOITER_DIRECTION_LEFT:
-		_mission_data.loiter_direction = LOITER_LEFT;
+		mission_staging->loiter_direction = LOITER_LEFT;
 		break;
 	case APLINK_LOITER_DIRECTION::APLINK_LOITER_DIRECTION_RIGHT:
-		_mission_data.loiter_direction = LOITER_RIGHT;
+		mission_staging->loiter_direction = LOITER_RIGHT;
 		break;
 	}
 
-	_mission_data.final_leg_dist = waypoints_count.final_leg;
-	_mission_data.glideslope_angle = waypoints_count.glideslope;
-	_mission_data.loiter_radius = waypoints_count.radius;
-	_mission_data.runway_heading = waypoints_count.runway_heading;
-
-	// Request first waypoint
-	aplink_request_waypoint req_waypoint = {
-		.index = 0
-	};
+	mission_staging->final_leg_dist = waypoints_count.final_leg;
+	mission_staging->glideslope_angle = waypoints_count.glideslope;
+	mission_staging->loiter_radius = waypoints_count.radius;
+	mission_staging->runway_heading = waypoints_count.runway_heading;
 
-	uint8_t packet[MAX_PACKET_LEN];
-	uint16_t len = aplink_request_waypoint_pack(req_waypoint, packet);
-	_hal->transmit_telem(packet, len);
+	// First waypoint is requested by update_mission_upload()
+	_waypoint_request_pending = mission_staging->num_items > 0;
+	_mission_ack_pending = true;
 }
 
 void Telem::update_waypoint()
 {
-	aplink_mission_item mission_item{};
-	aplink_mission_item_unpack(&telem_msg, &mission_item);
+	aplink_mission_item_v2 mission_item{};
 
-	_mission_data.mission_items[_last_waypoint_loaded++] = mission_item_t {
-		.latitude = (double)mission_item.lat * 1E-7,
-		.longitude = (double)mission_item.lon * 1E-7,
+	if (telem_msg.msg_id == MISSION_ITEM_V2_MSG_ID)
+	{
+		if (!aplink_mission_item_v2_unpack(&telem_msg, &mission_item))
+		{
+			return;
+		}
+	}
+	else
+	{
+		aplink_mission_item item_v1;
+
+		if (!aplink_mission_item_unpack(&telem_msg, &item_v1))
+		{
+			return;
+		}
+
+		// Original items have no altitude, so they take the commanded altitude
+		mission_item.lat = item_v1.lat;
+		mission_item.lon = item_v1.lon;
+		mission_item.alt = (int16_t)(mission_get_altitude(_mission) * 10);
+	}
+
+	const mission_item_t item = {
+		.latitude = mission_item.lat,
+		.longitude = mission_item.lon,
+		.altitude = mission_item.alt,
+		.type = mission_get_staging(_mission)->mission_type,
+		.reserved = 0
 	};
 
-	// Check if all waypoints have been loaded
-	if (_last_waypoint_loaded == _mission_data.num_items)
+	if (!mission_add_item(_mission, &item))
 	{
-		// Update mission if waypoints finished loading
-		mission_set(_mission_data);
+		return;
+	}
 
-		// Send acknowledgement
-		aplink_waypoints_ack waypoints_ack;
-		waypoints_ack.success = true;
+	_last_waypoint_loaded++;
+	_waypoint_request_pending = _last_waypoint_loaded < mission_get_staging(_mission)->num_items;
+}
+
+// Request the next waypoint once storage has room for it, and acknowledge
+// the mission once it has been saved
+void Telem::update_mission_upload()
+{
+	if (_waypoint_request_pending && mission_upload_ready(_mission))
+	{
+		_waypoint_request_pending = false;
 
 		uint8_t packet[MAX_PACKET_LEN];
-		uint16_t len = aplink_waypoints_ack_pack(waypoints_ack, packet);
+		uint16_t len;
+
+		if (_mission_upload_v2)
+		{
+			aplink_request_waypoint_v2 req_waypoint;
+			req_waypoint.index = _last_waypoint_loaded;
+			len = aplink_request_waypoint_v2_pack(req_waypoint, packet);
+		}
+		else
+		{
+			aplink_request_waypoint req_waypoint;
+			req_waypoint.index = (uint8_t)_last_waypoint_loaded;
+			len = aplink_request_waypoint_pack(req_waypoint, packet);
+		}
+
 		_hal->transmit_telem(packet, len);
 	}
-	else
+
+	const mission_upload_state_t upload_state = mission_get_upload_state(_mission);
+
+	if (_mission_ack_pending &&
+		(upload_state == MISSION_UPLOAD_DONE || upload_state == MISSION_UPLOAD_FAILED))
 	{
-		// Request next waypoint if waypoints not finished loading
-		aplink_request_waypoint req_waypoint;
-		req_waypoint.index = _last_waypoint_loaded;
+		_mission_ack_pending = false;
+
+		aplink_waypoints_ack waypoints_ack;
+		waypoints_ack.success = upload_state == MISSION_UPLOAD_DONE;
 
 		uint8_t packet[MAX_PACKET_LEN];
-		uint16_t len = aplink_request_waypoint_pack(req_waypoint, packet);
+		uint16_t len = aplink_waypoints_ack_pack(waypoints_ack, packet);
 		_hal->transmit_telem(packet, len);
 	}
 }
@@ -285,7 +370,7 @@ void Telem::update_set_altitude()
 	aplink_set_altitude msg{};
 	aplink_set_altitude_unpack(&telem_msg, &msg);
 
-	mission_set_altitude(msg.altitude);
+	mission_set_altitude(_mission, msg.altitude);
 
 	aplink_set_altitude_result result = {
 		.success = true
@@ -296,17 +381,24 @@ void Telem::update_set_altitude()
 	_hal->transmit_telem(packet, len);
 }
 
+// Parse in place, bytes after a complete message are left for the next call
 bool Telem::read_telem(aplink_msg* msg)
 {
-	while (!_hal->telem_buffer_empty())
-	{
-		uint8_t byte;
-		_hal->read_telem(&byte);
+	const uint8_t* data;
+	uint16_t len;
 
-		if (aplink_parse_byte(msg, byte))
+	while ((len = _hal->peek_telem(&data)) > 0)
+	{
+		for (uint16_t i = 0; i < len; i++)
 		{
-			return true;
+			if (aplink_parse_byte(msg, data[i]))
+			{
+				_hal->consume_telem(i + 1);
+				return true;
+			}
 		}
+
+		_hal->consume_telem(len);
 	}
 
 	return false;
@@ -26,11 +26,13 @@ static constexpr float CONTROL_SP_DT = 0.1;
 class Telem : public Module
 {
 public:
-	Telem(HAL* hal, DataBus* data_bus);
+	Telem(HAL* hal, DataBus* data_bus, param_context_t* params, mission_context_t* mission);
 
 	void update();
 
 private:
+	mission_context_t* _mission;
+
 	Subscriber<GNSS_data> _gnss_sub;
 	Subscriber<AHRS_data> _ahrs_sub;
 	Subscriber<local_position_s> _local_pos_sub;
@@ -61,12 +63,15 @@ private:
 	float last_power_transmit_s = 0;
 	float last_control_sp_transmit_s;
 
-	mission_data_t _mission_data;
-	uint8_t _last_waypoint_loaded = 0;
+	uint16_t _last_waypoint_loaded = 0;
+	bool _waypoint_request_pending = false;
+	bool _mission_ack_pending = false;
+	bool _mission_upload_v2 = false; // Upload started by WAYPOINTS_COUNT_V2
 
 	void update_param_set();
 	void update_waypoints_count();
 	void update_waypoint();
+	void update_mission_upload();
 	void update_set_altitude();
 	void send_telemetry();
 	void send_calibration();
@@ -1,7 +1,7 @@
 #include "usb_comm.h"
 
-USBComm::USBComm(HAL* hal, DataBus* data_bus)
-	: Module(hal, data_bus),
+USBComm::USBComm(HAL* hal, DataBus* data_bus, param_context_t* params)
+	: Module(hal, data_bus, params),
 	  _local_pos_sub(data_bus->local_position_node),
 	  _ahrs_sub(data_bus->ahrs_node),
 	  _gnss_sub(data_bus->gnss_node),
@@ -23,30 +23,49 @@ void USBComm::update()
 	_gnss_data = _gnss_sub.get();
 	_hitl_output_data = _hitl_output_sub.get();
 
-	// Read
-	if (read_usb())
+	// Transmit status for debug purposes, in lockstep every step is answered
+	// instead
+	if (!_lockstep)
+	{
+		transmit();
+	}
+}
+
+bool USBComm::read_step()
+{
+	while (read_usb())
 	{
 		if (msg.msg_id == HITL_SENSORS_MSG_ID)
 		{
 			read_hitl();
 		}
+		else if (msg.msg_id == HITL_STEP_MSG_ID && read_hitl_step())
+		{
+			return true;
+		}
 	}
 
-	// Transmit status for debug purposes
-	transmit();
+	return false;
 }
 
+// Parse in place, bytes after a complete message are left for the next call
 bool USBComm::read_usb()
 {
-	while (!_hal->usb_buffer_empty())
-	{
-		uint8_t byte;
-		_hal->usb_read(&byte);
+	const uint8_t* data;
+	uint16_t len;
 
-		if (aplink_parse_byte(&msg, byte))
+	while ((len = _hal->usb_peek(&data)) > 0)
+	{
+		for (uint16_t i = 0; i < len; i++)
 		{
-			return true;
+			if (aplink_parse_byte(&msg, data[i]))
+			{
+				_hal->usb_consume(i + 1);
+				return true;
+			}
 		}
+
+		_hal->usb_consume(len);
 	}
 
 	return false;
@@ -77,6 +96,76 @@ void USBComm::read_hitl()
 	_hitl_sensors_pub.publish(hitl_data);
 }
 
+// A repeated sequence number is a step the simulator did not get the answer
+// to, it is answered again without running the loop
+bool USBComm::read_hitl_step()
+{
+	aplink_hitl_step step;
+
+	if (!aplink_hitl_step_unpack(&msg, &step))
+	{
+		return false;
+	}
+
+	if (_lockstep && step.sequence == _step_sequence)
+	{
+		transmit_step();
+		return false;
+	}
+
+	if (_lockstep && step.sequence != _step_sequence + 1)
+	{
+		printf("HITL: step %lu after %lu\n", (unsigned long)step.sequence, (unsigned long)_step_sequence);
+	}
+
+	_lockstep = true;
+	_step_sequence = step.sequence;
+	_step_time = step.time_us;
+	_hal->set_sim_time(step.time_us);
+
+	hitl_sensors_s hitl_data;
+	hitl_data.imu_ax = step.imu_ax;
+	hitl_data.imu_ay = step.imu_ay;
+	hitl_data.imu_az = step.imu_az;
+	hitl_data.imu_gx = step.imu_gx;
+	hitl_data.imu_gy = step.imu_gy;
+	hitl_data.imu_gz = step.imu_gz;
+	hitl_data.mag_x = step.mag_x;
+	hitl_data.mag_y = step.mag_y;
+	hitl_data.mag_z = step.mag_z;
+	hitl_data.baro_asl = step.baro_asl;
+	hitl_data.gps_lat = step.gps_lat;
+	hitl_data.gps_lon = step.gps_lon;
+	hitl_data.of_x = step.of_x;
+	hitl_data.of_y = step.of_y;
+	hitl_data.timestamp = step.time_us;
+
+	_hitl_sensors_pub.publish(hitl_data);
+	return true;
+}
+
+// Outputs of the loop run for the last step, zero before the mixer has
+// produced any
+void USBComm::transmit_step()
+{
+	const HITL_output_data output = _hitl_output_sub.get();
+
+	aplink_hitl_step_output step_output{};
+	step_output.sequence = _step_sequence;
+	step_output.time_us = _step_time;
+
+	if (output.timestamp == _step_time)
+	{
+		step_output.ele_pwm = output.ele_duty;
+		step_output.rud_pwm = output.rud_duty;
+		step_output.thr_pwm = output.thr_duty;
+	}
+
+	uint8_t buffer[MAX_PACKET_LEN];
+	const uint16_t len = aplink_hitl_step_output_pack(step_output, buffer);
+	_hal->usb_transmit(buffer, len);
+}
+
 void USBComm::transmit()
 {
 	aplink_hitl_commands hitl_commands;
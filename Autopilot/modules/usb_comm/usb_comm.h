@@ -4,6 +4,7 @@
 #include <lib/module/module.h>
 #include "lib/utils/utils.h"
 #include "lib/parameters/params.h"
+#include <stdio.h>
 
 extern "C"
 {
@@ -14,10 +15,18 @@ extern "C"
 class USBComm : Module
 {
 public:
-	USBComm(HAL* hal, DataBus* data_bus);
+	USBComm(HAL* hal, DataBus* data_bus, param_context_t* params);
 
 	void update() override;
 
+	// Lockstep HITL. read_step() handles every message received so far and
+	// returns true once for each new step, which has set the simulated time
+	// and published its sensors. The caller then runs the loop once and
+	// answers with transmit_step().
+	bool read_step();
+	void transmit_step();
+	bool lockstep_active() const { return _lockstep; }
+
 private:
 	Subscriber<GNSS_data> _gnss_sub;
 	Subscriber<AHRS_data> _ahrs_sub;
@@ -45,8 +54,13 @@ private:
 
 	aplink_msg msg;
 
+	bool _lockstep = false;
+	uint32_t _step_sequence = 0;
+	uint64_t _step_time = 0;
+
 	bool read_usb();
 	void read_hitl();
+	bool read_hitl_step();
 	void transmit();
 };
 
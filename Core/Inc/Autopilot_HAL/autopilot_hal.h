@@ -10,6 +10,8 @@
 #include "Drivers/ina219.h"
 #include "Drivers/mlx90393.h"
 #include "Drivers/sd.h"
+#include "Drivers/spi_bus.h"
+#include "Drivers/timebase.h"
 #include "Drivers/uart_stream.h"
 #include "Drivers/usb_stream.h"
 #include "Drivers/cxof.h"
@@ -26,6 +28,7 @@ extern SPI_HandleTypeDef hspi1;
 
 extern TIM_HandleTypeDef htim2;
 extern TIM_HandleTypeDef htim3;
+extern TIM_HandleTypeDef htim4;
 extern TIM_HandleTypeDef htim5;
 extern TIM_HandleTypeDef htim6;
 extern TIM_HandleTypeDef htim7;
@@ -35,6 +38,42 @@ extern UART_HandleTypeDef huart3;
 extern UART_HandleTypeDef huart4;
 extern UART_HandleTypeDef huart6;
 
+// Fast task timing. Latency is from the IMU data ready interrupt of the
+// sample used to the PWM update, jitter is the spread of the loop period.
+// Run time is the cost of one pass through the fast task.
+struct LoopStats
+{
+	uint64_t last_start = 0;
+	uint32_t period_min = UINT32_MAX;
+	uint32_t period_max = 0;
+	uint32_t latency_min = UINT32_MAX;
+	uint32_t latency_max = 0;
+	uint64_t latency_sum = 0;
+	uint16_t latency_count = 0;
+	uint32_t run_max = 0;
+	uint64_t run_sum = 0;
+	uint16_t cycles = 0;
+};
+
+// RC passthrough latency, from the arrival of the SBUS frame to the start
+// of the first PWM frame carrying it
+struct RcLatencyStats
+{
+	uint32_t min = UINT32_MAX;
+	uint32_t max = 0;
+	uint64_t sum = 0;
+	uint16_t count = 0;
+};
+
+// Copy of the stats handed from the fast task to the SD task, which prints
+// it. The fast task only writes it while ready is clear.
+struct LoopReport
+{
+	LoopStats loop;
+	RcLatencyStats rc;
+	bool imu_sync = false;
+};
+
 class AutopilotHAL : public HAL
 {
 public:
@@ -42,10 +81,10 @@ public:
 
 	void init() override;
 
-	bool read_imu(float *ax, float *ay, float *az, float *gx, float *gy, float *gz) override;
-	bool read_mag(float *mx, float *my, float *mz) override;
-	bool read_baro(float *alt) override;
-	bool read_gnss(double *lat, double *lon, float* alt, uint8_t* sats, bool* fix) override;
+	bool read_imu(float *ax, float *ay, float *az, float *gx, float *gy, float *gz, uint64_t *timestamp) override;
+	bool read_mag(float *mx, float *my, float *mz, uint64_t *timestamp) override;
+	bool read_baro(float *alt, float *pressure, float *temperature, uint64_t *timestamp) override;
+	bool read_gnss(GNSS_data* gnss) override;
 	bool read_optical_flow(int16_t *x, int16_t *y) override;
 	bool read_power_monitor(float *voltage, float* current) override;
 
@@ -54,14 +93,20 @@ public:
 	void init_gnss();
 	void init_compass();
 	void init_of();
+	void start_sensor_reads();
 
-	static void gnss_dma_complete() { _instance->_gnss.dma_complete(); }
-	static void of_dma_complete() { _instance->cxof.dma_complete(); }
 
 	// logger_hal.cpp
 	void create_file(char name[], uint8_t len) override;
-	bool write_storage(uint8_t byte) override;
-	static void sd_interrupt_callback() { _instance->_sd.interrupt_callback(); }
+	uint16_t write_storage(const uint8_t* data, uint16_t len) override;
+	bool read_mission_file(uint8_t file, uint32_t offset, void* data, uint32_t len) override;
+	bool write_mission_file(uint8_t file, uint32_t offset, const void* data, uint32_t len) override;
+	bool mission_file_ready(bool* success) override;
+	static void sd_interrupt_callback()
+	{
+		_instance->print_loop_stats();
+		_instance->_sd.interrupt_callback();
+	}
 
 	// debug_hal.cpp
 	void debug_print(char * str) override;
@@ -70,11 +115,15 @@ public:
 	// time_hal.cpp
 	void delay_us(uint64_t) override;
 	uint64_t get_time_us() const override;
+	uint32_t get_cycle_count() const override;
+	void set_sim_time(uint64_t time_us) override;
 
-	// servos_hal.cpp
+	// control_hal.cpp
 	void init_servos();
 	void set_pwm(uint16_t ele_duty, uint16_t rud_duty, uint16_t thr_duty,
 				 uint16_t aux1_duty, uint16_t aux2_duty, uint16_t aux3_duty) override;
+	void set_pwm_rate(Pwm_group group, uint16_t rate_hz) override;
+	void set_rc_passthrough(const Rc_passthrough* passthrough) override;
 
 	// power_monitor_hal.cpp
 	void read_power_monitor();
@@ -82,26 +131,31 @@ public:
 	// telemetry_hal.cpp
 	void init_telem();
 	void transmit_telem(uint8_t tx_buff[], int len) override;
-	bool read_telem(uint8_t* byte) override;
-	bool telem_buffer_empty() override;
-	static void telemetry_dma_complete() { _instance->telem.dma_complete(); }
+	uint16_t read_telem(uint8_t* data, uint16_t len) override;
+	uint16_t peek_telem(const uint8_t** data) override;
+	void consume_telem(uint16_t len) override;
 
 	// RC
 	void get_rc_input(uint16_t duty[], uint8_t num_channels) override;
-	static void rc_dma_complete() { _instance->sbus_input.dma_complete(); }
 
 	// USB
-	bool usb_buffer_empty() override;
-  	void usb_transmit(uint8_t buf[], int len);
-	bool usb_read(uint8_t *byte);
-	static void usb_rx_callback(uint8_t* Buf, uint32_t Len) { _instance->usb_stream.rx_callback(Buf, Len); };
+  	void usb_transmit(uint8_t buf[], int len) override;
+	uint16_t usb_read(uint8_t* data, uint16_t len) override;
+	uint16_t usb_peek(const uint8_t** data) override;
+	void usb_consume(uint16_t len) override;
+	void usb_rx(uint8_t* Buf, uint32_t Len);
+	static void usb_rx_callback(uint8_t* Buf, uint32_t Len) { _instance->usb_rx(Buf, Len); };
 
 	// scheduler_hal.cpp
-	void set_main_task(void (*task)()) override;
+	void set_main_task(void (*task)(void* context), void* context) override;
+	void set_fast_task(void (*task)(void* context), void* context, bool imu_sync) override;
 	void execute_main_task();
+	void execute_imu_interrupt();
 	static void main_task_callback() { _instance->execute_main_task(); }
+	static void imu_interrupt_callback() { if (_instance) _instance->execute_imu_interrupt(); }
 
 private:
+	Spi_bus _spi1;
 	ICM42688 _imu;
 	INA219 _ina219;
 	Adafruit_MLX90393 _mag;
@@ -109,14 +163,55 @@ private:
 	Sd _sd;
 	SBUS_input sbus_input;
 	Uart_stream telem;
-	Servo servo1;
-	Servo servo2;
+	Servo_group _servos; // TIM3, elevator and aux 1-3
+	Servo_group _rudder_servo; // TIM2
+	Servo_group _throttle_servo; // TIM4
 	Cxof cxof;
 	USB_stream usb_stream;
 
-	// scheduler_hal.cpp
-	void (*main_task)() = nullptr;
+	// control_hal.cpp, written from the SBUS interrupt
+	Rc_passthrough _passthrough{};
+	volatile bool _passthrough_enabled = false;
+	RcLatencyStats _rc_latency; // Taken and reset by the fast task with interrupts masked
+
+	void rc_passthrough(const uint16_t channels[], uint64_t frame_time);
+	static void rc_frame_callback(void* context, const uint16_t channels[], uint64_t frame_time)
+	{
+		static_cast<AutopilotHAL*>(context)->rc_passthrough(channels, frame_time);
+	}
+
+	// Results of the SPI reads started at the top of the fast task
+	bool _mag_ready = false;
+	bool _baro_ready = false;
 
+	// time_hal.cpp
+	volatile bool _lockstep = false;
+	volatile uint64_t _sim_time_us = 0; // Accessed with interrupts masked, 64 bits take two stores
+
+	// scheduler_hal.cpp
+	void (*main_task)(void* context) = nullptr;
+	void* main_task_context = nullptr;
+	void (*fast_task)(void* context) = nullptr;
+	void* fast_task_context = nullptr;
+	bool _imu_sync = false;
+	volatile bool _imu_sync_active = false;
+	volatile bool _imu_sync_changed = false; // Printed by the SD task, not from the interrupts
+	uint64_t _imu_interrupt_time = 0;
+	uint64_t _imu_sample_time = 0; // Data ready time of the last sample read
+	LoopStats _loop_stats;
+	LoopReport _loop_report;
+	volatile bool _loop_report_ready = false;
+
+	// Two periods of the timer fallback
+	static constexpr uint64_t IMU_SYNC_TIMEOUT_US = 20000;
+	static constexpr uint16_t LOOP_STATS_CYCLES = 500;
+
+	void execute_fast_task();
+	void record_actuator_latency();
+	void print_loop_stats();
+
+	// The interrupt vectors of the board reach the HAL through this, there
+	// is only ever one
 	static AutopilotHAL* _instance;
 };
 
@@ -25,6 +25,8 @@ typedef enum OSR {
 
 /**
  * @brief Init the Barometer with default parameters
+ * 		  Only resets the driver state, the sensor reset and calibration
+ * 		  reads are done by the first calls to Barometer_calculate
  */
 extern void Barometer_init();
 
@@ -37,44 +39,43 @@ extern void Barometer_init();
 extern void Barometer_setOSR(OSR osr);
 
 /**
- * @brief Return the temperature with a 2 digits precision in celcius
- * Example : 2000 -> 20,00°C
+ * @brief Return the temperature of the last sample in celcius
  *
- * @param calculate true if you want to update the value
- * 		  It will update the threes values
- * @pre call Barometer_init
- *
- * @return the temperature
+ * @pre Barometer_calculate returned true
  */
-extern int32_t Barometer_getTemp(bool calculate);
+extern float Barometer_getTemp();
 
 /**
- * @brief Return the pressure in mbar with a 2 digits precision
- * Example : 100000 -> 1000,00 mbar
- *
- * @param calculate true if you want to update the value
- * 		  It will update the threes values
- * @pre call Barometer_init
+ * @brief Return the pressure of the last sample in pascal
  *
- * @return the pressure
+ * @pre Barometer_calculate returned true
  */
-extern int32_t Barometer_getPressure(bool calculate);
+extern float Barometer_getPressure();
 
 /**
- * @brief Return the altitude in meters
+ * @brief Return the altitude of the last sample in meters
  *
- * @param calculate true if you want to update the value
- * 		  It will update the threes values
- * @pre call Barometer_init
+ * @pre Barometer_calculate returned true
+ */
+extern float Barometer_getAltitude();
+
+/**
+ * @brief Return the time of the last sample in microseconds
+ * 		  This is the middle of its pressure conversion
  *
- * @return the altitude
+ * @pre Barometer_calculate returned true
  */
-extern bool Barometer_getAltitude(float *alt);
+extern uint64_t Barometer_getTimestamp();
 
 /**
- * @brief calculate/update the altitude/pressure/temperature
- * 		  using the barometer
+ * @brief advance the conversion sequence without blocking
+ * 		  Call it often, a conversion is only read out on the first
+ * 		  call after it finished
+ *
+ * @param time_us the current time in microseconds
+ *
+ * @return true if a new pressure sample is available
  */
-extern bool Barometer_calculate();
+extern bool Barometer_calculate(uint64_t time_us);
 
 #endif /* BAROMETER_H_ */
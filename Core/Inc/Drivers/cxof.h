@@ -2,6 +2,7 @@
 #define INC_DRIVERS_CXOF_H_
 
 #include "stm32f4xx_hal.h"
+#include "Drivers/uart_rx.h"
 #include <cstring>
 #include <stdio.h>
 
@@ -27,15 +28,16 @@ public:
 	Cxof(UART_HandleTypeDef* uart);
 	void setup();
 	bool read(Cxof_frame* frame);
-	void dma_complete();
 private:
-	UART_HandleTypeDef* _uart;
-	uint8_t rx_buffer[1];
+	uint8_t rx_buffer[128];
+	Uart_rx _rx;
 	uint8_t working_frame[CXOF_FRAME_LEN];
-	uint8_t frame_idx;
+	uint8_t frame_idx = 0;
 	bool frame_started = false;
 	bool new_data = false;
 	Cxof_frame result;
+
+	void parse_byte(uint8_t byte);
 };
 
 #endif /* INC_DRIVERS_CXOF_H_ */
@@ -9,17 +9,19 @@
 #define INC_GNSS_H_
 
 #include "stm32f4xx_hal.h"
+#include "Drivers/uart_rx.h"
+#include "Drivers/ubx.h"
 #include <cstdio>
 #include <cstring>
 
-extern "C"
-{
-#include "usbd_cdc_if.h"
-#include "minmea.h"
-}
-
 /**
- * Configure GNSS in U-center to ONLY output GGA NMEA sentences
+ * u-blox receiver on the UBX protocol
+ *
+ * setup() switches the port to UBX output and enables NAV-PVT at 10 Hz. The
+ * configuration is sent both as legacy CFG messages (M8) and as a VALSET
+ * (M9 and M10), each generation rejects the other. It is sent again whenever
+ * no solution arrives for a while, so a receiver that was still booting or
+ * got power cycled picks it up. The baud rate is left as it is.
  */
 class GNSS
 {
@@ -27,25 +29,26 @@ public:
 	GNSS(UART_HandleTypeDef* uart);
 	void setup();
 	bool read();
-	void dma_complete();
 
-	double lat = 0; // deg
-	double lon = 0; // deg
-	float alt = 0;
-	uint8_t sats = 0;
-	bool fix = false;
+	Ubx_nav_pvt pvt;
+	uint64_t timestamp = 0; // Reception of the solution (us)
 private:
 	UART_HandleTypeDef* _uart;
+	uint8_t rx_buffer[256];
+	Uart_rx _rx;
 
-	uint8_t rx_buffer[1];
+	static constexpr uint16_t measurement_period_ms = 100;
+	static constexpr uint32_t config_retry_ms = 1000;
+	uint8_t tx_buffer[96];
+	uint16_t tx_len = 0;
+	uint32_t last_solution_time = 0;
 
-	static constexpr uint8_t max_sentence_len = 100;
-	char sentence[max_sentence_len];
-	uint8_t sentence_index = 0;
-	bool sentence_started = false;
+	Ubx_parser _parser;
 	bool new_data = false;
 
-	double minmea_tocoord_double(const struct minmea_float *f);
+	void build_config();
+	void add_message(uint8_t cls, uint8_t id, const uint8_t* data, uint16_t len);
+	void send_config();
 };
 
 #endif /* INC_GNSS_H_ */
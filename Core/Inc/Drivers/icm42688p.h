@@ -6,6 +6,7 @@
 #include <cmath>
 #include <cstdio>
 #include "stm32f4xx_hal.h"
+#include "Drivers/spi_bus.h"
 
 namespace ICM42688reg {
 
@@ -274,6 +275,14 @@ class ICM42688 {
      */
 	int disableDataReadyInterrupt();
 
+	/**
+     * @brief      Queues the data read on the SPI bus.
+     *             The next getAGT() waits for it instead of reading.
+     *
+     * @return     ret < 0 if error
+     */
+	int requestAGT();
+
 	/**
      * @brief      Transfers data from ICM 42688-p to mcu.
      *             Must be called to access new measurements.
@@ -397,13 +406,17 @@ class ICM42688 {
 	size_t                    _numBytes = 0;        // number of bytes received from I2C
 
 	///\brief SPI Communication
-	SPI_HandleTypeDef*        _spi;
 	GPIO_TypeDef*             _csPinBank;
 	uint16_t                  _csPin;
-	uint32_t _spiLSPrescaler;
-	uint32_t _spiHSPrescaler;
+	spi_device_t              _spiLS;  // register access
+	spi_device_t              _spiHS;  // data readout
 	bool                      _useSPIHS     = false;
 
+	///\brief Queued data readout
+	spi_transaction_t _agtTransaction = {};
+	uint8_t           _agtTx[15]      = {};
+	uint8_t           _agtRx[15]      = {};
+
 	// buffer for reading from sensor
 	uint8_t _buffer[15] = {};
 
@@ -474,8 +487,6 @@ class ICM42688 {
 
 	// private functions
 	void setCSHigh();
-	void setCSLow();
-	void changeSPISpeed();
 	int writeRegister(uint8_t subAddress, uint8_t data);
 	int readRegisters(uint8_t subAddress, uint8_t count, uint8_t* dest);
 	int setBank(uint8_t bank);
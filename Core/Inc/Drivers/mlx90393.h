@@ -19,6 +19,7 @@
 #define ADAFRUIT_MLX90393_H
 
 #include "stm32f4xx_hal.h"
+#include "Drivers/spi_bus.h"
 #include <cstdio>
 
 #define MLX90393_DEFAULT_ADDR (0x0C) /* Can also be 0x18, depending on IC */
@@ -191,19 +192,24 @@ public:
 
   bool setTrigInt(bool state);
 //  bool readData(float *x, float *y, float *z);
-  bool readDataNonBlocking();
+  bool readDataNonBlocking(uint64_t time_us);
 
   float x, y, z;
+  uint64_t timestamp = 0; // Middle of the conversion (us)
 
 private:
-  SPI_HandleTypeDef* _spi;
-  uint32_t _spiPrescaler;
-  GPIO_TypeDef* _csPinBank;
-  uint16_t _csPin;
+  spi_device_t _device;
+
+  /* Queued measurement commands, status byte follows the command byte. */
+  spi_transaction_t _transaction = {};
+  uint8_t _tx[8] = {};
+  uint8_t _rx[8] = {};
 
   bool readRegister(uint8_t reg, uint16_t *data);
   bool writeRegister(uint8_t reg, uint16_t data);
   bool _init(void);
+  bool queueCommand(uint8_t cmd, uint8_t rxlen);
+  void convertMeasurement(const uint8_t *rx, float *x, float *y, float *z);
   uint8_t transceive(uint8_t *txbuf, uint8_t txlen, uint8_t *rxbuf = NULL,
                      uint8_t rxlen = 0, uint8_t interdelay = 10);
 
@@ -215,7 +221,7 @@ private:
   int32_t _sensorID = 90393;
 
   int _state = 0;
-  int _start_time;
+  uint64_t _start_time = 0;
 };
 
 #endif /* ADAFRUIT_MLX90393_H */
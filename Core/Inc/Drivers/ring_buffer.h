@@ -16,4 +16,12 @@ bool ring_buffer_empty(ring_buffer_t* rb);
 bool ring_buffer_write(ring_buffer_t* rb, uint8_t byte);
 bool ring_buffer_read(ring_buffer_t* rb, uint8_t* byte);
 
+// Bulk access, one producer and one consumer
+uint32_t ring_buffer_count(ring_buffer_t* rb);
+uint32_t ring_buffer_space(ring_buffer_t* rb);
+uint32_t ring_buffer_write_bytes(ring_buffer_t* rb, const uint8_t* data, uint32_t len);
+uint32_t ring_buffer_read_bytes(ring_buffer_t* rb, uint8_t* data, uint32_t len);
+uint32_t ring_buffer_peek(ring_buffer_t* rb, uint8_t** data);
+void ring_buffer_consume(ring_buffer_t* rb, uint32_t len);
+
 #endif // INC_RING_BUFFER_H
@@ -45,6 +45,9 @@
 
 #define SBUS_CHANNEL_COUNT 16U  //!< Number of analog channels in SBus frame
 
+#define SBUS_FLAG_FRAME_LOST 0x04U  //!< Receiver missed a frame from the transmitter
+#define SBUS_FLAG_FAILSAFE 0x08U  //!< Receiver is outputting its failsafe values
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -68,28 +71,45 @@ typedef struct {
     uint16_t channel15;  //!< Analog channel 15
 } SBusPacketTypeDef;  //!< Structure containing all analog channel values
 
+typedef struct {
+    uint8_t inFrame;  //!< Start byte seen, frame being built
+    uint8_t frame[SBUS_FRAME_SIZE];  //!< Frame being built or the last one
+    uint8_t frameIndex;  //!< Next byte position in frame
+    SBusPacketTypeDef packet;  //!< Channels of the last decoded frame
+} SBusParserTypeDef;  //!< Parser state, one per receiver, zero initialized
+
 /** Parses currently read byte into frame.
  *
  * Adds the passed byte into the SBus frame. If after the byte the frame is
  * built, function returns SBUS_FRAME_READY. Otherwise, function returns
  * SBUS_FRAME_NOT_READY.
  *
+ * @param parser parser state of the receiver
  * @param byte currently byte in the read sequence
  * @return if the SBus frame is ready to be decoded
  */
-uint8_t SBus_ParseByte(uint8_t byte);
+uint8_t SBus_ParseByte(SBusParserTypeDef* parser, uint8_t byte);
 
 /** Decodes the SBus frame into an SBus packet.
  *
+ * @param parser parser state of the receiver
+ */
+void SBus_DecodeFrame(SBusParserTypeDef* parser);
+
+/** Returns the flags byte of the last frame, valid until the next frame starts.
+ *
+ * @param parser parser state of the receiver
+ * @return SBUS_FLAG_x bits
  */
-void SBus_DecodeFrame(void);
+uint8_t SBus_GetFlags(const SBusParserTypeDef* parser);
 
 /** Returns the current value of the specified analog SBus channel.
  *
+ * @param parser parser state of the receiver
  * @param channel channel number
  * @return value of channel
  */
-uint16_t SBus_GetChannel(uint8_t channel);
+uint16_t SBus_GetChannel(const SBusParserTypeDef* parser, uint8_t channel);
 
 #ifdef __cplusplus
 };
@@ -10,19 +10,32 @@
 
 #include <Drivers/sbus.h>
 #include "stm32f4xx_hal.h"
+#include "Drivers/uart_rx.h"
 #include <cstdio>
 
+// Frames are decoded in the UART interrupt as soon as the line goes idle,
+// so a frame callback sees the sticks one frame gap after they arrive
 class SBUS_input
 {
 public:
 	SBUS_input(UART_HandleTypeDef* uart);
 	void setup();
-	void dma_complete();
 	void get_rc_data(uint16_t out[], int size);
+
+	// Runs in the UART interrupt for every good frame, time is its arrival (us)
+	void set_frame_callback(void (*callback)(void* context, const uint16_t channels[], uint64_t time), void* context);
+
 private:
-	UART_HandleTypeDef* _uart;
-	uint8_t _rx_buffer[1];
-	uint16_t _rc_data[16];
+	uint8_t _rx_buffer[128];
+	Uart_rx _rx;
+	SBusParserTypeDef _parser = {};
+	uint16_t _rc_data[SBUS_CHANNEL_COUNT] = {};
+
+	void (*_frame_callback)(void* context, const uint16_t channels[], uint64_t time) = nullptr;
+	void* _frame_context = nullptr;
+
+	void parse();
+	static void rx_callback(void* context) { static_cast<SBUS_input*>(context)->parse(); }
 };
 
 #endif /* INC_DRIVERS_SBUS_INPUT_H_ */
@@ -18,22 +18,47 @@ enum class SDMode
 	READ
 };
 
+enum class MissionRequest
+{
+	NONE,
+	READ,
+	WRITE
+};
+
 class Sd
 {
 public:
 	Sd();
 
 	void create_file(char name[], uint8_t len);
-	bool write_byte(uint8_t byte);
+	uint16_t write(const uint8_t* data, uint16_t len);
 	bool read(uint8_t* rx_buff, uint16_t size);
 	void interrupt_callback();
 
+	// Mission files, serviced one request at a time from interrupt_callback
+	bool read_mission(uint8_t file, uint32_t offset, void* data, uint32_t len);
+	bool write_mission(uint8_t file, uint32_t offset, const void* data, uint32_t len);
+	bool mission_ready(bool* success);
+
 private:
 	FATFS fatfs;
 	FIL fil;
 	SDMode sd_mode = SDMode::IDLE;
 	ring_buffer_t ring_buffer;
+	uint8_t data_buffer[4096] = {}; // Must be a power of 2
 	char file_name[32];
+
+	// Written by the main task while mission_request is NONE and by the SD
+	// task while it is not, signal fences order them around the handoff
+	FIL mission_fil;
+	volatile MissionRequest mission_request = MissionRequest::NONE;
+	uint8_t mission_file;
+	uint32_t mission_offset;
+	uint8_t* mission_data;
+	uint32_t mission_len;
+	bool mission_success = false;
+
+	void process_mission_request();
 };
 
 #endif /* INC_SD_H_ */
@@ -10,16 +10,46 @@
 
 #include "stm32f4xx_hal.h"
 
-class Servo
+/**
+ * PWM outputs sharing one timer
+ *
+ * The timer counts at a fixed number of ticks per microsecond, so pulse
+ * widths are exact instead of a fraction of a 50 Hz frame, and the frame
+ * rate only sets the reload value. Compare and reload registers are
+ * preloaded. write() updates every channel with the update event held off,
+ * so all channels latch together on the next period boundary.
+ *
+ * Only timers on APB1 are supported.
+ */
+class Servo_group
 {
 public:
-	Servo(TIM_HandleTypeDef* tim, uint32_t channel);
-	void init();
-	void set_angle(uint8_t deg);
-	void set_duty(uint16_t us);
+	static constexpr uint8_t max_channels = 4;
+	static constexpr uint16_t min_rate_hz = 50;
+	static constexpr uint16_t max_rate_hz = 490; // Leaves room for a 2000us pulse
+
+	Servo_group(TIM_HandleTypeDef* tim, const uint32_t channels[], uint8_t num_channels, uint8_t ticks_per_us = 1);
+
+	void init(uint16_t rate_hz);
+	void set_rate(uint16_t rate_hz);
+	void write(const uint16_t pulse_us[]);
+
+	uint16_t get_rate() const { return _rate_hz; }
+	uint8_t get_num_channels() const { return _num_channels; }
+
+	// Until values written now reach the pins, at the start of the next frame
+	uint32_t get_latch_delay_us() const
+	{
+		return (__HAL_TIM_GET_AUTORELOAD(_tim) + 1 - __HAL_TIM_GET_COUNTER(_tim)) / _ticks_per_us;
+	}
+
 private:
 	TIM_HandleTypeDef* _tim;
-	uint32_t _channel;
+	uint32_t _channels[max_channels];
+	uint8_t _num_channels;
+	uint8_t _ticks_per_us;
+	uint16_t _rate_hz = 0;
+	uint32_t _period = 0; // Ticks
 };
 
 #endif /* INC_DRIVERS_SERVO_H_ */
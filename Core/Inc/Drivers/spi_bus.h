@@ -0,0 +1,100 @@
+#ifndef INC_DRIVERS_SPI_BUS_H_
+#define INC_DRIVERS_SPI_BUS_H_
+
+#include "stm32f4xx_hal.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+	SPI_TRANSACTION_IDLE,
+	SPI_TRANSACTION_QUEUED,
+	SPI_TRANSACTION_DONE,
+	SPI_TRANSACTION_FAILED
+} spi_transaction_status_t;
+
+// Chip select and clock settings of one device on a bus
+typedef struct
+{
+	SPI_HandleTypeDef* spi;
+	GPIO_TypeDef* cs_port;
+	uint16_t cs_pin;
+	uint32_t prescaler; // SPI_BAUDRATEPRESCALER_x
+	uint32_t polarity; // SPI_POLARITY_x
+	uint32_t phase; // SPI_PHASE_x
+} spi_device_t;
+
+// Full duplex transfer of len bytes. The buffers belong to the caller and
+// must stay valid until the status leaves SPI_TRANSACTION_QUEUED.
+typedef struct spi_transaction
+{
+	const spi_device_t* device;
+	const uint8_t* tx;
+	uint8_t* rx; // NULL to ignore received bytes
+	uint16_t len;
+	void (*callback)(struct spi_transaction* transaction); // Optional, runs in the DMA interrupt
+	void* context;
+	volatile spi_transaction_status_t status;
+} spi_transaction_t;
+
+// For drivers written in C, the bus is found from the device
+bool spi_queue(spi_transaction_t* transaction);
+bool spi_wait(spi_transaction_t* transaction);
+bool spi_transfer(spi_transaction_t* transaction);
+
+#ifdef __cplusplus
+}
+
+/**
+ * Owns an SPI peripheral shared by several devices
+ *
+ * Transactions are queued and run back to back with DMA, so a driver can
+ * start its reads and carry on while they complete. The bus applies each
+ * device's prescaler and clock mode by writing CR1 between transactions
+ * and drives its chip select around the transfer.
+ *
+ * queue() may be called from any priority up to the SPI DMA interrupt.
+ * wait() and transfer() spin until the transaction is done, so they must
+ * only be used from contexts the DMA interrupt can preempt.
+ */
+class Spi_bus
+{
+public:
+	Spi_bus(SPI_HandleTypeDef* spi);
+
+	bool queue(spi_transaction_t* transaction);
+	bool wait(spi_transaction_t* transaction);
+	bool transfer(spi_transaction_t* transaction);
+
+	static Spi_bus* find(SPI_HandleTypeDef* spi);
+
+	// From HAL_SPI_TxRxCpltCallback, HAL_SPI_TxCpltCallback and HAL_SPI_ErrorCallback
+	static void complete_callback(SPI_HandleTypeDef* spi);
+	static void error_callback(SPI_HandleTypeDef* spi);
+
+private:
+	static constexpr uint8_t queue_size = 8;
+	static constexpr uint32_t timeout_ms = 5;
+
+	SPI_HandleTypeDef* _spi;
+	spi_transaction_t* _queue[queue_size];
+	volatile uint8_t _head = 0;
+	volatile uint8_t _count = 0;
+	uint32_t _mode = 0; // CR1 clock bits currently applied
+
+	void start();
+	void finish(bool success);
+	void configure(const spi_device_t* device);
+	void abort();
+
+	static constexpr uint8_t max_instances = 3;
+	static Spi_bus* _instances[max_instances];
+	static uint8_t _num_instances;
+};
+
+#endif
+
+#endif /* INC_DRIVERS_SPI_BUS_H_ */
@@ -0,0 +1,31 @@
+#ifndef INC_DRIVERS_TIMEBASE_H_
+#define INC_DRIVERS_TIMEBASE_H_
+
+#include "stm32f4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Microseconds since boot
+ *
+ * TIM5 counts at 1 MHz and wraps every 71.6 minutes, the wraps are counted
+ * here to extend it to 64 bits. That only works if it is called at least
+ * once per wrap, which the 100 Hz main task does. Safe to call from any
+ * interrupt.
+ */
+uint64_t timebase_get_us(void);
+
+/**
+ * CPU cycles from the DWT cycle counter, for measuring short sections of
+ * code. Wraps every 25 seconds at 168 MHz, so only differences are useful.
+ */
+void timebase_init_cycles(void);
+uint32_t timebase_get_cycles(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DRIVERS_TIMEBASE_H_ */
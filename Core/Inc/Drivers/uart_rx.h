@@ -0,0 +1,62 @@
+#ifndef INC_DRIVERS_UART_RX_H_
+#define INC_DRIVERS_UART_RX_H_
+
+#include "stm32f4xx_hal.h"
+#include "Drivers/timebase.h"
+
+/**
+ * Circular DMA receiver shared by the UART drivers
+ *
+ * The DMA writes continuously into the buffer and the HAL reports the write
+ * position on idle line, half transfer and transfer complete. That is a few
+ * interrupts per burst instead of one per byte, and a burst is handed over
+ * whole once the line goes idle. Parsing happens in the caller's context
+ * through peek() and consume(), or in the interrupt from the event callback
+ * for short frames that need the lowest latency.
+ *
+ * The buffer must hold more than what arrives between two reads, otherwise
+ * the DMA laps the reader and data is lost.
+ */
+class Uart_rx
+{
+public:
+	Uart_rx(UART_HandleTypeDef* uart, uint8_t* buffer, uint16_t size);
+
+	void setup();
+
+	// Longest contiguous span of unread bytes, returns its length
+	uint16_t peek(const uint8_t** data);
+	void consume(uint16_t len);
+
+	// Runs in the UART interrupt after each event
+	void set_event_callback(void (*callback)(void* context), void* context);
+
+	uint32_t get_event_count() const { return _event_count; }
+	uint64_t get_event_time() const { return _event_time; } // Arrival of the latest data (us)
+
+	// From HAL_UARTEx_RxEventCallback and HAL_UART_ErrorCallback
+	static void rx_event_callback(UART_HandleTypeDef* uart, uint16_t pos);
+	static void error_callback(UART_HandleTypeDef* uart);
+
+private:
+	UART_HandleTypeDef* _uart;
+	uint8_t* _buffer;
+	uint16_t _size;
+	volatile uint16_t _head = 0;
+	uint16_t _tail = 0;
+	volatile bool _restarted = false;
+	volatile uint32_t _event_count = 0;
+	volatile uint64_t _event_time = 0;
+	void (*_event_callback)(void* context) = nullptr;
+	void* _event_context = nullptr;
+
+	void rx_event(uint16_t pos);
+	void error();
+
+	static constexpr uint8_t max_instances = 6;
+	static Uart_rx* _instances[max_instances];
+	static uint8_t _num_instances;
+	static Uart_rx* find(UART_HandleTypeDef* uart);
+};
+
+#endif /* INC_DRIVERS_UART_RX_H_ */
@@ -2,13 +2,9 @@
 #define INC_DRIVERS_UART_STREAM_H_
 
 #include "stm32f4xx_hal.h"
+#include "Drivers/uart_rx.h"
 #include <stdio.h>
 
-extern "C"
-{
-#include "ring_buffer.h"
-}
-
 class Uart_stream
 {
 public:
@@ -16,14 +12,14 @@ public:
 
 	void setup();
 	void transmit(uint8_t tx_buff[], int len);
-	bool read_byte(uint8_t* byte);
-	bool buffer_empty();
-	void dma_complete();
+	uint16_t read(uint8_t* data, uint16_t len);
+	uint16_t peek(const uint8_t** data);
+	void consume(uint16_t len);
 
 private:
 	UART_HandleTypeDef* _uart;
-	uint8_t rx_buffer[1];
-	ring_buffer_t ring_buffer;
+	uint8_t rx_buffer[1024];
+	Uart_rx _rx;
 };
 
 #endif /* INC_DRIVERS_UART_STREAM_H_ */
@@ -0,0 +1,92 @@
+#ifndef INC_DRIVERS_UBX_H_
+#define INC_DRIVERS_UBX_H_
+
+#include <stdint.h>
+
+#define UBX_SYNC1 0xB5
+#define UBX_SYNC2 0x62
+
+#define UBX_CLASS_NAV 0x01
+#define UBX_CLASS_CFG 0x06
+
+#define UBX_NAV_PVT 0x07
+#define UBX_NAV_PVT_LEN 92
+
+#define UBX_CFG_PRT 0x00
+#define UBX_CFG_MSG 0x01
+#define UBX_CFG_RATE 0x08
+#define UBX_CFG_VALSET 0x8A
+
+// Navigation solution from NAV-PVT
+struct Ubx_nav_pvt
+{
+	int32_t lat = 0; // deg * 1E7
+	int32_t lon = 0; // deg * 1E7
+	float alt = 0; // Above mean sea level (m)
+	float vel_n = 0; // m/s
+	float vel_e = 0; // m/s
+	float vel_d = 0; // m/s
+	float h_acc = 0; // Horizontal position accuracy (m)
+	float v_acc = 0; // Vertical position accuracy (m)
+	float s_acc = 0; // Speed accuracy (m/s)
+	uint8_t sats = 0;
+	bool fix = false;
+
+	// UTC, only updated once the receiver has resolved it
+	uint16_t year = 0;
+	uint8_t month = 0;
+	uint8_t day = 0;
+	uint8_t hours = 0;
+	uint8_t minutes = 0;
+	uint8_t seconds = 0;
+};
+
+/**
+ * UBX framing and decoding, independent of the UART so it also builds on the
+ * host
+ *
+ * Bytes are fed one at a time. After a bad checksum, or a length nothing
+ * needed has, the parser goes back to looking for the sync characters.
+ */
+class Ubx_parser
+{
+public:
+	static constexpr uint16_t max_payload_len = 100;
+
+	// Returns true when a message with a good checksum is complete, it stays
+	// available until the next byte
+	bool parse_byte(uint8_t c);
+
+	uint8_t get_class() const { return msg_class; }
+	uint8_t get_id() const { return msg_id; }
+	uint16_t get_len() const { return msg_len; }
+	const uint8_t* get_payload() const { return payload; }
+
+	// False if the last message is not a NAV-PVT
+	bool decode_nav_pvt(Ubx_nav_pvt* pvt) const;
+
+private:
+	enum class Parse_state
+	{
+		SYNC1,
+		SYNC2,
+		CLASS,
+		ID,
+		LEN1,
+		LEN2,
+		PAYLOAD,
+		CK_A,
+		CK_B
+	};
+
+	Parse_state parse_state = Parse_state::SYNC1;
+	uint8_t msg_class = 0;
+	uint8_t msg_id = 0;
+	uint16_t msg_len = 0;
+	uint16_t payload_index = 0;
+	uint8_t payload[max_payload_len];
+	uint8_t ck_a = 0;
+	uint8_t ck_b = 0;
+};
+
+#endif /* INC_DRIVERS_UBX_H_ */
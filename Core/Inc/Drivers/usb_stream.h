@@ -13,12 +13,14 @@ public:
 	USB_stream();
 
 	void transmit(uint8_t tx_buff[], int len);
-	bool read_byte(uint8_t* byte);
+	uint16_t read(uint8_t* data, uint16_t len);
+	uint16_t peek(const uint8_t** data);
+	void consume(uint16_t len);
 	void rx_callback(uint8_t* Buf, uint32_t Len);
-	bool buffer_empty();
 
 private:
 	ring_buffer_t ring_buffer;
+	uint8_t data_buffer[1024] = {}; // Must be a power of 2
 };
 
 #endif /* INC_DRIVERS_USB_STREAM_H_ */
@@ -67,10 +67,21 @@ void USB_CDC_RxHandler(uint8_t* Buf, uint32_t Len);
 #define IMU_CS_GPIO_Port GPIOC
 #define SERVO1_Pin GPIO_PIN_6
 #define SERVO1_GPIO_Port GPIOA
+#define AUX1_Pin GPIO_PIN_7
+#define AUX1_GPIO_Port GPIOA
+#define IMU_INT_Pin GPIO_PIN_4
+#define IMU_INT_GPIO_Port GPIOC
+#define IMU_INT_EXTI_IRQn EXTI4_IRQn
 #define MAIN_LED_Pin GPIO_PIN_5
 #define MAIN_LED_GPIO_Port GPIOC
+#define AUX2_Pin GPIO_PIN_0
+#define AUX2_GPIO_Port GPIOB
+#define AUX3_Pin GPIO_PIN_1
+#define AUX3_GPIO_Port GPIOB
 #define SERVO2_Pin GPIO_PIN_15
 #define SERVO2_GPIO_Port GPIOA
+#define THROTTLE_Pin GPIO_PIN_6
+#define THROTTLE_GPIO_Port GPIOB
 
 /* USER CODE BEGIN Private defines */
 
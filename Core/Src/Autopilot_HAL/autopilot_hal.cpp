@@ -2,14 +2,18 @@
 
 AutopilotHAL* AutopilotHAL::_instance = nullptr;
 
+static const uint32_t servo_channels[] = { TIM_CHANNEL_1, TIM_CHANNEL_2, TIM_CHANNEL_3, TIM_CHANNEL_4 };
+
 AutopilotHAL::AutopilotHAL() :
+	_spi1(&hspi1),
 	_imu(&hspi1, GPIOC, GPIO_PIN_15, SPI_BAUDRATEPRESCALER_128, SPI_BAUDRATEPRESCALER_4),
 	_ina219(&hi2c1, 0.01),
 	_gnss(&huart3),
 	sbus_input(&huart4),
 	telem(&huart6),
-	servo1(&htim3, TIM_CHANNEL_1),
-	servo2(&htim2, TIM_CHANNEL_1),
+	_servos(&htim3, servo_channels, 4),
+	_rudder_servo(&htim2, servo_channels, 1),
+	_throttle_servo(&htim4, servo_channels, 1),
 	cxof(&huart2)
 {
 	_instance = this;
@@ -19,6 +23,7 @@ void AutopilotHAL::init()
 {
 	printf("HAL init\n");
 
+	timebase_init_cycles();
 	init_imu();
 	init_baro();
 	init_compass();
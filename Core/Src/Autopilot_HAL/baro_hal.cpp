@@ -6,7 +6,18 @@ void AutopilotHAL::init_baro()
 	Barometer_setOSR(OSR_4096);
 }
 
-bool AutopilotHAL::read_baro(float *alt)
+bool AutopilotHAL::read_baro(float *alt, float *pressure, float *temperature, uint64_t *timestamp)
 {
-	return Barometer_getAltitude(alt);
+	if (_baro_ready)
+	{
+		_baro_ready = false;
+		*alt = Barometer_getAltitude();
+		*pressure = Barometer_getPressure();
+		*temperature = Barometer_getTemp();
+		*timestamp = Barometer_getTimestamp();
+
+		return true;
+	}
+
+	return false;
 }
@@ -1,14 +1,82 @@
 #include "Autopilot_HAL/Autopilot_HAL.h"
 
+// Analog servo rate until the mixer applies the parameters
 void AutopilotHAL::init_servos()
 {
-	servo1.init();
-	servo2.init();
+	_servos.init(Servo_group::min_rate_hz);
+	_rudder_servo.init(Servo_group::min_rate_hz);
+	_throttle_servo.init(Servo_group::min_rate_hz);
 }
 
 void AutopilotHAL::set_pwm(uint16_t ele_duty, uint16_t rud_duty, uint16_t thr_duty,
 		  	  	  	  	 uint16_t aux1_duty, uint16_t aux2_duty, uint16_t aux3_duty)
 {
-	servo1.set_duty(ele_duty);
-	servo2.set_duty(rud_duty);
+	const uint16_t servo_duty[] = { ele_duty, aux1_duty, aux2_duty, aux3_duty };
+
+	_servos.write(servo_duty);
+	_rudder_servo.write(&rud_duty);
+	_throttle_servo.write(&thr_duty);
+
+	record_actuator_latency();
+}
+
+void AutopilotHAL::set_pwm_rate(Pwm_group group, uint16_t rate_hz)
+{
+	switch (group)
+	{
+	case PWM_GROUP_SERVOS:
+		_servos.set_rate(rate_hz);
+		break;
+	case PWM_GROUP_RUDDER:
+		_rudder_servo.set_rate(rate_hz);
+		break;
+	case PWM_GROUP_THROTTLE:
+		_throttle_servo.set_rate(rate_hz);
+		break;
+	default:
+		break;
+	}
+}
+
+void AutopilotHAL::set_rc_passthrough(const Rc_passthrough* passthrough)
+{
+	const uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (passthrough)
+	{
+		_passthrough = *passthrough;
+	}
+
+	_passthrough_enabled = passthrough != nullptr;
+
+	__set_PRIMASK(primask);
+}
+
+// SBUS interrupt. Elevator and aux share a timer, the aux outputs are idle
+// in direct mode.
+void AutopilotHAL::rc_passthrough(const uint16_t channels[], uint64_t frame_time)
+{
+	if (!_passthrough_enabled || channels[_passthrough.thr_ch] <= _passthrough.conn_threshold)
+	{
+		return;
+	}
+
+	const uint16_t servo_duty[] = { _passthrough.ele.apply(channels[_passthrough.ele_ch]), 0, 0, 0 };
+	const uint16_t rud_duty = _passthrough.rud.apply(channels[_passthrough.rud_ch]);
+	const uint16_t thr_duty = _passthrough.thr.apply(channels[_passthrough.thr_ch]);
+
+	_servos.write(servo_duty);
+	_rudder_servo.write(&rud_duty);
+	_throttle_servo.write(&thr_duty);
+
+	uint32_t latch_delay = _servos.get_latch_delay_us();
+	if (_rudder_servo.get_latch_delay_us() > latch_delay) latch_delay = _rudder_servo.get_latch_delay_us();
+	if (_throttle_servo.get_latch_delay_us() > latch_delay) latch_delay = _throttle_servo.get_latch_delay_us();
+
+	const uint32_t latency = get_time_us() - frame_time + latch_delay;
+	if (latency < _rc_latency.min) _rc_latency.min = latency;
+	if (latency > _rc_latency.max) _rc_latency.max = latency;
+	_rc_latency.sum += latency;
+	_rc_latency.count++;
 }
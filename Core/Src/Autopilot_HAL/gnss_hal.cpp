@@ -5,15 +5,30 @@ void AutopilotHAL::init_gnss()
 	_gnss.setup();
 }
 
-bool AutopilotHAL::read_gnss(double *lat, double *lon, float* alt, uint8_t* sats, bool* fix)
+bool AutopilotHAL::read_gnss(GNSS_data* gnss)
 {
 	if (_gnss.read())
 	{
-		*lat = _gnss.lat;
-		*lon = _gnss.lon;
-		*alt = _gnss.alt;
-		*sats = _gnss.sats;
-		*fix = _gnss.fix;
+		const Ubx_nav_pvt& pvt = _gnss.pvt;
+
+		gnss->lat = pvt.lat;
+		gnss->lon = pvt.lon;
+		gnss->asl = pvt.alt;
+		gnss->vel_n = pvt.vel_n;
+		gnss->vel_e = pvt.vel_e;
+		gnss->vel_d = pvt.vel_d;
+		gnss->h_acc = pvt.h_acc;
+		gnss->v_acc = pvt.v_acc;
+		gnss->s_acc = pvt.s_acc;
+		gnss->sats = pvt.sats;
+		gnss->fix = pvt.fix;
+		gnss->year = pvt.year;
+		gnss->month = pvt.month;
+		gnss->day = pvt.day;
+		gnss->hours = pvt.hours;
+		gnss->minutes = pvt.minutes;
+		gnss->seconds = pvt.seconds;
+		gnss->timestamp = _gnss.timestamp;
 
 		return true;
 	}
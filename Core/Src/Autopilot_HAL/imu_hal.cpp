@@ -4,17 +4,26 @@ void AutopilotHAL::init_imu()
 {
 	_imu.begin();
 
-	_imu.setAccelODR(ICM42688::odr100);
+	// Sets the fast task rate when it runs on the data ready interrupt
+	_imu.setAccelODR(ICM42688::odr500);
 	_imu.setAccelFS(ICM42688::gpm4);
 
-	_imu.setGyroODR(ICM42688::odr100);
+	_imu.setGyroODR(ICM42688::odr500);
 	_imu.setGyroFS(ICM42688::dps500);
+
+	_imu.enableDataReadyInterrupt();
 }
 
-bool AutopilotHAL::read_imu(float *ax, float *ay, float *az, float *gx, float *gy, float *gz)
+// The data ready edge marks when the sample was taken. Without the interrupt
+// the read time is the best estimate left.
+bool AutopilotHAL::read_imu(float *ax, float *ay, float *az, float *gx, float *gy, float *gz, uint64_t *timestamp)
 {
 	if (_imu.getAGT() == 1)
 	{
+		const uint64_t time = get_time_us();
+		_imu_sample_time = time - _imu_interrupt_time < IMU_SYNC_TIMEOUT_US ? _imu_interrupt_time : time;
+		*timestamp = _imu_sample_time;
+
 		*ax = -_imu.accX();
 		*ay = -_imu.accY();
 		*az = _imu.accZ();
@@ -27,3 +36,13 @@ bool AutopilotHAL::read_imu(float *ax, float *ay, float *az, float *gx, float *g
 
 	return false;
 }
+
+// Queues every SPI sensor access for this cycle in one go. The IMU read goes
+// first so read_imu() only waits for it, the magnetometer and barometer
+// transfers finish while the fast task runs.
+void AutopilotHAL::start_sensor_reads()
+{
+	_imu.requestAGT();
+	_mag_ready |= _mag.readDataNonBlocking(get_time_us());
+	_baro_ready |= Barometer_calculate(get_time_us());
+}
@@ -7,13 +7,15 @@ void AutopilotHAL::init_compass()
 	_mag.setOversampling(MLX90393_OSR_2);
 }
 
-bool AutopilotHAL::read_mag(float *mx, float *my, float *mz)
+bool AutopilotHAL::read_mag(float *mx, float *my, float *mz, uint64_t *timestamp)
 {
-	if (_mag.readDataNonBlocking())
+	if (_mag_ready)
 	{
+		_mag_ready = false;
 		*mx = -_mag.x;
 		*my = _mag.y;
 		*mz = -_mag.z;
+		*timestamp = _mag.timestamp;
 
 		return true;
 	}
@@ -1,7 +1,8 @@
 #include "Autopilot_HAL/Autopilot_HAL.h"
 
-void AutopilotHAL::set_main_task(void (*task)())
+void AutopilotHAL::set_main_task(void (*task)(void* context), void* context)
 {
+	main_task_context = context;
 	main_task = task;
 
 	if (HAL_TIM_Base_Start_IT(&htim7) != HAL_OK)
@@ -15,44 +16,219 @@ void AutopilotHAL::set_main_task(void (*task)())
 	}
 }
 
+void AutopilotHAL::set_fast_task(void (*task)(void* context), void* context, bool imu_sync)
+{
+	fast_task_context = context;
+	fast_task = task;
+	_imu_sync = imu_sync;
+}
+
+// The timer and IMU interrupts share a priority so the tasks never preempt
+// each other
 void AutopilotHAL::execute_main_task()
 {
 	if (main_task)
 	{
-		main_task();
+		main_task(main_task_context);
+	}
+
+	// The autopilot runs the fast task for each simulator step
+	if (_lockstep)
+	{
+		return;
+	}
+
+	if (_imu_sync && get_time_us() - _imu_interrupt_time < IMU_SYNC_TIMEOUT_US)
+	{
+		return;
+	}
+
+	if (_imu_sync_active)
+	{
+		_imu_sync_active = false;
+		_imu_sync_changed = true;
 	}
+
+	execute_fast_task();
 }
 
-void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+void AutopilotHAL::execute_imu_interrupt()
 {
-	if (htim == &htim7) // 100hz high priority interrupt
+	_imu_interrupt_time = get_time_us();
+
+	if (!_imu_sync || !fast_task || _lockstep)
 	{
-		AutopilotHAL::main_task_callback();
+		return;
 	}
-	else if (htim == &htim6) // 1hz low priority interrupt
+
+	if (!_imu_sync_active)
 	{
-		AutopilotHAL::sd_interrupt_callback();
+		_imu_sync_active = true;
+		_imu_sync_changed = true;
 	}
+
+	execute_fast_task();
 }
 
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart)
+void AutopilotHAL::execute_fast_task()
 {
-	if (huart == &huart2)
+	if (!fast_task)
 	{
-		AutopilotHAL::of_dma_complete();
+		return;
 	}
-	else if (huart == &huart3)
+
+	const uint64_t time = get_time_us();
+
+	if (_loop_stats.last_start != 0)
 	{
-		AutopilotHAL::gnss_dma_complete();
+		const uint32_t period = time - _loop_stats.last_start;
+		if (period < _loop_stats.period_min) _loop_stats.period_min = period;
+		if (period > _loop_stats.period_max) _loop_stats.period_max = period;
 	}
-	else if (huart == &huart4)
+
+	_loop_stats.last_start = time;
+
+	start_sensor_reads();
+	fast_task(fast_task_context);
+
+	const uint32_t run_time = get_time_us() - time;
+	if (run_time > _loop_stats.run_max) _loop_stats.run_max = run_time;
+	_loop_stats.run_sum += run_time;
+
+	if (++_loop_stats.cycles < LOOP_STATS_CYCLES)
+	{
+		return;
+	}
+
+	// The SBUS interrupt preempts this one and updates the RC stats, take
+	// them in one piece
+	const uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	const RcLatencyStats rc_latency = _rc_latency;
+	_rc_latency = RcLatencyStats{};
+	__set_PRIMASK(primask);
+
+	// Formatting is left to the SD task, which is the lowest priority and
+	// already owns stdout. A report it has not printed yet is kept.
+	if (!_loop_report_ready)
+	{
+		_loop_report = LoopReport{_loop_stats, rc_latency, _imu_sync_active};
+		__sync_synchronize();
+		_loop_report_ready = true;
+	}
+
+	_loop_stats = LoopStats{.last_start = time};
+}
+
+// SD task
+void AutopilotHAL::print_loop_stats()
+{
+	// Switches since the last call collapse into the current mode
+	if (_imu_sync_changed)
+	{
+		_imu_sync_changed = false;
+		printf(_imu_sync_active ? "Fast task on IMU interrupt\n" : "IMU interrupt lost, fast task on timer\n");
+	}
+
+	if (!_loop_report_ready)
+	{
+		return;
+	}
+
+	const LoopStats& loop = _loop_report.loop;
+	const RcLatencyStats& rc = _loop_report.rc;
+
+	printf("Fast task on %s: period %lu to %lu us, run time mean %lu max %lu us",
+		   _loop_report.imu_sync ? "IMU" : "timer",
+		   (unsigned long)loop.period_min, (unsigned long)loop.period_max,
+		   (unsigned long)(loop.run_sum / loop.cycles), (unsigned long)loop.run_max);
+
+	if (loop.latency_count > 0)
 	{
-		AutopilotHAL::rc_dma_complete();
+		printf(", latency %lu to %lu us, mean %lu us",
+			   (unsigned long)loop.latency_min, (unsigned long)loop.latency_max,
+			   (unsigned long)(loop.latency_sum / loop.latency_count));
 	}
-	else if (huart == &huart6)
+	else
 	{
-		AutopilotHAL::telemetry_dma_complete();
+		printf(", no IMU interrupt");
 	}
+
+	if (rc.count > 0)
+	{
+		printf(", RC to PWM %lu to %lu us, mean %lu us",
+			   (unsigned long)rc.min, (unsigned long)rc.max, (unsigned long)(rc.sum / rc.count));
+	}
+
+	printf("\n");
+
+	__sync_synchronize();
+	_loop_report_ready = false;
+}
+
+// Called on every PWM update. Only valid while the IMU interrupt is firing,
+// in either mode, since it timestamps the sample.
+void AutopilotHAL::record_actuator_latency()
+{
+	const uint64_t time = get_time_us();
+
+	if (time - _imu_interrupt_time >= IMU_SYNC_TIMEOUT_US)
+	{
+		return;
+	}
+
+	const uint32_t latency = time - _imu_sample_time;
+	if (latency < _loop_stats.latency_min) _loop_stats.latency_min = latency;
+	if (latency > _loop_stats.latency_max) _loop_stats.latency_max = latency;
+	_loop_stats.latency_sum += latency;
+	_loop_stats.latency_count++;
+}
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+	if (GPIO_Pin == IMU_INT_Pin) // IMU data ready, same priority as the main task
+	{
+		AutopilotHAL::imu_interrupt_callback();
+	}
+}
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+	if (htim == &htim7) // 100hz high priority interrupt
+	{
+		AutopilotHAL::main_task_callback();
+	}
+	else if (htim == &htim6) // 1hz low priority interrupt
+	{
+		AutopilotHAL::sd_interrupt_callback();
+	}
+}
+
+// Idle line, half transfer and transfer complete on the circular UART DMA
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef* huart, uint16_t Size)
+{
+	Uart_rx::rx_event_callback(huart, Size);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart)
+{
+	Uart_rx::error_callback(huart);
+}
+
+// SPI DMA transfers
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+	Spi_bus::complete_callback(hspi);
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+	Spi_bus::complete_callback(hspi);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* hspi)
+{
+	Spi_bus::error_callback(hspi);
 }
 
 void USB_CDC_RxHandler(uint8_t* Buf, uint32_t Len)
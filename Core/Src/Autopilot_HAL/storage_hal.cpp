@@ -5,7 +5,22 @@ void AutopilotHAL::create_file(char name[], uint8_t len)
 	_sd.create_file(name, len);
 }
 
-bool AutopilotHAL::write_storage(uint8_t byte)
+uint16_t AutopilotHAL::write_storage(const uint8_t* data, uint16_t len)
 {
-	return _sd.write_byte(byte);
+	return _sd.write(data, len);
+}
+
+bool AutopilotHAL::read_mission_file(uint8_t file, uint32_t offset, void* data, uint32_t len)
+{
+	return _sd.read_mission(file, offset, data, len);
+}
+
+bool AutopilotHAL::write_mission_file(uint8_t file, uint32_t offset, const void* data, uint32_t len)
+{
+	return _sd.write_mission(file, offset, data, len);
+}
+
+bool AutopilotHAL::mission_file_ready(bool* success)
+{
+	return _sd.mission_ready(success);
 }
@@ -2,6 +2,7 @@
 
 void AutopilotHAL::init_telem()
 {
+	sbus_input.set_frame_callback(&AutopilotHAL::rc_frame_callback, this);
 	sbus_input.setup();
 	telem.setup();
 }
@@ -11,12 +12,17 @@ void AutopilotHAL::transmit_telem(uint8_t tx_buff[], int len)
 	telem.transmit(tx_buff, len);
 }
 
-bool AutopilotHAL::read_telem(uint8_t* byte)
+uint16_t AutopilotHAL::read_telem(uint8_t* data, uint16_t len)
 {
-	return telem.read_byte(byte);
+	return telem.read(data, len);
 }
 
-bool AutopilotHAL::telem_buffer_empty()
+uint16_t AutopilotHAL::peek_telem(const uint8_t** data)
 {
-	return telem.buffer_empty();
+	return telem.peek(data);
+}
+
+void AutopilotHAL::consume_telem(uint16_t len)
+{
+	telem.consume(len);
 }
@@ -1,16 +1,40 @@
 #include "Autopilot_HAL/Autopilot_HAL.h"
 
-// Counter increments every 10 us
-// Resolution is 10 us
-// Maximum allowed time is 42949672950 us or 12 hours
-// SysTick has maximum time of 4.7 hours
+// Resolution is 1 us, 64 bits never wrap
 uint64_t AutopilotHAL::get_time_us() const
 {
-    return __HAL_TIM_GET_COUNTER(&htim5) * 10;
+	if (!_lockstep)
+	{
+		return timebase_get_us();
+	}
+
+	// Set by the main task, lower priority tasks could see half an update
+	const uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	const uint64_t time = _sim_time_us;
+	__set_PRIMASK(primask);
+
+	return time;
+}
+
+uint32_t AutopilotHAL::get_cycle_count() const
+{
+	return timebase_get_cycles();
 }
 
+// Always on the hardware clock, simulated time would never get there
 void AutopilotHAL::delay_us(uint64_t us)
 {
-	uint64_t start = get_time_us();
-	while (get_time_us() - start < us);
+	uint64_t start = timebase_get_us();
+	while (timebase_get_us() - start < us);
+}
+
+void AutopilotHAL::set_sim_time(uint64_t time_us)
+{
+	const uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	_sim_time_us = time_us;
+	__set_PRIMASK(primask);
+
+	_lockstep = true;
 }
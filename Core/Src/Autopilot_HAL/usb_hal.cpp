@@ -5,12 +5,29 @@ void AutopilotHAL::usb_transmit(uint8_t buf[], int len)
 	usb_stream.transmit(buf, len);
 }
 
-bool AutopilotHAL::usb_read(uint8_t *byte)
+uint16_t AutopilotHAL::usb_read(uint8_t* data, uint16_t len)
 {
-	return usb_stream.read_byte(byte);
+	return usb_stream.read(data, len);
 }
 
-bool AutopilotHAL::usb_buffer_empty()
+uint16_t AutopilotHAL::usb_peek(const uint8_t** data)
 {
-	return usb_stream.buffer_empty();
+	return usb_stream.peek(data);
+}
+
+void AutopilotHAL::usb_consume(uint16_t len)
+{
+	usb_stream.consume(len);
+}
+
+// In lockstep the simulator waits for every step, an update event on the
+// main task timer runs it now instead of on the next tick
+void AutopilotHAL::usb_rx(uint8_t* Buf, uint32_t Len)
+{
+	usb_stream.rx_callback(Buf, Len);
+
+	if (_lockstep)
+	{
+		htim7.Instance->EGR = TIM_EGR_UG;
+	}
 }
@@ -6,17 +6,16 @@
  */
 
 #include "Drivers/barometer.h"
+#include "Drivers/spi_bus.h"
 #include "stm32f4xx_hal.h"
-#include <math.h>
+#include "lib/fastmath/fastmath.h"
 
-#define SPI_TIMEOUT 50 //in ms
-
-#define MS5611_EN HAL_GPIO_WritePin(GPIOC, GPIO_PIN_14, GPIO_PIN_RESET);
 #define MS5611_DIS HAL_GPIO_WritePin(GPIOC, GPIO_PIN_14, GPIO_PIN_SET);
 
 #define MS5611_SPI_PRESCALER SPI_BAUDRATEPRESCALER_4
 
 #define CMD_RESET 0x1E
+#define CMD_ADC_READ 0x00
 #define CMD_PROM_C1 0xA2
 #define CMD_PROM_C2 0xA4
 #define CMD_PROM_C3 0xA6
@@ -36,122 +35,282 @@
 #define TEMP_OSR_2048     0x56
 #define TEMP_OSR_4096     0x58
 
-#define CONVERSION_OSR_256  1
-#define CONVERSION_OSR_512  2
-#define CONVERSION_OSR_1024 3
-#define CONVERSION_OSR_2048 5
-#define CONVERSION_OSR_4096 10
+// Maximum conversion times in microseconds
+#define CONVERSION_OSR_256  600
+#define CONVERSION_OSR_512  1170
+#define CONVERSION_OSR_1024 2280
+#define CONVERSION_OSR_2048 4540
+#define CONVERSION_OSR_4096 9040
+
+#define RESET_TIME_US 2800
+
+// Temperature drifts slowly, so only 1 in TEMP_DECIMATION conversions measures it
+#define TEMP_DECIMATION 10
+
+typedef enum {
+	STATE_RESET,
+	STATE_PROM,
+	STATE_CONVERT
+} State;
+
+typedef enum {
+	CONVERSION_NONE,
+	CONVERSION_PRESSURE,
+	CONVERSION_TEMP
+} Conversion;
 
 static uint16_t prom[6];
 extern SPI_HandleTypeDef hspi1;
 
+static const spi_device_t device = {
+	&hspi1, GPIOC, GPIO_PIN_14, MS5611_SPI_PRESCALER, SPI_POLARITY_HIGH, SPI_PHASE_2EDGE
+};
+
+// Every access is queued, so the commands and reads need their own buffers.
+// A read and the next conversion command can be in the queue together.
+static uint8_t command;
+static spi_transaction_t command_transaction = { &device, &command, NULL, 1 };
+static uint8_t read_tx[4];
+static uint8_t read_rx[4];
+static spi_transaction_t read_transaction = { &device, read_tx, read_rx, sizeof(read_rx) };
+
 //min OSR by default
 static uint8_t pressAddr = PRESSURE_OSR_256;
 static uint8_t tempAddr = TEMP_OSR_256;
 static uint32_t convDelay = CONVERSION_OSR_256;
 
-static int32_t temperature;
-static int32_t pressure;
+static float temperature;
+static float pressure;
 static float altitude;
+static uint64_t timestamp;
+
+// Temperature compensation, P = D1 * pressScale - pressOffset
+static float pressScale;
+static float pressOffset;
+static bool tempValid;
+
+static State state;
+static uint8_t promIndex;
+static uint64_t startTime;
+static Conversion conversion;
+static uint8_t conversionCount;
 
-static int state;
-static int startTime;
-static uint32_t D1, D2;
+// Conversion whose ADC read is in the queue
+static bool readPending;
+static Conversion readConversion;
+static uint64_t readTime;
 
 /**
- * @brief init the pressure sensor with default parameters
+ * @brief queue a command without waiting
+ *
+ * @return false if the bus queue is full or the last command is still queued
  */
-static void ms5611_init();
+static bool ms5611_queue_command(uint8_t cmd);
 
 /**
- * @brief write the command passed in parameters to the SPI Bus
+ * @brief queue a read of len bytes after the command byte without waiting
  *
- * @param data the command to write
+ * @return false if the bus queue is full or the last read is still queued
+ */
+static bool ms5611_queue_read(uint8_t cmd, uint8_t len);
+
+/**
+ * @brief the big endian result of the last read
+ */
+static uint32_t ms5611_read_result();
+
+/**
+ * @brief read the calibration PROM one word per call after the reset
  */
-static void ms5611_write(uint8_t data);
+static void ms5611_read_prom(uint64_t time_us);
 
 /**
- * @brief read the n bits of the SPI Bus on  register reg
+ * @brief collect finished ADC reads and start the next conversion
  *
- * @return the value read on the SPI bus
+ * @return true if a new pressure sample is available
+ */
+static bool ms5611_convert(uint64_t time_us);
+
+/**
+ * @brief update the compensation terms from a temperature reading
+ */
+static void ms5611_compensate_temp(uint32_t D2);
+
+/**
+ * @brief compensate a pressure reading and convert it to altitude
  */
-static uint16_t ms5611_read16bits(uint8_t reg);
-static uint32_t ms5611_read24bits(uint8_t reg);
+static void ms5611_compensate_pressure(uint32_t D1);
 
 
-static void ms5611_init()
+static bool ms5611_queue_command(uint8_t cmd)
 {
-	MS5611_DIS
-	HAL_Delay(10);
+	if (command_transaction.status == SPI_TRANSACTION_QUEUED) {
+		return false;
+	}
+
+	command = cmd;
 
-	ms5611_write(CMD_RESET);
-	HAL_Delay(10);
+	if (!spi_queue(&command_transaction)) {
+		command_transaction.status = SPI_TRANSACTION_FAILED;
+		return false;
+	}
 
-	prom[0] = ms5611_read16bits(CMD_PROM_C1);
-	prom[1] = ms5611_read16bits(CMD_PROM_C2);
-	prom[2] = ms5611_read16bits(CMD_PROM_C3);
-	prom[3] = ms5611_read16bits(CMD_PROM_C4);
-	prom[4] = ms5611_read16bits(CMD_PROM_C5);
-	prom[5] = ms5611_read16bits(CMD_PROM_C6);
+	return true;
 }
 
-static void ms5611_write(uint8_t data)
+static bool ms5611_queue_read(uint8_t cmd, uint8_t len)
 {
-	HAL_SPI_DeInit(&hspi1);
-	hspi1.Init.BaudRatePrescaler = MS5611_SPI_PRESCALER;
-	if (HAL_SPI_Init(&hspi1) != HAL_OK) {
-		while (1) {};
+	if (read_transaction.status == SPI_TRANSACTION_QUEUED) {
+		return false;
 	}
 
-	MS5611_EN
-	HAL_SPI_Transmit(&hspi1, &data, 1, SPI_TIMEOUT);
-	MS5611_DIS
-}
+	read_tx[0] = cmd;
+	read_transaction.len = len + 1;
 
-static uint16_t ms5611_read16bits(uint8_t reg)
-{
-	HAL_SPI_DeInit(&hspi1);
-	hspi1.Init.BaudRatePrescaler = MS5611_SPI_PRESCALER;
-	if (HAL_SPI_Init(&hspi1) != HAL_OK) {
-		while (1) {};
+	if (!spi_queue(&read_transaction)) {
+		read_transaction.status = SPI_TRANSACTION_FAILED;
+		return false;
 	}
 
-	uint8_t byte[3];
-	uint16_t return_value;
-	MS5611_EN
-	HAL_SPI_TransmitReceive(&hspi1, &reg, byte, 3, SPI_TIMEOUT);
-	MS5611_DIS
+	return true;
+}
+
+static uint32_t ms5611_read_result()
+{
 	/**
-	 * We dont care about byte[0] because that is what was recorded while
-	 * we were sending the first byte of the cmd. Since the baro wasn't sending
-	 * actual data at that time (it was listening for command), data[0] will
-	 * contain garbage data (probably all 0's).
+	 * We dont care about read_rx[0] because that is what was recorded while
+	 * we were sending the cmd. Since the baro wasn't sending actual data at
+	 * that time (it was listening for command), it will contain garbage data.
 	 */
-	return_value = ((uint16_t)byte[1]<<8) | (byte[2]);
-	return return_value;
+	uint32_t value = 0;
+
+	for (uint8_t i = 1; i < read_transaction.len; i++) {
+		value = (value << 8) | read_rx[i];
+	}
+
+	return value;
 }
 
-static uint32_t ms5611_read24bits(uint8_t reg)
+static void ms5611_read_prom(uint64_t time_us)
 {
-	HAL_SPI_DeInit(&hspi1);
-	hspi1.Init.BaudRatePrescaler = MS5611_SPI_PRESCALER;
-	if (HAL_SPI_Init(&hspi1) != HAL_OK) {
-		while (1) {};
+	if (command_transaction.status == SPI_TRANSACTION_FAILED) {
+		state = STATE_RESET;
+		return;
 	}
 
-	uint8_t byte[4];
-	uint32_t return_value;
-	MS5611_EN
-	HAL_SPI_TransmitReceive(&hspi1, &reg, byte, 4, SPI_TIMEOUT);
-	MS5611_DIS
-	return_value = ((uint32_t)byte[1]<<16) | ((uint32_t)(byte[2]<<8)) | (byte[3]);
-	return return_value;
+	if (time_us - startTime < RESET_TIME_US || read_transaction.status == SPI_TRANSACTION_QUEUED) {
+		return;
+	}
+
+	if (readPending) {
+		readPending = false;
+
+		// Start over from the reset, a missing coefficient would corrupt every sample
+		if (read_transaction.status != SPI_TRANSACTION_DONE) {
+			state = STATE_RESET;
+			return;
+		}
+
+		prom[promIndex++] = (uint16_t)ms5611_read_result();
+
+		if (promIndex == 6) {
+			conversion = CONVERSION_NONE;
+			state = STATE_CONVERT;
+			return;
+		}
+	}
+
+	if (ms5611_queue_read(CMD_PROM_C1 + promIndex * 2, 2)) {
+		readPending = true;
+	}
+}
+
+// The ADC read of one conversion goes out together with the command for the
+// next, and its result is collected on a later call.
+static bool ms5611_convert(uint64_t time_us)
+{
+	bool sample = false;
+
+	if (readPending && read_transaction.status != SPI_TRANSACTION_QUEUED) {
+		readPending = false;
+		const uint32_t value = ms5611_read_result();
+
+		// The ADC reads 0 if the conversion was not finished or never started
+		if (read_transaction.status == SPI_TRANSACTION_DONE && value != 0) {
+			if (readConversion == CONVERSION_TEMP) {
+				ms5611_compensate_temp(value);
+			} else if (tempValid) {
+				ms5611_compensate_pressure(value);
+				timestamp = readTime;
+				sample = true;
+			}
+		}
+	}
+
+	if (conversion != CONVERSION_NONE) {
+		if (time_us - startTime < convDelay || !ms5611_queue_read(CMD_ADC_READ, 3)) {
+			return sample;
+		}
+
+		readPending = true;
+		readConversion = conversion;
+		readTime = startTime + convDelay / 2;
+	}
+
+	if (!tempValid || ++conversionCount >= TEMP_DECIMATION) {
+		conversion = CONVERSION_TEMP;
+		conversionCount = 0;
+	} else {
+		conversion = CONVERSION_PRESSURE;
+	}
+
+	if (ms5611_queue_command(conversion == CONVERSION_TEMP ? tempAddr : pressAddr)) {
+		startTime = time_us;
+	} else {
+		conversion = CONVERSION_NONE;
+	}
+
+	return sample;
+}
+
+// First and second order compensation from the datasheet in single precision.
+// dT fits in 24 bits so it is exact, the rounding of the other terms is
+// below 0.01 Pa. Everything depending on temperature is folded into two
+// terms so each pressure sample is one multiply and subtract.
+static void ms5611_compensate_temp(uint32_t D2)
+{
+	const float dT = (float)D2 - (float)prom[4] * 256.0f;
+	float temp = 2000.0f + dT * (float)prom[5] * (1.0f / 8388608.0f);
+	float off = (float)prom[1] * 65536.0f + (float)prom[3] * dT * (1.0f / 128.0f);
+	float sens = (float)prom[0] * 32768.0f + (float)prom[2] * dT * (1.0f / 256.0f);
+
+	if (temp < 2000.0f) {   // second order temperature compensation
+		const float aux = (temp - 2000.0f) * (temp - 2000.0f);
+		temp -= dT * dT * (1.0f / 2147483648.0f);
+		off -= 2.5f * aux;
+		sens -= 1.25f * aux;
+	}
+
+	// P = (D1 * SENS / 2^21 - OFF) / 2^15
+	pressScale = sens * (1.0f / 68719476736.0f);
+	pressOffset = off * (1.0f / 32768.0f);
+	temperature = temp * 0.01f;
+	tempValid = true;
+}
+
+static void ms5611_compensate_pressure(uint32_t D1)
+{
+	pressure = (float)D1 * pressScale - pressOffset;
+	altitude = (1.0f - fast_powf(pressure * (1.0f / 101325.0f), 1.0f / 5.255f)) * 44330.77f;
 }
 
 
 void Barometer_init()
 {
-	ms5611_init();
+	MS5611_DIS
+
+	state = STATE_RESET;
+	tempValid = false;
 }
 
 void Barometer_setOSR(OSR osr)
@@ -187,86 +346,43 @@ void Barometer_setOSR(OSR osr)
 	}
 }
 
-int32_t Barometer_getTemp(bool calculate)
+float Barometer_getTemp()
 {
-	if (calculate)
-	{
-		Barometer_calculate();
-	}
 	return temperature;
 }
 
-int32_t Barometer_getPressure(bool calculate)
+float Barometer_getPressure()
 {
-	if (calculate)
-	{
-		Barometer_calculate();
-	}
 	return pressure;
 }
 
-bool Barometer_getAltitude(float *alt)
+float Barometer_getAltitude()
 {
-	if (Barometer_calculate())
-	{
-		*alt = altitude;
-		return true;
-	}
-	return false;
+	return altitude;
 }
 
-bool Barometer_calculate()
+uint64_t Barometer_getTimestamp()
 {
-	int32_t dT;
-	int64_t TEMP, OFF, SENS, P;
-	float press, r, c;
-
-	if (state == 0) {
-		// Convert pressure
-		ms5611_write(pressAddr);
-
-		startTime = HAL_GetTick();
-		state = 1;
-	} else if (state == 1 && (HAL_GetTick() - startTime) > convDelay) {
-		// Read ADC
-		D1 = ms5611_read24bits(0x00);
-
-		// Convert temp
-		ms5611_write(tempAddr);
-
-		startTime = HAL_GetTick();
-		state = 2;
-	} else if (state == 2 && (HAL_GetTick() - startTime) > convDelay) {
-		// Read ADC
-		D2 = ms5611_read24bits(0x00);
-
-		dT = D2-((long)prom[4]*256);
-		TEMP = 2000 + ((int64_t)dT * prom[5])/8388608;
-		OFF = (int64_t)prom[1] * 65536 + ((int64_t)prom[3] * dT ) / 128;
-		SENS = (int64_t)prom[0] * 32768 + ((int64_t)prom[2] * dT) / 256;
-
-		if (TEMP < 2000){   // second order temperature compensation
-			int64_t T2 = (((int64_t)dT)*dT) >> 31;
-			int64_t Aux_64 = (TEMP-2000)*(TEMP-2000);
-			int64_t OFF2 = (5*Aux_64)>>1;
-			int64_t SENS2 = (5*Aux_64)>>2;
-			TEMP = TEMP - T2;
-			OFF = OFF - OFF2;
-			SENS = SENS - SENS2;
-		}
-
-		P = (D1*SENS/2097152 - OFF)/32768;
-		temperature = TEMP;
-		pressure = P;
-
-		press = (float)pressure;
-		r= press/101325.0;
-		c = 1.0/5.255;
-		altitude = (1 - pow(r,c))*44330.77;
-
-		state = 0;
+	return timestamp;
+}
 
-		return true;
+bool Barometer_calculate(uint64_t time_us)
+{
+	switch (state)
+	{
+	case STATE_RESET:
+		if (ms5611_queue_command(CMD_RESET)) {
+			startTime = time_us;
+			promIndex = 0;
+			readPending = false;
+			state = STATE_PROM;
+		}
+		return false;
+	case STATE_PROM:
+		ms5611_read_prom(time_us);
+		return false;
+	case STATE_CONVERT:
+		return ms5611_convert(time_us);
 	}
 
 	return false;
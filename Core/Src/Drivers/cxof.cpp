@@ -1,17 +1,30 @@
 #include "Drivers/cxof.h"
 
 Cxof::Cxof(UART_HandleTypeDef* uart)
+	: _rx(uart, rx_buffer, sizeof(rx_buffer))
 {
-	_uart = uart;
 }
 
 void Cxof::setup()
 {
-	HAL_UART_Receive_DMA(_uart, rx_buffer, 1);
+	_rx.setup();
 }
 
 bool Cxof::read(Cxof_frame *frame)
 {
+	const uint8_t* data;
+	uint16_t len;
+
+	while ((len = _rx.peek(&data)) > 0)
+	{
+		for (uint16_t i = 0; i < len; i++)
+		{
+			parse_byte(data[i]);
+		}
+
+		_rx.consume(len);
+	}
+
 	if (new_data)
 	{
 		*frame = result;
@@ -21,10 +34,8 @@ bool Cxof::read(Cxof_frame *frame)
 	return false;
 }
 
-void Cxof::dma_complete()
+void Cxof::parse_byte(uint8_t byte)
 {
-	uint8_t byte = rx_buffer[0];
-
 	if (byte == CXOF_HEADER)
 	{
 		frame_started = true;
@@ -47,6 +58,4 @@ void Cxof::dma_complete()
 			frame_started = false;
 		}
 	}
-
-	HAL_UART_Receive_DMA(_uart, rx_buffer, 1);
 }
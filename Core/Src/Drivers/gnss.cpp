@@ -7,77 +7,160 @@
 
 #include "Drivers/gnss.h"
 
+// Configuration keys for M9 and later
+#define CFG_UART1OUTPROT_UBX 0x10740001
+#define CFG_UART1OUTPROT_NMEA 0x10740002
+#define CFG_RATE_MEAS 0x30210001
+#define CFG_MSGOUT_UBX_NAV_PVT_UART1 0x20910007
+
+static uint8_t* put_u16(uint8_t* data, uint16_t value)
+{
+	data[0] = value;
+	data[1] = value >> 8;
+	return data + 2;
+}
+
+static uint8_t* put_u32(uint8_t* data, uint32_t value)
+{
+	data[0] = value;
+	data[1] = value >> 8;
+	data[2] = value >> 16;
+	data[3] = value >> 24;
+	return data + 4;
+}
+
 GNSS::GNSS(UART_HandleTypeDef* uart)
+	: _uart(uart),
+	  _rx(uart, rx_buffer, sizeof(rx_buffer))
 {
-	_uart = uart;
 }
 
 void GNSS::setup()
 {
-	HAL_UART_Receive_DMA(_uart, rx_buffer, 1);
+	_rx.setup();
+
+	build_config();
+	send_config();
 }
 
+// Messages are parsed here rather than in the receive interrupt
 bool GNSS::read()
 {
+	const uint8_t* data;
+	uint16_t len;
+
+	while ((len = _rx.peek(&data)) > 0)
+	{
+		for (uint16_t i = 0; i < len; i++)
+		{
+			if (_parser.parse_byte(data[i]) && _parser.decode_nav_pvt(&pvt))
+			{
+				timestamp = _rx.get_event_time();
+				new_data = true;
+			}
+		}
+
+		_rx.consume(len);
+	}
+
 	if (new_data)
 	{
 		new_data = false;
+		last_solution_time = HAL_GetTick();
 
 		return true;
 	}
 
+	if (HAL_GetTick() - last_solution_time > config_retry_ms)
+	{
+		last_solution_time = HAL_GetTick();
+		send_config();
+	}
+
 	return false;
 }
 
-// Remember to disable UBX output! It is only made for NMEA packets, not UBX.
-void GNSS::dma_complete()
+void GNSS::build_config()
 {
-	char c = rx_buffer[0];
+	uint8_t data[32];
+	uint8_t* p;
+
+	tx_len = 0;
+
+	// M9 and M10, applied to RAM only
+	p = data;
+	*p++ = 0; // Version
+	*p++ = 0x01; // RAM layer
+	p = put_u16(p, 0);
+	p = put_u32(p, CFG_UART1OUTPROT_UBX);
+	*p++ = 1;
+	p = put_u32(p, CFG_UART1OUTPROT_NMEA);
+	*p++ = 0;
+	p = put_u32(p, CFG_RATE_MEAS);
+	p = put_u16(p, measurement_period_ms);
+	p = put_u32(p, CFG_MSGOUT_UBX_NAV_PVT_UART1);
+	*p++ = 1;
+	add_message(UBX_CLASS_CFG, UBX_CFG_VALSET, data, p - data);
+
+	// M8
+	p = data;
+	p = put_u16(p, measurement_period_ms);
+	p = put_u16(p, 1); // One navigation solution per measurement
+	p = put_u16(p, 1); // Align to GPS time
+	add_message(UBX_CLASS_CFG, UBX_CFG_RATE, data, p - data);
+
+	p = data;
+	*p++ = UBX_CLASS_NAV;
+	*p++ = UBX_NAV_PVT;
+	*p++ = 1; // Every solution on the current port
+	add_message(UBX_CLASS_CFG, UBX_CFG_MSG, data, p - data);
 
-	if (c == '$')
+	// Last, since the port may drop what follows while it is reconfigured
+	p = data;
+	*p++ = 1; // UART1
+	*p++ = 0;
+	p = put_u16(p, 0); // No TX ready pin
+	p = put_u32(p, 0x000008C0); // 8N1
+	p = put_u32(p, _uart->Init.BaudRate);
+	p = put_u16(p, 0x0003); // UBX and NMEA in
+	p = put_u16(p, 0x0001); // UBX out
+	p = put_u16(p, 0);
+	p = put_u16(p, 0);
+	add_message(UBX_CLASS_CFG, UBX_CFG_PRT, data, p - data);
+}
+
+void GNSS::add_message(uint8_t cls, uint8_t id, const uint8_t* data, uint16_t len)
+{
+	if (tx_len + len + 8 > (int)sizeof(tx_buffer))
 	{
-		sentence[0] = c;
-		sentence_index = 1;
-		sentence_started = true;
+		return;
 	}
-	else if (c == '\r' && sentence_started && sentence_index < max_sentence_len)
-	{
-		sentence[sentence_index] = c;
-		sentence_index = 0;
-		sentence_started = false;
 
-		struct minmea_sentence_gga frame;
-		if (minmea_parse_gga(&frame, (char*)sentence))
-		{
-//			printf("%s\n", sentence);
+	uint8_t* msg = &tx_buffer[tx_len];
+	msg[0] = UBX_SYNC1;
+	msg[1] = UBX_SYNC2;
+	msg[2] = cls;
+	msg[3] = id;
+	put_u16(&msg[4], len);
+	memcpy(&msg[6], data, len);
 
-			lat = minmea_tocoord_double(&frame.latitude);
-			lon = minmea_tocoord_double(&frame.longitude);
-			alt = frame.altitude.value;
-			sats = frame.satellites_tracked;
-			fix = frame.fix_quality == 1;
+	// Checksum covers class to the end of the payload
+	uint8_t a = 0;
+	uint8_t b = 0;
 
-			new_data = true;
-		}
-	}
-	else if (sentence_started && sentence_index < max_sentence_len)
+	for (uint16_t i = 2; i < len + 6; i++)
 	{
-		sentence[sentence_index] = c;
-		sentence_index++;
+		a += msg[i];
+		b += a;
 	}
 
-	HAL_UART_Receive_DMA(_uart, rx_buffer, 1);
+	msg[len + 6] = a;
+	msg[len + 7] = b;
+	tx_len += len + 8;
 }
 
-double GNSS::minmea_tocoord_double(const struct minmea_float *f)
+// Sent in the background, an earlier attempt still in progress is left alone
+void GNSS::send_config()
 {
-    if (f->scale == 0)
-        return NAN;
-    if (f->scale  > (INT_LEAST32_MAX / 100))
-        return NAN;
-    if (f->scale < (INT_LEAST32_MIN / 100))
-        return NAN;
-    int_least32_t degrees = f->value / (f->scale * 100);
-    int_least32_t minutes = f->value % (f->scale * 100);
-    return (double) degrees + (double) minutes / (60 * f->scale);
+	HAL_UART_Transmit_IT(_uart, tx_buffer, tx_len);
 }
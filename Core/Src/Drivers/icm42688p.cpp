@@ -4,11 +4,16 @@ using namespace ICM42688reg;
 
 /* ICM42688 object, input the SPI bus and chip select pin */
 ICM42688::ICM42688(SPI_HandleTypeDef * bus, GPIO_TypeDef * csPinBank, uint16_t csPin, uint32_t spiLSPrescaler, uint32_t spiHSPrescaler) {
-	_spi          = bus;   // SPI bus
 	_csPinBank    = csPinBank;  // chip select pin bank
 	_csPin        = csPin;  // chip select pin
-	_spiLSPrescaler = spiLSPrescaler;
-	_spiHSPrescaler = spiHSPrescaler;
+	_spiLS        = {bus, csPinBank, csPin, spiLSPrescaler, SPI_POLARITY_HIGH, SPI_PHASE_2EDGE};
+	_spiHS        = {bus, csPinBank, csPin, spiHSPrescaler, SPI_POLARITY_HIGH, SPI_PHASE_2EDGE};
+
+	_agtTx[0] = UB0_REG_TEMP_DATA1 | 0x80;
+	_agtTransaction.device = &_spiHS;
+	_agtTransaction.tx     = _agtTx;
+	_agtTransaction.rx     = _agtRx;
+	_agtTransaction.len    = sizeof(_agtTx);
 }
 
 /* starts communication with the ICM42688 */
@@ -60,10 +65,6 @@ void ICM42688::setCSHigh() {
 	HAL_GPIO_WritePin(_csPinBank, _csPin, GPIO_PIN_SET);
 }
 
-void ICM42688::setCSLow() {
-	HAL_GPIO_WritePin(_csPinBank, _csPin, GPIO_PIN_RESET);
-}
-
 /* sets the accelerometer full scale range to values other than default */
 int ICM42688::setAccelFS(AccelFS fssel) {
 	// use low speed SPI for register setting
@@ -275,11 +276,31 @@ int ICM42688::getAGT() {  // modified to use getRawAGT()
 	return 1;
 }
 
+/* queues the data readout, bank 0 must already be selected */
+int ICM42688::requestAGT() {
+	if (_agtTransaction.status == SPI_TRANSACTION_QUEUED) {
+		return 1;
+	}
+
+	if (!spi_queue(&_agtTransaction)) {
+		return -1;
+	}
+
+	return 1;
+}
+
 /* reads the most current data from ICM42688 and stores in buffer */
 int ICM42688::getRawAGT() {  // Added to return raw data only
 	_useSPIHS = true;          // use the high speed SPI for data readout
-	// grab the data from the ICM42688
-	if (readRegisters(UB0_REG_TEMP_DATA1, 14, _buffer) < 0) {
+	// grab the data from the ICM42688, or take the queued readout
+	if (_agtTransaction.status != SPI_TRANSACTION_IDLE) {
+		const bool ok = spi_wait(&_agtTransaction);
+		_agtTransaction.status = SPI_TRANSACTION_IDLE;
+		if (!ok) {
+			return -1;
+		}
+		memcpy(_buffer, &_agtRx[1], 14);
+	} else if (readRegisters(UB0_REG_TEMP_DATA1, 14, _buffer) < 0) {
 		return -1;
 	}
 
@@ -600,16 +621,15 @@ void ICM42688::setAccelCalZ(float bias, float scaleFactor) {
 /* writes a byte to ICM42688 register given a register address and data */
 int ICM42688::writeRegister(uint8_t subAddress, uint8_t data) {
 	// Low speed
-	HAL_SPI_DeInit(_spi);
-	_spi->Init.BaudRatePrescaler = _spiLSPrescaler;
-	if (HAL_SPI_Init(_spi) != HAL_OK) {
-		while (1) {};
-	}
+	uint8_t tx[2] = {subAddress, data};
+	spi_transaction_t transaction = {};
+	transaction.device = &_spiLS;
+	transaction.tx     = tx;
+	transaction.len    = sizeof(tx);
 
-	setCSLow();
-	HAL_SPI_Transmit(_spi, &subAddress, 1, HAL_MAX_DELAY);
-	HAL_SPI_Transmit(_spi, &data, 1, HAL_MAX_DELAY);
-	setCSHigh();
+	if (!spi_transfer(&transaction)) {
+		return -1;
+	}
 
 	HAL_Delay(10);
 
@@ -625,25 +645,26 @@ int ICM42688::writeRegister(uint8_t subAddress, uint8_t data) {
 
 /* reads registers from ICM42688 given a starting register address, number of bytes, and a pointer to store data */
 int ICM42688::readRegisters(uint8_t subAddress, uint8_t count, uint8_t* dest) {
-	if (_useSPIHS) {
-		HAL_SPI_DeInit(_spi);
-		_spi->Init.BaudRatePrescaler = _spiHSPrescaler;
-		if (HAL_SPI_Init(_spi) != HAL_OK) {
-			while (1) {};
-		}
-	} else {
-		HAL_SPI_DeInit(_spi);
-		_spi->Init.BaudRatePrescaler = _spiLSPrescaler;
-		if (HAL_SPI_Init(_spi) != HAL_OK) {
-			while (1) {};
-		}
+	uint8_t tx[16] = {};
+	uint8_t rx[16];
+
+	if (count >= sizeof(tx)) {
+		return -1;
 	}
 
-	setCSLow();
-	uint8_t writeAddr = subAddress | 0x80;
-	HAL_SPI_Transmit(_spi, &writeAddr, 1, HAL_MAX_DELAY);
-	HAL_SPI_Receive(_spi, dest, count, HAL_MAX_DELAY);
-	setCSHigh();
+	// the address byte goes out first, the data comes back after it
+	tx[0] = subAddress | 0x80;
+	spi_transaction_t transaction = {};
+	transaction.device = _useSPIHS ? &_spiHS : &_spiLS;
+	transaction.tx     = tx;
+	transaction.rx     = rx;
+	transaction.len    = count + 1;
+
+	if (!spi_transfer(&transaction)) {
+		return -1;
+	}
+
+	memcpy(dest, &rx[1], count);
 
 	return 1;
 }
@@ -29,10 +29,10 @@ Adafruit_MLX90393::Adafruit_MLX90393(void) {}
  *    @return True if initialization was successful, otherwise false.
  */
 bool Adafruit_MLX90393::begin_SPI(GPIO_TypeDef * csPinBank, uint16_t csPin, SPI_HandleTypeDef* spi, uint32_t spiPrescaler) {
-	_spi = spi;
-	_csPinBank = csPinBank;
-	_csPin = csPin;
-	_spiPrescaler = spiPrescaler;
+	_device = {spi, csPinBank, csPin, spiPrescaler, SPI_POLARITY_HIGH, SPI_PHASE_2EDGE};
+	_transaction.device = &_device;
+	_transaction.tx = _tx;
+	_transaction.rx = _rx;
 	return _init();
 }
 
@@ -290,6 +290,15 @@ bool Adafruit_MLX90393::readMeasurement(float *x, float *y, float *z) {
     return false;
   }
 
+  convertMeasurement(rx, x, y, z);
+
+  return true;
+}
+
+/**
+ * Converts the raw data register contents to uT.
+ */
+void Adafruit_MLX90393::convertMeasurement(const uint8_t *rx, float *x, float *y, float *z) {
   int16_t xi, yi, zi;
 
   /* Convert data to uT and float. */
@@ -313,8 +322,6 @@ bool Adafruit_MLX90393::readMeasurement(float *x, float *y, float *z) {
   *x = (float)xi * mlx90393_lsb_lookup[0][_gain][_res_x][0];
   *y = (float)yi * mlx90393_lsb_lookup[0][_gain][_res_y][0];
   *z = (float)zi * mlx90393_lsb_lookup[0][_gain][_res_z][1];
-
-  return true;
 }
 
 /**
@@ -337,17 +344,44 @@ bool Adafruit_MLX90393::readMeasurement(float *x, float *y, float *z) {
 //  return readMeasurement(x, y, z);
 //}
 
-bool Adafruit_MLX90393::readDataNonBlocking() {
-	int conversion_time = mlx90393_tconv[_dig_filt][_osr];
+/**
+ * Queues a command on the SPI bus without waiting for it.
+ */
+bool Adafruit_MLX90393::queueCommand(uint8_t cmd, uint8_t rxlen) {
+  _tx[0] = cmd;
+  _transaction.len = 2 + rxlen;
+  return spi_queue(&_transaction);
+}
+
+/**
+ * Single measurement cycle where every bus access is queued, the result of
+ * one step is collected on the next call.
+ *
+ * @return True when x, y and z hold a new measurement
+ */
+bool Adafruit_MLX90393::readDataNonBlocking(uint64_t time_us) {
+  const uint32_t conversion_time = mlx90393_tconv[_dig_filt][_osr] * 1000;
 
   if (_state == 0) {
-    startSingleMeasurement();
-    _state = 1;
-    _start_time = HAL_GetTick();
-  } else if (_state == 1 && (HAL_GetTick() - _start_time) > conversion_time) {
-    readMeasurement(&x, &y, &z);
+    if (queueCommand(MLX90393_REG_SM | MLX90393_AXIS_ALL, 0)) {
+      _state = 1;
+      _start_time = time_us;
+    }
+  } else if (_state == 1 && time_us - _start_time >= conversion_time) {
+    if (queueCommand(MLX90393_REG_RM | MLX90393_AXIS_ALL, 6)) {
+      _state = 2;
+    }
+  } else if (_state == 2 && _transaction.status != SPI_TRANSACTION_QUEUED) {
     _state = 0;
-    return true;
+
+    uint8_t stat = _rx[1] >> 2;
+
+    if (_transaction.status == SPI_TRANSACTION_DONE &&
+        (stat == MLX90393_STATUS_OK || stat == MLX90393_STATUS_SMMODE)) {
+      convertMeasurement(&_rx[2], &x, &y, &z);
+      timestamp = _start_time + conversion_time / 2;
+      return true;
+    }
   }
 
   return false;
@@ -398,21 +432,31 @@ uint8_t Adafruit_MLX90393::transceive(uint8_t *txbuf, uint8_t txlen,
                                       uint8_t interdelay) {
 	uint8_t status = 0;
 	uint8_t i;
-	uint8_t rxbuf2[rxlen + 2];
+	uint8_t txbuf2[16] = {0};
+	uint8_t rxbuf2[16];
+
+	if (txlen + rxlen + 1 > (int)sizeof(txbuf2)) {
+		return 0xFF;
+	}
+
+	/* Full duplex, the status and data clock in after the command. */
+	for (i = 0; i < txlen; i++) {
+		txbuf2[i] = txbuf[i];
+	}
+
+	spi_transaction_t transaction = {};
+	transaction.device = &_device;
+	transaction.tx = txbuf2;
+	transaction.rx = rxbuf2;
+	transaction.len = txlen + rxlen + 1;
 
-	HAL_SPI_DeInit(_spi);
-	_spi->Init.BaudRatePrescaler = _spiPrescaler;
-	if (HAL_SPI_Init(_spi) != HAL_OK) {
-		while (1) {};
+	if (!spi_transfer(&transaction)) {
+		return 0xFF;
 	}
 
-	HAL_GPIO_WritePin(_csPinBank, _csPin, GPIO_PIN_RESET);
-	HAL_SPI_Transmit(_spi, txbuf, txlen, HAL_MAX_DELAY);
-	HAL_SPI_Receive(_spi, rxbuf2, rxlen + 1, HAL_MAX_DELAY);
-	HAL_GPIO_WritePin(_csPinBank, _csPin, GPIO_PIN_SET);
-	status = rxbuf2[0];
+	status = rxbuf2[txlen];
 	for (i = 0; i < rxlen; i++) {
-		rxbuf[i] = rxbuf2[i + 1];
+		rxbuf[i] = rxbuf2[txlen + i + 1];
 	}
 	HAL_Delay(interdelay);
 
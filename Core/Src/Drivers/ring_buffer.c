@@ -1,4 +1,5 @@
 #include "Drivers/ring_buffer.h"
+#include <string.h>
 
 void ring_buffer_setup(ring_buffer_t* rb, uint8_t* buffer, uint32_t size) {
   rb->buffer = buffer;
@@ -40,3 +41,69 @@ bool ring_buffer_write(ring_buffer_t* rb, uint8_t byte) {
   rb->write_index = next_write_index;
   return true;
 }
+
+uint32_t ring_buffer_count(ring_buffer_t* rb) {
+  return (rb->write_index - rb->read_index) & rb->mask;
+}
+
+// One slot is kept empty to tell a full buffer from an empty one
+uint32_t ring_buffer_space(ring_buffer_t* rb) {
+  return rb->mask - ring_buffer_count(rb);
+}
+
+// Writes as much as fits, in at most two copies
+uint32_t ring_buffer_write_bytes(ring_buffer_t* rb, const uint8_t* data, uint32_t len) {
+  uint32_t local_write_index = rb->write_index;
+  uint32_t space = ring_buffer_space(rb);
+
+  if (len > space) {
+    len = space;
+  }
+
+  uint32_t first = rb->mask + 1 - local_write_index;
+  if (first > len) {
+    first = len;
+  }
+
+  memcpy(&rb->buffer[local_write_index], data, first);
+  memcpy(rb->buffer, data + first, len - first);
+
+  rb->write_index = (local_write_index + len) & rb->mask;
+  return len;
+}
+
+uint32_t ring_buffer_read_bytes(ring_buffer_t* rb, uint8_t* data, uint32_t len) {
+  uint32_t read = 0;
+  uint8_t* span;
+  uint32_t span_len;
+
+  while (read < len && (span_len = ring_buffer_peek(rb, &span)) > 0) {
+    if (span_len > len - read) {
+      span_len = len - read;
+    }
+
+    memcpy(data + read, span, span_len);
+    ring_buffer_consume(rb, span_len);
+    read += span_len;
+  }
+
+  return read;
+}
+
+// Longest contiguous span of unread bytes, returns its length
+uint32_t ring_buffer_peek(ring_buffer_t* rb, uint8_t** data) {
+  uint32_t local_read_index = rb->read_index;
+  uint32_t local_write_index = rb->write_index;
+
+  *data = &rb->buffer[local_read_index];
+
+  if (local_write_index >= local_read_index) {
+    return local_write_index - local_read_index;
+  }
+
+  return rb->mask + 1 - local_read_index;
+}
+
+void ring_buffer_consume(ring_buffer_t* rb, uint32_t len) {
+  rb->read_index = (rb->read_index + len) & rb->mask;
+}
@@ -1,34 +1,63 @@
 #include <Drivers/sbus_input.h>
 
 SBUS_input::SBUS_input(UART_HandleTypeDef* uart)
+	: _rx(uart, _rx_buffer, sizeof(_rx_buffer))
 {
-	_uart = uart;
 }
 
 void SBUS_input::setup()
 {
-	HAL_UART_Receive_DMA(_uart, _rx_buffer, 1);
+	_rx.set_event_callback(&SBUS_input::rx_callback, this);
+	_rx.setup();
 }
 
-void SBUS_input::dma_complete()
+void SBUS_input::set_frame_callback(void (*callback)(void* context, const uint16_t channels[], uint64_t time), void* context)
 {
-	if (SBus_ParseByte(_rx_buffer[0]) == SBUS_FRAME_READY)
-	{
-		SBus_DecodeFrame();
+	_frame_context = context;
+	_frame_callback = callback;
+}
+
+void SBUS_input::parse()
+{
+	const uint8_t* data;
+	uint16_t len;
 
-		for (int i = 0; i < 16; i++)
+	while ((len = _rx.peek(&data)) > 0)
+	{
+		for (uint16_t i = 0; i < len; i++)
 		{
-			_rc_data[i] = SBus_GetChannel(i);
+			if (SBus_ParseByte(&_parser, data[i]) == SBUS_FRAME_READY)
+			{
+				SBus_DecodeFrame(&_parser);
+
+				for (uint8_t j = 0; j < SBUS_CHANNEL_COUNT; j++)
+				{
+					_rc_data[j] = SBus_GetChannel(&_parser, j);
+				}
+
+				// The receiver repeats its failsafe values, those must not
+				// reach the outputs through the fast path
+				if (_frame_callback && !(SBus_GetFlags(&_parser) & SBUS_FLAG_FAILSAFE))
+				{
+					_frame_callback(_frame_context, _rc_data, _rx.get_event_time());
+				}
+			}
 		}
-	}
 
-	HAL_UART_Receive_DMA(_uart, _rx_buffer, 1);
+		_rx.consume(len);
+	}
 }
 
+// Parsed in the interrupt, the copy only has to be consistent
 void SBUS_input::get_rc_data(uint16_t out[], int size)
 {
+	const uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
 	for (int i = 0; i < size; i++)
 	{
 		out[i] = _rc_data[i];
 	}
+
+	__set_PRIMASK(primask);
 }
@@ -1,12 +1,9 @@
 #include "Drivers/sd.h"
-
-#define RING_BUFFER_SIZE (4096) // Must be a power of 2
-
-static uint8_t data_buffer[RING_BUFFER_SIZE] = {0U};
+#include <atomic>
 
 Sd::Sd()
 {
-	ring_buffer_setup(&ring_buffer, data_buffer, RING_BUFFER_SIZE);
+	ring_buffer_setup(&ring_buffer, data_buffer, sizeof(data_buffer));
 	f_mount(&fatfs, SDPath, 1);
 }
 
@@ -19,17 +16,16 @@ void Sd::create_file(char name[], uint8_t len)
 	}
 }
 
-// Append byte to ring buffer
-bool Sd::write_byte(uint8_t byte)
+// Append to ring buffer. A message that does not fit is dropped whole rather
+// than leaving a partial one in the log.
+uint16_t Sd::write(const uint8_t* data, uint16_t len)
 {
-	if (sd_mode == SDMode::WRITE)
+	if (sd_mode == SDMode::WRITE && ring_buffer_space(&ring_buffer) >= len)
 	{
-		ring_buffer_write(&ring_buffer, byte);
-
-		return true;
+		return ring_buffer_write_bytes(&ring_buffer, data, len);
 	}
 
-	return false;
+	return 0;
 }
 
 bool Sd::read(uint8_t* rx_buff, uint16_t size)
@@ -54,11 +50,111 @@ bool Sd::read(uint8_t* rx_buff, uint16_t size)
 	return false;
 }
 
+bool Sd::read_mission(uint8_t file, uint32_t offset, void* data, uint32_t len)
+{
+	if (mission_request != MissionRequest::NONE)
+	{
+		return false;
+	}
+
+	mission_file = file;
+	mission_offset = offset;
+	mission_data = (uint8_t*)data;
+	mission_len = len;
+
+	// The request has to be complete before the SD task can see it
+	std::atomic_signal_fence(std::memory_order_release);
+	mission_request = MissionRequest::READ;
+
+	return true;
+}
+
+bool Sd::write_mission(uint8_t file, uint32_t offset, const void* data, uint32_t len)
+{
+	if (mission_request != MissionRequest::NONE)
+	{
+		return false;
+	}
+
+	mission_file = file;
+	mission_offset = offset;
+	mission_data = (uint8_t*)data;
+	mission_len = len;
+
+	// The request has to be complete before the SD task can see it
+	std::atomic_signal_fence(std::memory_order_release);
+	mission_request = MissionRequest::WRITE;
+
+	return true;
+}
+
+// True once the last request has finished
+bool Sd::mission_ready(bool* success)
+{
+	if (mission_request != MissionRequest::NONE)
+	{
+		return false;
+	}
+
+	// Result and read data only after the SD task has finished
+	std::atomic_signal_fence(std::memory_order_acquire);
+	*success = mission_success;
+	return true;
+}
+
+// Files are opened per request so the log file is the only one held open
+void Sd::process_mission_request()
+{
+	char name[16];
+	sprintf(name, "mission%d.bin", mission_file);
+
+	BYTE mode = mission_request == MissionRequest::READ ? FA_READ | FA_OPEN_EXISTING :
+														  FA_WRITE | FA_OPEN_ALWAYS;
+	FRESULT res = f_open(&mission_fil, name, mode);
+
+	if (res == FR_OK)
+	{
+		res = f_lseek(&mission_fil, mission_offset);
+	}
+
+	UINT bytes = 0;
+	if (res == FR_OK)
+	{
+		if (mission_request == MissionRequest::READ)
+		{
+			res = f_read(&mission_fil, mission_data, mission_len, &bytes);
+		}
+		else
+		{
+			res = f_write(&mission_fil, mission_data, mission_len, &bytes);
+		}
+
+		f_close(&mission_fil);
+	}
+
+	if (res != FR_OK)
+	{
+		printf("Mission file %s error: %d\n", name, res);
+	}
+
+	mission_success = res == FR_OK && bytes == mission_len;
+
+	// Hand the result and buffer back to the main task
+	std::atomic_signal_fence(std::memory_order_release);
+	mission_request = MissionRequest::NONE;
+}
+
 // Empty ring buffer and sync to micro-sd card
 void Sd::interrupt_callback()
 {
 	printf("SD driver interrupt\n");
 
+	if (mission_request != MissionRequest::NONE)
+	{
+		std::atomic_signal_fence(std::memory_order_acquire);
+		process_mission_request();
+	}
+
 	if (sd_mode == SDMode::CREATE_FILE)
 	{
 		printf("SD Driver creating file: %s\n", file_name);
@@ -74,20 +170,21 @@ void Sd::interrupt_callback()
 	}
 	else if (sd_mode == SDMode::WRITE)
 	{
-		// Empty ring buffer
-		uint8_t buffer[RING_BUFFER_SIZE];
-		uint16_t i = 0;
-		while (!ring_buffer_empty(&ring_buffer))
-		{
-			ring_buffer_read(&ring_buffer, &buffer[i++]);
-		}
+		// Save to storage straight from the ring buffer, at most two spans
+		FRESULT res = FR_OK;
+		uint8_t* span;
+		uint32_t span_len;
 
-		// Save to storage
-		UINT bytes_written;
-		FRESULT res = f_write(&fil, buffer, i, &bytes_written);
-		if (res != FR_OK)
+		for (uint8_t i = 0; i < 2 && (span_len = ring_buffer_peek(&ring_buffer, &span)) > 0; i++)
 		{
-			printf("Error during writing\n");
+			UINT bytes_written;
+			res = f_write(&fil, span, span_len, &bytes_written);
+			ring_buffer_consume(&ring_buffer, span_len);
+
+			if (res != FR_OK)
+			{
+				printf("Error during writing\n");
+			}
 		}
 
 		res = f_sync(&fil);
@@ -1,49 +1,87 @@
 #include <Drivers/servo.h>
 
-Servo::Servo(TIM_HandleTypeDef* tim, uint32_t channel)
+Servo_group::Servo_group(TIM_HandleTypeDef* tim, const uint32_t channels[], uint8_t num_channels, uint8_t ticks_per_us)
 {
 	_tim = tim;
-	_channel = channel;
+	_num_channels = num_channels < max_channels ? num_channels : max_channels;
+	_ticks_per_us = ticks_per_us > 0 ? ticks_per_us : 1;
+
+	for (uint8_t i = 0; i < _num_channels; i++)
+	{
+		_channels[i] = channels[i];
+	}
 }
 
-void Servo::init()
+void Servo_group::init(uint16_t rate_hz)
 {
-	// Note: ARR must be set to 1000
-	HAL_TIM_PWM_Start(_tim, _channel);
+	// APB1 timers run at twice the bus clock unless the bus is undivided
+	uint32_t timer_clock = HAL_RCC_GetPCLK1Freq();
+	if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
+	{
+		timer_clock *= 2;
+	}
+
+	__HAL_TIM_SET_PRESCALER(_tim, timer_clock / (1000000 * _ticks_per_us) - 1);
+	_tim->Instance->CR1 |= TIM_CR1_ARPE;
 
-	set_angle(90); // Set to mid point
+	for (uint8_t i = 0; i < _num_channels; i++)
+	{
+		__HAL_TIM_ENABLE_OCxPRELOAD(_tim, _channels[i]);
+		__HAL_TIM_SET_COMPARE(_tim, _channels[i], 0);
+	}
+
+	set_rate(rate_hz);
+
+	// Load the prescaler and period now instead of at the end of the
+	// current period
+	_tim->Instance->EGR = TIM_EGR_UG;
+
+	for (uint8_t i = 0; i < _num_channels; i++)
+	{
+		HAL_TIM_PWM_Start(_tim, _channels[i]);
+	}
 }
 
-void Servo::set_angle(uint8_t deg)
+// Takes effect on the next period boundary, the current pulse is not cut
+void Servo_group::set_rate(uint16_t rate_hz)
 {
-	if (deg > 180)
+	if (rate_hz < min_rate_hz)
+	{
+		rate_hz = min_rate_hz;
+	}
+	else if (rate_hz > max_rate_hz)
 	{
-		deg = 180;
+		rate_hz = max_rate_hz;
 	}
 
-	// Since 50Hz PWM frequency, the period is 20ms
-	// The servo responds for the pulse width of 0.5ms to 2.5ms
-	// Low Duty Cycle Percentage = 0.5ms/20ms x 100% = 2.5%
-	// High Duty Cycle Percentage = 2.5ms/20ms x 100% = 12.5%
+	uint32_t period = 1000000UL * _ticks_per_us / rate_hz;
 
-	// Since ARR is 1000
-	// Low Duty = 2.5% of 1000 = 25
-	// High Duty = 12.5% of 1000 = 125
+	// 16 bit timers run out of range at low rates with a fine resolution
+	if (!IS_TIM_32B_COUNTER_INSTANCE(_tim->Instance) && period > 0x10000)
+	{
+		period = 0x10000;
+	}
 
-	// Since servo has angles between 0 to 180 degrees
-	// and pulse values between 25 to 125
-	// Pulse value for 1 degree of rotation is (125 - 25) / 180
-	// Then the pulse value for the capture/compare register is
-	// 25 + deg*((125 - 25) / 180)
-	float pulse_per_deg = (125.0f - 25.0f) / 180.0f;
-	__HAL_TIM_SET_COMPARE(_tim, _channel, 25 + deg * pulse_per_deg);
+	_rate_hz = rate_hz;
+	_period = period;
+	__HAL_TIM_SET_AUTORELOAD(_tim, _period - 1);
 }
 
-void Servo::set_duty(uint16_t us)
+void Servo_group::write(const uint16_t pulse_us[])
 {
-	// Since 50Hz PWM frequency, the period is 20000us
-	// Duty cycle percentage = us / 20000
-	// Since ARR is 1000
-	// Duty = 1000 * (us / 20000)
-	__HAL_TIM_SET_COMPARE(_tim, _channel, 1000 * (us / 20000.0f));
+	_tim->Instance->CR1 |= TIM_CR1_UDIS;
+
+	for (uint8_t i = 0; i < _num_channels; i++)
+	{
+		uint32_t pulse = (uint32_t)pulse_us[i] * _ticks_per_us;
+
+		if (pulse >= _period)
+		{
+			pulse = _period - 1;
+		}
+
+		__HAL_TIM_SET_COMPARE(_tim, _channels[i], pulse);
+	}
+
+	_tim->Instance->CR1 &= ~TIM_CR1_UDIS;
 }
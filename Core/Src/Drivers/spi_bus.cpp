@@ -0,0 +1,200 @@
+#include "Drivers/spi_bus.h"
+
+Spi_bus* Spi_bus::_instances[max_instances];
+uint8_t Spi_bus::_num_instances = 0;
+
+Spi_bus::Spi_bus(SPI_HandleTypeDef* spi)
+{
+	_spi = spi;
+	_mode = UINT32_MAX; // Configure on the first transaction
+
+	if (_num_instances < max_instances)
+	{
+		_instances[_num_instances++] = this;
+	}
+}
+
+bool Spi_bus::queue(spi_transaction_t* transaction)
+{
+	const uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (_count >= queue_size)
+	{
+		__set_PRIMASK(primask);
+		return false;
+	}
+
+	transaction->status = SPI_TRANSACTION_QUEUED;
+	_queue[(_head + _count) % queue_size] = transaction;
+	_count++;
+
+	// Otherwise the completion interrupt starts it
+	if (_count == 1)
+	{
+		start();
+	}
+
+	__set_PRIMASK(primask);
+	return true;
+}
+
+// A stuck transfer is aborted so the rest of the queue can run
+bool Spi_bus::wait(spi_transaction_t* transaction)
+{
+	uint32_t start_time = HAL_GetTick();
+
+	while (transaction->status == SPI_TRANSACTION_QUEUED)
+	{
+		if (HAL_GetTick() - start_time > timeout_ms)
+		{
+			abort();
+			start_time = HAL_GetTick();
+		}
+	}
+
+	return transaction->status == SPI_TRANSACTION_DONE;
+}
+
+bool Spi_bus::transfer(spi_transaction_t* transaction)
+{
+	return queue(transaction) && wait(transaction);
+}
+
+// Called with interrupts off or from the DMA interrupt
+void Spi_bus::start()
+{
+	while (_count > 0)
+	{
+		spi_transaction_t* transaction = _queue[_head];
+		const spi_device_t* device = transaction->device;
+
+		configure(device);
+		HAL_GPIO_WritePin(device->cs_port, device->cs_pin, GPIO_PIN_RESET);
+
+		HAL_StatusTypeDef status;
+
+		if (transaction->rx)
+		{
+			status = HAL_SPI_TransmitReceive_DMA(_spi, (uint8_t*)transaction->tx, transaction->rx, transaction->len);
+		}
+		else
+		{
+			status = HAL_SPI_Transmit_DMA(_spi, (uint8_t*)transaction->tx, transaction->len);
+		}
+
+		if (status == HAL_OK)
+		{
+			return;
+		}
+
+		finish(false);
+	}
+}
+
+void Spi_bus::finish(bool success)
+{
+	spi_transaction_t* transaction = _queue[_head];
+	const spi_device_t* device = transaction->device;
+
+	HAL_GPIO_WritePin(device->cs_port, device->cs_pin, GPIO_PIN_SET);
+
+	_head = (_head + 1) % queue_size;
+	_count--;
+
+	transaction->status = success ? SPI_TRANSACTION_DONE : SPI_TRANSACTION_FAILED;
+
+	if (transaction->callback)
+	{
+		transaction->callback(transaction);
+	}
+}
+
+// Only the clock bits change, so a register write is enough instead of a
+// full HAL_SPI_Init. The peripheral has to be disabled while they change,
+// the HAL enables it again on the next transfer.
+void Spi_bus::configure(const spi_device_t* device)
+{
+	const uint32_t mode = device->prescaler | device->polarity | device->phase;
+
+	if (mode == _mode)
+	{
+		return;
+	}
+
+	__HAL_SPI_DISABLE(_spi);
+	_spi->Instance->CR1 = (_spi->Instance->CR1 & ~(SPI_CR1_BR | SPI_CR1_CPOL | SPI_CR1_CPHA)) | mode;
+
+	_spi->Init.BaudRatePrescaler = device->prescaler;
+	_spi->Init.CLKPolarity = device->polarity;
+	_spi->Init.CLKPhase = device->phase;
+	_mode = mode;
+}
+
+void Spi_bus::abort()
+{
+	const uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (_count > 0)
+	{
+		HAL_SPI_Abort(_spi);
+		finish(false);
+		start();
+	}
+
+	__set_PRIMASK(primask);
+}
+
+Spi_bus* Spi_bus::find(SPI_HandleTypeDef* spi)
+{
+	for (uint8_t i = 0; i < _num_instances; i++)
+	{
+		if (_instances[i]->_spi == spi)
+		{
+			return _instances[i];
+		}
+	}
+
+	return nullptr;
+}
+
+void Spi_bus::complete_callback(SPI_HandleTypeDef* spi)
+{
+	Spi_bus* bus = find(spi);
+
+	if (bus && bus->_count > 0)
+	{
+		bus->finish(true);
+		bus->start();
+	}
+}
+
+void Spi_bus::error_callback(SPI_HandleTypeDef* spi)
+{
+	Spi_bus* bus = find(spi);
+
+	if (bus && bus->_count > 0)
+	{
+		bus->finish(false);
+		bus->start();
+	}
+}
+
+bool spi_queue(spi_transaction_t* transaction)
+{
+	Spi_bus* bus = Spi_bus::find(transaction->device->spi);
+	return bus && bus->queue(transaction);
+}
+
+bool spi_wait(spi_transaction_t* transaction)
+{
+	Spi_bus* bus = Spi_bus::find(transaction->device->spi);
+	return bus && bus->wait(transaction);
+}
+
+bool spi_transfer(spi_transaction_t* transaction)
+{
+	Spi_bus* bus = Spi_bus::find(transaction->device->spi);
+	return bus && bus->transfer(transaction);
+}
@@ -0,0 +1,37 @@
+#include "Drivers/timebase.h"
+
+extern TIM_HandleTypeDef htim5;
+
+static uint32_t last_count = 0;
+static uint64_t wraps = 0;
+
+uint64_t timebase_get_us(void)
+{
+	const uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	const uint32_t count = __HAL_TIM_GET_COUNTER(&htim5);
+
+	if (count < last_count)
+	{
+		wraps += (uint64_t)1 << 32;
+	}
+
+	last_count = count;
+	const uint64_t time = wraps | count;
+
+	__set_PRIMASK(primask);
+	return time;
+}
+
+void timebase_init_cycles(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t timebase_get_cycles(void)
+{
+	return DWT->CYCCNT;
+}
@@ -0,0 +1,107 @@
+#include "Drivers/uart_rx.h"
+
+Uart_rx* Uart_rx::_instances[max_instances];
+uint8_t Uart_rx::_num_instances = 0;
+
+Uart_rx::Uart_rx(UART_HandleTypeDef* uart, uint8_t* buffer, uint16_t size)
+{
+	_uart = uart;
+	_buffer = buffer;
+	_size = size;
+
+	if (_num_instances < max_instances)
+	{
+		_instances[_num_instances++] = this;
+	}
+}
+
+// The DMA stream must be set to circular mode
+void Uart_rx::setup()
+{
+	HAL_UARTEx_ReceiveToIdle_DMA(_uart, _buffer, _size);
+}
+
+uint16_t Uart_rx::peek(const uint8_t** data)
+{
+	// Reception restarts at the start of the buffer after an error
+	if (_restarted)
+	{
+		_restarted = false;
+		_tail = 0;
+	}
+
+	const uint16_t head = _head;
+	*data = &_buffer[_tail];
+
+	return head >= _tail ? head - _tail : _size - _tail;
+}
+
+void Uart_rx::consume(uint16_t len)
+{
+	_tail += len;
+
+	if (_tail >= _size)
+	{
+		_tail -= _size;
+	}
+}
+
+void Uart_rx::set_event_callback(void (*callback)(void* context), void* context)
+{
+	_event_context = context;
+	_event_callback = callback;
+}
+
+// pos is the write position, reported as the full size on transfer complete
+void Uart_rx::rx_event(uint16_t pos)
+{
+	_head = pos < _size ? pos : 0;
+	_event_time = timebase_get_us();
+	_event_count++;
+
+	if (_event_callback)
+	{
+		_event_callback(_event_context);
+	}
+}
+
+// The HAL aborts DMA reception on overrun, framing and noise errors
+void Uart_rx::error()
+{
+	_head = 0;
+	_restarted = true;
+	HAL_UARTEx_ReceiveToIdle_DMA(_uart, _buffer, _size);
+}
+
+Uart_rx* Uart_rx::find(UART_HandleTypeDef* uart)
+{
+	for (uint8_t i = 0; i < _num_instances; i++)
+	{
+		if (_instances[i]->_uart == uart)
+		{
+			return _instances[i];
+		}
+	}
+
+	return nullptr;
+}
+
+void Uart_rx::rx_event_callback(UART_HandleTypeDef* uart, uint16_t pos)
+{
+	Uart_rx* rx = find(uart);
+
+	if (rx)
+	{
+		rx->rx_event(pos);
+	}
+}
+
+void Uart_rx::error_callback(UART_HandleTypeDef* uart)
+{
+	Uart_rx* rx = find(uart);
+
+	if (rx)
+	{
+		rx->error();
+	}
+}
@@ -1,19 +1,15 @@
 #include "Drivers/uart_stream.h"
-
-#define RING_BUFFER_SIZE (1024) // Must be a power of 2
-
-static uint8_t data_buffer[RING_BUFFER_SIZE] = {0U};
+#include <cstring>
 
 Uart_stream::Uart_stream(UART_HandleTypeDef* uart)
+	: _rx(uart, rx_buffer, sizeof(rx_buffer))
 {
 	_uart = uart;
-
-	ring_buffer_setup(&ring_buffer, data_buffer, RING_BUFFER_SIZE);
 }
 
 void Uart_stream::setup()
 {
-	HAL_UART_Receive_DMA(_uart, rx_buffer, 1);
+	_rx.setup();
 }
 
 void Uart_stream::transmit(uint8_t tx_buff[], int len)
@@ -21,19 +17,33 @@ void Uart_stream::transmit(uint8_t tx_buff[], int len)
 	HAL_UART_Transmit(_uart, tx_buff, len, 1000);
 }
 
-bool Uart_stream::read_byte(uint8_t* byte)
+uint16_t Uart_stream::read(uint8_t* data, uint16_t len)
 {
-	return ring_buffer_read(&ring_buffer, byte);
+	uint16_t read = 0;
+	const uint8_t* span;
+	uint16_t span_len;
+
+	while (read < len && (span_len = _rx.peek(&span)) > 0)
+	{
+		if (span_len > len - read)
+		{
+			span_len = len - read;
+		}
+
+		memcpy(&data[read], span, span_len);
+		_rx.consume(span_len);
+		read += span_len;
+	}
+
+	return read;
 }
 
-bool Uart_stream::buffer_empty()
+uint16_t Uart_stream::peek(const uint8_t** data)
 {
-	return ring_buffer_empty(&ring_buffer);
+	return _rx.peek(data);
 }
 
-void Uart_stream::dma_complete()
+void Uart_stream::consume(uint16_t len)
 {
-	ring_buffer_write(&ring_buffer, rx_buffer[0]);
-	HAL_UART_Receive_DMA(_uart, rx_buffer, 1);
-//	printf("Uart stream driver: %d\n", rx_buffer[0]);
+	_rx.consume(len);
 }
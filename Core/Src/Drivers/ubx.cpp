@@ -0,0 +1,129 @@
+#include "Drivers/ubx.h"
+
+static uint16_t get_u16(const uint8_t* data)
+{
+	return (uint16_t)data[0] | ((uint16_t)data[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t* data)
+{
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+		   ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+bool Ubx_parser::parse_byte(uint8_t c)
+{
+	switch (parse_state)
+	{
+	case Parse_state::SYNC1:
+		if (c == UBX_SYNC1)
+		{
+			parse_state = Parse_state::SYNC2;
+		}
+		return false;
+	case Parse_state::SYNC2:
+		if (c == UBX_SYNC2)
+		{
+			ck_a = 0;
+			ck_b = 0;
+			parse_state = Parse_state::CLASS;
+		}
+		else if (c != UBX_SYNC1)
+		{
+			parse_state = Parse_state::SYNC1;
+		}
+		return false;
+	case Parse_state::CK_A:
+		parse_state = c == ck_a ? Parse_state::CK_B : Parse_state::SYNC1;
+		return false;
+	case Parse_state::CK_B:
+		parse_state = Parse_state::SYNC1;
+		return c == ck_b;
+	default:
+		break;
+	}
+
+	ck_a += c;
+	ck_b += ck_a;
+
+	switch (parse_state)
+	{
+	case Parse_state::CLASS:
+		msg_class = c;
+		parse_state = Parse_state::ID;
+		break;
+	case Parse_state::ID:
+		msg_id = c;
+		parse_state = Parse_state::LEN1;
+		break;
+	case Parse_state::LEN1:
+		msg_len = c;
+		parse_state = Parse_state::LEN2;
+		break;
+	case Parse_state::LEN2:
+		msg_len |= (uint16_t)c << 8;
+		payload_index = 0;
+
+		// Nothing needed is this long, skip it and sync on the next message
+		if (msg_len > max_payload_len)
+		{
+			parse_state = Parse_state::SYNC1;
+		}
+		else
+		{
+			parse_state = msg_len > 0 ? Parse_state::PAYLOAD : Parse_state::CK_A;
+		}
+		break;
+	case Parse_state::PAYLOAD:
+		payload[payload_index++] = c;
+
+		if (payload_index == msg_len)
+		{
+			parse_state = Parse_state::CK_A;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return false;
+}
+
+bool Ubx_parser::decode_nav_pvt(Ubx_nav_pvt* pvt) const
+{
+	if (msg_class != UBX_CLASS_NAV || msg_id != UBX_NAV_PVT || msg_len < UBX_NAV_PVT_LEN)
+	{
+		return false;
+	}
+
+	const uint8_t valid = payload[11];
+	const uint8_t fix_type = payload[20];
+	const uint8_t flags = payload[21];
+
+	// Date and time both valid and fully resolved
+	if ((valid & 0x07) == 0x07)
+	{
+		pvt->year = get_u16(&payload[4]);
+		pvt->month = payload[6];
+		pvt->day = payload[7];
+		pvt->hours = payload[8];
+		pvt->minutes = payload[9];
+		pvt->seconds = payload[10];
+	}
+
+	// 3D or GNSS + dead reckoning, with gnssFixOK
+	pvt->fix = (fix_type == 3 || fix_type == 4) && (flags & 0x01);
+	pvt->sats = payload[23];
+
+	pvt->lon = (int32_t)get_u32(&payload[24]);
+	pvt->lat = (int32_t)get_u32(&payload[28]);
+	pvt->alt = (int32_t)get_u32(&payload[36]) * 1E-3f;
+	pvt->h_acc = get_u32(&payload[40]) * 1E-3f;
+	pvt->v_acc = get_u32(&payload[44]) * 1E-3f;
+	pvt->vel_n = (int32_t)get_u32(&payload[48]) * 1E-3f;
+	pvt->vel_e = (int32_t)get_u32(&payload[52]) * 1E-3f;
+	pvt->vel_d = (int32_t)get_u32(&payload[56]) * 1E-3f;
+	pvt->s_acc = get_u32(&payload[68]) * 1E-3f;
+
+	return true;
+}
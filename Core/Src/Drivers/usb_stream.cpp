@@ -1,12 +1,8 @@
 #include "Drivers/usb_stream.h"
 
-#define RING_BUFFER_SIZE (1024) // Must be a power of 2
-
-static uint8_t data_buffer[RING_BUFFER_SIZE] = {0U};
-
 USB_stream::USB_stream()
 {
-	ring_buffer_setup(&ring_buffer, data_buffer, RING_BUFFER_SIZE);
+	ring_buffer_setup(&ring_buffer, data_buffer, sizeof(data_buffer));
 }
 
 void USB_stream::transmit(uint8_t tx_buff[], int len)
@@ -25,20 +21,26 @@ void USB_stream::transmit(uint8_t tx_buff[], int len)
 	CDC_Transmit_FS(tx_buff, len);
 }
 
-bool USB_stream::read_byte(uint8_t* byte)
+uint16_t USB_stream::read(uint8_t* data, uint16_t len)
 {
-	return ring_buffer_read(&ring_buffer, byte);
+	return ring_buffer_read_bytes(&ring_buffer, data, len);
 }
 
-void USB_stream::rx_callback(uint8_t* Buf, uint32_t Len)
+uint16_t USB_stream::peek(const uint8_t** data)
+{
+	uint8_t* span;
+	uint16_t len = ring_buffer_peek(&ring_buffer, &span);
+	*data = span;
+
+	return len;
+}
+
+void USB_stream::consume(uint16_t len)
 {
-	for (uint32_t i = 0; i < Len; i++)
-	{
-		ring_buffer_write(&ring_buffer, Buf[i]);
-	}
+	ring_buffer_consume(&ring_buffer, len);
 }
 
-bool USB_stream::buffer_empty()
+void USB_stream::rx_callback(uint8_t* Buf, uint32_t Len)
 {
-	return ring_buffer_empty(&ring_buffer);
+	ring_buffer_write_bytes(&ring_buffer, Buf, Len);
 }
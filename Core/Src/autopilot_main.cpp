@@ -2,11 +2,54 @@
 #include "autopilot_main.h"
 #include "autopilot.h"
 
+#ifdef AUTOPILOT_BENCH
+#include "bench/bench.h"
+#include "Drivers/timebase.h"
+#include <stdio.h>
+
+// DWT cycles, extended to 64 bits between calls. Results go out over SWO.
+class Target_bench_platform : public Bench_platform
+{
+public:
+	Target_bench_platform()
+	{
+		timebase_init_cycles();
+		_last = timebase_get_cycles();
+	}
+
+	uint64_t get_ticks() override
+	{
+		const uint32_t now = timebase_get_cycles();
+		_ticks += (uint32_t)(now - _last);
+		_last = now;
+		return _ticks;
+	}
+
+	const char* get_tick_unit() override { return "cycles"; }
+
+	void print(const char* str) override { fputs(str, stdout); fflush(stdout); }
+
+private:
+	uint32_t _last = 0;
+	uint64_t _ticks = 0;
+};
+#endif
+
 void autopilot_main_c()
 {
+#ifdef AUTOPILOT_BENCH
+	// Benchmark build instead of the flight code
+	Target_bench_platform platform;
+	Bench bench(&platform, BENCH_FORMAT_CSV);
+
+	bench.begin();
+	bench_run_libs(&bench);
+	bench.end();
+#else
 	AutopilotHAL hal; // Maybe declare this outside the function because after function completes, it gets destroyed and when interrupt calls it hardfault because its already destroyed
 	Autopilot autopilot(&hal);
 	autopilot.setup();
+#endif
 
 	// Bug: Hardfault handler when this removed
 	while (1);
@@ -0,0 +1,197 @@
+#ifndef INC_LINUX_HAL_H_
+#define INC_LINUX_HAL_H_
+
+#include <lib/hal/hal.h>
+#include <deque>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Samples pushed by the simulation, handed out in order once the simulated
+// clock reaches their timestamp
+template <typename T>
+class Sensor_feed
+{
+public:
+	void push(const T& sample) { _samples.push_back(sample); }
+
+	bool pop(uint64_t time_us, T* sample)
+	{
+		if (_samples.empty() || _samples.front().timestamp > time_us)
+		{
+			return false;
+		}
+
+		*sample = _samples.front();
+		_samples.pop_front();
+		return true;
+	}
+
+	// Timestamp of the next sample, UINT64_MAX if there is none
+	uint64_t next_time() const { return _samples.empty() ? UINT64_MAX : _samples.front().timestamp; }
+
+	void clear() { _samples.clear(); }
+
+private:
+	std::deque<T> _samples;
+};
+
+// File descriptor backed byte stream with the peek and consume access of
+// the firmware streams. Reads never block.
+class Fd_stream
+{
+public:
+	~Fd_stream();
+
+	bool open_pty(); // Prints the slave path to connect to
+	void set_fd(int fd) { _fd = fd; }
+	void close();
+
+	void transmit(const uint8_t* data, int len);
+	uint16_t read(uint8_t* data, uint16_t len);
+	uint16_t peek(const uint8_t** data);
+	void consume(uint16_t len);
+
+private:
+	int _fd = -1;
+	std::vector<uint8_t> _rx;
+
+	void poll();
+};
+
+struct Pwm_output
+{
+	uint16_t duty[6] = {}; // Elevator, rudder, throttle, aux 1-3, us
+	uint64_t timestamp = 0;
+};
+
+/**
+ * HAL for running the autopilot in a plain Linux process
+ *
+ * The clock is simulated and only moves when the simulation calls
+ * run_until(), so the flight code runs as fast as the CPU allows. Tasks
+ * are scheduled like on the board: the main task every 10 ms and the fast
+ * task on every IMU sample, or after the main task if samples stop.
+ *
+ * In lockstep HITL the simulator on the USB descriptor owns the clock and
+ * run_until() only runs the main task once to take its steps.
+ *
+ * Sensor samples come from in memory feeds filled by the caller, the
+ * outputs are read back with get_pwm(). Telemetry goes over a pty or any
+ * file descriptor, the SD card is a directory.
+ */
+class LinuxHAL : public HAL
+{
+public:
+	LinuxHAL(const std::string& sd_dir);
+	~LinuxHAL();
+
+	// Setup, before Autopilot::setup()
+	void set_telem_pty(bool enable) { _telem_pty = enable; }
+	void set_telem_fd(int fd) { _telem.set_fd(fd); }
+	void set_usb_fd(int fd) { _usb.set_fd(fd); }
+
+	// Simulation
+	void run_until(uint64_t time_us);
+	void push_imu(const IMU_data& imu) { _imu_feed.push(imu); }
+	void push_mag(const Mag_data& mag) { _mag_feed.push(mag); }
+	void push_baro(const Baro_data& baro) { _baro_feed.push(baro); }
+	void push_gnss(const GNSS_data& gnss) { _gnss_feed.push(gnss); }
+	void push_optical_flow(const OF_data& of) { _of_feed.push(of); }
+	void push_power(const Power_data& power) { _power_feed.push(power); }
+	void push_rc(const uint16_t channels[], uint8_t num_channels);
+	const Pwm_output& get_pwm() const { return _pwm; }
+	uint64_t get_fast_task_count() const { return _fast_task_count; }
+
+	// linux_hal.cpp
+	void init() override;
+	void debug_print(char* str) override;
+	void toggle_led() override;
+
+	// sensors_hal.cpp
+	bool read_imu(float *ax, float *ay, float *az, float *gx, float *gy, float *gz, uint64_t *timestamp) override;
+	bool read_mag(float *mx, float *my, float *mz, uint64_t *timestamp) override;
+	bool read_baro(float *alt, float *pressure, float *temperature, uint64_t *timestamp) override;
+	bool read_gnss(GNSS_data* gnss) override;
+	bool read_optical_flow(int16_t *x, int16_t *y) override;
+	bool read_power_monitor(float *voltage, float* current) override;
+	void get_rc_input(uint16_t duty[], uint8_t num_channels) override;
+
+	// comms_hal.cpp
+	void transmit_telem(uint8_t tx_buff[], int len) override;
+	uint16_t read_telem(uint8_t* data, uint16_t len) override;
+	uint16_t peek_telem(const uint8_t** data) override;
+	void consume_telem(uint16_t len) override;
+	void usb_transmit(uint8_t buf[], int len) override;
+	uint16_t usb_read(uint8_t* data, uint16_t len) override;
+	uint16_t usb_peek(const uint8_t** data) override;
+	void usb_consume(uint16_t len) override;
+
+	// storage_hal.cpp
+	void create_file(char name[], uint8_t len) override;
+	uint16_t write_storage(const uint8_t* data, uint16_t len) override;
+	bool read_mission_file(uint8_t file, uint32_t offset, void* data, uint32_t len) override;
+	bool write_mission_file(uint8_t file, uint32_t offset, const void* data, uint32_t len) override;
+	bool mission_file_ready(bool* success) override;
+
+	// control_hal.cpp
+	void set_pwm(uint16_t ele_duty, uint16_t rud_duty, uint16_t thr_duty,
+				 uint16_t aux1_duty, uint16_t aux2_duty, uint16_t aux3_duty) override;
+	void set_pwm_rate(Pwm_group group, uint16_t rate_hz) override;
+	void set_rc_passthrough(const Rc_passthrough* passthrough) override;
+
+	// linux_hal.cpp
+	void delay_us(uint64_t us) override;
+	uint64_t get_time_us() const override;
+	uint32_t get_cycle_count() const override;
+	void set_sim_time(uint64_t time_us) override;
+	void set_main_task(void (*task)(void* context), void* context) override;
+	void set_fast_task(void (*task)(void* context), void* context, bool imu_sync) override;
+
+private:
+	static constexpr uint64_t MAIN_TASK_PERIOD_US = 10000;
+	static constexpr uint64_t IMU_SYNC_TIMEOUT_US = 20000; // Same as the board
+	static constexpr uint8_t NUM_RC_CHANNELS = 16;
+
+	uint64_t _time_us = 0;
+	bool _lockstep = false;
+
+	// Scheduler
+	void (*_main_task)(void* context) = nullptr;
+	void* _main_context = nullptr;
+	void (*_fast_task)(void* context) = nullptr;
+	void* _fast_context = nullptr;
+	bool _imu_sync = false;
+	uint64_t _next_main_time = 0;
+	uint64_t _last_imu_time = 0;
+	uint64_t _fast_task_count = 0;
+
+	// Sensors
+	Sensor_feed<IMU_data> _imu_feed;
+	Sensor_feed<Mag_data> _mag_feed;
+	Sensor_feed<Baro_data> _baro_feed;
+	Sensor_feed<GNSS_data> _gnss_feed;
+	Sensor_feed<OF_data> _of_feed;
+	Sensor_feed<Power_data> _power_feed;
+	uint16_t _rc[NUM_RC_CHANNELS] = {};
+
+	// Comms
+	bool _telem_pty = false;
+	Fd_stream _telem;
+	Fd_stream _usb;
+
+	// Storage
+	std::string _sd_dir;
+	FILE* _log_file = nullptr;
+	bool _mission_success = false;
+
+	// Outputs
+	Pwm_output _pwm;
+	uint16_t _pwm_rate[PWM_GROUP_COUNT] = {};
+	Rc_passthrough _passthrough{};
+	bool _passthrough_enabled = false;
+
+	std::string sd_path(const std::string& name) const { return _sd_dir + "/" + name; }
+};
+
+#endif /* INC_LINUX_HAL_H_ */
@@ -0,0 +1,72 @@
+#ifndef INC_LOG_INDEX_LOG_INDEX_H_
+#define INC_LOG_INDEX_LOG_INDEX_H_
+
+#include "Log_index/log_schema.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Whole file memory map, read only or created read write at a fixed size
+class Mapped_file
+{
+public:
+	~Mapped_file();
+
+	bool open_read(const std::string& path);
+	bool create(const std::string& path, size_t size);
+	void close();
+
+	uint8_t* data() const { return _data; }
+	size_t size() const { return _size; }
+
+private:
+	int _fd = -1;
+	uint8_t* _data = nullptr;
+	size_t _size = 0;
+};
+
+struct Message_stats
+{
+	uint64_t count = 0;
+	uint64_t start_us = 0;
+	uint64_t end_us = 0;
+	bool sorted = true; // time_us never decreases, queries can binary search
+};
+
+struct Index_stats
+{
+	uint64_t frames = 0;
+	uint64_t unknown_frames = 0; // Valid frames without a schema, not exported
+	uint64_t skipped_bytes = 0; // Outside any valid frame
+	uint32_t rescans = 0; // Chunks that started inside a frame and were scanned again
+	Message_stats messages[256]; // By message id
+	double scan_s = 0;
+	double write_s = 0;
+};
+
+/**
+ * Splits a log into columns, one directory per message and one file per
+ * field
+ *
+ * Each thread takes an equal chunk of the file and walks it frame by frame
+ * from the first CRC checked frame at or after its start, like the serial
+ * parser would. A chunk normally starts in the middle of a frame owned by
+ * the chunk before, its first valid frame is then where the previous walk
+ * ended. If they disagree the chunk is scanned again from there, so the
+ * frames found are the same as in a single pass. The column files are
+ * sized from the counts and filled in parallel through memory maps.
+ *
+ * Columns are raw little endian arrays, time_us.bin of each message is the
+ * time index. manifest.json lists the messages, counts and column types.
+ */
+bool log_export(const uint8_t* data, size_t size, const std::string& out_dir, unsigned threads, Index_stats* stats);
+
+// Rows of message with time_us in [from_us, to_us) as CSV on out, binary
+// searched on the time index, or a scan of every row if the manifest says it
+// is not sorted. All columns if columns is empty.
+bool log_query(const std::string& dir, const Message_def* message, uint64_t from_us, uint64_t to_us,
+			   const std::vector<const Column_def*>& columns, FILE* out, uint64_t* rows);
+
+#endif /* INC_LOG_INDEX_LOG_INDEX_H_ */
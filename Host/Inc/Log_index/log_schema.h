@@ -0,0 +1,47 @@
+#ifndef INC_LOG_INDEX_LOG_SCHEMA_H_
+#define INC_LOG_INDEX_LOG_SCHEMA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum Column_type
+{
+	COLUMN_U8,
+	COLUMN_U16,
+	COLUMN_I16,
+	COLUMN_U32,
+	COLUMN_I32,
+	COLUMN_U64,
+	COLUMN_F32
+};
+
+struct Column_def
+{
+	const char* name;
+	uint16_t offset; // In the payload
+	Column_type type;
+};
+
+// Layout of one APLink message as written to the log, taken from the
+// packed structs in aplink_messages.h. Every logged message starts with
+// time_us, which becomes the index of its columns.
+struct Message_def
+{
+	uint8_t msg_id;
+	const char* name;
+	uint16_t payload_len;
+	const Column_def* columns;
+	uint8_t num_columns;
+};
+
+extern const Message_def LOG_MESSAGES[];
+extern const uint8_t LOG_NUM_MESSAGES;
+
+const Message_def* log_find_message(uint8_t msg_id);
+const Message_def* log_find_message(const char* name);
+const Column_def* log_find_column(const Message_def* message, const char* name);
+
+uint8_t column_size(Column_type type);
+const char* column_type_name(Column_type type); // numpy dtype, "u1", "f4"...
+
+#endif /* INC_LOG_INDEX_LOG_SCHEMA_H_ */
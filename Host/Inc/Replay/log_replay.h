@@ -0,0 +1,74 @@
+#ifndef INC_REPLAY_LOG_REPLAY_H_
+#define INC_REPLAY_LOG_REPLAY_H_
+
+#include "Linux_HAL/linux_hal.h"
+#include "modules/ahrs/ahrs.h"
+#include "modules/position_estimator/position_estimator.h"
+#include <stddef.h>
+#include <string>
+
+struct Replay_result
+{
+	uint64_t records = 0;
+	uint64_t imu_records = 0;
+	uint64_t ticks = 0;
+	uint64_t start_us = 0;
+	uint64_t end_us = 0;
+	bool from_boot = false; // Nothing was discarded before the first tick
+	uint64_t gaps = 0; // Ticks after which the recorder discarded records
+	uint64_t attitude_checks = 0; // Ticks with a flight log record to compare with
+	uint64_t attitude_matches = 0; // Of those, bit-exact roll, pitch and yaw
+};
+
+/**
+ * Runs AHRS and PositionEstimator on a recorded sensor log
+ *
+ * The log is what SensorLog writes: the sensor topics of the data bus as
+ * APLink records, with a LOG_TICK wherever the main task ran. Records are
+ * published into a private DataBus in file order with the clock set to
+ * their time. AHRS runs on every IMU record like in the fast task and
+ * PositionEstimator on every tick, so with the parameters of the flight the
+ * outputs are the ones computed on board, bit for bit.
+ *
+ * Flight log records in the same file carry the attitude Storage saw on
+ * board, each tick compares the replayed attitude against it.
+ *
+ * One replay per log, everything is reset by constructing a new one.
+ */
+class Log_replay
+{
+public:
+	Log_replay(const param_context_t& params);
+
+	// Appends one CSV row per tick to out, without a header. Formatting
+	// takes about as long as the replay, out can be null to skip it.
+	Replay_result run(const uint8_t* data, size_t len, std::string* out);
+
+	static const char* csv_header();
+
+private:
+	LinuxHAL _hal;
+	DataBus _data_bus;
+	param_context_t _params;
+
+	AHRS _ahrs;
+	PositionEstimator _position_estimator;
+
+	Publisher<IMU_data> _imu_pub;
+	Publisher<Mag_data> _mag_pub;
+	Publisher<Baro_data> _baro_pub;
+	Publisher<GNSS_data> _gnss_pub;
+	Publisher<OF_data> _of_pub;
+	Publisher<Modes_data> _modes_pub;
+	Subscriber<AHRS_data> _ahrs_sub;
+	Subscriber<local_position_s> _local_pos_sub;
+
+	aplink_flight_log_t _flight_log{};
+	bool _flight_log_pending = false;
+	uint32_t _dropped_bytes = 0;
+
+	void handle(aplink_msg_t* msg, Replay_result* result, std::string* out);
+	void handle_tick(const aplink_log_tick_t& tick, Replay_result* result, std::string* out);
+};
+
+#endif /* INC_REPLAY_LOG_REPLAY_H_ */
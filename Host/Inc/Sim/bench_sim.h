@@ -0,0 +1,51 @@
+#ifndef INC_SIM_BENCH_SIM_H_
+#define INC_SIM_BENCH_SIM_H_
+
+#include "Linux_HAL/linux_hal.h"
+
+/**
+ * Vehicle sitting level on the bench, facing north
+ *
+ * Feeds every sensor at the rate of the real driver with a little
+ * deterministic noise, plus RC frames with the sticks centered and the
+ * throttle low, so the autopilot gets through startup exactly as on the
+ * board. Optional gyro vibration gives the IMU filters something to do.
+ */
+class Bench_sim
+{
+public:
+	// Sensor periods of the board, us
+	static constexpr uint64_t IMU_PERIOD = 2000;
+	static constexpr uint64_t MAG_PERIOD = 10000;
+	static constexpr uint64_t BARO_PERIOD = 20000;
+	static constexpr uint64_t GNSS_PERIOD = 100000;
+	static constexpr uint64_t POWER_PERIOD = 100000;
+	static constexpr uint64_t RC_PERIOD = 14000;
+
+	Bench_sim(LinuxHAL* hal);
+
+	void set_vibration(float freq, float amplitude) { _vib_freq = freq; _vib_amplitude = amplitude; }
+	void set_rc(uint8_t channel, uint16_t value);
+
+	// Pushes every sample due before time_us
+	void step_to(uint64_t time_us);
+
+private:
+	static constexpr uint8_t NUM_RC_CHANNELS = 16;
+
+	LinuxHAL* _hal;
+	uint64_t _next_imu = 0;
+	uint64_t _next_mag = 0;
+	uint64_t _next_baro = 0;
+	uint64_t _next_gnss = 0;
+	uint64_t _next_power = 0;
+	uint64_t _next_rc = 0;
+	uint32_t _seed = 1;
+	float _vib_freq = 0;
+	float _vib_amplitude = 0;
+	uint16_t _rc[NUM_RC_CHANNELS];
+
+	float noise(float amplitude);
+};
+
+#endif /* INC_SIM_BENCH_SIM_H_ */
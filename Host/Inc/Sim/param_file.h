@@ -0,0 +1,11 @@
+#ifndef INC_SIM_PARAM_FILE_H_
+#define INC_SIM_PARAM_FILE_H_
+
+#include <lib/parameters/params.h>
+
+// Sets parameters from a text file with one "NAME VALUE" per line, # starts
+// a comment. Returns the number of parameters set, -1 if the file could not
+// be read. Unknown names are reported and skipped.
+int param_load_file(param_context_t* params, const char* path);
+
+#endif /* INC_SIM_PARAM_FILE_H_ */
@@ -0,0 +1,139 @@
+#include "Linux_HAL/linux_hal.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+Fd_stream::~Fd_stream()
+{
+	close();
+}
+
+bool Fd_stream::open_pty()
+{
+	const int fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+	if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0)
+	{
+		printf("Cannot open telemetry pty\n");
+
+		if (fd >= 0)
+		{
+			::close(fd);
+		}
+
+		return false;
+	}
+
+	printf("Telemetry on %s\n", ptsname(fd));
+	_fd = fd;
+	return true;
+}
+
+void Fd_stream::close()
+{
+	if (_fd >= 0)
+	{
+		::close(_fd);
+		_fd = -1;
+	}
+}
+
+// Nothing connected drops the data, like the radio with no ground station
+void Fd_stream::transmit(const uint8_t* data, int len)
+{
+	if (_fd >= 0 && len > 0)
+	{
+		if (::write(_fd, data, len) < 0)
+		{
+			return;
+		}
+	}
+}
+
+void Fd_stream::poll()
+{
+	if (_fd < 0)
+	{
+		return;
+	}
+
+	uint8_t buffer[256];
+	ssize_t len;
+
+	while ((len = ::read(_fd, buffer, sizeof(buffer))) > 0)
+	{
+		_rx.insert(_rx.end(), buffer, buffer + len);
+	}
+}
+
+uint16_t Fd_stream::read(uint8_t* data, uint16_t len)
+{
+	const uint8_t* span;
+	uint16_t total = 0;
+	uint16_t available;
+
+	while (total < len && (available = peek(&span)) > 0)
+	{
+		const uint16_t n = available < len - total ? available : len - total;
+		memcpy(data + total, span, n);
+		consume(n);
+		total += n;
+	}
+
+	return total;
+}
+
+uint16_t Fd_stream::peek(const uint8_t** data)
+{
+	poll();
+
+	*data = _rx.data();
+	return _rx.size() < UINT16_MAX ? _rx.size() : UINT16_MAX;
+}
+
+void Fd_stream::consume(uint16_t len)
+{
+	_rx.erase(_rx.begin(), _rx.begin() + (len < _rx.size() ? len : _rx.size()));
+}
+
+void LinuxHAL::transmit_telem(uint8_t tx_buff[], int len)
+{
+	_telem.transmit(tx_buff, len);
+}
+
+uint16_t LinuxHAL::read_telem(uint8_t* data, uint16_t len)
+{
+	return _telem.read(data, len);
+}
+
+uint16_t LinuxHAL::peek_telem(const uint8_t** data)
+{
+	return _telem.peek(data);
+}
+
+void LinuxHAL::consume_telem(uint16_t len)
+{
+	_telem.consume(len);
+}
+
+// No USB on the host unless a descriptor is given, the stream stays empty
+void LinuxHAL::usb_transmit(uint8_t buf[], int len)
+{
+	_usb.transmit(buf, len);
+}
+
+uint16_t LinuxHAL::usb_read(uint8_t* data, uint16_t len)
+{
+	return _usb.read(data, len);
+}
+
+uint16_t LinuxHAL::usb_peek(const uint8_t** data)
+{
+	return _usb.peek(data);
+}
+
+void LinuxHAL::usb_consume(uint16_t len)
+{
+	_usb.consume(len);
+}
@@ -0,0 +1,31 @@
+#include "Linux_HAL/linux_hal.h"
+
+void LinuxHAL::set_pwm(uint16_t ele_duty, uint16_t rud_duty, uint16_t thr_duty,
+					   uint16_t aux1_duty, uint16_t aux2_duty, uint16_t aux3_duty)
+{
+	_pwm.duty[0] = ele_duty;
+	_pwm.duty[1] = rud_duty;
+	_pwm.duty[2] = thr_duty;
+	_pwm.duty[3] = aux1_duty;
+	_pwm.duty[4] = aux2_duty;
+	_pwm.duty[5] = aux3_duty;
+	_pwm.timestamp = _time_us;
+}
+
+void LinuxHAL::set_pwm_rate(Pwm_group group, uint16_t rate_hz)
+{
+	if (group < PWM_GROUP_COUNT)
+	{
+		_pwm_rate[group] = rate_hz;
+	}
+}
+
+void LinuxHAL::set_rc_passthrough(const Rc_passthrough* passthrough)
+{
+	if (passthrough)
+	{
+		_passthrough = *passthrough;
+	}
+
+	_passthrough_enabled = passthrough != nullptr;
+}
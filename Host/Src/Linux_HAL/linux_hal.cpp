@@ -0,0 +1,144 @@
+#include "Linux_HAL/linux_hal.h"
+#include <chrono>
+#include <errno.h>
+#include <sys/stat.h>
+
+LinuxHAL::LinuxHAL(const std::string& sd_dir)
+	: _sd_dir(sd_dir)
+{
+}
+
+LinuxHAL::~LinuxHAL()
+{
+	if (_log_file)
+	{
+		fclose(_log_file);
+	}
+}
+
+void LinuxHAL::init()
+{
+	printf("HAL init\n");
+
+	if (mkdir(_sd_dir.c_str(), 0755) != 0 && errno != EEXIST)
+	{
+		printf("Cannot create SD directory %s\n", _sd_dir.c_str());
+	}
+
+	if (_telem_pty)
+	{
+		_telem.open_pty();
+	}
+
+	printf("HAL init done\n");
+}
+
+void LinuxHAL::debug_print(char* str)
+{
+	fputs(str, stdout);
+}
+
+void LinuxHAL::toggle_led()
+{
+}
+
+// Simulated, only moves in run_until() and delay_us()
+uint64_t LinuxHAL::get_time_us() const
+{
+	return _time_us;
+}
+
+// Host time in ns, the same role as the cycle counter for profiling
+uint32_t LinuxHAL::get_cycle_count() const
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LinuxHAL::delay_us(uint64_t us)
+{
+	_time_us += us;
+}
+
+void LinuxHAL::set_sim_time(uint64_t time_us)
+{
+	_time_us = time_us;
+	_lockstep = true;
+}
+
+void LinuxHAL::set_main_task(void (*task)(void* context), void* context)
+{
+	_main_task = task;
+	_main_context = context;
+	_next_main_time = _time_us + MAIN_TASK_PERIOD_US;
+}
+
+void LinuxHAL::set_fast_task(void (*task)(void* context), void* context, bool imu_sync)
+{
+	_fast_task = task;
+	_fast_context = context;
+	_imu_sync = imu_sync;
+}
+
+// Runs every task due up to time_us in time order. With IMU sync each IMU
+// sample starts the fast task at its timestamp, like the data ready
+// interrupt. The main task runs the fast task itself once samples stop.
+void LinuxHAL::run_until(uint64_t time_us)
+{
+	if (_lockstep)
+	{
+		if (_main_task)
+		{
+			_main_task(_main_context);
+		}
+
+		return;
+	}
+
+	while (true)
+	{
+		const uint64_t next_imu = _imu_sync && _fast_task ? _imu_feed.next_time() : UINT64_MAX;
+		const uint64_t next_main = _main_task ? _next_main_time : UINT64_MAX;
+		const uint64_t next = next_imu < next_main ? next_imu : next_main;
+
+		if (next > time_us)
+		{
+			break;
+		}
+
+		if (next > _time_us)
+		{
+			_time_us = next;
+		}
+
+		if (next_imu <= next_main)
+		{
+			_last_imu_time = next_imu;
+			_fast_task(_fast_context);
+			_fast_task_count++;
+
+			// A task that did not read the sample must not stall the loop
+			if (_imu_feed.next_time() == next_imu)
+			{
+				IMU_data unread;
+				_imu_feed.pop(next_imu, &unread);
+			}
+		}
+		else
+		{
+			_next_main_time += MAIN_TASK_PERIOD_US;
+			_main_task(_main_context);
+
+			if (_fast_task && !_lockstep && (!_imu_sync || _time_us - _last_imu_time >= IMU_SYNC_TIMEOUT_US))
+			{
+				_fast_task(_fast_context);
+				_fast_task_count++;
+			}
+		}
+	}
+
+	if (time_us > _time_us)
+	{
+		_time_us = time_us;
+	}
+}
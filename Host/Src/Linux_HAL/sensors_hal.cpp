@@ -0,0 +1,116 @@
+#include "Linux_HAL/linux_hal.h"
+
+bool LinuxHAL::read_imu(float *ax, float *ay, float *az, float *gx, float *gy, float *gz, uint64_t *timestamp)
+{
+	IMU_data imu;
+
+	if (!_imu_feed.pop(_time_us, &imu))
+	{
+		return false;
+	}
+
+	*ax = imu.ax;
+	*ay = imu.ay;
+	*az = imu.az;
+	*gx = imu.gx;
+	*gy = imu.gy;
+	*gz = imu.gz;
+	*timestamp = imu.timestamp;
+	return true;
+}
+
+bool LinuxHAL::read_mag(float *mx, float *my, float *mz, uint64_t *timestamp)
+{
+	Mag_data mag;
+
+	if (!_mag_feed.pop(_time_us, &mag))
+	{
+		return false;
+	}
+
+	*mx = mag.x;
+	*my = mag.y;
+	*mz = mag.z;
+	*timestamp = mag.timestamp;
+	return true;
+}
+
+bool LinuxHAL::read_baro(float *alt, float *pressure, float *temperature, uint64_t *timestamp)
+{
+	Baro_data baro;
+
+	if (!_baro_feed.pop(_time_us, &baro))
+	{
+		return false;
+	}
+
+	*alt = baro.alt;
+	*pressure = baro.pressure;
+	*temperature = baro.temperature;
+	*timestamp = baro.timestamp;
+	return true;
+}
+
+bool LinuxHAL::read_gnss(GNSS_data* gnss)
+{
+	return _gnss_feed.pop(_time_us, gnss);
+}
+
+bool LinuxHAL::read_optical_flow(int16_t *x, int16_t *y)
+{
+	OF_data of;
+
+	if (!_of_feed.pop(_time_us, &of))
+	{
+		return false;
+	}
+
+	*x = of.x;
+	*y = of.y;
+	return true;
+}
+
+bool LinuxHAL::read_power_monitor(float *voltage, float* current)
+{
+	Power_data power;
+
+	if (!_power_feed.pop(_time_us, &power))
+	{
+		return false;
+	}
+
+	*voltage = power.batt_voltage;
+	*current = power.batt_current;
+	return true;
+}
+
+// Stands in for an SBUS frame, so the passthrough runs here like in the
+// receiver interrupt
+void LinuxHAL::push_rc(const uint16_t channels[], uint8_t num_channels)
+{
+	for (uint8_t i = 0; i < num_channels && i < NUM_RC_CHANNELS; i++)
+	{
+		_rc[i] = channels[i];
+	}
+
+	if (!_passthrough_enabled || _rc[_passthrough.thr_ch] <= _passthrough.conn_threshold)
+	{
+		return;
+	}
+
+	_pwm.duty[0] = _passthrough.ele.apply(_rc[_passthrough.ele_ch]);
+	_pwm.duty[1] = _passthrough.rud.apply(_rc[_passthrough.rud_ch]);
+	_pwm.duty[2] = _passthrough.thr.apply(_rc[_passthrough.thr_ch]);
+	_pwm.duty[3] = 0;
+	_pwm.duty[4] = 0;
+	_pwm.duty[5] = 0;
+	_pwm.timestamp = _time_us;
+}
+
+void LinuxHAL::get_rc_input(uint16_t duty[], uint8_t num_channels)
+{
+	for (uint8_t i = 0; i < num_channels; i++)
+	{
+		duty[i] = i < NUM_RC_CHANNELS ? _rc[i] : 0;
+	}
+}
@@ -0,0 +1,70 @@
+#include "Linux_HAL/linux_hal.h"
+
+// The log goes straight to the file, the directory stands in for the card
+void LinuxHAL::create_file(char name[], uint8_t len)
+{
+	if (_log_file)
+	{
+		return;
+	}
+
+	const std::string path = sd_path(std::string(name, len));
+	_log_file = fopen(path.c_str(), "wb");
+
+	if (!_log_file)
+	{
+		printf("Cannot create log file %s\n", path.c_str());
+	}
+}
+
+uint16_t LinuxHAL::write_storage(const uint8_t* data, uint16_t len)
+{
+	if (!_log_file)
+	{
+		return 0;
+	}
+
+	return fwrite(data, 1, len, _log_file);
+}
+
+// Requests complete at once, mission_file_ready() reports the result
+bool LinuxHAL::read_mission_file(uint8_t file, uint32_t offset, void* data, uint32_t len)
+{
+	const std::string path = sd_path("mission" + std::to_string(file) + ".bin");
+	FILE* f = fopen(path.c_str(), "rb");
+
+	_mission_success = f && fseek(f, offset, SEEK_SET) == 0 && fread(data, 1, len, f) == len;
+
+	if (f)
+	{
+		fclose(f);
+	}
+
+	return true;
+}
+
+bool LinuxHAL::write_mission_file(uint8_t file, uint32_t offset, const void* data, uint32_t len)
+{
+	const std::string path = sd_path("mission" + std::to_string(file) + ".bin");
+	FILE* f = fopen(path.c_str(), "r+b");
+
+	if (!f)
+	{
+		f = fopen(path.c_str(), "w+b");
+	}
+
+	_mission_success = f && fseek(f, offset, SEEK_SET) == 0 && fwrite(data, 1, len, f) == len;
+
+	if (f)
+	{
+		fclose(f);
+	}
+
+	return true;
+}
+
+bool LinuxHAL::mission_file_ready(bool* success)
+{
+	*success = _mission_success;
+	return true;
+}
@@ -0,0 +1,516 @@
+#include "Log_index/log_index.h"
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+extern "C"
+{
+#include "lib/aplink_c/aplink.h"
+}
+
+Mapped_file::~Mapped_file()
+{
+	close();
+}
+
+bool Mapped_file::open_read(const std::string& path)
+{
+	close();
+
+	_fd = ::open(path.c_str(), O_RDONLY);
+	struct stat st;
+
+	if (_fd < 0 || fstat(_fd, &st) != 0)
+	{
+		close();
+		return false;
+	}
+
+	_size = st.st_size;
+
+	if (_size > 0)
+	{
+		void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+
+		if (data == MAP_FAILED)
+		{
+			close();
+			return false;
+		}
+
+		_data = (uint8_t*)data;
+		madvise(_data, _size, MADV_SEQUENTIAL);
+	}
+
+	return true;
+}
+
+bool Mapped_file::create(const std::string& path, size_t size)
+{
+	close();
+
+	_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+	if (_fd < 0 || ftruncate(_fd, size) != 0)
+	{
+		close();
+		return false;
+	}
+
+	_size = size;
+
+	if (_size > 0)
+	{
+		void* data = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+
+		if (data == MAP_FAILED)
+		{
+			close();
+			return false;
+		}
+
+		_data = (uint8_t*)data;
+	}
+
+	return true;
+}
+
+void Mapped_file::close()
+{
+	if (_data)
+	{
+		munmap(_data, _size);
+	}
+
+	if (_fd >= 0)
+	{
+		::close(_fd);
+	}
+
+	_fd = -1;
+	_data = nullptr;
+	_size = 0;
+}
+
+// Frames found in one chunk, grouped by message
+struct Chunk_scan
+{
+	size_t begin = 0;
+	size_t first = 0; // First valid frame, or end if there is none
+	size_t end = 0; // Where the walk left the chunk, a frame start or the end of the file
+	std::vector<uint64_t> frames[256]; // Offsets, only for messages with a schema
+	uint64_t unknown_frames = 0;
+	uint64_t skipped_bytes = 0;
+};
+
+// Length of a CRC checked frame at offset, 0 if there is none
+static size_t frame_length(const uint8_t* data, size_t size, size_t offset)
+{
+	if (data[offset] != START_BYTE || size - offset < HEADER_LEN + FOOTER_LEN)
+	{
+		return 0;
+	}
+
+	const size_t payload_len = data[offset + 1];
+	const size_t len = aplink_calc_packet_size(payload_len);
+
+	if (len > size - offset)
+	{
+		return 0;
+	}
+
+	const uint16_t checksum = (data[offset + len - 2] << 8) | data[offset + len - 1];
+
+	return aplink_crc16(&data[offset + 1], payload_len + HEADER_LEN - 1) == checksum ? len : 0;
+}
+
+// Walks frames starting before limit. A byte that does not start a valid
+// frame is skipped, which also resyncs after corruption.
+static void scan_chunk(const uint8_t* data, size_t size, size_t begin, size_t limit, Chunk_scan* chunk)
+{
+	*chunk = Chunk_scan();
+	chunk->begin = begin;
+	chunk->first = SIZE_MAX;
+
+	size_t offset = begin;
+
+	while (offset < limit)
+	{
+		const size_t len = frame_length(data, size, offset);
+
+		if (len == 0)
+		{
+			chunk->skipped_bytes++;
+			offset++;
+			continue;
+		}
+
+		if (chunk->first == SIZE_MAX)
+		{
+			chunk->first = offset;
+		}
+
+		const Message_def* message = log_find_message(data[offset + 2]);
+
+		if (message && data[offset + 1] == message->payload_len)
+		{
+			chunk->frames[message->msg_id].push_back(offset);
+		}
+		else
+		{
+			chunk->unknown_frames++;
+		}
+
+		offset += len;
+	}
+
+	chunk->end = offset;
+
+	if (chunk->first == SIZE_MAX)
+	{
+		chunk->first = offset;
+	}
+}
+
+template <typename Fn>
+static void parallel_for(unsigned count, Fn fn)
+{
+	std::vector<std::thread> threads;
+
+	for (unsigned i = 1; i < count; i++)
+	{
+		threads.emplace_back(fn, i);
+	}
+
+	fn(0);
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool write_manifest(const std::string& path, size_t size, const Index_stats* stats)
+{
+	FILE* f = fopen(path.c_str(), "w");
+
+	if (!f)
+	{
+		return false;
+	}
+
+	fprintf(f, "{\n  \"bytes\": %zu,\n  \"frames\": %llu,\n  \"unknown_frames\": %llu,\n  \"skipped_bytes\": %llu,\n  \"messages\": [",
+		size, (unsigned long long)stats->frames, (unsigned long long)stats->unknown_frames,
+		(unsigned long long)stats->skipped_bytes);
+
+	bool first = true;
+
+	for (uint8_t i = 0; i < LOG_NUM_MESSAGES; i++)
+	{
+		const Message_def& message = LOG_MESSAGES[i];
+		const Message_stats& ms = stats->messages[message.msg_id];
+
+		if (ms.count == 0)
+		{
+			continue;
+		}
+
+		fprintf(f, "%s\n    {\"name\": \"%s\", \"id\": %u, \"count\": %llu, \"start_us\": %llu, \"end_us\": %llu, \"sorted\": %s, \"columns\": [",
+			first ? "" : ",", message.name, message.msg_id, (unsigned long long)ms.count,
+			(unsigned long long)ms.start_us, (unsigned long long)ms.end_us, ms.sorted ? "true" : "false");
+
+		for (uint8_t c = 0; c < message.num_columns; c++)
+		{
+			fprintf(f, "%s{\"name\": \"%s\", \"dtype\": \"<%s\"}", c > 0 ? ", " : "",
+				message.columns[c].name, column_type_name(message.columns[c].type));
+		}
+
+		fprintf(f, "]}");
+		first = false;
+	}
+
+	fprintf(f, "\n  ]\n}\n");
+	return fclose(f) == 0;
+}
+
+bool log_export(const uint8_t* data, size_t size, const std::string& out_dir, unsigned threads, Index_stats* stats)
+{
+	*stats = Index_stats();
+
+	// Small logs are not worth a thread per core
+	static constexpr size_t MIN_CHUNK = 1 << 20;
+	const unsigned num_chunks = std::max<unsigned>(1, std::min<size_t>(threads, size / MIN_CHUNK));
+	std::vector<Chunk_scan> chunks(num_chunks);
+
+	const auto scan_start = std::chrono::steady_clock::now();
+
+	parallel_for(num_chunks, [&](unsigned i)
+	{
+		scan_chunk(data, size, size * i / num_chunks, size * (i + 1) / num_chunks, &chunks[i]);
+	});
+
+	// Stitch the chunks, see the header
+	for (unsigned i = 1; i < num_chunks; i++)
+	{
+		const size_t start = chunks[i - 1].end;
+		const size_t limit = size * (i + 1) / num_chunks;
+
+		if (start > chunks[i].first)
+		{
+			scan_chunk(data, size, start, limit, &chunks[i]);
+			stats->rescans++;
+		}
+		else
+		{
+			// Bytes before start were covered by the previous chunk's last frame
+			chunks[i].skipped_bytes -= start - chunks[i].begin;
+		}
+	}
+
+	stats->scan_s = seconds_since(scan_start);
+
+	// Row of each chunk's first frame in every column
+	std::vector<uint64_t> bases(num_chunks * 256);
+
+	for (unsigned i = 0; i < num_chunks; i++)
+	{
+		stats->unknown_frames += chunks[i].unknown_frames;
+		stats->skipped_bytes += chunks[i].skipped_bytes;
+
+		for (unsigned id = 0; id < 256; id++)
+		{
+			bases[i * 256 + id] = stats->messages[id].count;
+			stats->messages[id].count += chunks[i].frames[id].size();
+		}
+	}
+
+	stats->frames = stats->unknown_frames;
+
+	for (unsigned id = 0; id < 256; id++)
+	{
+		stats->frames += stats->messages[id].count;
+	}
+
+	const auto write_start = std::chrono::steady_clock::now();
+
+	if (mkdir(out_dir.c_str(), 0755) != 0 && errno != EEXIST)
+	{
+		fprintf(stderr, "Cannot create %s\n", out_dir.c_str());
+		return false;
+	}
+
+	for (uint8_t m = 0; m < LOG_NUM_MESSAGES; m++)
+	{
+		const Message_def& message = LOG_MESSAGES[m];
+		Message_stats& ms = stats->messages[message.msg_id];
+
+		if (ms.count == 0)
+		{
+			continue;
+		}
+
+		const std::string dir = out_dir + "/" + message.name;
+
+		if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+		{
+			fprintf(stderr, "Cannot create %s\n", dir.c_str());
+			return false;
+		}
+
+		std::vector<Mapped_file> columns(message.num_columns);
+
+		for (uint8_t c = 0; c < message.num_columns; c++)
+		{
+			const std::string path = dir + "/" + message.columns[c].name + ".bin";
+
+			if (!columns[c].create(path, ms.count * column_size(message.columns[c].type)))
+			{
+				fprintf(stderr, "Cannot create %s\n", path.c_str());
+				return false;
+			}
+		}
+
+		parallel_for(num_chunks, [&](unsigned i)
+		{
+			const std::vector<uint64_t>& frames = chunks[i].frames[message.msg_id];
+			const uint64_t base = bases[i * 256 + message.msg_id];
+
+			// One pass over the frames, each frame is read once and its
+			// fields scattered to the columns
+			for (size_t k = 0; k < frames.size(); k++)
+			{
+				const uint8_t* payload = data + frames[k] + HEADER_LEN;
+
+				for (uint8_t c = 0; c < message.num_columns; c++)
+				{
+					const Column_def& column = message.columns[c];
+					const uint64_t row = base + k;
+
+					switch (column_size(column.type))
+					{
+					case 1: columns[c].data()[row] = payload[column.offset]; break;
+					case 2: memcpy(columns[c].data() + row * 2, payload + column.offset, 2); break;
+					case 4: memcpy(columns[c].data() + row * 4, payload + column.offset, 4); break;
+					case 8: memcpy(columns[c].data() + row * 8, payload + column.offset, 8); break;
+					}
+				}
+			}
+		});
+
+		// time_us is the first field of every logged message
+		const uint64_t* time = (const uint64_t*)columns[0].data();
+		ms.start_us = time[0];
+		ms.end_us = time[ms.count - 1];
+
+		for (uint64_t k = 1; k < ms.count && ms.sorted; k++)
+		{
+			ms.sorted = time[k] >= time[k - 1];
+		}
+	}
+
+	stats->write_s = seconds_since(write_start);
+
+	return write_manifest(out_dir + "/manifest.json", size, stats);
+}
+
+// The "sorted" flag of message in manifest.json, false if it is not listed
+static bool manifest_sorted(const std::string& dir, const Message_def* message, bool* sorted)
+{
+	FILE* f = fopen((dir + "/manifest.json").c_str(), "r");
+
+	if (!f)
+	{
+		return false;
+	}
+
+	std::string manifest;
+	char chunk[4096];
+	size_t len;
+
+	while ((len = fread(chunk, 1, sizeof(chunk), f)) > 0)
+	{
+		manifest.append(chunk, len);
+	}
+
+	fclose(f);
+
+	// One line per message, written by write_manifest
+	const size_t entry = manifest.find(std::string("{\"name\": \"") + message->name + "\"");
+	const size_t flag = manifest.find("\"sorted\": ", entry);
+
+	if (entry == std::string::npos || flag == std::string::npos)
+	{
+		return false;
+	}
+
+	*sorted = manifest.compare(flag + 10, 4, "true") == 0;
+	return true;
+}
+
+bool log_query(const std::string& dir, const Message_def* message, uint64_t from_us, uint64_t to_us,
+			   const std::vector<const Column_def*>& columns, FILE* out, uint64_t* rows)
+{
+	const std::string message_dir = dir + "/" + message->name;
+
+	std::vector<const Column_def*> selected = columns;
+	if (selected.empty())
+	{
+		for (uint8_t c = 0; c < message->num_columns; c++)
+		{
+			selected.push_back(&message->columns[c]);
+		}
+	}
+
+	Mapped_file time_file;
+	if (!time_file.open_read(message_dir + "/time_us.bin"))
+	{
+		fprintf(stderr, "Cannot read %s/time_us.bin\n", message_dir.c_str());
+		return false;
+	}
+
+	bool sorted;
+	if (!manifest_sorted(dir, message, &sorted))
+	{
+		fprintf(stderr, "Cannot find %s in %s/manifest.json\n", message->name, dir.c_str());
+		return false;
+	}
+
+	const uint64_t* time = (const uint64_t*)time_file.data();
+	const size_t count = time_file.size() / sizeof(uint64_t);
+	size_t first = 0;
+	size_t end = count;
+
+	// The binary search needs a sorted index, otherwise every row is checked
+	if (sorted)
+	{
+		first = std::lower_bound(time, time + count, from_us) - time;
+		end = std::max<size_t>(first, std::lower_bound(time, time + count, to_us) - time);
+	}
+
+	std::vector<Mapped_file> files(selected.size());
+
+	for (size_t c = 0; c < selected.size(); c++)
+	{
+		const std::string path = message_dir + "/" + selected[c]->name + ".bin";
+
+		if (!files[c].open_read(path) || files[c].size() != count * column_size(selected[c]->type))
+		{
+			fprintf(stderr, "Cannot read %s\n", path.c_str());
+			return false;
+		}
+	}
+
+	for (size_t c = 0; c < selected.size(); c++)
+	{
+		fprintf(out, "%s%s", c > 0 ? "," : "", selected[c]->name);
+	}
+
+	fprintf(out, "\n");
+
+	*rows = 0;
+
+	for (size_t row = first; row < end; row++)
+	{
+		if (!sorted && (time[row] < from_us || time[row] >= to_us))
+		{
+			continue;
+		}
+
+		for (size_t c = 0; c < selected.size(); c++)
+		{
+			const uint8_t* value = files[c].data() + row * column_size(selected[c]->type);
+
+			if (c > 0)
+			{
+				fputc(',', out);
+			}
+
+			switch (selected[c]->type)
+			{
+			case COLUMN_U8: fprintf(out, "%u", *value); break;
+			case COLUMN_U16: { uint16_t v; memcpy(&v, value, 2); fprintf(out, "%u", v); break; }
+			case COLUMN_I16: { int16_t v; memcpy(&v, value, 2); fprintf(out, "%d", v); break; }
+			case COLUMN_U32: { uint32_t v; memcpy(&v, value, 4); fprintf(out, "%u", v); break; }
+			case COLUMN_I32: { int32_t v; memcpy(&v, value, 4); fprintf(out, "%d", v); break; }
+			case COLUMN_U64: { uint64_t v; memcpy(&v, value, 8); fprintf(out, "%llu", (unsigned long long)v); break; }
+			case COLUMN_F32: { float v; memcpy(&v, value, 4); fprintf(out, "%.9g", v); break; }
+			}
+		}
+
+		fputc('\n', out);
+		(*rows)++;
+	}
+
+	return true;
+}
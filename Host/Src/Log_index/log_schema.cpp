@@ -0,0 +1,180 @@
+#include "Log_index/log_schema.h"
+#include <string.h>
+#include <type_traits>
+
+extern "C"
+{
+#include "lib/aplink_c/aplink.h"
+#include "lib/aplink_c/aplink_messages.h"
+}
+
+template <typename T>
+static constexpr Column_type column_type_of()
+{
+	static_assert(!std::is_same<T, double>::value, "No double columns");
+
+	return std::is_same<T, float>::value ? COLUMN_F32 :
+		   std::is_same<T, uint64_t>::value ? COLUMN_U64 :
+		   std::is_same<T, int32_t>::value ? COLUMN_I32 :
+		   std::is_same<T, uint32_t>::value ? COLUMN_U32 :
+		   std::is_same<T, int16_t>::value ? COLUMN_I16 :
+		   std::is_same<T, uint16_t>::value ? COLUMN_U16 : COLUMN_U8;
+}
+
+// Offsets and types come from the message structs, so the schema follows
+// any change to aplink_messages.h
+#define COLUMN(msg, field) {#field, offsetof(msg, field), column_type_of<decltype(msg::field)>()}
+#define MESSAGE(id, name, msg, columns) {id, name, sizeof(msg), columns, sizeof(columns) / sizeof(Column_def)}
+
+static const Column_def flight_log_columns[] = {
+	COLUMN(aplink_flight_log_t, time_us),
+	COLUMN(aplink_flight_log_t, roll),
+	COLUMN(aplink_flight_log_t, pitch),
+	COLUMN(aplink_flight_log_t, yaw),
+	COLUMN(aplink_flight_log_t, lat),
+	COLUMN(aplink_flight_log_t, lon),
+	COLUMN(aplink_flight_log_t, system_mode)
+};
+
+static const Column_def log_imu_columns[] = {
+	COLUMN(aplink_log_imu_t, time_us),
+	COLUMN(aplink_log_imu_t, gx),
+	COLUMN(aplink_log_imu_t, gy),
+	COLUMN(aplink_log_imu_t, gz),
+	COLUMN(aplink_log_imu_t, ax),
+	COLUMN(aplink_log_imu_t, ay),
+	COLUMN(aplink_log_imu_t, az)
+};
+
+static const Column_def log_mag_columns[] = {
+	COLUMN(aplink_log_mag_t, time_us),
+	COLUMN(aplink_log_mag_t, x),
+	COLUMN(aplink_log_mag_t, y),
+	COLUMN(aplink_log_mag_t, z)
+};
+
+static const Column_def log_baro_columns[] = {
+	COLUMN(aplink_log_baro_t, time_us),
+	COLUMN(aplink_log_baro_t, alt),
+	COLUMN(aplink_log_baro_t, pressure),
+	COLUMN(aplink_log_baro_t, temperature)
+};
+
+static const Column_def log_gnss_columns[] = {
+	COLUMN(aplink_log_gnss_t, time_us),
+	COLUMN(aplink_log_gnss_t, lat),
+	COLUMN(aplink_log_gnss_t, lon),
+	COLUMN(aplink_log_gnss_t, asl),
+	COLUMN(aplink_log_gnss_t, vel_n),
+	COLUMN(aplink_log_gnss_t, vel_e),
+	COLUMN(aplink_log_gnss_t, vel_d),
+	COLUMN(aplink_log_gnss_t, h_acc),
+	COLUMN(aplink_log_gnss_t, v_acc),
+	COLUMN(aplink_log_gnss_t, s_acc),
+	COLUMN(aplink_log_gnss_t, sats),
+	COLUMN(aplink_log_gnss_t, fix),
+	COLUMN(aplink_log_gnss_t, year),
+	COLUMN(aplink_log_gnss_t, month),
+	COLUMN(aplink_log_gnss_t, day),
+	COLUMN(aplink_log_gnss_t, hours),
+	COLUMN(aplink_log_gnss_t, minutes),
+	COLUMN(aplink_log_gnss_t, seconds)
+};
+
+static const Column_def log_of_columns[] = {
+	COLUMN(aplink_log_of_t, time_us),
+	COLUMN(aplink_log_of_t, x),
+	COLUMN(aplink_log_of_t, y)
+};
+
+static const Column_def log_tick_columns[] = {
+	COLUMN(aplink_log_tick_t, time_us),
+	COLUMN(aplink_log_tick_t, system_mode),
+	COLUMN(aplink_log_tick_t, flight_mode),
+	COLUMN(aplink_log_tick_t, auto_mode),
+	COLUMN(aplink_log_tick_t, manual_mode),
+	COLUMN(aplink_log_tick_t, dropped_bytes)
+};
+
+const Message_def LOG_MESSAGES[] = {
+	MESSAGE(FLIGHT_LOG_MSG_ID, "flight_log", aplink_flight_log_t, flight_log_columns),
+	MESSAGE(LOG_IMU_MSG_ID, "log_imu", aplink_log_imu_t, log_imu_columns),
+	MESSAGE(LOG_MAG_MSG_ID, "log_mag", aplink_log_mag_t, log_mag_columns),
+	MESSAGE(LOG_BARO_MSG_ID, "log_baro", aplink_log_baro_t, log_baro_columns),
+	MESSAGE(LOG_GNSS_MSG_ID, "log_gnss", aplink_log_gnss_t, log_gnss_columns),
+	MESSAGE(LOG_OF_MSG_ID, "log_of", aplink_log_of_t, log_of_columns),
+	MESSAGE(LOG_TICK_MSG_ID, "log_tick", aplink_log_tick_t, log_tick_columns)
+};
+
+const uint8_t LOG_NUM_MESSAGES = sizeof(LOG_MESSAGES) / sizeof(Message_def);
+
+const Message_def* log_find_message(uint8_t msg_id)
+{
+	for (uint8_t i = 0; i < LOG_NUM_MESSAGES; i++)
+	{
+		if (LOG_MESSAGES[i].msg_id == msg_id)
+		{
+			return &LOG_MESSAGES[i];
+		}
+	}
+
+	return nullptr;
+}
+
+const Message_def* log_find_message(const char* name)
+{
+	for (uint8_t i = 0; i < LOG_NUM_MESSAGES; i++)
+	{
+		if (strcmp(LOG_MESSAGES[i].name, name) == 0)
+		{
+			return &LOG_MESSAGES[i];
+		}
+	}
+
+	return nullptr;
+}
+
+const Column_def* log_find_column(const Message_def* message, const char* name)
+{
+	for (uint8_t i = 0; i < message->num_columns; i++)
+	{
+		if (strcmp(message->columns[i].name, name) == 0)
+		{
+			return &message->columns[i];
+		}
+	}
+
+	return nullptr;
+}
+
+uint8_t column_size(Column_type type)
+{
+	switch (type)
+	{
+	case COLUMN_U8: return 1;
+	case COLUMN_U16: return 2;
+	case COLUMN_I16: return 2;
+	case COLUMN_U32: return 4;
+	case COLUMN_I32: return 4;
+	case COLUMN_U64: return 8;
+	case COLUMN_F32: return 4;
+	}
+
+	return 0;
+}
+
+const char* column_type_name(Column_type type)
+{
+	switch (type)
+	{
+	case COLUMN_U8: return "u1";
+	case COLUMN_U16: return "u2";
+	case COLUMN_I16: return "i2";
+	case COLUMN_U32: return "u4";
+	case COLUMN_I32: return "i4";
+	case COLUMN_U64: return "u8";
+	case COLUMN_F32: return "f4";
+	}
+
+	return "";
+}
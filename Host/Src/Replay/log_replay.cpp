@@ -0,0 +1,215 @@
+#include "Replay/log_replay.h"
+#include <stdio.h>
+#include <string.h>
+
+Log_replay::Log_replay(const param_context_t& params)
+	: _hal("."),
+	  _params(params),
+	  _ahrs(&_hal, &_data_bus, &_params),
+	  _position_estimator(&_hal, &_data_bus, &_params),
+	  _imu_pub(_data_bus.imu_node),
+	  _mag_pub(_data_bus.mag_node),
+	  _baro_pub(_data_bus.baro_node),
+	  _gnss_pub(_data_bus.gnss_node),
+	  _of_pub(_data_bus.of_node),
+	  _modes_pub(_data_bus.modes_node),
+	  _ahrs_sub(_data_bus.ahrs_node),
+	  _local_pos_sub(_data_bus.local_position_node)
+{
+}
+
+const char* Log_replay::csv_header()
+{
+	return "time_us,roll,pitch,yaw,q0,q1,q2,q3,ahrs_converged,x,y,z,vx,vy,vz,pos_converged\n";
+}
+
+Replay_result Log_replay::run(const uint8_t* data, size_t len, std::string* out)
+{
+	Replay_result result;
+	aplink_msg_t msg{};
+
+	for (size_t i = 0; i < len; i++)
+	{
+		if (aplink_parse_byte(&msg, data[i]))
+		{
+			handle(&msg, &result, out);
+		}
+	}
+
+	return result;
+}
+
+void Log_replay::handle(aplink_msg_t* msg, Replay_result* result, std::string* out)
+{
+	result->records++;
+
+	switch (msg->msg_id)
+	{
+	case LOG_IMU_MSG_ID:
+	{
+		aplink_log_imu_t log;
+		if (aplink_log_imu_unpack(msg, &log))
+		{
+			IMU_data imu;
+			imu.gx = log.gx;
+			imu.gy = log.gy;
+			imu.gz = log.gz;
+			imu.ax = log.ax;
+			imu.ay = log.ay;
+			imu.az = log.az;
+			imu.timestamp = log.time_us;
+
+			// Fast task
+			_hal.set_sim_time(log.time_us);
+			_imu_pub.publish(imu);
+			_ahrs.update();
+			result->imu_records++;
+		}
+		break;
+	}
+	case LOG_MAG_MSG_ID:
+	{
+		aplink_log_mag_t log;
+		if (aplink_log_mag_unpack(msg, &log))
+		{
+			Mag_data mag;
+			mag.x = log.x;
+			mag.y = log.y;
+			mag.z = log.z;
+			mag.timestamp = log.time_us;
+			_mag_pub.publish(mag);
+		}
+		break;
+	}
+	case LOG_BARO_MSG_ID:
+	{
+		aplink_log_baro_t log;
+		if (aplink_log_baro_unpack(msg, &log))
+		{
+			Baro_data baro;
+			baro.alt = log.alt;
+			baro.pressure = log.pressure;
+			baro.temperature = log.temperature;
+			baro.timestamp = log.time_us;
+			_baro_pub.publish(baro);
+		}
+		break;
+	}
+	case LOG_GNSS_MSG_ID:
+	{
+		aplink_log_gnss_t log;
+		if (aplink_log_gnss_unpack(msg, &log))
+		{
+			GNSS_data gnss;
+			gnss.lat = log.lat;
+			gnss.lon = log.lon;
+			gnss.asl = log.asl;
+			gnss.vel_n = log.vel_n;
+			gnss.vel_e = log.vel_e;
+			gnss.vel_d = log.vel_d;
+			gnss.h_acc = log.h_acc;
+			gnss.v_acc = log.v_acc;
+			gnss.s_acc = log.s_acc;
+			gnss.sats = log.sats;
+			gnss.fix = log.fix;
+			gnss.year = log.year;
+			gnss.month = log.month;
+			gnss.day = log.day;
+			gnss.hours = log.hours;
+			gnss.minutes = log.minutes;
+			gnss.seconds = log.seconds;
+			gnss.timestamp = log.time_us;
+			_gnss_pub.publish(gnss);
+		}
+		break;
+	}
+	case LOG_OF_MSG_ID:
+	{
+		aplink_log_of_t log;
+		if (aplink_log_of_unpack(msg, &log))
+		{
+			OF_data of;
+			of.x = log.x;
+			of.y = log.y;
+			of.timestamp = log.time_us;
+			_of_pub.publish(of);
+		}
+		break;
+	}
+	case LOG_TICK_MSG_ID:
+	{
+		aplink_log_tick_t log;
+		if (aplink_log_tick_unpack(msg, &log))
+		{
+			handle_tick(log, result, out);
+		}
+		break;
+	}
+	case FLIGHT_LOG_MSG_ID:
+		_flight_log_pending = aplink_flight_log_unpack(msg, &_flight_log);
+		break;
+	default:
+		break;
+	}
+}
+
+void Log_replay::handle_tick(const aplink_log_tick_t& tick, Replay_result* result, std::string* out)
+{
+	if (result->ticks == 0)
+	{
+		result->from_boot = tick.dropped_bytes == 0;
+		result->start_us = tick.time_us;
+	}
+	else if (tick.dropped_bytes != _dropped_bytes)
+	{
+		result->gaps++;
+	}
+
+	_dropped_bytes = tick.dropped_bytes;
+	result->end_us = tick.time_us;
+	result->ticks++;
+
+	// Storage wrote the flight log earlier in this main task, on the
+	// attitude as of the start of the tick
+	const AHRS_data ahrs = _ahrs_sub.get();
+
+	if (_flight_log_pending)
+	{
+		result->attitude_checks++;
+
+		if (memcmp(&ahrs.roll, &_flight_log.roll, sizeof(float)) == 0 &&
+			memcmp(&ahrs.pitch, &_flight_log.pitch, sizeof(float)) == 0 &&
+			memcmp(&ahrs.yaw, &_flight_log.yaw, sizeof(float)) == 0)
+		{
+			result->attitude_matches++;
+		}
+
+		_flight_log_pending = false;
+	}
+
+	// Main task, then the modes Commander left for the fast task
+	_hal.set_sim_time(tick.time_us);
+	_position_estimator.update();
+
+	Modes_data modes;
+	modes.system_mode = (System_mode)tick.system_mode;
+	modes.flight_mode = (Flight_mode)tick.flight_mode;
+	modes.auto_mode = (Auto_mode)tick.auto_mode;
+	modes.manual_mode = (Manual_mode)tick.manual_mode;
+	_modes_pub.publish(modes);
+
+	if (!out)
+	{
+		return;
+	}
+
+	// %.9g prints every float so it reads back to the same bits
+	const local_position_s pos = _local_pos_sub.get();
+	char row[384];
+	snprintf(row, sizeof(row),
+			 "%llu,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%d,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%d\n",
+			 (unsigned long long)tick.time_us,
+			 ahrs.roll, ahrs.pitch, ahrs.yaw, ahrs.q[0], ahrs.q[1], ahrs.q[2], ahrs.q[3], ahrs.converged,
+			 pos.x, pos.y, pos.z, pos.vx, pos.vy, pos.vz, pos.converged);
+	out->append(row);
+}
@@ -0,0 +1,112 @@
+#include "Sim/bench_sim.h"
+#include <math.h>
+
+// SBUS values, the sticks centered and the throttle just above the
+// transmitter connected threshold
+static constexpr uint16_t RC_CENTER = 992;
+static constexpr uint16_t RC_LOW = 600;
+
+// Somewhere with a typical mid latitude field, uT
+static constexpr int32_t HOME_LAT = 433890000;
+static constexpr int32_t HOME_LON = -794000000;
+static constexpr float HOME_ASL = 100.0f;
+static constexpr float MAG_NORTH = 20.0f;
+static constexpr float MAG_DOWN = 45.0f;
+
+Bench_sim::Bench_sim(LinuxHAL* hal)
+	: _hal(hal)
+{
+	for (uint8_t i = 0; i < NUM_RC_CHANNELS; i++)
+	{
+		_rc[i] = RC_CENTER;
+	}
+
+	_rc[2] = RC_LOW; // Throttle
+	_rc[4] = RC_LOW; // Manual switch
+	_rc[5] = RC_LOW; // Mode switch
+}
+
+void Bench_sim::set_rc(uint8_t channel, uint16_t value)
+{
+	if (channel < NUM_RC_CHANNELS)
+	{
+		_rc[channel] = value;
+	}
+}
+
+// Uniform in [-amplitude, amplitude], the same sequence on every run
+float Bench_sim::noise(float amplitude)
+{
+	_seed = _seed * 1664525 + 1013904223;
+	return amplitude * ((_seed >> 8) * (2.0f / 16777216.0f) - 1.0f);
+}
+
+void Bench_sim::step_to(uint64_t time_us)
+{
+	for (; _next_imu < time_us; _next_imu += IMU_PERIOD)
+	{
+		const float vib = _vib_amplitude * sinf(6.28318531f * _vib_freq * _next_imu * 1e-6f);
+
+		IMU_data imu;
+		imu.gx = noise(0.1f) + vib;
+		imu.gy = noise(0.1f) + vib;
+		imu.gz = noise(0.1f);
+		imu.ax = noise(0.01f);
+		imu.ay = noise(0.01f);
+		imu.az = -1.0f + noise(0.01f);
+		imu.timestamp = _next_imu;
+		_hal->push_imu(imu);
+	}
+
+	for (; _next_mag < time_us; _next_mag += MAG_PERIOD)
+	{
+		_hal->push_mag(Mag_data{-MAG_NORTH + noise(0.2f), noise(0.2f), -MAG_DOWN + noise(0.2f), _next_mag});
+	}
+
+	for (; _next_baro < time_us; _next_baro += BARO_PERIOD)
+	{
+		Baro_data baro;
+		baro.alt = HOME_ASL + noise(0.2f);
+		baro.pressure = 100129.0f;
+		baro.temperature = 20.0f;
+		baro.timestamp = _next_baro;
+		_hal->push_baro(baro);
+	}
+
+	for (; _next_gnss < time_us; _next_gnss += GNSS_PERIOD)
+	{
+		const uint32_t seconds = _next_gnss / 1000000;
+
+		GNSS_data gnss;
+		gnss.lat = HOME_LAT;
+		gnss.lon = HOME_LON;
+		gnss.asl = HOME_ASL;
+		gnss.h_acc = 1.5f;
+		gnss.v_acc = 2.5f;
+		gnss.s_acc = 0.2f;
+		gnss.sats = 12;
+		gnss.fix = true;
+		gnss.year = 2025;
+		gnss.month = 6;
+		gnss.day = 1;
+		gnss.hours = 12 + seconds / 3600;
+		gnss.minutes = seconds / 60 % 60;
+		gnss.seconds = seconds % 60;
+		gnss.timestamp = _next_gnss;
+		_hal->push_gnss(gnss);
+	}
+
+	for (; _next_power < time_us; _next_power += POWER_PERIOD)
+	{
+		Power_data power;
+		power.batt_voltage = 12.4f;
+		power.batt_current = 0.3f;
+		power.timestamp = _next_power;
+		_hal->push_power(power);
+	}
+
+	for (; _next_rc < time_us; _next_rc += RC_PERIOD)
+	{
+		_hal->push_rc(_rc, NUM_RC_CHANNELS);
+	}
+}
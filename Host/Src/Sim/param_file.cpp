@@ -0,0 +1,52 @@
+#include "Sim/param_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int param_load_file(param_context_t* params, const char* path)
+{
+	FILE* file = fopen(path, "r");
+
+	if (!file)
+	{
+		return -1;
+	}
+
+	char line[128];
+	int count = 0;
+	int line_num = 0;
+
+	while (fgets(line, sizeof(line), file))
+	{
+		line_num++;
+
+		char* comment = strchr(line, '#');
+		if (comment) *comment = '\0';
+
+		char name[32];
+		char value[32];
+		if (sscanf(line, "%31s %31s", name, value) != 2) continue;
+
+		param_t param = param_find(params, name);
+
+		if (param == PARAM_INVALID)
+		{
+			fprintf(stderr, "%s:%d: unknown parameter %s\n", path, line_num, name);
+			continue;
+		}
+
+		if (param_get_type(params, param) == PARAM_TYPE_INT32)
+		{
+			param_set_int32(params, param, strtol(value, nullptr, 0));
+		}
+		else
+		{
+			param_set_float(params, param, strtof(value, nullptr));
+		}
+
+		count++;
+	}
+
+	fclose(file);
+	return count;
+}
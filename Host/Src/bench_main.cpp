@@ -0,0 +1,79 @@
+#include "bench/bench.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Microbenchmarks of the flight libraries on the host. Results go to stdout
+// as CSV or JSON, one row per benchmark, in nanoseconds per operation.
+
+class Host_bench_platform : public Bench_platform
+{
+public:
+	uint64_t get_ticks() override
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	const char* get_tick_unit() override { return "ns"; }
+
+	void print(const char* str) override { fputs(str, stdout); }
+};
+
+static void usage(const char* name)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  --format <csv|json>  Output format, default csv\n"
+		"  --filter <text>      Only run benchmarks with text in their name\n"
+		"  --scale <n>          Multiply the iteration counts, default 10\n",
+		name);
+}
+
+int main(int argc, char* argv[])
+{
+	Bench_format format = BENCH_FORMAT_CSV;
+	const char* filter = nullptr;
+	int scale = 10; // Counts are sized for the board, which is much slower
+
+	for (int i = 1; i < argc; i++)
+	{
+		const bool has_value = i + 1 < argc;
+
+		if (strcmp(argv[i], "--format") == 0 && has_value)
+		{
+			const char* value = argv[++i];
+
+			if (strcmp(value, "csv") == 0) format = BENCH_FORMAT_CSV;
+			else if (strcmp(value, "json") == 0) format = BENCH_FORMAT_JSON;
+			else
+			{
+				usage(argv[0]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--filter") == 0 && has_value) filter = argv[++i];
+		else if (strcmp(argv[i], "--scale") == 0 && has_value) scale = atoi(argv[++i]);
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (scale < 1)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	Host_bench_platform platform;
+	Bench bench(&platform, format, scale, filter);
+
+	bench.begin();
+	bench_run_libs(&bench);
+	bench.end();
+
+	return 0;
+}
@@ -0,0 +1,190 @@
+#include "Log_index/log_index.h"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include "lib/aplink_c/aplink.h"
+}
+
+// Exports logs to per message column files and queries them by time range.
+// Rates and summaries go to stderr, query rows to stdout.
+
+static void usage(const char* name)
+{
+	fprintf(stderr,
+		"Usage: %s export <log> <out_dir> [options]\n"
+		"  --threads <n>      Scan threads, default one per core\n"
+		"  --verify           Also parse with aplink_parse_byte and compare the frame counts\n"
+		"       %s query <dir> <message> <from_us> <to_us> [field]...\n"
+		"  Rows with time_us in [from_us, to_us) as CSV, all fields if none are given\n",
+		name, name);
+}
+
+static double gb_per_s(size_t bytes, double seconds)
+{
+	return seconds > 0 ? bytes / seconds * 1e-9 : 0;
+}
+
+// Frames the flight code's parser finds, as a reference for the scan
+static uint64_t serial_frames(const uint8_t* data, size_t size)
+{
+	aplink_msg_t msg = {};
+	uint64_t frames = 0;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		frames += aplink_parse_byte(&msg, data[i]);
+	}
+
+	return frames;
+}
+
+static int run_export(int argc, char* argv[])
+{
+	if (argc < 4)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	const char* log_path = argv[2];
+	const char* out_dir = argv[3];
+	unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+	bool verify = false;
+
+	for (int i = 4; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--verify") == 0) verify = true;
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	Mapped_file log;
+
+	if (!log.open_read(log_path))
+	{
+		fprintf(stderr, "Cannot read %s\n", log_path);
+		return 1;
+	}
+
+	Index_stats stats;
+
+	if (!log_export(log.data(), log.size(), out_dir, threads, &stats))
+	{
+		return 1;
+	}
+
+	fprintf(stderr, "%s: %.1f MB, %llu frames, %llu without a schema, %llu bytes skipped, %u rescans\n",
+		log_path, log.size() * 1e-6, (unsigned long long)stats.frames, (unsigned long long)stats.unknown_frames,
+		(unsigned long long)stats.skipped_bytes, stats.rescans);
+
+	for (uint8_t i = 0; i < LOG_NUM_MESSAGES; i++)
+	{
+		const Message_stats& ms = stats.messages[LOG_MESSAGES[i].msg_id];
+
+		if (ms.count > 0)
+		{
+			fprintf(stderr, "  %-12s %10llu rows, %.3f to %.3f s%s\n", LOG_MESSAGES[i].name,
+				(unsigned long long)ms.count, ms.start_us * 1e-6, ms.end_us * 1e-6,
+				ms.sorted ? "" : ", not sorted by time, queries scan every row");
+		}
+	}
+
+	fprintf(stderr, "%u threads, scan %.3f s %.2f GB/s, write %.3f s, total %.2f GB/s\n",
+		threads, stats.scan_s, gb_per_s(log.size(), stats.scan_s), stats.write_s,
+		gb_per_s(log.size(), stats.scan_s + stats.write_s));
+
+	if (verify)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		const uint64_t frames = serial_frames(log.data(), log.size());
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		fprintf(stderr, "aplink_parse_byte %.3f s %.2f GB/s, %llu frames\n", seconds,
+			gb_per_s(log.size(), seconds), (unsigned long long)frames);
+
+		// The flight parser reads a whole frame from any start byte before
+		// checking it, so after corrupt bytes it can miss frames the scan
+		// resyncs to. It must never find more.
+		if (frames > stats.frames || (frames < stats.frames && stats.skipped_bytes == 0))
+		{
+			fprintf(stderr, "Frame counts differ\n");
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int run_query(int argc, char* argv[])
+{
+	if (argc < 6)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	const Message_def* message = log_find_message(argv[3]);
+
+	if (!message)
+	{
+		fprintf(stderr, "Unknown message %s\n", argv[3]);
+		return 1;
+	}
+
+	std::vector<const Column_def*> columns;
+
+	for (int i = 6; i < argc; i++)
+	{
+		const Column_def* column = log_find_column(message, argv[i]);
+
+		if (!column)
+		{
+			fprintf(stderr, "%s has no field %s\n", message->name, argv[i]);
+			return 1;
+		}
+
+		columns.push_back(column);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	uint64_t rows = 0;
+
+	if (!log_query(argv[2], message, strtoull(argv[4], nullptr, 10), strtoull(argv[5], nullptr, 10), columns, stdout, &rows))
+	{
+		return 1;
+	}
+
+	fflush(stdout);
+	fprintf(stderr, "%llu rows in %.3f ms\n", (unsigned long long)rows,
+		std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e3);
+
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc >= 2 && strcmp(argv[1], "export") == 0)
+	{
+		return run_export(argc, argv);
+	}
+
+	if (argc >= 2 && strcmp(argv[1], "query") == 0)
+	{
+		return run_query(argc, argv);
+	}
+
+	usage(argv[0]);
+	return 1;
+}
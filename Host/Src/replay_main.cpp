@@ -0,0 +1,225 @@
+#include "Replay/log_replay.h"
+#include "Sim/param_file.h"
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Replays sensor logs through AHRS and PositionEstimator. Each log is a
+// separate replay, so a directory of logs works as a regression corpus with
+// --ref and as a benchmark of the estimators from the real time factors.
+// Summaries go to stderr, the flight code prints to stdout.
+
+struct Options
+{
+	const char* params = "params/sitl.params";
+	const char* out_dir = nullptr;
+	const char* ref_dir = nullptr;
+	bool quiet = false;
+	std::vector<const char*> logs;
+};
+
+static void usage(const char* name)
+{
+	fprintf(stderr,
+		"Usage: %s [options] <log>...\n"
+		"  --params <file>    Parameters the logs were recorded with, default params/sitl.params\n"
+		"  --out <dir>        Write the estimator outputs per tick to <dir>/<log name>.csv\n"
+		"  --ref <dir>        Compare the outputs with <dir>/<log name>.csv, fail on any difference\n"
+		"  --quiet            Only print the summaries\n",
+		name);
+}
+
+static bool read_file(const std::string& path, std::string* data)
+{
+	FILE* f = fopen(path.c_str(), "rb");
+
+	if (!f)
+	{
+		return false;
+	}
+
+	char chunk[65536];
+	size_t len;
+
+	while ((len = fread(chunk, 1, sizeof(chunk), f)) > 0)
+	{
+		data->append(chunk, len);
+	}
+
+	fclose(f);
+	return true;
+}
+
+static std::string base_name(const char* path)
+{
+	const char* slash = strrchr(path, '/');
+	return slash ? slash + 1 : path;
+}
+
+// Line of the first difference, 0 if the outputs are the same
+static size_t first_difference(const std::string& a, const std::string& b)
+{
+	size_t line = 1;
+
+	for (size_t i = 0; i < a.size() || i < b.size(); i++)
+	{
+		if (i >= a.size() || i >= b.size() || a[i] != b[i])
+		{
+			return line;
+		}
+
+		if (a[i] == '\n')
+		{
+			line++;
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const bool has_value = i + 1 < argc;
+
+		if (strcmp(argv[i], "--params") == 0 && has_value) options.params = argv[++i];
+		else if (strcmp(argv[i], "--out") == 0 && has_value) options.out_dir = argv[++i];
+		else if (strcmp(argv[i], "--ref") == 0 && has_value) options.ref_dir = argv[++i];
+		else if (strcmp(argv[i], "--quiet") == 0) options.quiet = true;
+		else if (argv[i][0] != '-') options.logs.push_back(argv[i]);
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (options.logs.empty())
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (options.quiet && !freopen("/dev/null", "w", stdout))
+	{
+		return 1;
+	}
+
+	param_context_t params;
+	param_init(&params);
+
+	if (param_load_file(&params, options.params) < 0)
+	{
+		fprintf(stderr, "Cannot read %s\n", options.params);
+		return 1;
+	}
+
+	bool ok = true;
+	double total_sim = 0;
+	double total_wall = 0;
+
+	for (const char* path : options.logs)
+	{
+		const std::string name = base_name(path);
+		std::string log;
+
+		if (!read_file(path, &log))
+		{
+			fprintf(stderr, "%s: cannot read\n", path);
+			ok = false;
+			continue;
+		}
+
+		const bool keep_output = options.out_dir || options.ref_dir;
+		std::string output = Log_replay::csv_header();
+
+		// Too big for the stack
+		std::unique_ptr<Log_replay> replay = std::make_unique<Log_replay>(params);
+
+		const auto start = std::chrono::steady_clock::now();
+		const Replay_result result = replay->run((const uint8_t*)log.data(), log.size(), keep_output ? &output : nullptr);
+		const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		const double sim = (result.end_us - result.start_us) * 1e-6;
+
+		total_sim += sim;
+		total_wall += wall;
+
+		fprintf(stderr, "%s: %.1f s in %.3f s, real time factor %.1f, %llu IMU records, %llu ticks\n",
+			name.c_str(), sim, wall, wall > 0 ? sim / wall : 0,
+			(unsigned long long)result.imu_records, (unsigned long long)result.ticks);
+
+		if (result.ticks == 0)
+		{
+			fprintf(stderr, "%s: no sensor log records, was LOG_SENSORS set?\n", name.c_str());
+			ok = false;
+			continue;
+		}
+
+		// Without the start the estimators begin from a different state
+		// than on board, the replay is still repeatable
+		if (!result.from_boot || result.gaps > 0)
+		{
+			fprintf(stderr, "%s: log %s, %llu gaps, outputs will differ from the flight\n", name.c_str(),
+				result.from_boot ? "starts at boot" : "does not start at boot", (unsigned long long)result.gaps);
+		}
+
+		if (result.attitude_checks > 0)
+		{
+			fprintf(stderr, "%s: attitude bit-exact with the flight log on %llu of %llu ticks\n", name.c_str(),
+				(unsigned long long)result.attitude_matches, (unsigned long long)result.attitude_checks);
+		}
+
+		if (options.out_dir)
+		{
+			const std::string out_path = std::string(options.out_dir) + "/" + name + ".csv";
+			FILE* f = fopen(out_path.c_str(), "wb");
+
+			if (!f || fwrite(output.data(), 1, output.size(), f) != output.size())
+			{
+				fprintf(stderr, "%s: cannot write %s\n", name.c_str(), out_path.c_str());
+				ok = false;
+			}
+
+			if (f)
+			{
+				fclose(f);
+			}
+		}
+
+		if (options.ref_dir)
+		{
+			const std::string ref_path = std::string(options.ref_dir) + "/" + name + ".csv";
+			std::string ref;
+
+			if (!read_file(ref_path, &ref))
+			{
+				fprintf(stderr, "%s: cannot read %s\n", name.c_str(), ref_path.c_str());
+				ok = false;
+			}
+			else if (const size_t line = first_difference(output, ref))
+			{
+				fprintf(stderr, "%s: differs from %s at line %zu\n", name.c_str(), ref_path.c_str(), line);
+				ok = false;
+			}
+			else
+			{
+				fprintf(stderr, "%s: matches %s\n", name.c_str(), ref_path.c_str());
+			}
+		}
+	}
+
+	if (options.logs.size() > 1)
+	{
+		fprintf(stderr, "%zu logs, %.1f s in %.3f s, real time factor %.1f\n",
+			options.logs.size(), total_sim, total_wall, total_wall > 0 ? total_sim / total_wall : 0);
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+#include "Linux_HAL/linux_hal.h"
+#include "Sim/bench_sim.h"
+#include "Sim/param_file.h"
+#include "autopilot.h"
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Software in the loop: the flight code on the Linux HAL, fed by the bench
+// simulation as fast as the CPU allows. The real time factor is simulated
+// time over wall time. Instances share nothing, each runs on its own thread.
+
+static constexpr uint64_t STEP_US = 10000;
+
+struct Options
+{
+	double duration = 60;
+	double report = 10;
+	float vibration = 0;
+	const char* params = "params/sitl.params";
+	const char* sd_dir = "sitl_sd";
+	bool pty = false;
+	bool quiet = false;
+	int instances = 1;
+};
+
+struct Result
+{
+	bool ok = false;
+	double wall = 0;
+	uint64_t fast_task_count = 0;
+	Pwm_output pwm;
+};
+
+static void usage(const char* name)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  --duration <s>     Simulated time to run, default 60\n"
+		"  --params <file>    Parameter file, default params/sitl.params\n"
+		"  --sd <dir>         Directory standing in for the SD card, default sitl_sd\n"
+		"  --pty              Telemetry on a pseudo terminal, first instance only\n"
+		"  --vibration <hz>   Gyro vibration for the IMU filters, default none\n"
+		"  --report <s>       Simulated time between real time factor reports, default 10\n"
+		"  --instances <n>    Independent autopilots on their own threads, default 1\n"
+		"  --quiet            Only print the reports\n",
+		name);
+}
+
+static double wall_seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void run_instance(const Options& options, int index, Result* result)
+{
+	const std::string sd_dir = options.instances > 1 ? std::string(options.sd_dir) + "_" + std::to_string(index) : options.sd_dir;
+
+	LinuxHAL hal(sd_dir);
+	hal.set_telem_pty(options.pty && index == 0);
+
+	// Too big for the thread stack
+	std::unique_ptr<Autopilot> autopilot = std::make_unique<Autopilot>(&hal);
+
+	const int num_params = param_load_file(autopilot->get_params(), options.params);
+	if (num_params < 0)
+	{
+		fprintf(stderr, "Cannot read %s\n", options.params);
+		return;
+	}
+
+	if (index == 0)
+	{
+		fprintf(stderr, "Loaded %d parameters from %s\n", num_params, options.params);
+	}
+
+	Bench_sim sim(&hal);
+	sim.set_vibration(options.vibration, options.vibration > 0 ? 5.0f : 0.0f);
+
+	autopilot->setup();
+
+	const uint64_t end_time = options.duration * 1e6;
+	const uint64_t report_period = options.report > 0 ? options.report * 1e6 : end_time;
+	uint64_t next_report = report_period;
+	const auto start = std::chrono::steady_clock::now();
+
+	for (uint64_t time = STEP_US; time <= end_time; time += STEP_US)
+	{
+		sim.step_to(time);
+		hal.run_until(time);
+
+		if (index == 0 && time >= next_report && time < end_time)
+		{
+			next_report += report_period;
+			fprintf(stderr, "t = %.0f s, real time factor %.1f\n", time * 1e-6, time * 1e-6 / wall_seconds(start));
+		}
+	}
+
+	result->wall = wall_seconds(start);
+	result->fast_task_count = hal.get_fast_task_count();
+	result->pwm = hal.get_pwm();
+	result->ok = true;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const bool has_value = i + 1 < argc;
+
+		if (strcmp(argv[i], "--duration") == 0 && has_value) options.duration = atof(argv[++i]);
+		else if (strcmp(argv[i], "--params") == 0 && has_value) options.params = argv[++i];
+		else if (strcmp(argv[i], "--sd") == 0 && has_value) options.sd_dir = argv[++i];
+		else if (strcmp(argv[i], "--vibration") == 0 && has_value) options.vibration = atof(argv[++i]);
+		else if (strcmp(argv[i], "--report") == 0 && has_value) options.report = atof(argv[++i]);
+		else if (strcmp(argv[i], "--instances") == 0 && has_value) options.instances = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--pty") == 0) options.pty = true;
+		else if (strcmp(argv[i], "--quiet") == 0) options.quiet = true;
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (options.instances < 1)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	// The flight code prints to stdout, reports go to stderr
+	if (options.quiet && !freopen("/dev/null", "w", stdout))
+	{
+		return 1;
+	}
+
+	std::vector<Result> results(options.instances);
+	const auto start = std::chrono::steady_clock::now();
+
+	if (options.instances == 1)
+	{
+		run_instance(options, 0, &results[0]);
+	}
+	else
+	{
+		std::vector<std::thread> threads;
+
+		for (int i = 0; i < options.instances; i++)
+		{
+			threads.emplace_back(run_instance, std::cref(options), i, &results[i]);
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	const double wall = wall_seconds(start);
+
+	for (int i = 0; i < options.instances; i++)
+	{
+		const Result& result = results[i];
+
+		if (!result.ok)
+		{
+			return 1;
+		}
+
+		fprintf(stderr, "Instance %d: simulated %.1f s in %.3f s, real time factor %.1f, %llu fast task runs\n",
+			i, options.duration, result.wall, options.duration / result.wall, (unsigned long long)result.fast_task_count);
+
+		// Same inputs, so any difference is state leaking between instances
+		if (memcmp(result.pwm.duty, results[0].pwm.duty, sizeof(result.pwm.duty)) != 0 ||
+			result.fast_task_count != results[0].fast_task_count)
+		{
+			fprintf(stderr, "Instance %d diverged from instance 0\n", i);
+			return 1;
+		}
+	}
+
+	if (options.instances > 1)
+	{
+		fprintf(stderr, "%d instances, %.1f simulated s per wall s\n", options.instances, options.instances * options.duration / wall);
+	}
+
+	return 0;
+}
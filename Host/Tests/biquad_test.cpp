@@ -0,0 +1,280 @@
+#include "check.h"
+#include "lib/filters/biquad.h"
+#include <math.h>
+#include <stdint.h>
+
+// Sweeps sines through Biquad3 and checks the measured response of the low
+// pass and notch designs, the pass through cases and reset().
+
+static constexpr float SAMPLE_RATE = 1000;
+static constexpr double DB_3 = 0.70710678118654752; // -3 dB
+
+// Gain for a sine at freq once the filter has settled. The axes get different
+// phases and must agree.
+static double gain(const Biquad_coeffs& coeffs, double freq)
+{
+	Biquad3 filter;
+	filter.set_coeffs(coeffs);
+
+	const double phase[3] = {0, 2.0, 4.0};
+	const double w = 2 * M_PI * freq / SAMPLE_RATE;
+
+	// Settle for a second, then fit a sine and cosine at freq to a second
+	// of output by least squares
+	const uint32_t settle = (uint32_t)SAMPLE_RATE;
+	const uint32_t window = (uint32_t)SAMPLE_RATE;
+
+	double ss[3] = {}, cc[3] = {}, sc[3] = {}, ys[3] = {}, yc[3] = {};
+
+	for (uint32_t n = 0; n < settle + window; n++)
+	{
+		float x[3];
+
+		for (uint8_t i = 0; i < 3; i++)
+		{
+			x[i] = (float)sin(w * n + phase[i]);
+		}
+
+		filter.apply(x);
+
+		if (n < settle)
+		{
+			continue;
+		}
+
+		for (uint8_t i = 0; i < 3; i++)
+		{
+			const double s = sin(w * n + phase[i]);
+			const double c = cos(w * n + phase[i]);
+			ss[i] += s * s;
+			cc[i] += c * c;
+			sc[i] += s * c;
+			ys[i] += x[i] * s;
+			yc[i] += x[i] * c;
+		}
+	}
+
+	double amplitude[3];
+
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		const double det = ss[i] * cc[i] - sc[i] * sc[i];
+		const double a = (ys[i] * cc[i] - yc[i] * sc[i]) / det;
+		const double b = (yc[i] * ss[i] - ys[i] * sc[i]) / det;
+		amplitude[i] = hypot(a, b);
+	}
+
+	check(fabs(amplitude[1] - amplitude[0]) < 1E-5 && fabs(amplitude[2] - amplitude[0]) < 1E-5,
+		"axes disagree at %.2f Hz: %f %f %f", freq, amplitude[0], amplitude[1], amplitude[2]);
+
+	return amplitude[0];
+}
+
+static double to_db(double gain)
+{
+	return 20 * log10(gain);
+}
+
+// Frequency in [lo, hi] where the gain crosses level, the gain must be above
+// it at lo and below at hi or the other way around
+static double find_crossing(const Biquad_coeffs& coeffs, double lo, double hi, double level)
+{
+	const bool rising = gain(coeffs, lo) < level;
+
+	for (int i = 0; i < 40; i++)
+	{
+		const double mid = 0.5 * (lo + hi);
+
+		if ((gain(coeffs, mid) < level) == rising)
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	return 0.5 * (lo + hi);
+}
+
+static void test_lowpass()
+{
+	const float cutoffs[] = {5, 30, 80, 200, 400};
+
+	for (float cutoff : cutoffs)
+	{
+		const Biquad_coeffs coeffs = biquad_lowpass(SAMPLE_RATE, cutoff);
+		const double corner = find_crossing(coeffs, cutoff / 4, fmin(cutoff * 4, 0.49 * SAMPLE_RATE), DB_3);
+		const double pass = gain(coeffs, cutoff / 10);
+
+		printf("low pass %5.1f Hz: -3 dB at %8.3f Hz, %6.3f dB at cutoff / 10", cutoff, corner, to_db(pass));
+
+		check(fabs(corner - cutoff) < 0.005 * cutoff, "low pass %.1f Hz: -3 dB at %.3f Hz", cutoff, corner);
+		check(fabs(to_db(pass)) < 0.01, "low pass %.1f Hz: %.3f dB at a tenth of the cutoff", cutoff, to_db(pass));
+
+		// Second order, at least 40 dB per decade
+		if (cutoff * 10 < 0.5f * SAMPLE_RATE)
+		{
+			const double stop = gain(coeffs, cutoff * 10);
+			printf(", %6.1f dB at cutoff * 10", to_db(stop));
+			check(to_db(stop) < -39.5, "low pass %.1f Hz: %.1f dB at ten times the cutoff", cutoff, to_db(stop));
+		}
+
+		printf("\n");
+	}
+}
+
+static void test_notch()
+{
+	const struct { float center; float bandwidth; } notches[] = {
+		{50, 10},
+		{100, 20},
+		{150, 60},
+		{300, 40},
+		{450, 20}
+	};
+
+	for (const auto& n : notches)
+	{
+		const Biquad_coeffs coeffs = biquad_notch(SAMPLE_RATE, n.center, n.bandwidth);
+		const double depth = gain(coeffs, n.center);
+		const double lower = find_crossing(coeffs, fmax(n.center - 3 * n.bandwidth, n.center / 2), n.center, DB_3);
+		const double upper = find_crossing(coeffs, n.center, fmin(n.center + 3 * n.bandwidth, 0.49 * SAMPLE_RATE), DB_3);
+		const double width = upper - lower;
+
+		printf("notch %5.1f Hz: depth %6.1f dB, -3 dB from %7.2f to %7.2f Hz, width %6.2f Hz for %5.1f\n",
+			n.center, to_db(depth), lower, upper, width, n.bandwidth);
+
+		check(to_db(depth) < -60, "notch %.1f Hz: only %.1f dB deep", n.center, to_db(depth));
+		check(fabs(width - n.bandwidth) < 0.005 * n.bandwidth, "notch %.1f Hz: width %.2f Hz, set to %.1f",
+			n.center, width, n.bandwidth);
+		check(lower < n.center && upper > n.center, "notch %.1f Hz: -3 dB points %.2f and %.2f Hz", n.center, lower, upper);
+
+		// Three widths away the signal is untouched, the skirts widen a
+		// little near Nyquist
+		const double away_freqs[] = {n.center - 3 * n.bandwidth, n.center + 3 * n.bandwidth};
+
+		for (double away : away_freqs)
+		{
+			if (away > 0 && away < 0.49 * SAMPLE_RATE)
+			{
+				const double away_db = to_db(gain(coeffs, away));
+				check(fabs(away_db) < 0.25, "notch %.1f Hz: %.3f dB at %.1f Hz", n.center, away_db, away);
+			}
+		}
+	}
+}
+
+static uint32_t xorshift(uint32_t* state)
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+// Coefficients that should leave the signal exactly as it is
+static void check_pass_through(const Biquad_coeffs& coeffs, const char* name)
+{
+	Biquad3 filter;
+	filter.set_coeffs(coeffs);
+
+	uint32_t state = 0xC0FFEE;
+	uint32_t changed = 0;
+
+	for (uint32_t n = 0; n < 10000; n++)
+	{
+		float x[3];
+		float in[3];
+
+		for (uint8_t i = 0; i < 3; i++)
+		{
+			in[i] = x[i] = (float)(xorshift(&state) / 4294967295.0 * 200 - 100);
+		}
+
+		filter.apply(x);
+
+		for (uint8_t i = 0; i < 3; i++)
+		{
+			changed += x[i] != in[i];
+		}
+	}
+
+	check(changed == 0, "%s: %u samples changed", name, changed);
+}
+
+static void test_pass_through()
+{
+	const float nyquist = 0.5f * SAMPLE_RATE;
+
+	check_pass_through(Biquad_coeffs{}, "default coefficients");
+	check_pass_through(biquad_lowpass(SAMPLE_RATE, 0), "low pass at 0 Hz");
+	check_pass_through(biquad_lowpass(SAMPLE_RATE, -10), "low pass below 0 Hz");
+	check_pass_through(biquad_lowpass(SAMPLE_RATE, nyquist), "low pass at Nyquist");
+	check_pass_through(biquad_lowpass(SAMPLE_RATE, 2 * nyquist), "low pass above Nyquist");
+	check_pass_through(biquad_notch(SAMPLE_RATE, 0, 20), "notch at 0 Hz");
+	check_pass_through(biquad_notch(SAMPLE_RATE, nyquist, 20), "notch at Nyquist");
+	check_pass_through(biquad_notch(SAMPLE_RATE, 2 * nyquist, 20), "notch above Nyquist");
+	check_pass_through(biquad_notch(SAMPLE_RATE, 100, 0), "notch of zero width");
+}
+
+// After reset() a constant input comes straight out, from zero it takes a
+// while to settle. At low cutoffs the float recursion itself settles slightly
+// off the input, 1E-5 at 20 Hz and 0.1 % at 1 Hz for this rate, so slow
+// filters are not checked.
+static void check_reset(const Biquad_coeffs& coeffs, const char* name)
+{
+	const float input[3] = {0.35f, -9.81f, 150.0f};
+
+	Biquad3 filter;
+	filter.set_coeffs(coeffs);
+	filter.reset(input);
+
+	Biquad3 cold;
+	cold.set_coeffs(coeffs);
+
+	double max_error = 0;
+	double cold_error = 0;
+
+	for (uint32_t n = 0; n < 1000; n++)
+	{
+		float x[3] = {input[0], input[1], input[2]};
+		float y[3] = {input[0], input[1], input[2]};
+		filter.apply(x);
+		cold.apply(y);
+
+		for (uint8_t i = 0; i < 3; i++)
+		{
+			max_error = fmax(max_error, fabs(x[i] - input[i]) / fabs(input[i]));
+
+			if (n == 0)
+			{
+				cold_error = fmax(cold_error, fabs(y[i] - input[i]) / fabs(input[i]));
+			}
+		}
+	}
+
+	printf("%-16s after reset() off by %.2e, from zero %.2e on the first sample\n", name, max_error, cold_error);
+
+	check(max_error < 2E-5, "%s: output after reset() off by %.2e of the input", name, max_error);
+	check(cold_error > 100 * max_error, "%s: filter from zero already settled, %.2e", name, cold_error);
+}
+
+static void test_reset()
+{
+	check_reset(biquad_lowpass(SAMPLE_RATE, 20), "low pass 20 Hz");
+	check_reset(biquad_lowpass(SAMPLE_RATE, 80), "low pass 80 Hz");
+	check_reset(biquad_notch(SAMPLE_RATE, 100, 20), "notch 100 Hz");
+}
+
+int main()
+{
+	test_lowpass();
+	test_notch();
+	test_pass_through();
+	test_reset();
+
+	return check_result();
+}
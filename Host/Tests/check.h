@@ -0,0 +1,46 @@
+#ifndef TESTS_CHECK_H_
+#define TESTS_CHECK_H_
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// Minimal checks for the host tests. Each test is its own executable run by
+// ctest, failures are printed and counted, and check_result() is the exit
+// code.
+
+inline int& check_failures()
+{
+	static int failures = 0;
+	return failures;
+}
+
+// Prints the formatted message when the condition fails, returns the condition
+inline bool check(bool condition, const char* format, ...)
+{
+	if (!condition)
+	{
+		va_list args;
+		va_start(args, format);
+		fprintf(stderr, "FAIL: ");
+		vfprintf(stderr, format, args);
+		fprintf(stderr, "\n");
+		va_end(args);
+
+		check_failures()++;
+	}
+
+	return condition;
+}
+
+inline int check_result()
+{
+	if (check_failures() > 0)
+	{
+		fprintf(stderr, "%d checks failed\n", check_failures());
+		return 1;
+	}
+
+	return 0;
+}
+
+#endif /* TESTS_CHECK_H_ */
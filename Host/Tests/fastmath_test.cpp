@@ -0,0 +1,238 @@
+#include "check.h"
+#include "lib/fastmath/fastmath.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// Sweeps every fastmath kernel over the domains listed in fastmath.h and
+// fails if the error against double libm exceeds the documented bound.
+
+static constexpr uint32_t POINTS = 1000000;
+
+struct Error
+{
+	double max_abs = 0;
+	double max_rel = 0;
+	float worst_abs_x = 0;
+	float worst_rel_x = 0;
+
+	void add(float x, double value, double reference)
+	{
+		const double abs_err = fabs(value - reference);
+		const double rel_err = reference != 0 ? abs_err / fabs(reference) : abs_err;
+
+		if (abs_err > max_abs)
+		{
+			max_abs = abs_err;
+			worst_abs_x = x;
+		}
+
+		if (rel_err > max_rel)
+		{
+			max_rel = rel_err;
+			worst_rel_x = x;
+		}
+	}
+};
+
+enum Bound_type
+{
+	BOUND_ABS,
+	BOUND_REL
+};
+
+static void report(const char* kernel, const char* domain, const Error& error, Bound_type type, double bound)
+{
+	const double measured = type == BOUND_ABS ? error.max_abs : error.max_rel;
+	const bool ok = measured <= bound;
+
+	printf("%-12s %-26s abs %9.2e  rel %9.2e  bound %s %7.1e  %s\n", kernel, domain,
+		error.max_abs, error.max_rel, type == BOUND_ABS ? "abs" : "rel", bound, ok ? "ok" : "EXCEEDED");
+
+	check(ok, "%s over %s: %s error %.3e > %.1e, worst near x = %.9g", kernel, domain,
+		type == BOUND_ABS ? "abs" : "rel", measured, bound,
+		type == BOUND_ABS ? error.worst_abs_x : error.worst_rel_x);
+}
+
+// Evenly spaced points over [lo, hi], both ends included
+static float grid(float lo, float hi, uint32_t i, uint32_t n)
+{
+	return lo + (hi - lo) * (float)((double)i / (n - 1));
+}
+
+static uint32_t xorshift(uint32_t* state)
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+static float from_bits(uint32_t bits)
+{
+	float x;
+	memcpy(&x, &bits, sizeof(x));
+	return x;
+}
+
+static void sweep_sin_cos()
+{
+	const struct { const char* domain; float range; double bound; } domains[] = {
+		{"|x| <= 2 pi", FASTMATH_2PI, 2.8e-7},
+		{"|x| <= 100", 100.0f, 8.6e-6}
+	};
+
+	for (const auto& d : domains)
+	{
+		Error sin_error, cos_error;
+
+		for (uint32_t i = 0; i < POINTS; i++)
+		{
+			const float x = grid(-d.range, d.range, i, POINTS);
+			sin_error.add(x, fast_sinf(x), sin((double)x));
+			cos_error.add(x, fast_cosf(x), cos((double)x));
+		}
+
+		report("fast_sinf", d.domain, sin_error, BOUND_ABS, d.bound);
+		report("fast_cosf", d.domain, cos_error, BOUND_ABS, d.bound);
+	}
+}
+
+static void sweep_atan2()
+{
+	Error error;
+	uint32_t state = 0x12345678;
+
+	// Every direction at magnitudes across the float range
+	for (uint32_t i = 0; i < POINTS; i++)
+	{
+		const double angle = grid(-FASTMATH_PI, FASTMATH_PI, i, POINTS);
+		const double magnitude = ldexp(1.0, (int)(xorshift(&state) % 200) - 100);
+		const float y = (float)(magnitude * sin(angle));
+		const float x = (float)(magnitude * cos(angle));
+
+		error.add(y, fast_atan2f(y, x), atan2((double)y, (double)x));
+	}
+
+	// Arbitrary finite pairs, including subnormals and mismatched scales
+	for (uint32_t i = 0; i < POINTS; i++)
+	{
+		const float y = from_bits(xorshift(&state));
+		const float x = from_bits(xorshift(&state));
+
+		if (isfinite(y) && isfinite(x))
+		{
+			error.add(y, fast_atan2f(y, x), atan2((double)y, (double)x));
+		}
+	}
+
+	report("fast_atan2f", "all finite y, x", error, BOUND_ABS, 5.3e-7);
+}
+
+static void sweep_asin()
+{
+	Error error;
+
+	for (uint32_t i = 0; i < POINTS; i++)
+	{
+		const float x = grid(-1.0f, 1.0f, i, POINTS);
+		error.add(x, fast_asinf(x), asin((double)x));
+	}
+
+	report("fast_asinf", "[-1, 1]", error, BOUND_ABS, 3.0e-7);
+}
+
+static void sweep_sqrt()
+{
+	Error error;
+	uint32_t wrong = 0;
+
+	// Every 64th float from 0 to the largest finite one
+	for (uint32_t bits = 0; bits < 0x7F800000; bits += 64)
+	{
+		const float x = from_bits(bits);
+		const float value = fast_sqrtf(x);
+		const float rounded = (float)sqrt((double)x);
+
+		error.add(x, value, sqrt((double)x));
+		wrong += value != rounded;
+	}
+
+	printf("%-12s %-26s abs %9.2e  rel %9.2e  %u not correctly rounded\n", "fast_sqrtf", "x >= 0",
+		error.max_abs, error.max_rel, wrong);
+	check(wrong == 0, "fast_sqrtf: %u results not correctly rounded", wrong);
+}
+
+static void sweep_exp()
+{
+	const struct { const char* domain; float range; double bound; } domains[] = {
+		{"[-10, 10]", 10.0f, 6.8e-7},
+		{"[-80, 80]", 80.0f, 3.9e-6}
+	};
+
+	for (const auto& d : domains)
+	{
+		Error error;
+
+		for (uint32_t i = 0; i < POINTS; i++)
+		{
+			const float x = grid(-d.range, d.range, i, POINTS);
+			error.add(x, fast_expf(x), exp((double)x));
+		}
+
+		report("fast_expf", d.domain, error, BOUND_REL, d.bound);
+	}
+}
+
+static void sweep_log()
+{
+	Error near_error;
+
+	for (uint32_t i = 0; i < POINTS; i++)
+	{
+		const float x = grid(1e-3f, 10.0f, i, POINTS);
+		near_error.add(x, fast_logf(x), log((double)x));
+	}
+
+	report("fast_logf", "[1e-3, 10]", near_error, BOUND_ABS, 6.0e-7);
+
+	// Every 16th positive normal float
+	Error normal_error;
+
+	for (uint32_t bits = 0x00800000; bits < 0x7F800000; bits += 16)
+	{
+		const float x = from_bits(bits);
+		normal_error.add(x, fast_logf(x), log((double)x));
+	}
+
+	report("fast_logf", "positive normals", normal_error, BOUND_REL, 3.1e-7);
+}
+
+static void sweep_pow()
+{
+	// Exponent of the barometric altitude formula in barometer.c
+	const float y = 1.0f / 5.255f;
+	Error error;
+
+	for (uint32_t i = 0; i < POINTS; i++)
+	{
+		const float x = grid(0.3f, 1.2f, i, POINTS);
+		error.add(x, fast_powf(x, y), pow((double)x, (double)y));
+	}
+
+	report("fast_powf", "x in [0.3, 1.2], y = 0.19", error, BOUND_REL, 1.8e-7);
+}
+
+int main()
+{
+	sweep_sin_cos();
+	sweep_atan2();
+	sweep_asin();
+	sweep_sqrt();
+	sweep_exp();
+	sweep_log();
+	sweep_pow();
+
+	return check_result();
+}
@@ -0,0 +1,140 @@
+#include "check.h"
+#include "bench/geo_double.h"
+#include "lib/geo/geo.h"
+#include "lib/geo/map_projection.h"
+#include <math.h>
+#include <stdint.h>
+
+// Checks the float geodesy in lib/geo, lat_lon_to_meters and the cached
+// MapProjection, against the double implementation it replaced, for random pairs at a fixed distance up to 85 degrees latitude, against
+// the worst case errors in geo.h. Up to 10 km that is well within a
+// centimetre.
+
+static constexpr uint32_t PAIRS = 200000;
+static constexpr double EARTH_RADIUS = 6378137.0;
+
+static uint32_t xorshift(uint32_t* state)
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+// Uniform in [lo, hi]
+static double uniform(uint32_t* state, double lo, double hi)
+{
+	return lo + (hi - lo) * (xorshift(state) / 4294967295.0);
+}
+
+// Distance in meters between two nearby positions in degrees
+static double distance(double lat_a, double lon_a, double lat_b, double lon_b)
+{
+	const double north = (lat_b - lat_a) * M_PI / 180.0 * EARTH_RADIUS;
+	const double east = (lon_b - lon_a) * M_PI / 180.0 * EARTH_RADIUS * cos((lat_a + lat_b) / 2.0 * M_PI / 180.0);
+	return hypot(north, east);
+}
+
+// Longitude in degrees on the same side of the antimeridian as lon_ref
+static double unwrap_lon(int32_t lon_ref, int32_t lon)
+{
+	double delta = (lon - (double)lon_ref) * 1E-7;
+
+	if (delta > 180)
+	{
+		delta -= 360;
+	}
+	else if (delta < -180)
+	{
+		delta += 360;
+	}
+
+	return lon_ref * 1E-7 + delta;
+}
+
+static void check_range(double range, double to_meters_bound, double round_trip_bound, double project_bound)
+{
+	uint32_t state = 0x9E3779B9;
+	double to_meters_error = 0;
+	double round_trip_error = 0;
+	double project_error = 0;
+	double reproject_error = 0;
+
+	for (uint32_t i = 0; i < PAIRS; i++)
+	{
+		// A reference and a point range meters away in a random direction,
+		// kept clear of the poles where east is undefined
+		const double bearing = uniform(&state, -M_PI, M_PI);
+		const double north = range * cos(bearing);
+		const double east = range * sin(bearing);
+		const int32_t lat_ref = (int32_t)uniform(&state, -85E7, 85E7);
+		const int32_t lon_ref = (int32_t)uniform(&state, -180E7, 180E7);
+
+		double lat_deg, lon_deg;
+		geo_double_meters_to_lat_lon(north, east, lat_ref * 1E-7, lon_ref * 1E-7, &lat_deg, &lon_deg);
+
+		if (lon_deg > 180)
+		{
+			lon_deg -= 360;
+		}
+		else if (lon_deg < -180)
+		{
+			lon_deg += 360;
+		}
+
+		const int32_t lat = (int32_t)lround(lat_deg * 1E7);
+		const int32_t lon = (int32_t)lround(lon_deg * 1E7);
+
+		// Reference projection of the exact integer position
+		double north_ref, east_ref;
+		geo_double_lat_lon_to_meters(lat_ref * 1E-7, lon_ref * 1E-7, lat * 1E-7, unwrap_lon(lon_ref, lon), &north_ref, &east_ref);
+
+		float north_f, east_f;
+		lat_lon_to_meters(lat_ref, lon_ref, lat, lon, &north_f, &east_f);
+		to_meters_error = fmax(to_meters_error, hypot(north_f - north_ref, east_f - east_ref));
+
+		// Float meters back to a position, compared with where it started
+		int32_t lat_back, lon_back;
+		meters_to_lat_lon(north_f, east_f, lat_ref, lon_ref, &lat_back, &lon_back);
+		round_trip_error = fmax(round_trip_error, distance(lat * 1E-7, lon * 1E-7, lat_back * 1E-7, unwrap_lon(lon, lon_back)));
+
+		// Same through the projection the estimator and navigator cache
+		MapProjection projection;
+		projection.init(lat_ref, lon_ref);
+
+		float north_p, east_p;
+		projection.project(lat, lon, &north_p, &east_p);
+		project_error = fmax(project_error, hypot(north_p - north_ref, east_p - east_ref));
+
+		projection.reproject(north_p, east_p, &lat_back, &lon_back);
+		reproject_error = fmax(reproject_error, distance(lat * 1E-7, lon * 1E-7, lat_back * 1E-7, unwrap_lon(lon, lon_back)));
+	}
+
+	printf("%7.0f m  lat_lon_to_meters vs double %8.2f mm (bound %4.1f)  round trip %8.2f mm (bound %4.1f)\n",
+		range, to_meters_error * 1E3, to_meters_bound * 1E3, round_trip_error * 1E3, round_trip_bound * 1E3);
+
+	check(to_meters_error <= to_meters_bound, "lat_lon_to_meters at %.0f m: %.2f mm from double, bound %.1f mm",
+		range, to_meters_error * 1E3, to_meters_bound * 1E3);
+	check(round_trip_error <= round_trip_bound, "meters_to_lat_lon round trip at %.0f m: %.2f mm, bound %.1f mm",
+		range, round_trip_error * 1E3, round_trip_bound * 1E3);
+
+	printf("%7.0f m  MapProjection::project vs double %8.2f mm (bound %4.1f)  round trip %8.2f mm (bound %4.1f)\n",
+		range, project_error * 1E3, project_bound * 1E3, reproject_error * 1E3, round_trip_bound * 1E3);
+
+	check(project_error <= project_bound, "MapProjection::project at %.0f m: %.2f mm from double, bound %.1f mm",
+		range, project_error * 1E3, project_bound * 1E3);
+	check(reproject_error <= round_trip_bound, "MapProjection::reproject round trip at %.0f m: %.2f mm, bound %.1f mm",
+		range, reproject_error * 1E3, round_trip_bound * 1E3);
+}
+
+int main()
+{
+	// Bounds from geo.h and map_projection.h, the round trip also includes
+	// rounding to 1E-7 deg
+	check_range(1000, 0.0003, 0.001, 0.0004);
+	check_range(10000, 0.003, 0.005, 0.004);
+	check_range(100000, 0.03, 0.03, 0.04);
+
+	return check_result();
+}
@@ -0,0 +1,124 @@
+#include "check.h"
+#include "lib/filters/gyro_fft.h"
+#include <math.h>
+#include <stdint.h>
+
+// Feeds Gyro_fft a synthetic gyro signal, two tones on different axes over a
+// little noise, and checks the peaks it reports, the update cadence and that
+// the peaks stay inside the IMU_DNF_MIN to IMU_DNF_MAX search range.
+
+static constexpr float SAMPLE_RATE = 1000;
+static constexpr float BIN_WIDTH = SAMPLE_RATE / Gyro_fft::N;
+static constexpr float MIN_FREQ = 60;
+static constexpr float MAX_FREQ = 400;
+
+static uint32_t xorshift(uint32_t* state)
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+struct Tone
+{
+	float freq;
+	float amplitude;
+};
+
+// Runs samples through a fresh Gyro_fft, returns the number of updates
+static uint32_t run(Gyro_fft* fft, const Tone tones[2], uint32_t samples)
+{
+	fft->set_range(MIN_FREQ, MAX_FREQ);
+
+	uint32_t state = 0xC0FFEE;
+	uint32_t updates = 0;
+	uint32_t last_update = 0;
+
+	for (uint32_t n = 1; n <= samples; n++)
+	{
+		const double t = n / (double)SAMPLE_RATE;
+		const float noise = (float)(xorshift(&state) / 4294967295.0 - 0.5) * 0.02f;
+
+		// The first tone mostly on roll, the second on pitch, yaw gets both
+		const float a = tones[0].amplitude * (float)sin(2 * M_PI * tones[0].freq * t);
+		const float b = tones[1].amplitude * (float)sin(2 * M_PI * tones[1].freq * t + 1.0);
+		const float gyr[3] = {a + noise, b - noise, 0.3f * (a + b) + noise};
+
+		if (fft->update(gyr, SAMPLE_RATE))
+		{
+			// One analysis per hop of half a window once it is full
+			check(updates == 0 || n - last_update == Gyro_fft::N / 2, "update after %u samples", n - last_update);
+			updates++;
+			last_update = n;
+		}
+	}
+
+	return updates;
+}
+
+static void test_two_tones()
+{
+	const Tone tones[2] = {{237.0f, 0.5f}, {123.5f, 1.0f}};
+
+	Gyro_fft fft;
+	const uint32_t updates = run(&fft, tones, 4000);
+
+	printf("two tones: %.2f Hz snr %.0f, %.2f Hz snr %.0f after %u updates\n", fft.peak_freq[0], fft.peak_snr[0],
+		fft.peak_freq[1], fft.peak_snr[1], updates);
+
+	check(updates > 4000 / (Gyro_fft::N / 2) - 4, "only %u updates", updates);
+
+	// Sorted low to high whatever their power. A parabola through the Hann
+	// windowed power is off by up to about a tenth of a bin.
+	check(fabsf(fft.peak_freq[0] - tones[1].freq) < 0.15f * BIN_WIDTH, "low peak at %.2f Hz, tone at %.2f Hz",
+		fft.peak_freq[0], tones[1].freq);
+	check(fabsf(fft.peak_freq[1] - tones[0].freq) < 0.15f * BIN_WIDTH, "high peak at %.2f Hz, tone at %.2f Hz",
+		fft.peak_freq[1], tones[0].freq);
+	check(fft.peak_snr[0] > 100 && fft.peak_snr[1] > 100, "snr %.1f and %.1f", fft.peak_snr[0], fft.peak_snr[1]);
+}
+
+static void test_noise_only()
+{
+	const Tone tones[2] = {{100, 0}, {200, 0}};
+
+	Gyro_fft fft;
+	run(&fft, tones, 2000);
+
+	check(fft.peak_freq[0] == 0 && fft.peak_freq[1] == 0, "peaks at %.2f and %.2f Hz in noise", fft.peak_freq[0],
+		fft.peak_freq[1]);
+}
+
+// Tones in the end bins of the search range but outside it must not move the
+// notches past IMU_DNF_MIN and IMU_DNF_MAX, tones well outside are ignored
+static void test_range()
+{
+	const Tone edges[2] = {{MIN_FREQ - 0.4f * BIN_WIDTH, 1.0f}, {MAX_FREQ + 0.2f * BIN_WIDTH, 1.0f}};
+
+	Gyro_fft fft;
+	run(&fft, edges, 4000);
+
+	printf("tones at %.2f and %.2f Hz: peaks at %.2f and %.2f Hz\n", edges[0].freq, edges[1].freq,
+		fft.peak_freq[0], fft.peak_freq[1]);
+
+	check(fft.peak_freq[0] == MIN_FREQ, "peak below the range at %.2f Hz", fft.peak_freq[0]);
+	check(fft.peak_freq[1] == MAX_FREQ, "peak above the range at %.2f Hz", fft.peak_freq[1]);
+
+	const Tone outside[2] = {{25, 1.0f}, {470, 1.0f}};
+
+	Gyro_fft outside_fft;
+	run(&outside_fft, outside, 4000);
+
+	check(outside_fft.peak_freq[0] == 0 && outside_fft.peak_freq[1] == 0, "tones outside the range gave %.2f and %.2f Hz",
+		outside_fft.peak_freq[0], outside_fft.peak_freq[1]);
+}
+
+int main()
+{
+	test_two_tones();
+	test_noise_only();
+	test_range();
+
+	return check_result();
+}
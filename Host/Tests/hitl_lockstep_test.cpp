@@ -0,0 +1,436 @@
+#include "check.h"
+#include "Linux_HAL/linux_hal.h"
+#include "Sim/param_file.h"
+#include "autopilot.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <math.h>
+#include <memory>
+#include <stdlib.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+// Steps an autopilot in lockstep HITL over a socketpair, the way the
+// simulator does over USB, and checks the answers: sequence and time are
+// echoed, a repeated step is answered without running the loop and a gap in
+// the sequence is stepped through. A second autopilot runs free on the
+// Linux HAL scheduler with the same samples at the same times, its outputs
+// have to match the lockstep ones exactly.
+
+static constexpr uint32_t NUM_STEPS = 3000;
+static constexpr uint64_t STEP_US = 10000;
+static constexpr uint32_t DUPLICATE_STEP = 1500; // Sent twice
+static constexpr uint32_t GAP_STEP = 2500; // Sequence skips one from here on
+
+// Switches up for stabilized, then auto
+static constexpr uint32_t STABILIZED_STEP = 1000;
+static constexpr uint32_t AUTO_STEP = 2000;
+
+static constexpr uint16_t RC_LOW = 600;
+static constexpr uint16_t RC_CENTER = 1200;
+static constexpr uint16_t RC_HIGH = 1811;
+
+static constexpr int32_t HOME_LAT = 433890000;
+static constexpr int32_t HOME_LON = -794000000;
+
+struct Step_result
+{
+	bool answered = false;
+	bool has_output = false;
+	uint16_t duty[3] = {}; // Elevator, rudder, throttle
+};
+
+// Sensors of a vehicle rocking gently on the bench with a little noise,
+// the same on every run
+static aplink_hitl_step make_step(uint32_t step, uint32_t* seed)
+{
+	auto noise = [seed](float amplitude)
+	{
+		*seed = *seed * 1664525 + 1013904223;
+		return amplitude * ((*seed >> 8) * (2.0f / 16777216.0f) - 1.0f);
+	};
+
+	const float t = step * STEP_US * 1e-6f;
+
+	aplink_hitl_step sample{};
+	sample.time_us = step * STEP_US;
+	sample.imu_gx = 10.0f * sinf(1.3f * t) + noise(0.1f);
+	sample.imu_gy = 5.0f * sinf(0.7f * t) + noise(0.1f);
+	sample.imu_gz = noise(0.1f);
+	sample.imu_ax = noise(0.01f);
+	sample.imu_ay = noise(0.01f);
+	sample.imu_az = -1.0f + noise(0.01f);
+	sample.mag_x = -20.0f + noise(0.2f);
+	sample.mag_y = noise(0.2f);
+	sample.mag_z = -45.0f + noise(0.2f);
+	sample.baro_asl = 100.0f + noise(0.2f);
+	sample.gps_lat = HOME_LAT;
+	sample.gps_lon = HOME_LON;
+	return sample;
+}
+
+static void make_rc(uint32_t step, uint16_t rc[16])
+{
+	for (uint8_t i = 0; i < 16; i++)
+	{
+		rc[i] = RC_CENTER;
+	}
+
+	rc[THR_CH] = RC_LOW;
+	rc[MAN_CH] = step >= STABILIZED_STEP ? RC_HIGH : RC_LOW;
+	rc[MOD_CH] = step >= AUTO_STEP ? RC_HIGH : RC_LOW;
+}
+
+// Parameters for both autopilots. The IMU filters are off so the flight
+// sensor path publishes the samples unchanged, as the HITL path does.
+static bool load_params(param_context_t* params)
+{
+	if (param_load_file(params, "params/sitl.params") < 0)
+	{
+		return false;
+	}
+
+	param_set_float(params, param_find(params, "IMU_GYR_CUTOFF"), 0);
+	param_set_float(params, param_find(params, "IMU_ACC_CUTOFF"), 0);
+	param_set_int32(params, param_find(params, "IMU_DNF_EN"), 0);
+	param_set_int32(params, param_find(params, "LOG_SENSORS"), 0);
+
+	// Throttle low must still read as a connected transmitter
+	param_set_int32(params, param_find(params, "RC_MIN_DUTY"), RC_LOW);
+	return true;
+}
+
+// Saves a mission to the SD directory, so both autopilots load it at boot
+static void save_mission(const std::string& sd_dir)
+{
+	LinuxHAL hal(sd_dir);
+	hal.init();
+	DataBus data_bus;
+	param_context_t params;
+	param_init(&params);
+	mission_context_t mission;
+	mission_init(&mission);
+	MissionStorage storage(&hal, &data_bus, &params, &mission);
+
+	mission_data_t* staging = mission_begin_update(&mission);
+	staging->num_items = 4;
+	staging->mission_type = MISSION_WAYPOINT;
+
+	uint16_t sent = 0;
+
+	while (mission_get_upload_state(&mission) == MISSION_UPLOAD_RECEIVING)
+	{
+		if (sent < staging->num_items && mission_upload_ready(&mission))
+		{
+			mission_item_t item = {};
+			item.latitude = HOME_LAT + (sent + 1) * 20000;
+			item.longitude = HOME_LON + (sent % 2) * 20000;
+			item.altitude = 500;
+			item.type = MISSION_WAYPOINT;
+			mission_add_item(&mission, &item);
+			sent++;
+		}
+		else
+		{
+			storage.update();
+		}
+	}
+
+	check(mission_get_upload_state(&mission) == MISSION_UPLOAD_DONE, "mission upload to %s failed", sd_dir.c_str());
+}
+
+// The altitude is only held in RAM, it comes from the ground station
+static int open_telem(LinuxHAL* hal)
+{
+	int fds[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+	{
+		return -1;
+	}
+
+	fcntl(fds[0], F_SETFL, O_NONBLOCK);
+	fcntl(fds[1], F_SETFL, O_NONBLOCK);
+	hal->set_telem_fd(fds[0]);
+
+	aplink_set_altitude altitude{50.0f};
+	uint8_t packet[MAX_PACKET_LEN];
+	const uint16_t len = aplink_set_altitude_pack(altitude, packet);
+
+	if (write(fds[1], packet, len) != len)
+	{
+		return -1;
+	}
+
+	return fds[1];
+}
+
+// Everything the telemetry sent, so it never fills the socket
+static void drain(int fd)
+{
+	uint8_t buffer[4096];
+	while (read(fd, buffer, sizeof(buffer)) > 0);
+}
+
+static bool send_step(int fd, const aplink_hitl_step& step)
+{
+	uint8_t packet[MAX_PACKET_LEN];
+	const uint16_t len = aplink_hitl_step_pack(step, packet);
+	return write(fd, packet, len) == len;
+}
+
+static std::vector<aplink_hitl_step_output> read_outputs(int fd, aplink_msg* msg)
+{
+	std::vector<aplink_hitl_step_output> outputs;
+	uint8_t buffer[1024];
+	ssize_t len;
+
+	while ((len = read(fd, buffer, sizeof(buffer))) > 0)
+	{
+		for (ssize_t i = 0; i < len; i++)
+		{
+			aplink_hitl_step_output output;
+
+			if (aplink_parse_byte(msg, buffer[i]) && msg->msg_id == HITL_STEP_OUTPUT_MSG_ID &&
+				aplink_hitl_step_output_unpack(msg, &output))
+			{
+				outputs.push_back(output);
+			}
+		}
+	}
+
+	return outputs;
+}
+
+static std::vector<Step_result> run_lockstep(const std::string& sd_dir)
+{
+	std::vector<Step_result> results(NUM_STEPS + 1);
+
+	LinuxHAL hal(sd_dir);
+	std::unique_ptr<Autopilot> autopilot = std::make_unique<Autopilot>(&hal);
+	check(load_params(autopilot->get_params()), "cannot read params/sitl.params");
+
+	int fds[2];
+	check(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0, "socketpair failed");
+	fcntl(fds[0], F_SETFL, O_NONBLOCK);
+	fcntl(fds[1], F_SETFL, O_NONBLOCK);
+	hal.set_usb_fd(fds[0]);
+	const int telem_fd = open_telem(&hal);
+
+	autopilot->setup();
+
+	aplink_msg msg{};
+	uint32_t seed = 1;
+	uint32_t wrong_echo = 0;
+	uint32_t wrong_count = 0;
+
+	for (uint32_t step = 1; step <= NUM_STEPS; step++)
+	{
+		uint16_t rc[16];
+		make_rc(step, rc);
+		hal.push_rc(rc, 16);
+
+		aplink_hitl_step sample = make_step(step, &seed);
+		sample.sequence = step >= GAP_STEP ? step + 1 : step;
+		send_step(fds[1], sample);
+		hal.run_until(sample.time_us);
+
+		std::vector<aplink_hitl_step_output> outputs = read_outputs(fds[1], &msg);
+		wrong_count += outputs.size() != 1;
+
+		if (outputs.empty())
+		{
+			continue;
+		}
+
+		const aplink_hitl_step_output output = outputs.back();
+		wrong_echo += output.sequence != sample.sequence || output.time_us != sample.time_us;
+
+		Step_result& result = results[step];
+		result.answered = true;
+		result.has_output = output.ele_pwm || output.rud_pwm || output.thr_pwm;
+		result.duty[0] = output.ele_pwm;
+		result.duty[1] = output.rud_pwm;
+		result.duty[2] = output.thr_pwm;
+
+		// The simulator missed the answer and sends the step again, with
+		// different contents it must not use
+		if (step == DUPLICATE_STEP)
+		{
+			aplink_hitl_step repeat = make_step(step + 100, &seed);
+			repeat.sequence = sample.sequence;
+			send_step(fds[1], repeat);
+			hal.run_until(repeat.time_us);
+
+			outputs = read_outputs(fds[1], &msg);
+			check(outputs.size() == 1, "repeated step answered %zu times", outputs.size());
+			check(hal.get_time_us() == sample.time_us, "repeated step moved the time to %llu us",
+				(unsigned long long)hal.get_time_us());
+
+			if (!outputs.empty())
+			{
+				const aplink_hitl_step_output& again = outputs.back();
+				check(again.sequence == sample.sequence && again.time_us == sample.time_us,
+					"repeated step answered as %u at %llu us", again.sequence, (unsigned long long)again.time_us);
+				check(again.ele_pwm == output.ele_pwm && again.rud_pwm == output.rud_pwm && again.thr_pwm == output.thr_pwm,
+					"repeated step ran the loop again");
+			}
+		}
+
+		drain(telem_fd);
+	}
+
+	check(wrong_count == 0, "%u steps not answered exactly once", wrong_count);
+	check(wrong_echo == 0, "%u answers with the wrong sequence or time", wrong_echo);
+
+	close(fds[1]);
+	close(telem_fd);
+	return results;
+}
+
+// The same samples through the sensor feeds, each IMU sample starts the fast
+// task and the main task follows at the same time, the order of a step
+static std::vector<Step_result> run_free(const std::string& sd_dir)
+{
+	std::vector<Step_result> results(NUM_STEPS + 1);
+
+	LinuxHAL hal(sd_dir);
+	std::unique_ptr<Autopilot> autopilot = std::make_unique<Autopilot>(&hal);
+	check(load_params(autopilot->get_params()), "cannot read params/sitl.params");
+	const int telem_fd = open_telem(&hal);
+
+	autopilot->setup();
+
+	uint32_t seed = 1;
+
+	for (uint32_t step = 1; step <= NUM_STEPS; step++)
+	{
+		uint16_t rc[16];
+		make_rc(step, rc);
+		hal.push_rc(rc, 16);
+
+		const aplink_hitl_step sample = make_step(step, &seed);
+
+		if (step == DUPLICATE_STEP)
+		{
+			make_step(step + 100, &seed);
+		}
+
+		IMU_data imu;
+		imu.gx = sample.imu_gx;
+		imu.gy = sample.imu_gy;
+		imu.gz = sample.imu_gz;
+		imu.ax = sample.imu_ax;
+		imu.ay = sample.imu_ay;
+		imu.az = sample.imu_az;
+		imu.timestamp = sample.time_us;
+		hal.push_imu(imu);
+
+		// Sensors reads nothing during the first step, which only loads the
+		// parameters, so the other samples would queue up behind
+		if (step > 1)
+		{
+			hal.push_mag(Mag_data{sample.mag_x, sample.mag_y, sample.mag_z, sample.time_us});
+
+			Baro_data baro;
+			baro.alt = sample.baro_asl;
+			baro.timestamp = sample.time_us;
+			hal.push_baro(baro);
+
+			GNSS_data gnss;
+			gnss.lat = sample.gps_lat;
+			gnss.lon = sample.gps_lon;
+			gnss.sats = 10;
+			gnss.fix = true;
+			gnss.timestamp = sample.time_us;
+			hal.push_gnss(gnss);
+		}
+
+		hal.run_until(sample.time_us);
+
+		const Pwm_output& pwm = hal.get_pwm();
+		Step_result& result = results[step];
+		result.answered = true;
+		result.has_output = pwm.timestamp == sample.time_us;
+		result.duty[0] = pwm.duty[0];
+		result.duty[1] = pwm.duty[1];
+		result.duty[2] = pwm.duty[2];
+
+		drain(telem_fd);
+	}
+
+	close(telem_fd);
+	return results;
+}
+
+static void remove_sd(const std::string& sd_dir)
+{
+	const std::string command = "rm -rf '" + sd_dir + "'";
+
+	if (system(command.c_str()) != 0)
+	{
+		fprintf(stderr, "Cannot remove %s\n", sd_dir.c_str());
+	}
+}
+
+int main()
+{
+	char sd_template[] = "/tmp/hitl_lockstep_test.XXXXXX";
+	const char* sd_root = mkdtemp(sd_template);
+
+	if (!sd_root)
+	{
+		fprintf(stderr, "Cannot create a temporary directory\n");
+		return 1;
+	}
+
+	const std::string lockstep_dir = std::string(sd_root) + "/lockstep";
+	const std::string free_dir = std::string(sd_root) + "/free";
+	save_mission(lockstep_dir);
+	save_mission(free_dir);
+
+	const std::vector<Step_result> lockstep = run_lockstep(lockstep_dir);
+	const std::vector<Step_result> free = run_free(free_dir);
+
+	// Servo outputs are compared on steps where both ran the mixer in flight,
+	// the free running HAL passes RC straight through in direct mode
+	uint32_t compared = 0;
+	uint32_t mismatched = 0;
+	uint32_t first_mismatch = 0;
+	uint16_t min_ele = UINT16_MAX;
+	uint16_t max_ele = 0;
+
+	for (uint32_t step = 1; step <= NUM_STEPS; step++)
+	{
+		if (!lockstep[step].has_output || !free[step].has_output)
+		{
+			continue;
+		}
+
+		compared++;
+		min_ele = std::min(min_ele, lockstep[step].duty[0]);
+		max_ele = std::max(max_ele, lockstep[step].duty[0]);
+
+		if (memcmp(lockstep[step].duty, free[step].duty, sizeof(lockstep[step].duty)) != 0)
+		{
+			if (mismatched++ == 0)
+			{
+				first_mismatch = step;
+			}
+		}
+	}
+
+	printf("%u steps compared, %u differ, elevator %u to %u\n", compared, mismatched, min_ele, max_ele);
+
+	check(compared >= NUM_STEPS - STABILIZED_STEP, "only %u steps with outputs to compare", compared);
+	check(max_ele - min_ele > 50, "elevator only moved from %u to %u, nothing to compare", min_ele, max_ele);
+	check(mismatched == 0, "%u steps differ from the free running autopilot, first at step %u: %u %u %u, free %u %u %u",
+		mismatched, first_mismatch,
+		lockstep[first_mismatch].duty[0], lockstep[first_mismatch].duty[1], lockstep[first_mismatch].duty[2],
+		free[first_mismatch].duty[0], free[first_mismatch].duty[1], free[first_mismatch].duty[2]);
+
+	remove_sd(sd_root);
+	return check_result();
+}
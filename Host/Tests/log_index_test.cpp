@@ -0,0 +1,355 @@
+#include "check.h"
+#include "Log_index/log_index.h"
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern "C"
+{
+#include "lib/aplink_c/aplink.h"
+#include "lib/aplink_c/aplink_messages.h"
+}
+
+// Exports a synthetic multi-MB log with flipped bytes, garbage, truncated and
+// unknown frames at several thread counts. Every column file and the manifest
+// have to match the single threaded export byte for byte. The IMU frames
+// carry a complete log_tick frame in their payload, so chunks that start
+// inside them find a false first frame and have to be rescanned. Queries are
+// checked against a count of the time index, sorted and not.
+
+static constexpr size_t LOG_SIZE = 9 << 20;
+static const unsigned THREADS[] = {2, 3, 4, 5, 8};
+
+static uint32_t rng_state = 12345;
+
+static uint32_t rng()
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+static float rng_float()
+{
+	return (int32_t)rng() * 1e-6f;
+}
+
+static bool read_file(const std::string& path, std::string* data)
+{
+	FILE* f = fopen(path.c_str(), "rb");
+
+	if (!f)
+	{
+		return false;
+	}
+
+	char chunk[65536];
+	size_t len;
+
+	while ((len = fread(chunk, 1, sizeof(chunk), f)) > 0)
+	{
+		data->append(chunk, len);
+	}
+
+	fclose(f);
+	return true;
+}
+
+static void append_packet(std::string* log, const uint8_t* packet, uint16_t len)
+{
+	log->append((const char*)packet, len);
+}
+
+static std::string make_log()
+{
+	std::string log;
+	uint8_t packet[MAX_PACKET_LEN];
+
+	for (uint64_t tick = 0; log.size() < LOG_SIZE; tick++)
+	{
+		const uint64_t time_us = 1000000 + tick * 1000;
+		const size_t frame_start = log.size();
+
+		aplink_log_imu_t imu;
+		imu.time_us = time_us;
+		imu.gx = rng_float();
+		imu.gy = rng_float();
+		imu.gz = rng_float();
+		imu.ax = rng_float();
+		imu.ay = rng_float();
+		imu.az = rng_float();
+
+		// A valid frame hidden in the payload, only seen by a walk that
+		// starts inside this frame
+		aplink_log_tick_t hidden = {};
+		hidden.time_us = time_us;
+		uint8_t hidden_packet[MAX_PACKET_LEN];
+		const uint16_t hidden_len = aplink_log_tick_pack(hidden, hidden_packet);
+		memcpy((uint8_t*)&imu + sizeof(imu.time_us), hidden_packet, hidden_len);
+
+		append_packet(&log, packet, aplink_log_imu_pack(imu, packet));
+
+		if (tick % 4 == 0)
+		{
+			aplink_log_baro_t baro = {};
+			baro.time_us = time_us;
+			baro.alt = rng_float();
+			baro.pressure = 101325.0f + rng_float();
+			append_packet(&log, packet, aplink_log_baro_pack(baro, packet));
+		}
+
+		if (tick % 10 == 0)
+		{
+			aplink_log_mag_t mag = {};
+			mag.time_us = time_us;
+			mag.x = rng_float();
+			mag.y = rng_float();
+			mag.z = rng_float();
+			append_packet(&log, packet, aplink_log_mag_pack(mag, packet));
+
+			aplink_log_tick_t log_tick = {};
+			log_tick.time_us = time_us;
+			log_tick.system_mode = tick % 5;
+			log_tick.dropped_bytes = tick;
+			append_packet(&log, packet, aplink_log_tick_pack(log_tick, packet));
+		}
+
+		if (tick % 100 == 0)
+		{
+			aplink_log_gnss_t gnss = {};
+			gnss.time_us = time_us;
+			gnss.lat = rng();
+			gnss.lon = rng();
+			gnss.fix = 3;
+			append_packet(&log, packet, aplink_log_gnss_pack(gnss, packet));
+
+			// Valid frame without a schema
+			uint8_t payload[40];
+			for (uint8_t& byte : payload)
+			{
+				byte = rng();
+			}
+			append_packet(&log, packet, aplink_pack(packet, payload, sizeof(payload), 200));
+		}
+
+		// Corruption
+		if (tick % 997 == 0)
+		{
+			log[frame_start + rng() % (log.size() - frame_start)] ^= 1 << (rng() % 8);
+		}
+
+		if (tick % 1499 == 0)
+		{
+			for (uint32_t n = 1 + rng() % 64; n > 0; n--)
+			{
+				log.push_back((char)(n % 7 == 0 ? START_BYTE : rng()));
+			}
+		}
+
+		if (tick % 2003 == 0)
+		{
+			const uint16_t len = aplink_log_imu_pack(imu, packet);
+			append_packet(&log, packet, 1 + rng() % (len - 1));
+		}
+	}
+
+	// Pad the end so the two thread split lands in the header of an IMU
+	// frame, before its hidden frame, which forces at least one rescan
+	const uint8_t imu_len = sizeof(aplink_log_imu_t);
+
+	while (true)
+	{
+		const size_t mid = log.size() / 2;
+		bool in_header = false;
+
+		for (size_t back = 1; back <= HEADER_LEN + sizeof(uint64_t); back++)
+		{
+			in_header |= (uint8_t)log[mid - back] == START_BYTE && (uint8_t)log[mid - back + 1] == imu_len &&
+				(uint8_t)log[mid - back + 2] == LOG_IMU_MSG_ID;
+		}
+
+		if (in_header)
+		{
+			break;
+		}
+
+		log.append(2, '\0');
+	}
+
+	return log;
+}
+
+// Removes an export directory, only the files log_export writes
+static void remove_export(const std::string& dir)
+{
+	for (uint8_t m = 0; m < LOG_NUM_MESSAGES; m++)
+	{
+		const std::string message_dir = dir + "/" + LOG_MESSAGES[m].name;
+
+		for (uint8_t c = 0; c < LOG_MESSAGES[m].num_columns; c++)
+		{
+			unlink((message_dir + "/" + LOG_MESSAGES[m].columns[c].name + ".bin").c_str());
+		}
+
+		rmdir(message_dir.c_str());
+	}
+
+	unlink((dir + "/manifest.json").c_str());
+	rmdir(dir.c_str());
+}
+
+static bool same_file(const std::string& a, const std::string& b)
+{
+	std::string data_a, data_b;
+	const bool read_a = read_file(a, &data_a);
+	const bool read_b = read_file(b, &data_b);
+
+	return read_a == read_b && data_a == data_b;
+}
+
+// Runs a query, returns the rows and checks every printed time is in range
+static uint64_t query(const std::string& dir, const Message_def* message, uint64_t from_us, uint64_t to_us)
+{
+	char* text = nullptr;
+	size_t text_len = 0;
+	FILE* out = open_memstream(&text, &text_len);
+	uint64_t rows = 0;
+
+	const std::vector<const Column_def*> columns = {log_find_column(message, "time_us")};
+	check(log_query(dir, message, from_us, to_us, columns, out, &rows), "%s query failed", message->name);
+	fclose(out);
+
+	uint64_t printed = 0;
+	const char* line = strchr(text, '\n');
+
+	while (line && line[1] != '\0')
+	{
+		const uint64_t time_us = strtoull(line + 1, nullptr, 10);
+		check(time_us >= from_us && time_us < to_us, "%s query returned time %llu", message->name,
+			(unsigned long long)time_us);
+		printed++;
+		line = strchr(line + 1, '\n');
+	}
+
+	check(printed == rows, "%s query printed %llu rows, reported %llu", message->name,
+		(unsigned long long)printed, (unsigned long long)rows);
+
+	free(text);
+	return rows;
+}
+
+// Rows of the exported time index in [from_us, to_us), without relying on order
+static uint64_t count_rows(const std::string& dir, const Message_def* message, uint64_t from_us, uint64_t to_us)
+{
+	std::string data;
+	read_file(dir + "/" + message->name + "/time_us.bin", &data);
+
+	uint64_t rows = 0;
+
+	for (size_t offset = 0; offset + 8 <= data.size(); offset += 8)
+	{
+		uint64_t time_us;
+		memcpy(&time_us, data.data() + offset, 8);
+		rows += time_us >= from_us && time_us < to_us;
+	}
+
+	return rows;
+}
+
+int main()
+{
+	char dir_template[] = "/tmp/log_index_test.XXXXXX";
+	const char* tmp_dir = mkdtemp(dir_template);
+
+	if (!tmp_dir)
+	{
+		fprintf(stderr, "Cannot create a temporary directory\n");
+		return 1;
+	}
+
+	const std::string log = make_log();
+	const uint8_t* data = (const uint8_t*)log.data();
+
+	const std::string ref_dir = std::string(tmp_dir) + "/threads_1";
+	Index_stats ref;
+	check(log_export(data, log.size(), ref_dir, 1, &ref), "single threaded export failed");
+
+	const Message_def* imu = log_find_message("log_imu");
+	const Message_def* baro = log_find_message("log_baro");
+
+	printf("%zu bytes, %llu frames, %llu unknown, %llu bytes skipped\n", log.size(),
+		(unsigned long long)ref.frames, (unsigned long long)ref.unknown_frames,
+		(unsigned long long)ref.skipped_bytes);
+
+	check(ref.messages[imu->msg_id].count > 150000 && ref.unknown_frames > 0 && ref.skipped_bytes > 0,
+		"log has %llu IMU rows, %llu unknown frames, %llu bytes skipped",
+		(unsigned long long)ref.messages[imu->msg_id].count, (unsigned long long)ref.unknown_frames,
+		(unsigned long long)ref.skipped_bytes);
+
+	for (unsigned threads : THREADS)
+	{
+		const std::string out_dir = std::string(tmp_dir) + "/threads_" + std::to_string(threads);
+		Index_stats stats;
+		check(log_export(data, log.size(), out_dir, threads, &stats), "export with %u threads failed", threads);
+
+		printf("%u threads: %u rescans\n", threads, stats.rescans);
+		check(threads != 2 || stats.rescans == 1, "2 threads: %u rescans", stats.rescans);
+
+		check(stats.frames == ref.frames && stats.skipped_bytes == ref.skipped_bytes &&
+			stats.unknown_frames == ref.unknown_frames,
+			"%u threads: %llu frames, %llu skipped, %llu unknown", threads, (unsigned long long)stats.frames,
+			(unsigned long long)stats.skipped_bytes, (unsigned long long)stats.unknown_frames);
+
+		check(same_file(ref_dir + "/manifest.json", out_dir + "/manifest.json"),
+			"%u threads: manifest.json differs", threads);
+
+		for (uint8_t m = 0; m < LOG_NUM_MESSAGES; m++)
+		{
+			const Message_def& message = LOG_MESSAGES[m];
+
+			for (uint8_t c = 0; c < message.num_columns; c++)
+			{
+				const std::string file = std::string("/") + message.name + "/" + message.columns[c].name + ".bin";
+				check(same_file(ref_dir + file, out_dir + file), "%u threads: %s differs", threads, file.c_str());
+			}
+		}
+
+		remove_export(out_dir);
+	}
+
+	// Sorted, binary searched
+	const uint64_t imu_rows = query(ref_dir, imu, 2000000, 3500000);
+	check(imu_rows > 0 && imu_rows == count_rows(ref_dir, imu, 2000000, 3500000),
+		"log_imu query returned %llu rows", (unsigned long long)imu_rows);
+	check(query(ref_dir, imu, 3500000, 2000000) == 0, "empty range returned rows");
+
+	remove_export(ref_dir);
+
+	// Out of order baro records, the query has to scan instead
+	std::string unsorted;
+	uint8_t packet[MAX_PACKET_LEN];
+
+	for (uint32_t k = 0; k < 1000; k++)
+	{
+		aplink_log_baro_t record = {};
+		record.time_us = (k * 7919 % 1000) * 1000;
+		append_packet(&unsorted, packet, aplink_log_baro_pack(record, packet));
+	}
+
+	const std::string unsorted_dir = std::string(tmp_dir) + "/unsorted";
+	Index_stats stats;
+	check(log_export((const uint8_t*)unsorted.data(), unsorted.size(), unsorted_dir, 1, &stats), "unsorted export failed");
+	check(!stats.messages[baro->msg_id].sorted, "out of order log_baro exported as sorted");
+
+	const uint64_t baro_rows = query(unsorted_dir, baro, 200000, 400000);
+	check(baro_rows == 200 && baro_rows == count_rows(unsorted_dir, baro, 200000, 400000),
+		"unsorted log_baro query returned %llu rows", (unsigned long long)baro_rows);
+
+	remove_export(unsorted_dir);
+	rmdir(tmp_dir);
+
+	return check_result();
+}
@@ -0,0 +1,286 @@
+#include "check.h"
+#include "Linux_HAL/linux_hal.h"
+#include "Sim/param_file.h"
+#include "lib/geo/geo.h"
+#include "modules/mission_storage/mission_storage.h"
+#include "modules/navigator/navigator.h"
+#include "modules/position_control/position_control.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Flies a mission longer than the window through Navigator and
+// PositionControl and counts the bytes they copy out of the mission store.
+// mission_get() and mission_get_item() are wrapped at link time
+// (-Wl,--wrap=mission_get,--wrap=mission_get_item). The same flight is then
+// repeated with every mission_get() copying the mission by value as it did
+// before the store handed out pointers, for comparison.
+
+// mission_data_t before the store was double buffered, 256 items of double
+// lat/lon, returned by value from every mission_get()
+struct Legacy_mission_item
+{
+	double latitude;
+	double longitude;
+};
+
+struct Legacy_mission_data
+{
+	Legacy_mission_item mission_items[256];
+	mission_type_t mission_type;
+	uint8_t num_items;
+	float loiter_radius;
+	loiter_direction_t loiter_direction;
+	float final_leg_dist;
+	float glideslope_angle;
+	float runway_heading;
+	uint8_t last_item_index;
+};
+
+static bool counting = false;
+static bool by_value = false;
+static uint64_t get_calls = 0;
+static uint64_t copied_bytes = 0;
+static Legacy_mission_data legacy_source;
+Legacy_mission_data legacy_sink;
+
+extern "C"
+{
+const mission_data_t* __real_mission_get(const mission_context_t* mission);
+bool __real_mission_get_item(const mission_context_t* mission, uint16_t index, mission_item_t* item);
+
+const mission_data_t* __wrap_mission_get(const mission_context_t* mission)
+{
+	if (counting)
+	{
+		get_calls++;
+
+		if (by_value)
+		{
+			memcpy(&legacy_sink, &legacy_source, sizeof(legacy_sink));
+			copied_bytes += sizeof(legacy_sink);
+		}
+	}
+
+	return __real_mission_get(mission);
+}
+
+bool __wrap_mission_get_item(const mission_context_t* mission, uint16_t index, mission_item_t* item)
+{
+	const bool found = __real_mission_get_item(mission, index, item);
+
+	if (counting && found)
+	{
+		copied_bytes += sizeof(*item);
+	}
+
+	return found;
+}
+}
+
+static constexpr uint16_t NUM_ITEMS = 100;
+static constexpr int32_t LAT_REF = 437794390;
+static constexpr int32_t LON_REF = -794030930;
+
+struct Flight_result
+{
+	uint32_t ticks = 0;
+	uint16_t last_index = 0;
+	uint64_t get_calls = 0;
+	uint64_t copied_bytes = 0;
+	uint64_t max_tick_bytes = 0;
+	uint32_t copying_ticks = 0; // Ticks that copied anything
+	uint32_t window_changes = 0;
+	uint32_t wrong_alt_ticks = 0; // Ticks the published altitude was not the waypoint's
+	double seconds = 0;
+};
+
+// Zigzag of waypoints 300 m apart, climbing 0.5 m per waypoint from 100 m
+static int16_t waypoint_altitude(uint16_t index)
+{
+	return 1000 + index * 5;
+}
+
+static void waypoint_position(uint16_t index, int32_t* lat, int32_t* lon)
+{
+	const float north = index * 300.0f;
+	const float east = (index % 2) * 300.0f;
+	meters_to_lat_lon(north, east, LAT_REF, LON_REF, lat, lon);
+}
+
+static void upload(mission_context_t* mission, MissionStorage* storage)
+{
+	mission_data_t* staging = mission_begin_update(mission);
+	staging->num_items = NUM_ITEMS;
+	staging->mission_type = MISSION_WAYPOINT;
+
+	uint16_t sent = 0;
+
+	while (mission_get_upload_state(mission) == MISSION_UPLOAD_RECEIVING)
+	{
+		if (sent < NUM_ITEMS && mission_upload_ready(mission))
+		{
+			mission_item_t item = {};
+			waypoint_position(sent, &item.latitude, &item.longitude);
+			item.altitude = waypoint_altitude(sent);
+			item.type = MISSION_WAYPOINT;
+			mission_add_item(mission, &item);
+			sent++;
+		}
+		else
+		{
+			storage->update();
+		}
+	}
+
+	mission_set_altitude(mission, 100.0f);
+}
+
+static Flight_result fly(const param_context_t& loaded_params, const std::string& sd_dir, bool copy_by_value)
+{
+	LinuxHAL hal(sd_dir);
+	DataBus data_bus;
+	param_context_t params = loaded_params;
+	mission_context_t mission;
+	mission_init(&mission);
+
+	MissionStorage storage(&hal, &data_bus, &params, &mission);
+	Navigator navigator(&hal, &data_bus, &params, &mission);
+	PositionControl position_control(&hal, &data_bus, &params, &mission);
+
+	Publisher<Modes_data> modes_pub(data_bus.modes_node);
+	Publisher<local_position_s> local_pos_pub(data_bus.local_position_node);
+	Subscriber<waypoint_s> waypoint_sub(data_bus.waypoint_node);
+
+	upload(&mission, &storage);
+	check(mission_get_upload_state(&mission) == MISSION_UPLOAD_DONE, "mission upload failed");
+
+	Modes_data modes;
+	modes.system_mode = System_mode::FLIGHT;
+	modes.flight_mode = Flight_mode::AUTO;
+	modes.auto_mode = Auto_mode::MISSION;
+
+	local_position_s local_pos;
+	local_pos.ref_xy_set = true;
+	local_pos.ref_lat = LAT_REF;
+	local_pos.ref_lon = LON_REF;
+	local_pos.gnd_spd = 15.0f;
+
+	Flight_result result;
+	by_value = copy_by_value;
+	uint16_t window_version = mission_get_window_version(&mission);
+
+	for (uint32_t tick = 0; tick < 20000; tick++)
+	{
+		hal.set_sim_time(tick * 10000ULL);
+		modes.timestamp = hal.get_time_us();
+		local_pos.timestamp = hal.get_time_us();
+		modes_pub.publish(modes);
+		local_pos_pub.publish(local_pos);
+
+		storage.update();
+
+		if (mission_get_window_version(&mission) != window_version)
+		{
+			window_version = mission_get_window_version(&mission);
+			result.window_changes++;
+		}
+
+		const uint64_t start_bytes = copied_bytes;
+		const uint64_t start_calls = get_calls;
+		const auto start = std::chrono::steady_clock::now();
+
+		counting = true;
+		navigator.update();
+		position_control.update();
+		counting = false;
+
+		result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		const uint64_t tick_bytes = copied_bytes - start_bytes;
+		result.get_calls += get_calls - start_calls;
+		result.copied_bytes += tick_bytes;
+		result.copying_ticks += tick_bytes > 0;
+		result.max_tick_bytes = std::max(result.max_tick_bytes, tick_bytes);
+		result.ticks++;
+
+		// Fly straight to the current waypoint at 30 m per tick
+		const waypoint_s waypoint = waypoint_sub.get();
+		result.last_index = waypoint.current_index;
+		result.wrong_alt_ticks += waypoint.timestamp > 0 &&
+			waypoint.current_alt != waypoint_altitude(waypoint.current_index) * 0.1f;
+
+		if (waypoint.num_waypoints > 0 && waypoint.current_index == waypoint.num_waypoints - 1 &&
+			fabsf(waypoint.current_north - local_pos.x) < 1 && fabsf(waypoint.current_east - local_pos.y) < 1)
+		{
+			break;
+		}
+
+		const float d_north = waypoint.current_north - local_pos.x;
+		const float d_east = waypoint.current_east - local_pos.y;
+		const float distance = sqrtf(d_north * d_north + d_east * d_east);
+		const float step = distance > 30.0f ? 30.0f / distance : 1.0f;
+		local_pos.x += d_north * step;
+		local_pos.y += d_east * step;
+	}
+
+	return result;
+}
+
+static void print_result(const char* name, const Flight_result& result)
+{
+	printf("%-9s %5u ticks, %6llu mission_get calls, %9llu bytes copied, %9.1f bytes/tick, "
+		"max %6llu in one tick, %5u ticks copied anything, %.0f ns/tick\n",
+		name, result.ticks, (unsigned long long)result.get_calls, (unsigned long long)result.copied_bytes,
+		(double)result.copied_bytes / result.ticks, (unsigned long long)result.max_tick_bytes,
+		result.copying_ticks, result.seconds / result.ticks * 1e9);
+}
+
+int main()
+{
+	param_context_t params;
+	param_init(&params);
+
+	if (param_load_file(&params, "params/sitl.params") < 0)
+	{
+		fprintf(stderr, "Cannot read params/sitl.params\n");
+		return 1;
+	}
+
+	char sd_template[] = "/tmp/mission_copy_test.XXXXXX";
+	const char* sd_dir = mkdtemp(sd_template);
+
+	if (!sd_dir)
+	{
+		fprintf(stderr, "Cannot create a temporary directory\n");
+		return 1;
+	}
+
+	const Flight_result pointer = fly(params, sd_dir, false);
+	const Flight_result value = fly(params, sd_dir, true);
+
+	print_result("pointer", pointer);
+	print_result("by value", value);
+
+	check(pointer.last_index == NUM_ITEMS - 1, "flight ended at waypoint %u of %u", pointer.last_index, NUM_ITEMS);
+	check(pointer.wrong_alt_ticks == 0, "waypoint altitude wrong for %u ticks", pointer.wrong_alt_ticks);
+	check(pointer.window_changes > 2, "window only changed %u times, mission should not fit in it", pointer.window_changes);
+
+	// Items are only copied while the geometry is rebuilt for a new window,
+	// never more than the window holds
+	check(pointer.copying_ticks <= pointer.window_changes + 1, "%u ticks copied items, %u window changes",
+		pointer.copying_ticks, pointer.window_changes);
+	check(pointer.max_tick_bytes <= MISSION_WINDOW_ITEMS * sizeof(mission_item_t), "%llu bytes copied in one tick",
+		(unsigned long long)pointer.max_tick_bytes);
+
+	for (const char* name : {"mission0.bin", "mission1.bin"})
+	{
+		unlink((std::string(sd_dir) + "/" + name).c_str());
+	}
+
+	rmdir(sd_dir);
+	return check_result();
+}
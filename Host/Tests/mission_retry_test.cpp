@@ -0,0 +1,143 @@
+#include "check.h"
+#include "Linux_HAL/linux_hal.h"
+#include "modules/mission_storage/mission_storage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+// Corrupts one chunk of a saved mission and checks that MissionStorage backs
+// off between reads, leaves the window version alone while it retries and
+// flags the mission unusable once it gives up. A new upload clears the flag.
+
+static constexpr uint16_t NUM_ITEMS = 100;
+static constexpr uint16_t BAD_CHUNK = 2;
+
+static void upload(mission_context_t* mission, MissionStorage* storage)
+{
+	mission_data_t* staging = mission_begin_update(mission);
+	staging->num_items = NUM_ITEMS;
+	staging->mission_type = MISSION_WAYPOINT;
+
+	uint16_t sent = 0;
+
+	while (mission_get_upload_state(mission) == MISSION_UPLOAD_RECEIVING)
+	{
+		if (sent < NUM_ITEMS && mission_upload_ready(mission))
+		{
+			mission_item_t item = {};
+			item.latitude = 437794390 + sent * 1000;
+			item.longitude = -794030930;
+			item.altitude = 1000;
+			item.type = MISSION_WAYPOINT;
+			mission_add_item(mission, &item);
+			sent++;
+		}
+		else
+		{
+			storage->update();
+		}
+	}
+}
+
+// Flips a byte in the first item of a chunk so its CRC no longer matches
+static bool corrupt_chunk(const std::string& path, uint16_t chunk)
+{
+	FILE* f = fopen(path.c_str(), "r+b");
+
+	if (!f)
+	{
+		return false;
+	}
+
+	uint8_t byte = 0;
+	const long offset = mission_chunk_offset(chunk);
+	bool ok = fseek(f, offset, SEEK_SET) == 0 && fread(&byte, 1, 1, f) == 1;
+	byte ^= 0xFF;
+	ok = ok && fseek(f, offset, SEEK_SET) == 0 && fwrite(&byte, 1, 1, f) == 1;
+
+	fclose(f);
+	return ok;
+}
+
+int main()
+{
+	char sd_template[] = "/tmp/mission_retry_test.XXXXXX";
+	const char* sd_dir = mkdtemp(sd_template);
+
+	if (!sd_dir)
+	{
+		fprintf(stderr, "Cannot create a temporary directory\n");
+		return 1;
+	}
+
+	LinuxHAL hal(sd_dir);
+	DataBus data_bus;
+	param_context_t params;
+	param_init(&params);
+	mission_context_t mission;
+	mission_init(&mission);
+
+	MissionStorage storage(&hal, &data_bus, &params, &mission);
+
+	upload(&mission, &storage);
+	check(mission_get_upload_state(&mission) == MISSION_UPLOAD_DONE, "mission upload failed");
+
+	const std::string file = std::string(sd_dir) + "/mission" + std::to_string(mission_get_file(&mission)) + ".bin";
+	check(corrupt_chunk(file, BAD_CHUNK), "cannot corrupt %s", file.c_str());
+
+	// Let the window around the first waypoint load, then move it to start
+	// at the bad chunk
+	uint16_t chunk;
+	while (mission_window_get_missing(&mission, &chunk))
+	{
+		storage.update();
+	}
+
+	mission_request_window(&mission, BAD_CHUNK * MISSION_CHUNK_ITEMS + 1);
+
+	const uint16_t window_version = mission_get_window_version(&mission);
+	uint64_t failed_time = 0;
+
+	for (uint32_t tick = 0; tick < 500; tick++)
+	{
+		hal.set_sim_time(tick * 10000ULL);
+		storage.update();
+
+		if (!failed_time && !mission_check_usable(&mission))
+		{
+			failed_time = hal.get_time_us();
+		}
+	}
+
+	// Delays double from the first, the last failure gives up without one
+	uint64_t total_delay = 0;
+
+	for (uint8_t i = 0; i < MISSION_CHUNK_RETRIES - 1; i++)
+	{
+		total_delay += MISSION_CHUNK_RETRY_DELAY_US << i;
+	}
+
+	printf("gave up after %.2f s, expected %.2f s\n", failed_time * 1e-6, total_delay * 1e-6);
+
+	check(!mission_check_usable(&mission), "mission still usable with a corrupt chunk");
+	check(failed_time >= total_delay && failed_time <= total_delay + 50000,
+		"gave up at %llu us, retry delays add up to %llu us", (unsigned long long)failed_time, (unsigned long long)total_delay);
+	check(mission_get_window_version(&mission) == window_version, "window version changed %u times while retrying",
+		(uint16_t)(mission_get_window_version(&mission) - window_version));
+
+	mission_item_t item;
+	check(!mission_get_item(&mission, BAD_CHUNK * MISSION_CHUNK_ITEMS, &item), "item from the corrupt chunk was loaded");
+
+	// A new mission gets a fresh set of retries
+	upload(&mission, &storage);
+	check(mission_check_usable(&mission), "new mission not usable");
+
+	for (const char* name : {"mission0.bin", "mission1.bin"})
+	{
+		unlink((std::string(sd_dir) + "/" + name).c_str());
+	}
+
+	rmdir(sd_dir);
+	return check_result();
+}
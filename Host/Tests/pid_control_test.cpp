@@ -0,0 +1,290 @@
+#include "check.h"
+#include "lib/pi_control/pi_control.h"
+#include "lib/pi_control/pid_control.h"
+#include <math.h>
+#include <stdint.h>
+
+// Drives PID_control with steps and ramps and checks each of its terms on its
+// own: derivative on measurement, the setpoint low pass, feed forward and the
+// integral hold while saturated. PI_control is compared with its code from
+// before integrate() was shared, which it has to match bit for bit.
+
+static constexpr float DT = 0.002f; // Inner loop at 500 Hz
+
+struct Gains
+{
+	float kP = 0;
+	float kI = 0;
+	float kD = 0;
+	float kFF = 0;
+	float integral_limit = 1;
+	float output_min = -1;
+	float output_max = 1;
+	float trim = 0;
+	float setpoint_cutoff = 0;
+	float derivative_cutoff = 0;
+};
+
+static float output(PID_control* pid, const Gains& g, float state, float setpoint)
+{
+	return pid->get_output(state, setpoint, g.kP, g.kI, g.kD, g.kFF, g.integral_limit, g.output_min, g.output_max,
+		g.trim, g.setpoint_cutoff, g.derivative_cutoff, DT);
+}
+
+// PI_control::get_output before the integral clamp moved to integrate()
+class PI_reference
+{
+public:
+	float get_output(float state, float setpoint, float kP, float kI, float integral_limit, float output_min,
+					 float output_max, float trim, float dt)
+	{
+		float error = setpoint - state;
+
+		if (kI != 0)
+		{
+			_integral += error * dt;
+			_integral = clamp(_integral, -integral_limit / kI, integral_limit / kI);
+		}
+
+		float output = trim + kP * error + kI * _integral;
+		return clamp(output, output_min, output_max);
+	}
+
+	float _integral = 0;
+
+private:
+	static float clamp(float n, float min, float max)
+	{
+		return n > max ? max : n < min ? min : n;
+	}
+};
+
+static uint32_t xorshift(uint32_t* state)
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+static float random_float(uint32_t* state, float min, float max)
+{
+	return min + (max - min) * (float)(xorshift(state) / 4294967295.0);
+}
+
+static void test_pi_unchanged()
+{
+	const float kIs[] = {0, 0.5f, 3.0f};
+	uint32_t state = 0xC0FFEE;
+	uint32_t differ = 0;
+
+	for (float kI : kIs)
+	{
+		PI_control pi;
+		PI_reference reference;
+
+		for (uint32_t n = 0; n < 20000; n++)
+		{
+			const float measured = random_float(&state, -2, 2);
+			const float setpoint = random_float(&state, -2, 2);
+			const float kP = random_float(&state, 0, 2);
+			const float limit = random_float(&state, 0.1f, 1);
+			const float trim = random_float(&state, -0.1f, 0.1f);
+			const float dt = random_float(&state, 0.001f, 0.02f);
+
+			const float a = pi.get_output(measured, setpoint, kP, kI, limit, -1, 1, trim, dt);
+			const float b = reference.get_output(measured, setpoint, kP, kI, limit, -1, 1, trim, dt);
+
+			differ += a != b || pi.get_integral() != reference._integral;
+		}
+	}
+
+	check(differ == 0, "PI_control differs from before the refactor on %u steps", differ);
+}
+
+// A setpoint step moves P and FF but not D, a measurement ramp does
+static void test_derivative_on_measurement()
+{
+	Gains g;
+	g.kD = 0.1f;
+	g.output_min = -100;
+	g.output_max = 100;
+
+	PID_control pid;
+	output(&pid, g, 0, 0);
+
+	const float step = output(&pid, g, 0, 1);
+	check(step == 0, "setpoint step kicked the derivative to %f", step);
+
+	// Falling at 2 per second, the derivative pushes up by kD * 2
+	float state = 0;
+	float ramp = 0;
+
+	for (uint32_t n = 0; n < 10; n++)
+	{
+		state -= 2 * DT;
+		ramp = output(&pid, g, state, 1);
+	}
+
+	check(fabsf(ramp - 0.2f) < 1E-3f, "derivative %f on a ramp of -2 per second, expected 0.2", ramp);
+
+	// Filtered, a measurement step is spread over time instead of a spike
+	g.derivative_cutoff = 20;
+	PID_control filtered;
+	output(&filtered, g, 0, 0);
+
+	const float first = output(&filtered, g, -0.01f, 0);
+	const float unfiltered = g.kD * 0.01f / DT;
+	float later = first;
+
+	for (uint32_t n = 0; n < 10; n++)
+	{
+		later = output(&filtered, g, -0.01f, 0);
+	}
+
+	printf("derivative of a 0.01 step: %f filtered, %f unfiltered, %f after 10 samples\n", first, unfiltered, later);
+
+	check(first > 0 && first < 0.25f * unfiltered, "filtered derivative %f of a step, %f unfiltered", first, unfiltered);
+	check(later >= 0 && later < first, "filtered derivative did not decay, %f then %f", first, later);
+}
+
+// First order, 63 % of a step after one time constant
+static void test_setpoint_lowpass()
+{
+	Gains g;
+	g.kFF = 1;
+	g.setpoint_cutoff = 5;
+
+	PID_control pid;
+	output(&pid, g, 0, 0);
+
+	const float tau = 1.0f / (2 * (float)M_PI * g.setpoint_cutoff);
+	const uint32_t steps = (uint32_t)roundf(tau / DT);
+	float response = 0;
+
+	for (uint32_t n = 0; n < steps; n++)
+	{
+		response = output(&pid, g, 0, 1);
+	}
+
+	printf("setpoint low pass %.0f Hz: %.3f of a step after %u samples\n", g.setpoint_cutoff, response, steps);
+
+	check(fabsf(response - 0.632f) < 0.02f, "setpoint low pass at %.3f after one time constant", response);
+
+	// The first call starts the filter at the setpoint rather than 0
+	PID_control fresh;
+	const float first = output(&fresh, g, 0, 0.5f);
+	check(first == 0.5f, "first output %f, the filter did not start at the setpoint", first);
+
+	// Off, the setpoint is used as is
+	g.setpoint_cutoff = 0;
+	PID_control direct;
+	output(&direct, g, 0, 0);
+	const float direct_step = output(&direct, g, 0, 1);
+	check(direct_step == 1, "unfiltered setpoint step gave %f", direct_step);
+}
+
+static void test_feed_forward()
+{
+	Gains g;
+	g.kFF = 0.25f;
+	g.trim = 0.1f;
+
+	PID_control pid;
+	float out = 0;
+
+	// Whatever the measurement, only the setpoint and trim matter with no
+	// P, I or D
+	const float states[] = {-3, 0, 0.5f, 2};
+
+	for (float state : states)
+	{
+		out = output(&pid, g, state, 2);
+		check(fabsf(out - 0.6f) < 1E-6f, "feed forward %f at measurement %f, expected 0.6", out, state);
+	}
+
+	// P adds on top
+	g.kP = 0.1f;
+	PID_control with_p;
+	out = output(&with_p, g, 1, 2);
+	check(fabsf(out - 0.7f) < 1E-6f, "feed forward with P %f, expected 0.7", out);
+}
+
+// The integral stops growing once the output saturates, and comes off the
+// limit as soon as the error reverses. PI_control only has the clamp and
+// winds up to it.
+static void test_saturation_hold()
+{
+	Gains g;
+	g.kP = 0.5f;
+	g.kI = 2;
+	g.integral_limit = 5;
+	g.output_min = -1;
+	g.output_max = 1;
+
+	PID_control pid;
+	PI_control pi;
+
+	float held = 0;
+	uint32_t saturated_at = 0;
+
+	for (uint32_t n = 1; n <= 2000; n++)
+	{
+		const float out = output(&pid, g, 0, 1);
+		pi.get_output(0, 1, g.kP, g.kI, g.integral_limit, g.output_min, g.output_max, g.trim, DT);
+
+		if (out == g.output_max && saturated_at == 0)
+		{
+			saturated_at = n;
+			held = pid.get_integral();
+		}
+	}
+
+	printf("saturated after %u samples, integral held at %f, %f without the hold\n", saturated_at,
+		pid.get_integral(), pi.get_integral());
+
+	check(saturated_at > 0, "output never saturated");
+	check(pid.get_integral() == held, "integral went from %f to %f while saturated", held,
+		pid.get_integral());
+	check(fabsf(pi.get_integral() - g.integral_limit / g.kI) < 1E-5f, "PI_control integral %f, clamp at %f",
+		pi.get_integral(), g.integral_limit / g.kI);
+
+	// Overshoot, the error reverses
+	uint32_t pid_recovery = 0;
+	uint32_t pi_recovery = 0;
+
+	for (uint32_t n = 1; n <= 2000 && (pid_recovery == 0 || pi_recovery == 0); n++)
+	{
+		if (output(&pid, g, 2, 1) < g.output_max && pid_recovery == 0)
+		{
+			pid_recovery = n;
+		}
+
+		if (pi.get_output(2, 1, g.kP, g.kI, g.integral_limit, g.output_min, g.output_max, g.trim, DT) < g.output_max &&
+			pi_recovery == 0)
+		{
+			pi_recovery = n;
+		}
+	}
+
+	printf("off the limit after %u samples, %u without the hold\n", pid_recovery, pi_recovery);
+
+	check(pid_recovery > 0 && pid_recovery <= 2, "took %u samples to come off the limit", pid_recovery);
+	check(pi_recovery > 10 * pid_recovery, "PI_control came off the limit after %u samples", pi_recovery);
+
+	// reset() clears the integral and the hold
+	pid.reset();
+	check(pid.get_integral() == 0, "integral %f after reset()", pid.get_integral());
+}
+
+int main()
+{
+	test_pi_unchanged();
+	test_derivative_on_measurement();
+	test_setpoint_lowpass();
+	test_feed_forward();
+	test_saturation_hold();
+
+	return check_result();
+}
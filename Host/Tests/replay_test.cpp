@@ -0,0 +1,147 @@
+#include "check.h"
+#include "Linux_HAL/linux_hal.h"
+#include "Replay/log_replay.h"
+#include "Sim/bench_sim.h"
+#include "Sim/param_file.h"
+#include "autopilot.h"
+#include <dirent.h>
+#include <memory>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+
+// Records a SITL sensor log with LOG_SENSORS and replays it twice. The
+// replayed attitude has to be bit-exact with the flight log records on every
+// tick and the two replays have to agree byte for byte, which is what
+// replay --ref checks against a saved output.
+
+static constexpr uint64_t STEP_US = 10000;
+static constexpr uint64_t DURATION_US = 10000000;
+
+static bool read_file(const std::string& path, std::string* data)
+{
+	FILE* f = fopen(path.c_str(), "rb");
+
+	if (!f)
+	{
+		return false;
+	}
+
+	char chunk[65536];
+	size_t len;
+
+	while ((len = fread(chunk, 1, sizeof(chunk), f)) > 0)
+	{
+		data->append(chunk, len);
+	}
+
+	fclose(f);
+	return true;
+}
+
+// The log is named after the GNSS time, everything else is a mission file
+static std::string find_log(const std::string& sd_dir)
+{
+	std::string name;
+	DIR* dir = opendir(sd_dir.c_str());
+
+	if (!dir)
+	{
+		return name;
+	}
+
+	while (const dirent* entry = readdir(dir))
+	{
+		if (entry->d_name[0] != '.' && strncmp(entry->d_name, "mission", 7) != 0)
+		{
+			name = entry->d_name;
+		}
+	}
+
+	closedir(dir);
+	return name;
+}
+
+static void record(const param_context_t& params, const std::string& sd_dir)
+{
+	LinuxHAL hal(sd_dir);
+
+	// Too big for the stack
+	std::unique_ptr<Autopilot> autopilot = std::make_unique<Autopilot>(&hal);
+	*autopilot->get_params() = params;
+
+	Bench_sim sim(&hal);
+	sim.set_vibration(120, 5.0f);
+
+	autopilot->setup();
+
+	for (uint64_t time = STEP_US; time <= DURATION_US; time += STEP_US)
+	{
+		sim.step_to(time);
+		hal.run_until(time);
+	}
+}
+
+int main()
+{
+	param_context_t params;
+	param_init(&params);
+
+	if (param_load_file(&params, "params/sitl.params") < 0)
+	{
+		fprintf(stderr, "Cannot read params/sitl.params\n");
+		return 1;
+	}
+
+	param_set_int32(&params, param_find(&params, "LOG_SENSORS"), 1);
+
+	char sd_template[] = "/tmp/replay_test.XXXXXX";
+	const char* sd_dir = mkdtemp(sd_template);
+
+	if (!sd_dir)
+	{
+		fprintf(stderr, "Cannot create a temporary directory\n");
+		return 1;
+	}
+
+	record(params, sd_dir);
+
+	const std::string name = find_log(sd_dir);
+	const std::string path = std::string(sd_dir) + "/" + name;
+	std::string log;
+	check(!name.empty() && read_file(path, &log), "no log written to %s", sd_dir);
+
+	std::string outputs[2];
+	Replay_result results[2];
+
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		std::unique_ptr<Log_replay> replay = std::make_unique<Log_replay>(params);
+		results[i] = replay->run((const uint8_t*)log.data(), log.size(), &outputs[i]);
+	}
+
+	const Replay_result& result = results[0];
+
+	printf("%s: %zu bytes, %llu ticks, %llu IMU records, attitude bit-exact on %llu of %llu ticks\n",
+		name.c_str(), log.size(), (unsigned long long)result.ticks, (unsigned long long)result.imu_records,
+		(unsigned long long)result.attitude_matches, (unsigned long long)result.attitude_checks);
+
+	// One tick per main task run, the log file opens once GNSS has the time
+	check(result.ticks > DURATION_US / STEP_US * 9 / 10, "only %llu ticks", (unsigned long long)result.ticks);
+	check(result.from_boot && result.gaps == 0, "log %s, %llu gaps", result.from_boot ? "from boot" : "not from boot",
+		(unsigned long long)result.gaps);
+	check(result.attitude_checks > result.ticks * 9 / 10, "attitude only compared on %llu of %llu ticks",
+		(unsigned long long)result.attitude_checks, (unsigned long long)result.ticks);
+	check(result.attitude_matches == result.attitude_checks, "attitude bit-exact on %llu of %llu ticks",
+		(unsigned long long)result.attitude_matches, (unsigned long long)result.attitude_checks);
+
+	check(!outputs[0].empty() && outputs[0] == outputs[1], "second replay differs from the first");
+	check(results[1].ticks == result.ticks && results[1].attitude_matches == result.attitude_matches,
+		"second replay has %llu ticks and %llu matches", (unsigned long long)results[1].ticks,
+		(unsigned long long)results[1].attitude_matches);
+
+	unlink(path.c_str());
+	rmdir(sd_dir);
+	return check_result();
+}
@@ -0,0 +1,279 @@
+#include "check.h"
+#include "Drivers/ubx.h"
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+// Feeds NAV-PVT byte streams through the UBX parser the GNSS driver uses and
+// checks the decoded solution, then corrupts the streams: a bad checksum, a
+// message longer than the parser keeps and garbage between messages.
+
+// NAV-PVT with a 3D fix and resolved UTC, 2025-06-14 12:34:56, 14 satellites
+// lat 43.7794390 lon -79.4030930 hMSL 123.456 m
+// velN 1.234 velE -5.678 velD 0.321 m/s, hAcc 1.520 vAcc 2.480 m, sAcc 0.310 m/s
+static const uint8_t nav_pvt_3d[] = {
+	0xB5, 0x62, 0x01, 0x07, 0x5C, 0x00, 0xC8, 0xA6, 0x60, 0x1C, 0xE9, 0x07, 0x06, 0x0E, 0x0C, 0x22,
+	0x38, 0x37, 0x15, 0x00, 0x00, 0x00, 0xC0, 0x1D, 0xFE, 0xFF, 0x03, 0x01, 0xEA, 0x0E, 0xAE, 0x0C,
+	0xAC, 0xD0, 0x56, 0x36, 0x18, 0x1A, 0x23, 0x5C, 0x01, 0x00, 0x40, 0xE2, 0x01, 0x00, 0xF0, 0x05,
+	0x00, 0x00, 0xB0, 0x09, 0x00, 0x00, 0xD2, 0x04, 0x00, 0x00, 0xD2, 0xE9, 0xFF, 0xFF, 0x41, 0x01,
+	0x00, 0x00, 0xB2, 0x16, 0x00, 0x00, 0x91, 0xC1, 0xB6, 0x01, 0x36, 0x01, 0x00, 0x00, 0x98, 0xFF,
+	0x00, 0x00, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x13, 0xB7,
+};
+
+// NAV-PVT 100 ms later with a 2D fix, time valid but not fully resolved,
+// 4 satellites
+// lat 43.7794411 lon -79.4031012 hMSL -1.250 m
+// velN -0.860 velE 0.045 velD -2.150 m/s, hAcc 25.700 vAcc 41.300 m, sAcc 1.730 m/s
+static const uint8_t nav_pvt_2d[] = {
+	0xB5, 0x62, 0x01, 0x07, 0x5C, 0x00, 0x2C, 0xA7, 0x60, 0x1C, 0xE9, 0x07, 0x06, 0x0E, 0x0C, 0x22,
+	0x38, 0x30, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x04, 0x5C, 0x0C,
+	0xAC, 0xD0, 0x6B, 0x36, 0x18, 0x1A, 0xEE, 0x7F, 0x00, 0x00, 0x1E, 0xFB, 0xFF, 0xFF, 0x64, 0x64,
+	0x00, 0x00, 0x54, 0xA1, 0x00, 0x00, 0xA4, 0xFC, 0xFF, 0xFF, 0x2D, 0x00, 0x00, 0x00, 0x9A, 0xF7,
+	0xFF, 0xFF, 0x5C, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC2, 0x06, 0x00, 0x00, 0x40, 0x54,
+	0x89, 0x00, 0x08, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0xEF, 0xF5,
+};
+
+typedef std::vector<uint8_t> Bytes;
+
+struct Feed_result
+{
+	uint32_t messages = 0; // Good checksums
+	uint32_t solutions = 0; // Of those, NAV-PVT
+};
+
+static Feed_result feed(Ubx_parser* parser, const Bytes& stream, Ubx_nav_pvt* pvt)
+{
+	Feed_result result;
+
+	for (uint8_t c : stream)
+	{
+		if (parser->parse_byte(c))
+		{
+			result.messages++;
+			result.solutions += parser->decode_nav_pvt(pvt);
+		}
+	}
+
+	return result;
+}
+
+static Bytes bytes(const uint8_t* data, size_t len)
+{
+	return Bytes(data, data + len);
+}
+
+static void append(Bytes* stream, const Bytes& more)
+{
+	stream->insert(stream->end(), more.begin(), more.end());
+}
+
+// Frames a payload the way the receiver does
+static Bytes frame(uint8_t cls, uint8_t id, const Bytes& payload)
+{
+	Bytes msg = {UBX_SYNC1, UBX_SYNC2, cls, id, (uint8_t)payload.size(), (uint8_t)(payload.size() >> 8)};
+	append(&msg, payload);
+
+	uint8_t a = 0;
+	uint8_t b = 0;
+
+	for (size_t i = 2; i < msg.size(); i++)
+	{
+		a += msg[i];
+		b += a;
+	}
+
+	msg.push_back(a);
+	msg.push_back(b);
+	return msg;
+}
+
+static bool near(float value, float expected)
+{
+	return fabsf(value - expected) <= 1E-6f * fmaxf(1.0f, fabsf(expected));
+}
+
+static void check_3d(const Ubx_nav_pvt& pvt, const char* name)
+{
+	check(pvt.lat == 437794390 && pvt.lon == -794030930, "%s: lat %d lon %d", name, pvt.lat, pvt.lon);
+	check(near(pvt.alt, 123.456f), "%s: hMSL %f", name, pvt.alt);
+	check(near(pvt.vel_n, 1.234f) && near(pvt.vel_e, -5.678f) && near(pvt.vel_d, 0.321f),
+		"%s: vel %f %f %f", name, pvt.vel_n, pvt.vel_e, pvt.vel_d);
+	check(near(pvt.h_acc, 1.52f) && near(pvt.v_acc, 2.48f) && near(pvt.s_acc, 0.31f),
+		"%s: hAcc %f vAcc %f sAcc %f", name, pvt.h_acc, pvt.v_acc, pvt.s_acc);
+	check(pvt.fix && pvt.sats == 14, "%s: fix %d sats %u", name, pvt.fix, pvt.sats);
+}
+
+static void check_utc(const Ubx_nav_pvt& pvt, const char* name)
+{
+	check(pvt.year == 2025 && pvt.month == 6 && pvt.day == 14 &&
+		pvt.hours == 12 && pvt.minutes == 34 && pvt.seconds == 56,
+		"%s: UTC %04u-%02u-%02u %02u:%02u:%02u", name, pvt.year, pvt.month, pvt.day, pvt.hours, pvt.minutes, pvt.seconds);
+}
+
+static void test_decode()
+{
+	Ubx_parser parser;
+	Ubx_nav_pvt pvt;
+
+	const Feed_result result = feed(&parser, bytes(nav_pvt_3d, sizeof(nav_pvt_3d)), &pvt);
+	check(result.solutions == 1, "3D fix: %u solutions", result.solutions);
+	check_3d(pvt, "3D fix");
+	check_utc(pvt, "3D fix");
+
+	// A 2D fix is not a fix, and UTC that is not fully resolved is not used
+	feed(&parser, bytes(nav_pvt_2d, sizeof(nav_pvt_2d)), &pvt);
+	check(pvt.lat == 437794411 && pvt.lon == -794031012, "2D fix: lat %d lon %d", pvt.lat, pvt.lon);
+	check(near(pvt.alt, -1.25f), "2D fix: hMSL %f", pvt.alt);
+	check(near(pvt.vel_n, -0.86f) && near(pvt.vel_e, 0.045f) && near(pvt.vel_d, -2.15f),
+		"2D fix: vel %f %f %f", pvt.vel_n, pvt.vel_e, pvt.vel_d);
+	check(near(pvt.h_acc, 25.7f) && near(pvt.v_acc, 41.3f) && near(pvt.s_acc, 1.73f),
+		"2D fix: hAcc %f vAcc %f sAcc %f", pvt.h_acc, pvt.v_acc, pvt.s_acc);
+	check(!pvt.fix && pvt.sats == 4, "2D fix: fix %d sats %u", pvt.fix, pvt.sats);
+	check_utc(pvt, "UTC kept from the 3D fix");
+
+	Ubx_parser fresh_parser;
+	Ubx_nav_pvt fresh;
+	feed(&fresh_parser, bytes(nav_pvt_2d, sizeof(nav_pvt_2d)), &fresh);
+	check(fresh.year == 0, "UTC set from an unresolved time, year %u", fresh.year);
+}
+
+// Other messages pass the framing but are not solutions
+static void test_other_messages()
+{
+	Ubx_parser parser;
+	Ubx_nav_pvt pvt;
+
+	// ACK-ACK of a CFG-VALSET
+	Bytes stream = frame(0x05, 0x01, {UBX_CLASS_CFG, UBX_CFG_VALSET});
+
+	// NAV-PVT of the older 84 byte version
+	append(&stream, frame(UBX_CLASS_NAV, UBX_NAV_PVT, Bytes(84, 0)));
+
+	const Feed_result result = feed(&parser, stream, &pvt);
+	check(result.messages == 2 && result.solutions == 0, "other messages: %u messages, %u solutions",
+		result.messages, result.solutions);
+}
+
+static void test_bad_checksum()
+{
+	const size_t len = sizeof(nav_pvt_3d);
+	const size_t corrupt[] = {len - 1, len - 2, 6, 40};
+
+	for (size_t index : corrupt)
+	{
+		Ubx_parser parser;
+		Ubx_nav_pvt pvt;
+
+		Bytes stream = bytes(nav_pvt_3d, len);
+		stream[index] ^= 0x10;
+		Feed_result result = feed(&parser, stream, &pvt);
+		check(result.messages == 0, "byte %zu corrupted: %u messages", index, result.messages);
+		check(pvt.lat == 0, "byte %zu corrupted: solution used", index);
+
+		// The next message is still found
+		result = feed(&parser, bytes(nav_pvt_3d, len), &pvt);
+		check(result.solutions == 1, "after a bad checksum at byte %zu: %u solutions", index, result.solutions);
+		check_3d(pvt, "after a bad checksum");
+	}
+}
+
+static void test_long_payload()
+{
+	Ubx_parser parser;
+	Ubx_nav_pvt pvt;
+
+	// NAV-SAT with 24 satellites is longer than the parser keeps
+	Bytes sat(8 + 24 * 12);
+
+	for (size_t i = 0; i < sat.size(); i++)
+	{
+		sat[i] = (uint8_t)(i * 7) != UBX_SYNC1 ? (uint8_t)(i * 7) : 0;
+	}
+
+	check(sat.size() > Ubx_parser::max_payload_len, "NAV-SAT of %zu bytes fits", sat.size());
+
+	Bytes stream = frame(UBX_CLASS_NAV, 0x35, sat);
+	append(&stream, bytes(nav_pvt_3d, sizeof(nav_pvt_3d)));
+
+	const Feed_result result = feed(&parser, stream, &pvt);
+	check(result.messages == 1 && result.solutions == 1, "after a long payload: %u messages, %u solutions",
+		result.messages, result.solutions);
+	check_3d(pvt, "after a long payload");
+}
+
+static uint32_t xorshift(uint32_t* state)
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+static void test_resync()
+{
+	Ubx_parser parser;
+	Ubx_nav_pvt pvt;
+	uint32_t state = 0x2545F491;
+
+	// Line noise without sync characters, then a false sync and a repeated
+	// first sync character right before the message
+	Bytes stream;
+
+	for (int i = 0; i < 1000; i++)
+	{
+		const uint8_t c = xorshift(&state);
+		stream.push_back(c != UBX_SYNC1 ? c : 0);
+	}
+
+	append(&stream, {UBX_SYNC1, 0x00, UBX_SYNC1, UBX_SYNC1});
+	append(&stream, Bytes(nav_pvt_3d + 1, nav_pvt_3d + sizeof(nav_pvt_3d)));
+
+	Feed_result result = feed(&parser, stream, &pvt);
+	check(result.messages == 1 && result.solutions == 1, "after garbage: %u messages, %u solutions",
+		result.messages, result.solutions);
+	check_3d(pvt, "after garbage");
+
+	// A message cut off mid payload takes the start of the next one with
+	// it, the one after is found
+	stream = Bytes(nav_pvt_3d, nav_pvt_3d + 40);
+	append(&stream, bytes(nav_pvt_3d, sizeof(nav_pvt_3d)));
+	append(&stream, bytes(nav_pvt_2d, sizeof(nav_pvt_2d)));
+
+	result = feed(&parser, stream, &pvt);
+	check(result.solutions >= 1 && pvt.lat == 437794411, "after a cut off message: %u solutions, lat %d",
+		result.solutions, pvt.lat);
+
+	// A long stream with random garbage between solutions loses none of them
+	stream.clear();
+	const uint32_t num_solutions = 1000;
+
+	for (uint32_t i = 0; i < num_solutions; i++)
+	{
+		const uint32_t garbage = xorshift(&state) % 64;
+
+		for (uint32_t j = 0; j < garbage; j++)
+		{
+			const uint8_t c = xorshift(&state);
+			stream.push_back(c != UBX_SYNC1 ? c : 0);
+		}
+
+		append(&stream, i % 2 ? bytes(nav_pvt_2d, sizeof(nav_pvt_2d)) : bytes(nav_pvt_3d, sizeof(nav_pvt_3d)));
+	}
+
+	result = feed(&parser, stream, &pvt);
+	check(result.solutions == num_solutions, "interleaved garbage: %u of %u solutions", result.solutions, num_solutions);
+}
+
+int main()
+{
+	test_decode();
+	test_other_messages();
+	test_bad_checksum();
+	test_long_payload();
+	test_resync();
+
+	return check_result();
+}